@@ -0,0 +1,69 @@
+/*
+  Name:         AnalysisChunk.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Analyzes one stretch of a video on its own thread...
+*/
+
+// Includes...
+#include "AnalysisChunk.h"
+
+// Constructor...
+AnalysisChunk::AnalysisChunk(
+    WormTracker const &Template, wxString const &_sPath,
+    MediaIndex const *_pIndex, unsigned int const _unFirstFrame,
+    unsigned int const _unFrames, unsigned int const _unStride,
+    unsigned int const unReadAheadFrames)
+    : wxThread(wxTHREAD_JOINABLE),
+      Reader(unReadAheadFrames),
+      sPath(_sPath),
+      pIndex(_pIndex),
+      unFirstFrame(_unFirstFrame),
+      unFrames(_unFrames),
+      unStride(_unStride)
+{
+    // Set up just like the template...
+    Tracker.CopySettings(Template);
+}
+
+// Thread entry point...
+wxThread::ExitCode AnalysisChunk::Entry()
+{
+    // Variables...
+    cv::Mat         GrayImage;
+    unsigned int    unFrame = 0;
+
+    // Analyze our stretch, unless the video ends first or cancel requested...
+    while(unFrame < unFrames && !TestDestroy() && Reader.Read(GrayImage))
+    {
+        Tracker.Advance(GrayImage);
+      ++unFrame;
+    }
+
+    // Stop decoding, the next stretch isn't ours...
+    Reader.Stop();
+
+    // Done...
+    return NULL;
+}
+
+// The tracker with the results...
+WormTracker &AnalysisChunk::GetTracker()
+{
+    return Tracker;
+}
+
+// Seek to the stretch and start analyzing it...
+bool AnalysisChunk::Start()
+{
+    // Only expecting our stretch, numbered from where it starts...
+    Tracker.Reset(unFrames);
+    Tracker.SetFrameNumbering(unFirstFrame, unStride);
+
+    // Start decoding from its first frame...
+    if(!Reader.Open(sPath, unFirstFrame, pIndex, unStride))
+        return false;
+
+    // Start analyzing...
+    return (Create() == wxTHREAD_NO_ERROR && Run() == wxTHREAD_NO_ERROR);
+}
+
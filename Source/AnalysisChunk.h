@@ -0,0 +1,88 @@
+/*
+  Name:         AnalysisChunk.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Analyzes one stretch of a video on its own thread, with its own
+                decoder and its own tracker set up just like another. The
+                tracker starts out knowing nothing of the frames before its
+                stretch, so whoever analyzed those stitches its results onto
+                their own when it's done...
+*/
+
+// Multiple include protection...
+#ifndef _ANALYSISCHUNK_H_
+#define _ANALYSISCHUNK_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/thread.h>
+
+    // Worm tracker...
+    #include "WormTracker.h"
+
+    // Read ahead video decoder...
+    #include "VideoReader.h"
+
+// AnalysisChunk class...
+class AnalysisChunk : public wxThread
+{
+    // Public methods...
+    public:
+
+        // Constructor takes the tracker to copy the settings of, the video
+        //  and its index if any, the stretch of it to analyze, and how far to
+        //  decode ahead. The stretch starts at the given frame and takes
+        //  unFrames of them, each unStride frames after the last. The index
+        //  must outlive Start()...
+        AnalysisChunk(WormTracker const &Template, wxString const &sPath,
+                      MediaIndex const *pIndex,
+                      unsigned int const unFirstFrame,
+                      unsigned int const unFrames,
+                      unsigned int const unStride,
+                      unsigned int const unReadAheadFrames);
+
+        // Accessors...
+
+            // The tracker with the results. Only safe once the thread is
+            //  done...
+            WormTracker        &GetTracker();
+
+        // Mutators...
+
+            // Seek to the stretch and start analyzing it. Returns false if
+            //  the video can't be opened or seeked, or the thread started...
+            bool                Start();
+
+    // Protected methods...
+    protected:
+
+        // Thread entry point...
+        virtual ExitCode        Entry();
+
+    // Protected attributes...
+    protected:
+
+        // Tracker for just this stretch...
+        WormTracker             Tracker;
+
+        // Decoder for just this stretch...
+        VideoReader             Reader;
+
+        // The video, its index, and the stretch of it to analyze...
+        wxString                sPath;
+        MediaIndex const       *pIndex;
+        unsigned int            unFirstFrame;
+        unsigned int            unFrames;
+        unsigned int            unStride;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        AnalysisChunk(AnalysisChunk const &);
+        AnalysisChunk &operator=(AnalysisChunk const &);
+};
+
+#endif
+
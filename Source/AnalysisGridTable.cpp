@@ -0,0 +1,198 @@
+/*
+  Name:         AnalysisGridTable.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Virtual table behind the analysis results grid...
+*/
+
+// Includes...
+#include "AnalysisGridTable.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Default constructor...
+AnalysisGridTable::AnalysisGridTable()
+    : wxGridTableBase()
+{
+
+}
+
+// Add a column...
+void AnalysisGridTable::AddColumn(
+    wxString const &sLabel, wxString const &sUnits)
+{
+    // Columns are fixed once there are rows, the values are strided by them...
+    assert(Worms.empty());
+
+    // Add it...
+    Column NewColumn;
+    NewColumn.sLabel = sLabel;
+    NewColumn.sUnits = sUnits;
+    Columns.push_back(NewColumn);
+
+    // Tell the grid...
+    Notify(wxGRIDTABLE_NOTIFY_COLS_APPENDED, 0, 1);
+}
+
+// Queue a row for the given worm number...
+void AnalysisGridTable::AppendRow(uint32_t const unWorm, float const *pValues)
+{
+    // Store the label and values...
+    Worms.push_back(unWorm);
+    Values.insert(Values.end(), pValues, pValues + Columns.size());
+}
+
+// Forget every row, keeping the columns...
+void AnalysisGridTable::Clear()
+{
+    // Remember how many rows the grid thinks there are...
+    int const nRows = Order.size();
+
+    // Forget them, including any not yet flushed...
+    Worms.clear();
+    Values.clear();
+    Order.clear();
+
+    // Tell the grid...
+    if(nRows > 0)
+        Notify(wxGRIDTABLE_NOTIFY_ROWS_DELETED, 0, nRows);
+}
+
+// Tell the grid about rows appended since the last flush...
+void AnalysisGridTable::Flush()
+{
+    // Nothing new...
+    size_t const OldRows = Order.size();
+    if(OldRows == Worms.size())
+        return;
+
+    // New rows go at the end in the order they came...
+    Order.resize(Worms.size());
+    for(size_t Row = OldRows; Row < Order.size(); ++Row)
+        Order[Row] = Row;
+
+    // Tell the grid...
+    Notify(wxGRIDTABLE_NOTIFY_ROWS_APPENDED, 0, Order.size() - OldRows);
+}
+
+// Get a column's label...
+wxString AnalysisGridTable::GetColLabelValue(int nColumn)
+{
+    return Columns.at(nColumn).sLabel;
+}
+
+// Get the units shown after a column's values...
+wxString const &AnalysisGridTable::GetColUnits(int const nColumn) const
+{
+    return Columns.at(nColumn).sUnits;
+}
+
+// Get a cell's raw value, by displayed row...
+float AnalysisGridTable::GetFloat(int nRow, int nColumn) const
+{
+    return Values[Order[nRow] * Columns.size() + nColumn];
+}
+
+// Number of columns...
+int AnalysisGridTable::GetNumberCols()
+{
+    return Columns.size();
+}
+
+// Number of rows...
+int AnalysisGridTable::GetNumberRows()
+{
+    return Order.size();
+}
+
+// Get a row's label...
+wxString AnalysisGridTable::GetRowLabelValue(int nRow)
+{
+    return wxString::Format(wxT("Worm %u"), Worms[Order[nRow]]);
+}
+
+// Format a cell for display...
+wxString AnalysisGridTable::GetValue(int nRow, int nColumn)
+{
+    // Not measured...
+    float const fValue = GetFloat(nRow, nColumn);
+    if(std::isnan(fValue))
+        return wxEmptyString;
+
+    // Format with its units...
+    return wxString::Format(wxT("%.3f"), fValue) + Columns[nColumn].sUnits;
+}
+
+// Is the cell empty?
+bool AnalysisGridTable::IsEmptyCell(int nRow, int nColumn)
+{
+    return std::isnan(GetFloat(nRow, nColumn));
+}
+
+// Forget every row and column...
+void AnalysisGridTable::Reset()
+{
+    // Rows first...
+    Clear();
+
+    // Then columns...
+    int const nColumns = Columns.size();
+    Columns.clear();
+    if(nColumns > 0)
+        Notify(wxGRIDTABLE_NOTIFY_COLS_DELETED, 0, nColumns);
+}
+
+// Send a message to the grid, if attached...
+void AnalysisGridTable::Notify(
+    int const nMessage, int const nFirst, int const nCount)
+{
+    // Not attached yet...
+    if(!GetView())
+        return;
+
+    // Appends only take a count, everything else a position and a count...
+    if(nMessage == wxGRIDTABLE_NOTIFY_ROWS_APPENDED ||
+       nMessage == wxGRIDTABLE_NOTIFY_COLS_APPENDED)
+    {
+        wxGridTableMessage Message(this, nMessage, nCount);
+        GetView()->ProcessTableMessage(Message);
+    }
+    else
+    {
+        wxGridTableMessage Message(this, nMessage, nFirst, nCount);
+        GetView()->ProcessTableMessage(Message);
+    }
+}
+
+// Cells can't be edited...
+void AnalysisGridTable::SetValue(int nRow, int nColumn, wxString const &sValue)
+{
+
+}
+
+// Reorder the rows by a column...
+void AnalysisGridTable::Sort(int const nColumn, bool const bAscending)
+{
+    // Compare the column's value in two appended rows. Unmeasured values
+    //  always sink to the bottom...
+    size_t const Stride = Columns.size();
+    std::stable_sort(Order.begin(), Order.end(),
+        [this, nColumn, bAscending, Stride](uint32_t unLeft, uint32_t unRight)
+        {
+            // Get the two values...
+            float const fLeft   = Values[unLeft * Stride + nColumn];
+            float const fRight  = Values[unRight * Stride + nColumn];
+
+            // Either unmeasured...
+            if(std::isnan(fLeft) || std::isnan(fRight))
+                return !std::isnan(fLeft) && std::isnan(fRight);
+
+            // Compare in the requested direction...
+            return bAscending ? (fLeft < fRight) : (fRight < fLeft);
+        });
+
+    // Redraw whatever is visible...
+    if(GetView())
+        GetView()->ForceRefresh();
+}
+
@@ -0,0 +1,125 @@
+/*
+  Name:         AnalysisGridTable.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Virtual table behind the analysis results grid. Each row is a
+                worm label and a fixed number of floats, all kept in one flat
+                array, and cells are only formatted into strings when the grid
+                asks to draw them. Sorting reorders a permutation of row indices
+                rather than the rows themselves...
+*/
+
+// Multiple include protection...
+#ifndef _ANALYSISGRIDTABLE_H_
+#define _ANALYSISGRIDTABLE_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/grid.h>
+
+    // Standard libraries and STL...
+    #include <cstdint>
+    #include <vector>
+
+// AnalysisGridTable class...
+class AnalysisGridTable : public wxGridTableBase
+{
+    // Public methods...
+    public:
+
+        // Default constructor...
+        AnalysisGridTable();
+
+        // Accessors...
+
+            // Number of columns...
+            virtual int         GetNumberCols();
+
+            // Number of rows...
+            virtual int         GetNumberRows();
+
+            // Get a column's label...
+            virtual wxString    GetColLabelValue(int nColumn);
+
+            // Get the units shown after a column's values, if any...
+            wxString const     &GetColUnits(int const nColumn) const;
+
+            // Get a row's label, which follows its row when sorted...
+            virtual wxString    GetRowLabelValue(int nRow);
+
+            // Format a cell for display. Only called for visible cells...
+            virtual wxString    GetValue(int nRow, int nColumn);
+
+            // Get a cell's raw value, by displayed row... θ(1)
+            float               GetFloat(int nRow, int nColumn) const;
+
+            // Is the cell empty? Cells appended as NaN are...
+            virtual bool        IsEmptyCell(int nRow, int nColumn);
+
+        // Mutators...
+
+            // Add a column. Call before appending any rows...
+            void                AddColumn(wxString const &sLabel,
+                                          wxString const &sUnits);
+
+            // Queue a row for the given worm number with one value per column.
+            //  Use NaN for a value not measured. Grid isn't told until
+            //  Flush()... θ(1) amortized
+            void                AppendRow(uint32_t const unWorm,
+                                          float const *pValues);
+
+            // Forget every row, keeping the columns...
+            virtual void        Clear();
+
+            // Tell the grid about rows appended since the last flush...
+            void                Flush();
+
+            // Forget every row and column...
+            void                Reset();
+
+            // Cells can't be edited...
+            virtual void        SetValue(int nRow, int nColumn,
+                                         wxString const &sValue);
+
+            // Reorder the rows by a column, leaving equal rows in their
+            //  existing order... O(n log n)
+            void                Sort(int const nColumn, bool const bAscending);
+
+    // Protected types...
+    protected:
+
+        // A column's label and the units shown after each value...
+        typedef struct Column
+        {
+            wxString    sLabel;
+            wxString    sUnits;
+
+        }Column;
+
+    // Protected methods...
+    protected:
+
+        // Send a message to the grid, if attached...
+        void                    Notify(int const nMessage, int const nFirst,
+                                       int const nCount);
+
+    // Protected attributes...
+    protected:
+
+        // Columns...
+        std::vector<Column>     Columns;
+
+        // Worm number for each row, in appended order...
+        std::vector<uint32_t>   Worms;
+
+        // Every row's values back to back, in appended order...
+        std::vector<float>      Values;
+
+        // Appended row index for each displayed row. Rows appended since the
+        //  last flush aren't in here yet...
+        std::vector<uint32_t>   Order;
+};
+
+#endif
+
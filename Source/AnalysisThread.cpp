@@ -8,13 +8,81 @@
 #include "AnalysisThread.h"
 #include "MainFrame.h"
 #include "Experiment.h"
+#include "TrajectoryFile.h"
+#include <algorithm>
+
+// Fewest frames worth giving a thread of its own. Each stretch starts out not
+//  knowing the worms, and it takes a few frames for its tracker to settle...
+static unsigned int const MinimumChunkFrames = 1800;
+
+// Number of frames sampled from a stretch taking every unStride'th...
+static unsigned int SampledFrames(
+    unsigned int const unFirstFrame, unsigned int const unEndFrame,
+    unsigned int const unStride)
+{
+    return (unEndFrame > unFirstFrame) ?
+        (unEndFrame - unFirstFrame + unStride - 1) / unStride : 0;
+}
 
 // Analysis thread constructor locks UI...
 AnalysisThread::AnalysisThread(MainFrame &_Frame)
     : wxThread(wxTHREAD_DETACHED),
       Frame(_Frame),
-      pCapture(nullptr)
+      unReadAheadFrames(8),
+      unDecoderThreads(1),
+      dImageSequenceRate(0.0),
+      unParallelChunks(1),
+      dStartTime(0.0),
+      dEndTime(0.0),
+      unStride(1),
+      dTargetRate(0.0)
 {
+    // Variables...
+    wxConfig   &Configuration = *::wxGetApp().pConfiguration;
+
+    // Read the configuration here, it isn't safe from the thread...
+    long lReadAheadFrames = unReadAheadFrames;
+    Configuration.Read(
+        wxT("/Analysis/ReadAheadFrames"), &lReadAheadFrames, lReadAheadFrames);
+    unReadAheadFrames = (lReadAheadFrames > 0) ? lReadAheadFrames : 1;
+
+    // Image sequences are decoded on every processor, unless told otherwise,
+    //  and have no rate of their own, so need to be told it...
+    long lDecoderThreads = 0;
+    Configuration.Read(
+        wxT("/Analysis/DecoderThreads"), &lDecoderThreads, lDecoderThreads);
+    unDecoderThreads = (lDecoderThreads > 0) ?
+        lDecoderThreads : std::max(wxThread::GetCPUCount(), 1);
+    Configuration.Read(wxT("/Analysis/ImageSequenceRate"),
+                       &dImageSequenceRate, dImageSequenceRate);
+
+    // Only body size can be analyzed in pieces or at a lower rate. A stimulus
+    //  schedule runs from the start of the video and needs every frame to
+    //  place its stimuli and measure the responses...
+    if(Frame.ChosenAnalysisType->GetCurrentSelection() ==
+        MainFrame::ANALYSIS_BODY_SIZE)
+    {
+        // Split a long video across every processor, unless told
+        //  otherwise...
+        long lParallelChunks = 0;
+        Configuration.Read(
+            wxT("/Analysis/ParallelChunks"), &lParallelChunks, lParallelChunks);
+        unParallelChunks = (lParallelChunks > 0) ?
+            lParallelChunks : std::max(wxThread::GetCPUCount(), 1);
+
+        // Part of the video to analyze...
+        Configuration.Read(wxT("/Analysis/StartTime"), &dStartTime, 0.0);
+        Configuration.Read(wxT("/Analysis/EndTime"), &dEndTime, 0.0);
+        dStartTime  = std::max(dStartTime, 0.0);
+        dEndTime    = std::max(dEndTime, 0.0);
+
+        // How often to sample it...
+        long lStride = unStride;
+        Configuration.Read(wxT("/Analysis/Stride"), &lStride, lStride);
+        unStride = (lStride > 0) ? lStride : 1;
+        Configuration.Read(wxT("/Analysis/TargetRate"), &dTargetRate, 0.0);
+    }
+
     // Reset the tracker, if not already...
     Frame.Tracker.Reset(0);
     
@@ -31,10 +99,10 @@ void *AnalysisThread::Entry()
         wxArrayInt SelectedRows = Frame.MediaGrid->GetSelectedRows();
         int nRow = SelectedRows[0];
         
-        // Generate complete path...
-        wxString sPath = Frame.pExperiment->GetCachePath() +
-                         wxT("/media/") +
-                         Frame.MediaGrid->GetCellValue(nRow, MainFrame::TITLE);
+        // Generate complete path, extracting it from the experiment first
+        //  if it hasn't been yet...
+        wxString sPath = Frame.pExperiment->GetMediaPath(
+            Frame.MediaGrid->GetCellValue(nRow, MainFrame::TITLE));
 
     // Find the media...
     wxFileName MediaFile(sPath);
@@ -46,8 +114,12 @@ void *AnalysisThread::Entry()
     // Get the file extension...
     wxString sExtension = MediaFile.GetExt().Lower();
 
+    // It is a directory of images, or a pattern matching some...
+    if(ImageSequenceReader::IsSequence(sPath))
+        AnalyzeImageSequence(sPath);
+
     // It is a movie...
-    if(sExtension == wxT("mov")   ||
+    else if(sExtension == wxT("mov")   ||
        sExtension == wxT("avi")   ||
        sExtension == wxT("mpg")   ||
        sExtension == wxT("mpeg"))
@@ -56,6 +128,10 @@ void *AnalysisThread::Entry()
     // It is an image...
     else
         AnalyzeImage(sPath);
+
+    // Keep the trajectories with the experiment, even if cancelled part way...
+    SaveTrajectories(
+        Frame.pExperiment->GetTrajectoryPath(MediaFile.GetFullName()));
         
     // Done...
     return NULL;
@@ -67,24 +143,21 @@ void AnalysisThread::AnalyzeImage(wxString sPath)
     // Variables...
     wxString            sTemp;
 
-    // Reset the tracker, if not already...
+    // Reset the tracker, if not already. A still has no time to schedule
+    //  stimuli over...
     Frame.Tracker.Reset(0);
+    Frame.Tracker.SetFrameRate(0.0);
 
     // Load the image...
     //  2020/06/10 - updating to cv::IMREAD_* constants
     // and general C++ best practices
     //pGrayImage = cvLoadImage(sPath.mb_str(), CV_LOAD_IMAGE_GRAYSCALE);
     //pGrayImage = cvLoadImage(sPath.mb_str(), cv::IMREAD_GRAYSCALE);
-    
-    string sPathStr(sPath.mb_str());
-
-    cv::Mat matImage = cv::imread(sPathStr, cv::IMREAD_GRAYSCALE);
-    IplImage copyImg = cvIplImage(matImage);
-    IplImage *pGrayImage = &copyImg;
-     
+    cv::Mat const GrayImage = 
+        cv::imread(string(sPath.mb_str()), cv::IMREAD_GRAYSCALE);
 
         // Failed to load media...
-        if(!pGrayImage)
+        if(GrayImage.empty())
         {
             // Alert...
             wxLogError(wxT("Unable to load image. It may be in an unrecognized"
@@ -94,11 +167,100 @@ void AnalysisThread::AnalyzeImage(wxString sPath)
             return;
         }
 
-    // Feed into tracker...
-    Frame.Tracker.Advance(*pGrayImage);
-    
-    // Cleanup gray image...
-    cvReleaseImage(&pGrayImage);
+    // Feed into tracker. Nobody else has the image, so it can keep it...
+    Frame.Tracker.Advance(GrayImage);
+}
+
+// Analyze a sequence of images...
+void AnalysisThread::AnalyzeImageSequence(wxString sPath)
+{
+    // Variables...
+    ImageSequenceReader     Reader(
+        std::max(unReadAheadFrames, unDecoderThreads), unDecoderThreads);
+    cv::Mat                 GrayImage;
+    unsigned int            unSampleStride  = unStride;
+    unsigned int            unFirstFrame    = 0;
+    unsigned int            unFrame         = 0;
+
+    // Place the part to analyze on frames, and how often to sample it. Times
+    //  and rates need to know the rate the images were taken at...
+    if(dImageSequenceRate > 0.0)
+    {
+        // From the frame showing at the start time...
+        unFirstFrame = (unsigned int) (dStartTime * dImageSequenceRate);
+
+        // Whatever stride gets closest to the target rate...
+        if(dTargetRate > 0.0)
+            unSampleStride = std::max((unsigned int)
+                (dImageSequenceRate / dTargetRate + 0.5), 1U);
+    }
+
+    // Without it, only the stride can be honoured...
+    else if(dStartTime > 0.0 || dEndTime > 0.0 || dTargetRate > 0.0)
+        wxLogWarning(wxT("The rate this image sequence was taken at is not"
+                         " known, so it will be analyzed from start to end"
+                         " at its full rate."));
+
+    // List the images and start decoding ahead...
+    if(!Reader.Open(sPath, unFirstFrame, unSampleStride))
+    {
+        // Alert...
+        wxLogError(wxT("There are no images in this sequence that can be"
+                       " read from the start time chosen for analysis."));
+
+        // Abort...
+        return;
+    }
+
+    // Up to and including the one showing at the end time...
+    unsigned int unEndFrame = Reader.GetTotalFrames();
+    if(dImageSequenceRate > 0.0 && dEndTime > 0.0)
+        unEndFrame = std::min(
+            (unsigned int) (dEndTime * dImageSequenceRate) + 1, unEndFrame);
+
+    // Every image was listed, so we know exactly how many there will be...
+    unsigned int const unFrames =
+        SampledFrames(unFirstFrame, unEndFrame, unSampleStride);
+
+        // Nothing in it...
+        if(unFrames == 0)
+        {
+            // Alert...
+            wxLogError(wxT("There is nothing in this media between the start"
+                           " and end times chosen for analysis."));
+
+            // Abort...
+            return;
+        }
+
+    // Reset the tracker, expecting every one...
+    Frame.Tracker.Reset(unFrames);
+    Frame.Tracker.SetFrameNumbering(unFirstFrame, unSampleStride);
+
+    // Stimuli are scheduled in seconds, so the tracker needs the frame rate.
+    //  That is of the frames it sees...
+    Frame.Tracker.SetFrameRate(dImageSequenceRate / unSampleStride);
+
+    // Start the analysis stop watch...
+    StatusUpdateStopWatch.Start();
+
+    // Keep showing images until there are no more or cancel requested. The
+    //  tracker holds onto each frame as with a video...
+    while(unFrame < unFrames && !TestDestroy() && Reader.Read(GrayImage))
+    {
+        Frame.Tracker.Advance(GrayImage);
+      ++unFrame;
+    }
+
+    // Stop decoding, if we didn't get to the end...
+    Reader.Stop();
+
+    // Ran out early, so one of them couldn't be read...
+    if(unFrame < unFrames && !TestDestroy())
+        wxLogWarning(wxT("Analysis stopped at image %u of %u, which could"
+                         " not be read."),
+                     unFirstFrame + unFrame * unSampleStride + 1,
+                     Reader.GetTotalFrames());
 }
 
 // Analyze video...
@@ -107,92 +269,172 @@ void AnalysisThread::AnalyzeImage(wxString sPath)
 void AnalysisThread::AnalyzeVideo(wxString sPath)
 {
     // Variables...
-    IplImage           *pGrayImage              = NULL;
-    wxString            sTemp;
-    cv::VideoCapture	slitherCap;
-
-    // Initialize capture from AVI...
-    //  2020/06/10 - renamed function for OpenCV4
-    pCapture = cvCreateFileCapture(sPath.fn_str());
-
-        // Failed to load media...
-        if(!pCapture)
+    VideoReader             Reader(unReadAheadFrames);
+    MediaIndex              Index;
+    vector<AnalysisChunk *> Chunks;
+    vector<unsigned int>    Boundaries;
+    cv::Mat                 GrayImage;
+    unsigned int            unSampleStride  = unStride;
+    unsigned int            unFirstFrame    = 0;
+    unsigned int            unEndFrame      = 0;
+    unsigned int            unFrame         = 0;
+    wxString                sTemp;
+
+    // Get its frame index, made when it was imported, to know its length and
+    //  where its keyframes are. It can still be analyzed without one...
+    Frame.LoadMediaIndex(wxFileName(sPath).GetFullName(), Index);
+
+    // Place the part to analyze on frames, and how often to sample it. Times
+    //  and rates need the index...
+    if(Index.IsOk())
+    {
+        // From the frame showing at the start time up to and including the
+        //  one showing at the end time...
+        unEndFrame = Index.Frames();
+        if(dStartTime > 0.0)
+            unFirstFrame = Index.FrameAtTime(dStartTime * 1000.0);
+        if(dEndTime > 0.0)
+            unEndFrame = std::min(
+                Index.FrameAtTime(dEndTime * 1000.0) + 1, unEndFrame);
+
+        // Nothing in it...
+        if(unFirstFrame >= unEndFrame)
         {
             // Alert...
-            wxLogError(wxT("Your system does not appear to have an suitable"
-                           " codec installed to read this media."));
-            
+            wxLogError(wxT("There is nothing in this media between the start"
+                           " and end times chosen for analysis."));
+
             // Abort...
             return;
         }
 
-    // Reset the tracker, if not already...
-    //  2020/06/10 - I think the new constant needs to be used
-    Frame.Tracker.Reset((unsigned int) 
-        cvGetCaptureProperty(pCapture, cv::CAP_PROP_FRAME_COUNT));
+        // Whatever stride gets closest to the target rate...
+        if(dTargetRate > 0.0 && Index.GetFramesPerSecond() > 0.0)
+            unSampleStride = std::max((unsigned int)
+                (Index.GetFramesPerSecond() / dTargetRate + 0.5), 1U);
+    }
+
+    // Without one, only the stride can be honoured...
+    else if(dStartTime > 0.0 || dEndTime > 0.0 || dTargetRate > 0.0)
+        wxLogWarning(wxT("This media could not be indexed, so it will be"
+                         " analyzed from start to end at its full rate."));
+
+    // Start decoding ahead...
+    if(!Reader.Open(sPath, unFirstFrame, &Index, unSampleStride))
+    {
+        // Alert...
+        wxLogError(wxT("Your system does not appear to have an suitable"
+                       " codec installed to read this media."));
+        
+        // Abort...
+        return;
+    }
+
+    // Without an index, the container's length is all we have to go on...
+    if(!Index.IsOk())
+        unEndFrame = Reader.GetTotalFrames();
+
+    // Split it into roughly even stretches, if it's long enough to be worth
+    //  it. Without a length we can only go through it from the start. Nor
+    //  with stimuli scheduled, since each stretch would time them from its
+    //  own start and responses aren't stitched...
+    unsigned int const unChunks = Frame.Tracker.IsMeasuringStimuli() ? 1U :
+        std::max(std::min(unParallelChunks,
+            SampledFrames(unFirstFrame, unEndFrame, unSampleStride) /
+                MinimumChunkFrames), 1U);
+
+        // Each starts on whichever keyframe is closest, so none has to decode
+        //  its way forward from the one before. Stretches too short for a
+        //  keyframe of their own are folded into the one before...
+        Boundaries.push_back(unFirstFrame);
+        for(unsigned int unChunk = 1; unChunk < unChunks; ++unChunk)
+        {
+            unsigned int const unBoundary = Index.NearestKeyframe(
+                unFirstFrame + (unsigned int) ((unsigned long long)
+                    (unEndFrame - unFirstFrame) * unChunk / unChunks));
+            if(unBoundary > Boundaries.back() && unBoundary < unEndFrame)
+                Boundaries.push_back(unBoundary);
+        }
+        Boundaries.push_back(std::max(unEndFrame, unFirstFrame));
+
+    // Reset the tracker, if not already. It only does the first stretch...
+    Frame.Tracker.Reset(
+        SampledFrames(Boundaries[0], Boundaries[1], unSampleStride));
+    Frame.Tracker.SetFrameNumbering(Boundaries[0], unSampleStride);
+
+    // Stimuli are scheduled in seconds, so the tracker needs the frame rate.
+    //  That is of the frames it sees...
+    Frame.Tracker.SetFrameRate(Reader.GetFramesPerSecond() / unSampleStride);
+
+    // Start every other stretch on a thread of its own, each from a seek...
+    for(unsigned int unChunk = 1; unChunk + 1 < Boundaries.size(); ++unChunk)
+    {
+        // Create...
+        AnalysisChunk *pChunk = new AnalysisChunk(
+            Frame.Tracker, sPath, &Index, Boundaries[unChunk],
+            SampledFrames(Boundaries[unChunk], Boundaries[unChunk + 1],
+                          unSampleStride),
+            unSampleStride, unReadAheadFrames);
+        Chunks.push_back(pChunk);
+
+        // Couldn't seek or start a thread, so go through it all from here...
+        if(!pChunk->Start())
+        {
+            // Stop and forget every stretch...
+            for(unsigned int unStarted = 0; unStarted < Chunks.size();
+              ++unStarted)
+            {
+                Chunks[unStarted]->Delete();
+                delete Chunks[unStarted];
+            }
+            Chunks.clear();
+
+            // Expect every frame...
+            Boundaries.resize(1);
+            Boundaries.push_back(std::max(unEndFrame, unFirstFrame));
+            Frame.Tracker.Reset(
+                SampledFrames(Boundaries[0], Boundaries[1], unSampleStride));
+            Frame.Tracker.SetFrameNumbering(Boundaries[0], unSampleStride);
+            break;
+        }
+    }
 
     // Start the analysis stop watch...
     StatusUpdateStopWatch.Start();
 
-    // Keep showing media until there is nothing left or cancel requested...
-    while(!TestDestroy())
+    // Keep showing media until there is nothing left of our stretch or cancel
+    //  requested. The tracker holds onto each frame for as long as its
+    //  thinking displays need it, and then the buffer goes back to the
+    //  reader's pool. Without a length, go until the media runs out...
+    unsigned int const unFrames =
+        SampledFrames(Boundaries[0], Boundaries[1], unSampleStride);
+    while((unEndFrame == 0 || unFrame < unFrames) &&
+          !TestDestroy() && Reader.Read(GrayImage))
     {
-        // Retrieve the captured image...
-        IplImage const *pOriginalImage = cvQueryFrame(pCapture);
-        
-            // There are no more...
-            if(!pOriginalImage)
-                break;
-
-        // The Quicktime backend appears to be buggy in that it keeps cycling
-        //  through the video even after we have all frames. A temporary hack
-        //  is to just break the analysis loop when we have both current frame, 
-        //  total frame, and they are equal...
-        #ifdef __APPLE__
-
-            // Get current position...
-	    //  2020/06/10 - updating to new constants in OpenCV4
-            int const nCurrentFrame = (int) 
-                cvGetCaptureProperty(pCapture, cv::CAP_PROP_POS_FRAMES);
-
-            // Get total number of frames...
-            int const nTotalFrames = (int) 
-                cvGetCaptureProperty(pCapture, CV_CAP_PROP_FRAME_COUNT);
-
-            // Reached the end...
-            if(nCurrentFrame + 1 == nTotalFrames)
-                break;
-
-        #endif
-
-	// 2020/06/10 - converting to C++ API using cv::Mat
-        // The tracker prefers grayscale 8-bit unsigned format, prepare...
-	
-	    cv::Mat pOriginalMatImage = cv::cvarrToMat(pOriginalImage); 
-	    cv::Mat pGrayMatImage(cvGetSize(pOriginalImage), CV_8UC1);
-	    //convert to grayscale
-	    cv::cvtColor(pOriginalMatImage, pGrayMatImage, CV_8UC1);
-            // Allocate blank grayscale image...
-            //pGrayImage = 
-            //    cvCreateImage(cvGetSize(pOriginalImage), IPL_DEPTH_8U, 1);
-
-            // Convert original to grayscale...
-            //cvConvertImage(pOriginalImage, pGrayImage);
-	    
-	      
-	    //replace pGrayImage
-	    IplImage copyGrayImg = cvIplImage(pGrayMatImage);
-	    pGrayImage = &copyGrayImg;
-        
-	// Feed into tracker...
-        Frame.Tracker.Advance(*pGrayImage);
-        
-        // Cleanup gray image...
-        cvReleaseImage(&pGrayImage);
+        Frame.Tracker.Advance(GrayImage);
+      ++unFrame;
     }
 
-    // Release the capture source...
-    cvReleaseCapture(&pCapture);
+    // Stop decoding, if we didn't get to the end...
+    Reader.Stop();
+
+    // Carry on with each of the other stretches in turn, once it's done...
+    for(unsigned int unChunk = 0; unChunk < Chunks.size(); ++unChunk)
+    {
+        // Cancelled, so don't wait for it to finish...
+        if(TestDestroy())
+            Chunks[unChunk]->Delete();
+
+        // Wait for it and stitch its tracks onto ours...
+        else
+        {
+            Chunks[unChunk]->Wait();
+            Frame.Tracker.Stitch(Chunks[unChunk]->GetTracker());
+        }
+
+        // Done with it...
+        delete Chunks[unChunk];
+    }
 }
 
 // Analysis thread exitting callback...
@@ -212,3 +454,17 @@ void AnalysisThread::OnExit()
         wxPostEvent(&Frame, Event);
 }
 
+// Write the tracker's trajectories out where the experiment will save them...
+void AnalysisThread::SaveTrajectories(wxString const &sPath)
+{
+    // Nothing was recorded...
+    if(Frame.Tracker.GetTrajectories().Rows() == 0)
+        return;
+
+    // Write it out...
+    if(!TrajectoryFile::Write(string(sPath.fn_str()), 
+                              Frame.Tracker.GetTrajectories(),
+                              Frame.Tracker.GetSnapshot()->dMillimetersPerPixel))
+        wxLogError(wxT("Unable to save trajectories to ") + sPath);
+}
+
@@ -30,6 +30,18 @@
     // Worm tracker...
     #include "WormTracker.h"
 
+    // Read ahead video decoder...
+    #include "VideoReader.h"
+
+    // Read ahead image sequence decoder...
+    #include "ImageSequenceReader.h"
+
+    // Stretch of a video analyzed on its own thread...
+    #include "AnalysisChunk.h"
+
+    // Standard libraries and STL...
+    #include <vector>
+
 // Forward declarations...
 class MainFrame;
 
@@ -52,6 +64,10 @@ class AnalysisThread : public wxThread
             // Analyze single image...
             void AnalyzeImage(wxString sPath);
 
+            // Analyze a sequence of images, given as a directory or wildcard
+            //  pattern...
+            void AnalyzeImageSequence(wxString sPath);
+
             // Analyze video...
             void AnalyzeVideo(wxString sPath);
 
@@ -61,6 +77,9 @@ class AnalysisThread : public wxThread
             // Analysis thread exit callback...
             void OnExit();
 
+            // Write the tracker's trajectories out to the given file...
+            void SaveTrajectories(wxString const &sPath);
+
     // Protected members...
     protected:
 
@@ -70,8 +89,27 @@ class AnalysisThread : public wxThread
         // Pointer to main frame to render on...
         MainFrame          &Frame;
 
-        // Capture handle...
-        CvCapture          *pCapture;
+        // Frames to decode ahead of the tracker...
+        unsigned int        unReadAheadFrames;
+
+        // Threads to decode an image sequence with, and the rate it was
+        //  taken at, zero if unknown...
+        unsigned int        unDecoderThreads;
+        double              dImageSequenceRate;
+
+        // Most stretches to split a long video into and analyze at once...
+        unsigned int        unParallelChunks;
+
+        // Part of a video to analyze, in seconds from the start. An end of
+        //  zero is the end of the video...
+        double              dStartTime;
+        double              dEndTime;
+
+        // Analyze only every unStride'th frame, or if a target analysis
+        //  rate in frames per second is given, whatever stride comes
+        //  closest to that...
+        unsigned int        unStride;
+        double              dTargetRate;
 
 };
 
@@ -9,88 +9,228 @@
 #include "MainFrame.h"
 #include "Experiment.h"
 #include <wx/dcbuffer.h>
+#include <wx/stdpaths.h>
 
+    #include <algorithm>
     #include <cstdio>
+    #include <string>
 
 using namespace cv;
 // Capture thread constructor...
 CaptureThread::CaptureThread(MainFrame *_pMainFrame)
     : wxThread(wxTHREAD_DETACHED),
-      pMainFrame(_pMainFrame)
+      pMainFrame(_pMainFrame),
+      pSource(NULL),
+      bRecord(true),
+      bLiveTracking(false),
+      nFourCC(cv::VideoWriter::fourcc('M', 'J', 'P', 'G')),
+      dMaxLatency(1.0)
 {
+    // Variables...
+    wxConfig   &Configuration   = *::wxGetApp().pConfiguration;
+    long        lBufferFrames   = 8;
+    bool        bReplay         = true;
+    double      dReplayRate     = 30.0;
+    wxString    sDropPolicy;
+    wxString    sCodec;
+    wxString    sDirectory;
+
+    // Read the configuration here, it isn't safe from the thread...
+
+        // Where to capture from, whether to replay at the nominal rate, and
+        //  the rate for sources without one of their own...
+        Configuration.Read(wxT("/Capture/Source"), &sSource, wxT("camera:0"));
+        Configuration.Read(wxT("/Capture/Replay"), &bReplay, bReplay);
+        Configuration.Read(
+            wxT("/Capture/ReplayRate"), &dReplayRate, dReplayRate);
+
+        // Whether to record at all...
+        Configuration.Read(wxT("/Capture/Record"), &bRecord, bRecord);
 
+        // Where to, named after when. Each capture gets its own file...
+        Configuration.Read(wxT("/Capture/RecordingDirectory"), &sDirectory,
+                           wxStandardPaths::Get().GetDocumentsDir());
+        sRecordingPath = sDirectory + wxFileName::GetPathSeparator() +
+            wxDateTime::Now().Format(wxT("Capture %Y-%m-%d %H-%M-%S.avi"));
+
+        // Codec, as its four character code. RAW records uncompressed...
+        Configuration.Read(wxT("/Capture/Codec"), &sCodec, wxT("MJPG"));
+        if(sCodec.IsSameAs(wxT("RAW"), false))
+            nFourCC = 0;
+        else if(sCodec.Length() == 4)
+        {
+            std::string const sFourCC(sCodec.mb_str());
+            nFourCC = cv::VideoWriter::fourcc(
+                sFourCC[0], sFourCC[1], sFourCC[2], sFourCC[3]);
+        }
+
+        // Longest a frame may wait to be encoded before it is shed...
+        Configuration.Read(
+            wxT("/Capture/MaxLatency"), &dMaxLatency, dMaxLatency);
+
+        // Frames to hold while the codec catches up, and which to drop when
+        //  it doesn't...
+        Configuration.Read(
+            wxT("/Capture/BufferFrames"), &lBufferFrames, lBufferFrames);
+        Configuration.Read(
+            wxT("/Capture/DropPolicy"), &sDropPolicy, wxT("Oldest"));
+
+    // Make the source. It isn't opened until the thread runs...
+    pSource = FrameSource::Create(sSource, dReplayRate);
+    if(pSource)
+        pSource->SetReplay(bReplay);
+
+    // Make the frame ring, or none at all if there is no one to consume
+    //  it. Neither side is running yet...
+    pMainFrame->CaptureFrameBuffer.Configure(
+        bRecord ? std::max(lBufferFrames, 1L) : 0,
+        sDropPolicy.IsSameAs(wxT("Newest"), false) ?
+            RingBuffer<CapturedFrame>::DROP_NEWEST :
+            RingBuffer<CapturedFrame>::DROP_OLDEST);
+
+    // Feed the live tracker too, if it was started. The main frame reset
+    //  the preview and what the live tracker reads before starting either
+    //  side...
+    bLiveTracking = (pMainFrame->pLiveTrackingThread != NULL);
 }
         
 // Thread entry point...
 void *CaptureThread::Entry()
 {
-    // Variables...
-    cv::Mat   pOriginalIntelImage;
-    cv::Mat   *pClonedIntelImage = NULL;
-
-    /* TODO: Allow user to pick which camera, if more than one detected.
+    /* TODO: Allow user to pick which camera from the user interface, if more
+             than one detected, rather than only by /Capture/Source.
              http://opencvlibrary.sourceforge.net/faq#head-3921717fef168800c43a822b03ca241ce8e9cc6d */
 
-    // Initialize live capture from camera, then re-enable capture button...
-    VideoCapture pCapture(0);
+    // Open the source, then re-enable capture button...
+    bool const bOpened = pSource && pSource->Open();
     pMainFrame->GetToolBar()->EnableTool(MainFrame::ID_CAPTURE, true);
 
-        // Failed to connect to camera...
-        if(!pCapture.isOpened())
+        // Failed to connect to camera, or whatever else was configured...
+        if(!bOpened)
         {
             // Alert...
             printf("cvCreateCameraCapture failed (%d)\n", cvGetErrStatus());
-            wxLogError(wxT("I can't capture from your camera. Check to make"
-                           " sure that it is plugged in, powered on, and the"
-                           " drivers are installed and working.\n\n"
-                           
-                           "If you have successfully captured from the camera"
-                           " already, it may just be a buggy driver."));
+            if(pSource && pSource->IsLive())
+                wxLogError(wxT("I can't capture from your camera. Check to"
+                               " make sure that it is plugged in, powered on,"
+                               " and the drivers are installed and working."
+                               "\n\n"
+
+                               "If you have successfully captured from the"
+                               " camera already, it may just be a buggy"
+                               " driver."));
+            else
+                wxLogError(wxT("I can't capture from \"%s\". Check the"
+                               " capture source in the configuration."),
+                           sSource.c_str());
 
             // Cleanup, abort...
+            delete pSource;
+            pSource = NULL;
             pMainFrame->CaptureTimer.Stop();
             pMainFrame->GetToolBar()->ToggleTool(MainFrame::ID_CAPTURE, false);
+
+            // Let the main frame stop the live tracker, in a thread safe
+            //  way...
+            wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                                 MainFrame::ID_CAPTURE_ENDED);
+            wxPostEvent(pMainFrame, Event);
             return NULL;
         }
 
+    // Note the source's frame rate for the recording...
+    double const dFramesPerSecond = pSource->GetFramesPerSecond();
+
+    // Start recording, unless asked not to...
+    RecordingThread *pRecordingThread = NULL;
+    if(bRecord)
+    {
+        // Start...
+        pRecordingThread = new RecordingThread(
+            pMainFrame->CaptureFrameBuffer, sRecordingPath, nFourCC,
+            dMaxLatency);
+        if(!pRecordingThread->Start())
+        {
+            // Alert...
+            wxLogError(wxT("Unable to start the RecordingThread..."));
+
+            // Carry on without...
+            delete pRecordingThread;
+            pRecordingThread = NULL;
+        }
+    }
+
+    // The frame, if it isn't being recorded. Buffer reused each time...
+    cv::Mat FrameImage;
+
     // Keep showing live feed as long there are frames and the capture button
     //  remains toggled...
-    while(pCapture.grab() &&
-          pMainFrame->GetToolBar()->GetToolState(MainFrame::ID_CAPTURE))
+    for(unsigned int unFrame = 0;
+        pSource->Grab() &&
+        pMainFrame->GetToolBar()->GetToolState(MainFrame::ID_CAPTURE);
+      ++unFrame)
     {
-        // Retrieve the captured frame we just grabbed and check for error...
-        //pOriginalIntelImage = cvRetrieveFrame(pCapture);
+        // Slot to record the frame in, unless not recording, or the ring is
+        //  full and this frame has to be dropped...
+        CapturedFrame *pFrame = pRecordingThread ?
+            pMainFrame->CaptureFrameBuffer.Back() : NULL;
 
-	pCapture.retrieve(pOriginalIntelImage);
-
-        // Make our own internal copy to modify...
-	if (pClonedIntelImage)
-	    delete pClonedIntelImage;
-	
-	pClonedIntelImage = new cv::Mat();
-	*pClonedIntelImage = pOriginalIntelImage.clone();
+        // Retrieve the captured frame we just grabbed straight into the
+        //  ring's slot if recording it, otherwise into our own, reusing
+        //  whatever buffer it had last time around...
+        cv::Mat &Image = pFrame ? pFrame->Image : FrameImage;
+        if(!pSource->Retrieve(Image))
+            break;
+        double const dCaptureTime = RecordingThread::Now();
 
         // Perform post processing...
-        PerformPostProcessing(pClonedIntelImage);
-        
+        PerformPostProcessing(&Image);
+
+        // Hand the frame to the recording thread...
+        if(pFrame)
+        {
+            // Stamp it...
+            pFrame->unFrame             = unFrame;
+            pFrame->dCaptureTime        = dCaptureTime;
+            pFrame->dFramesPerSecond    = dFramesPerSecond;
+
+            // Hand it over...
+            pMainFrame->CaptureFrameBuffer.Publish();
+        }
+
+        // Hand a copy to the live tracker as the newest, replacing any it
+        //  hasn't got to yet...
+        if(bLiveTracking)
+        {
+            // Copy and stamp it...
+            CapturedFrame &LiveFrame = pMainFrame->LiveFrames.Back();
+            Image.copyTo(LiveFrame.Image);
+            LiveFrame.unFrame           = unFrame;
+            LiveFrame.dCaptureTime      = dCaptureTime;
+            LiveFrame.dFramesPerSecond  = dFramesPerSecond;
+
+            // Hand it over...
+            pMainFrame->LiveFrames.Publish();
+        }
+
         // Show the OSD over the frame...
-        //ShowOnScreenDisplay(pClonedIntelImage);
-        
-        // Add frame to capture frame buffer...
-        pMainFrame->CaptureFrameBuffer.push_back(pClonedIntelImage);
+        //ShowOnScreenDisplay(&Image);
+
+        // Make the preview and hand it to the capture timer...
+        PreparePreview(Image, pMainFrame->CapturePreview.Back());
+        pMainFrame->CapturePreview.Publish();
     }
 
-    // Flush the capture frame queue...
-    while(!pMainFrame->CaptureFrameBuffer.empty())
+    // Finish the recording...
+    if(pRecordingThread)
     {
-        // Deallocate oldest...
-        pClonedIntelImage = pMainFrame->CaptureFrameBuffer.front();
-        pMainFrame->CaptureFrameBuffer.pop_front();
-        //cvReleaseImage(&pClonedIntelImage);
+        pRecordingThread->Stop();
+        delete pRecordingThread;
     }
 
     // Release the capture source...
-    pCapture.release();
+    delete pSource;
+    pSource = NULL;
 
     // Repaint the capture image panel...
     wxMutexGuiEnter(); 
@@ -100,10 +240,15 @@ void *CaptureThread::Entry()
     // Stop the timer...
     pMainFrame->CaptureTimer.Stop();
 
-    // Untoggle the capture button...
+    // Untoggle the capture button, and let it be pressed again now that we
+    //  are done with the frame ring and preview...
     pMainFrame->GetToolBar()->ToggleTool(MainFrame::ID_CAPTURE, false);
-    
-    delete pClonedIntelImage;
+    pMainFrame->GetToolBar()->EnableTool(MainFrame::ID_CAPTURE, true);
+
+    // Let the main frame stop the live tracker, in a thread safe way...
+    wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                         MainFrame::ID_CAPTURE_ENDED);
+    wxPostEvent(pMainFrame, Event);
 
     // Done...
     return NULL;
@@ -115,6 +260,36 @@ void CaptureThread::PerformPostProcessing(cv::Mat *pIntelImage)
     // Stubbed...
 }
 
+// Scale a frame to the capture pane and convert it to RGB...
+void CaptureThread::PreparePreview(cv::Mat const &Image,
+                                   CapturePreviewFrame &Preview)
+{
+    // Size the panel was last time the user interface looked...
+    int const nWidth = pMainFrame->nCapturePreviewWidth.load(
+        std::memory_order_relaxed);
+    int const nHeight = pMainFrame->nCapturePreviewHeight.load(
+        std::memory_order_relaxed);
+
+    // Nowhere to show it...
+    if(nWidth <= 0 || nHeight <= 0)
+    {
+        Preview.Image.release();
+        return;
+    }
+
+    // Scale first, so the conversion has fewer pixels to do. Area
+    //  interpolation averages every source pixel into the smaller image,
+    //  which is as good as it gets for shrinking, and is vectorized...
+    cv::resize(Image, ScaledImage, cv::Size(nWidth, nHeight), 0, 0,
+               cv::INTER_AREA);
+
+    // Convert into what wxWidgets expects, reusing the slot's buffer...
+    cv::cvtColor(ScaledImage, Preview.Image,
+                 (ScaledImage.channels() == 1) ?
+                    cv::COLOR_GRAY2RGB : cv::COLOR_BGR2RGB);
+    Preview.FrameSize = Image.size();
+}
+
 // Show the OSD over the frame...
 void CaptureThread::ShowOnScreenDisplay(IplImage *pIntelImage)
 {
@@ -19,9 +19,26 @@
     #include <opencv2/imgproc/imgproc.hpp>
     #include <opencv2/imgproc/imgproc_c.h>
 
+    // Recording thread...
+    #include "RecordingThread.h"
+
+    // Where frames come from...
+    #include "FrameSource.h"
+
 // Forward declarations...
 class MainFrame;
 
+// A captured frame made ready for the capture pane...
+typedef struct CapturePreviewFrame
+{
+    // 8-bit RGB, scaled to the panel as it was when made...
+    cv::Mat         Image;
+
+    // Size of the frame it was made from...
+    cv::Size        FrameSize;
+
+}CapturePreviewFrame;
+
 // CaptureThread class...
 class CaptureThread : public wxThread
 {
@@ -37,6 +54,11 @@ class CaptureThread : public wxThread
         // Perform post processing...
         void PerformPostProcessing(cv::Mat *pIntelImage);
 
+        // Scale a frame to the capture pane and convert it to RGB, so the
+        //  user interface only has to blit it...
+        void PreparePreview(cv::Mat const &Image,
+                            CapturePreviewFrame &Preview);
+
         // Show the OSD over the frame...
         void ShowOnScreenDisplay(IplImage *pIntelImage);
 
@@ -45,6 +67,24 @@ class CaptureThread : public wxThread
 
         // Pointer to main frame to render on...
         MainFrame      *pMainFrame;
+
+        // Where frames come from, NULL if the configured source isn't one
+        //  we know. Opened on the thread, released when it finishes...
+        FrameSource    *pSource;
+        wxString        sSource;
+
+        // Whether to record, and feed the live tracker...
+        bool            bRecord;
+        bool            bLiveTracking;
+
+        // Where to record, and how...
+        wxString        sRecordingPath;
+        int             nFourCC;
+        double          dMaxLatency;
+
+        // Frame scaled for the preview, before converting. Buffer reused
+        //  each time...
+        cv::Mat         ScaledImage;
 };
 
 #endif
@@ -6,14 +6,20 @@
 
 // Includes...
 #include "Experiment.h"
+#include <sys/stat.h>
 
 // Constructor...
 Experiment::Experiment(MainFrame *_pMainFrame)
     :   pMainFrame(_pMainFrame),
         sPath(wxEmptyString),
         sCachePath(wxEmptyString),
+        pArchive(new ExperimentArchive),
         bLoadOk(true),
-        bNeedSave(false)
+        bNeedSave(false),
+        pSaveThread(NULL),
+        unSavingRevision(0),
+        unRevision(0),
+        pMediaImporter(NULL)
 {
     // Fill in UI elements with default values...
     pMainFrame->ExperimentTitle->ChangeValue(wxT("My New Experiment"));
@@ -80,6 +86,7 @@ wxString Experiment::CreateTempDirectory() const
     // Create skeleton subdirectory structure...
     wxFileName::Mkdir(sCheckCachePath + wxT("/control/"));
     wxFileName::Mkdir(sCheckCachePath + wxT("/media/"));
+    wxFileName::Mkdir(sCheckCachePath + wxT("/analysis/"));
 
     // Return directory to caller...
     return sCheckCachePath;
@@ -126,6 +133,245 @@ void Experiment::EnableUI(bool bEnable, bool bReset)
     }
 }
 
+// Extract a file, or every file under a directory, from the archive into the
+//  cache...
+bool Experiment::ExtractFromArchive(wxString const &sName)
+{
+    // Variables...
+    bool                                bSuccessful = true;
+    std::vector<wxString>               Names;
+    std::vector<std::string>            Members;
+    std::shared_ptr<ExperimentArchive>  pSource;
+
+    // Find what's left of it in the archive, and hold on to that archive...
+    {
+        // Lock...
+        wxMutexLocker Lock(ArchiveMutex);
+
+        // Find...
+        FindUnextracted(sName, Names);
+        for(size_t Index = 0; Index < Names.size(); ++Index)
+            Members.push_back(Unextracted[Names[Index]]);
+        pSource = pArchive;
+    }
+
+    // Extract each. This can take a while, so it's done unlocked into a file
+    //  of its own, and only moved into place if nobody else already has. Those
+    //  are kept to the side, out of the way of anything listing the cache in
+    //  the meantime...
+    wxString const sExtracting = sCachePath + wxT("/extracting");
+    if(!Names.empty())
+        wxFileName::Mkdir(sExtracting, wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL);
+    for(size_t Index = 0; Index < Names.size(); ++Index)
+    {
+        // Find it in the archive...
+        ExperimentArchive::Entry const *pMember =
+            pSource->Find(Members[Index]);
+
+        // Make sure it has somewhere to go...
+        wxString const sDestination = sCachePath + wxT("/") + Names[Index];
+        wxFileName::Mkdir(wxFileName(sDestination).GetPath(), wxS_DIR_DEFAULT,
+                          wxPATH_MKDIR_FULL);
+
+        // Extract it to the side...
+        wxString const sTemporary =
+            wxFileName::CreateTempFileName(sExtracting + wxT("/"));
+        if(!pMember || sTemporary.IsEmpty() ||
+           !pSource->Extract(*pMember, std::string(sTemporary.fn_str())))
+        {
+            // Log it and try the next...
+            wxLogError(wxT("Unable to extract from experiment: ") +
+                       Names[Index]);
+            if(!sTemporary.IsEmpty())
+                wxRemoveFile(sTemporary);
+            bSuccessful = false;
+            continue;
+        }
+
+        // Lock...
+        wxMutexLocker Lock(ArchiveMutex);
+
+        // Extracted by someone else meanwhile, or removed or renamed. A save
+        //  in between only moves entries, so what's still waiting under this
+        //  name is what was just extracted...
+        if(!Unextracted.count(Names[Index]))
+        {
+            wxRemoveFile(sTemporary);
+            continue;
+        }
+
+        // Move it into place...
+        if(!wxRenameFile(sTemporary, sDestination, true))
+        {
+            // Log it and try the next...
+            wxLogError(wxT("Unable to extract from experiment: ") +
+                       Names[Index]);
+            wxRemoveFile(sTemporary);
+            bSuccessful = false;
+            continue;
+        }
+
+        // It's in the cache now, the same as in the archive until it's
+        //  changed...
+        RememberArchived(Names[Index], Unextracted[Names[Index]]);
+        Unextracted.erase(Names[Index]);
+    }
+
+    // Done...
+    return bSuccessful;
+}
+
+// Find the archive entry a file in the cache still has the same contents
+//  as...
+bool Experiment::FindArchived(
+    wxString const &sName, std::string &sMember) const
+{
+    // Variables...
+    struct stat Status;
+
+    // Never was the same as any...
+    std::map<wxString, ArchivedFile>::const_iterator Found =
+        Extracted.find(sName);
+    if(Found == Extracted.end())
+        return false;
+
+    // It's changed since...
+    wxString const sCachedPath = sCachePath + wxT("/") + sName;
+    if(stat(sCachedPath.fn_str(), &Status) != 0 ||
+       static_cast<uint64_t>(Status.st_size) != Found->second.ulSize ||
+       Status.st_mtime != Found->second.Modified)
+        return false;
+
+    // Still the same...
+    sMember = Found->second.sMember;
+    return true;
+}
+
+// Find what is still in the archive of a file, or every file under a
+//  directory...
+void Experiment::FindUnextracted(
+    wxString const &sName, std::vector<wxString> &Names) const
+{
+    // Start over...
+    Names.clear();
+
+    // The file itself...
+    if(Unextracted.count(sName))
+        Names.push_back(sName);
+
+    // Anything under it, which sort together...
+    wxString const sDirectory = sName + wxT("/");
+    for(std::map<wxString, std::string>::const_iterator Pending =
+            Unextracted.lower_bound(sDirectory);
+        Pending != Unextracted.end() && Pending->first.StartsWith(sDirectory);
+      ++Pending)
+        Names.push_back(Pending->first);
+}
+
+// Wait for the media import in progress to finish, and forget it...
+void Experiment::FinishImportingMedia()
+{
+    // There wasn't one...
+    if(!pMediaImporter)
+        return;
+
+    // Wait for it, and let it go...
+    pMediaImporter->Wait();
+    delete pMediaImporter;
+    pMediaImporter = NULL;
+}
+
+// Wait for the save in progress to finish, and take in what it saved...
+bool Experiment::FinishSave()
+{
+    // Variables...
+    std::map<std::string, std::string> Moved;
+
+    // There wasn't one...
+    if(!pSaveThread)
+        return false;
+
+    // Wait for it to finish, if it hasn't...
+    pSaveThread->Wait();
+    std::vector<SaveThread::Item> const &Items = pSaveThread->GetItems();
+
+    // It failed, so nothing has changed...
+    if(!pSaveThread->IsSucceeded())
+    {
+        delete pSaveThread;
+        pSaveThread = NULL;
+        return false;
+    }
+
+    // Lock...
+    wxMutexLocker Lock(ArchiveMutex);
+
+    // Read the new archive instead. Any extraction still reading the old one
+    //  keeps it until it's done...
+    pArchive.reset(new ExperimentArchive);
+    if(!pArchive->Open(std::string(sPath.fn_str())))
+        wxLogError(wxT("Unable to reopen after saving: ") + sPath);
+
+    // Note where each entry kept or copied from the old archive is in the
+    //  new one...
+    for(size_t Index = 0; Index < Items.size(); ++Index)
+    {
+        if(Items[Index].bSaved && (Items[Index].Do == SaveThread::COPY ||
+                                   Items[Index].Do == SaveThread::KEEP))
+            Moved[Items[Index].Member.sName] = Items[Index].sName;
+    }
+
+    // Whatever was in the old archive is wherever it was saved in the new
+    //  one, even if renamed since. Every entry saved, or it would have
+    //  failed, so anything else wasn't part of the experiment any more...
+    std::map<wxString, std::string>::iterator Remaining = Unextracted.begin();
+    while(Remaining != Unextracted.end())
+    {
+        std::map<std::string, std::string>::const_iterator Found =
+            Moved.find(Remaining->second);
+        if(Found != Moved.end())
+        {
+            Remaining->second = Found->second;
+          ++Remaining;
+        }
+        else
+            Remaining = Unextracted.erase(Remaining);
+    }
+    std::map<wxString, ArchivedFile>::iterator Archived = Extracted.begin();
+    while(Archived != Extracted.end())
+    {
+        std::map<std::string, std::string>::const_iterator Found =
+            Moved.find(Archived->second.sMember);
+        if(Found != Moved.end())
+        {
+            Archived->second.sMember = Found->second;
+          ++Archived;
+        }
+        else
+            Archived = Extracted.erase(Archived);
+    }
+
+    // Each file saved from the cache is the same as its entry now, as it was
+    //  when the save started...
+    for(size_t Index = 0; Index < Items.size(); ++Index)
+    {
+        if(!Items[Index].bSaved || Items[Index].Do != SaveThread::ADD_FILE)
+            continue;
+        ArchivedFile &Saved = Extracted[Items[Index].sCacheName];
+        Saved.sMember       = Items[Index].sName;
+        Saved.ulSize        = Items[Index].ulSize;
+        Saved.Modified      = Items[Index].Modified;
+    }
+
+    // Saved, unless it was changed after the save started...
+    if(unRevision == unSavingRevision)
+        ClearNeedSave();
+
+    // Done with it...
+    delete pSaveThread;
+    pSaveThread = NULL;
+    return true;
+}
 
 // Get the path to experiment cache...
 wxString &Experiment::GetCachePath()
@@ -135,6 +381,73 @@ wxString &Experiment::GetCachePath()
 }
 
 
+// Get the media import in progress, if it's the one with this serial...
+MediaImporter *Experiment::GetMediaImporter(unsigned int const unSerial)
+{
+    // Check...
+    if(!pMediaImporter || pMediaImporter->GetSerial() != unSerial)
+        return NULL;
+
+    // Return it...
+    return pMediaImporter;
+}
+
+// Get the path to the frame index kept for a piece of media...
+wxString Experiment::GetMediaIndexPath(wxString const &sMediaTitle)
+{
+    // Kept under the analysis directory too, so it is saved with the rest...
+    ExtractFromArchive(wxT("analysis/") + sMediaTitle + wxT(".index"));
+    return sCachePath + wxT("/analysis/") + sMediaTitle + wxT(".index");
+}
+
+// Get the path to a piece of media in the cache...
+wxString Experiment::GetMediaPath(wxString const &sMediaTitle)
+{
+    // Extract it first, if it hasn't been yet...
+    ExtractFromArchive(wxT("media/") + sMediaTitle);
+    return sCachePath + wxT("/media/") + sMediaTitle;
+}
+
+// Get the size of a piece of media, whether or not it has been extracted...
+wxULongLong Experiment::GetMediaSize(wxString const &sMediaTitle)
+{
+    // Variables...
+    wxULongLong ulSize = 0;
+
+    // Still in the archive, so its central directory knows. Anything under
+    //  it counts too, if it's a directory...
+    {
+        // Lock...
+        wxMutexLocker Lock(ArchiveMutex);
+
+        // Add up...
+        std::vector<wxString> Names;
+        FindUnextracted(wxT("media/") + sMediaTitle, Names);
+        for(size_t Index = 0; Index < Names.size(); ++Index)
+        {
+            ExperimentArchive::Entry const *pMember =
+                pArchive->Find(Unextracted[Names[Index]]);
+            if(pMember)
+                ulSize += pMember->ulUncompressedSize;
+        }
+
+        // Found it...
+        if(!Names.empty())
+            return ulSize;
+    }
+
+    // Otherwise the file in the cache does, or everything in it if it's a
+    //  directory of images...
+    wxFileName const MediaFile(sCachePath + wxT("/media/") + sMediaTitle);
+    if(MediaFile.FileExists())
+        ulSize = MediaFile.GetSize();
+    else if(::wxDirExists(MediaFile.GetFullPath()))
+        ulSize = wxDir::GetTotalSize(MediaFile.GetFullPath());
+
+    // Done...
+    return ulSize;
+}
+
 // Get the full path, file name, and extension to file on disk...
 wxString &Experiment::GetPath()
 {
@@ -142,6 +455,14 @@ wxString &Experiment::GetPath()
     return sPath;
 }
 
+// Get the path to the trajectories saved for a piece of media...
+wxString Experiment::GetTrajectoryPath(wxString const &sMediaTitle)
+{
+    // Kept under the analysis directory, named after the media...
+    ExtractFromArchive(wxT("analysis/") + sMediaTitle + wxT(".trajectory"));
+    return sCachePath + wxT("/analysis/") + sMediaTitle + wxT(".trajectory");
+}
+
 // Get new unique cache file name...
 wxString Experiment::GetUniqueCacheFileName() const
 {
@@ -152,6 +473,27 @@ wxString Experiment::GetUniqueCacheFileName() const
     return UniqueCacheFileName.CreateTempFileName(sCachePath + wxT("/"));
 }
 
+// Start importing media into the cache in the background...
+bool Experiment::ImportMedia(std::vector<MediaImporter::Item> const &Items)
+{
+    // Already importing...
+    if(pMediaImporter)
+        return false;
+
+    // Start it and check for error...
+    pMediaImporter = new MediaImporter(*pMainFrame, Items);
+    if(!pMediaImporter->Start())
+    {
+        // Cleanup...
+        delete pMediaImporter;
+        pMediaImporter = NULL;
+        return false;
+    }
+
+    // Done...
+    return true;
+}
+
 // Has this file ever been saved?
 bool Experiment::IsEverBeenSaved() const
 {
@@ -159,6 +501,20 @@ bool Experiment::IsEverBeenSaved() const
     return (sPath != wxEmptyString);
 }
 
+// Is a media import in progress?
+bool Experiment::IsImportingMedia() const
+{
+    // Check...
+    return (pMediaImporter != NULL);
+}
+
+// Is media by this title still being imported?
+bool Experiment::IsImportingMedia(wxString const &sTitle) const
+{
+    // Check...
+    return (pMediaImporter && pMediaImporter->IsImporting(sTitle));
+}
+
 // Does the experiment need to be saved?
 bool Experiment::IsNeedSave() const
 {
@@ -173,12 +529,27 @@ bool Experiment::IsLoadOk() const
     return bLoadOk;
 }
 
+// Has the save in progress finished?
+bool Experiment::IsSaveFinished() const
+{
+    // Check...
+    return (pSaveThread && pSaveThread->IsFinished());
+}
+
+// Is a save in progress, or finished but not yet taken in?
+bool Experiment::IsSaving() const
+{
+    // Check...
+    return (pSaveThread != NULL);
+}
+
 // Load experiment...
 bool Experiment::Load(const wxString _sPath)
 {
     // Variables...
-    unsigned int    unProgress  = 0;
-    wxULongLong     ulTotalSize = 0;
+    wxULongLong             ulTotalSize = 0;
+    std::vector<uint8_t>    ControlData;
+    wxXmlDocument           XmlControlDocument;
 
     // Disable load flag until we are done loading...
     bLoadOk = false;
@@ -189,110 +560,49 @@ bool Experiment::Load(const wxString _sPath)
     // Store the path...
     sPath = _sPath;
     
-    // Open the experiment...
-    wxFFileInputStream InputStream(sPath);
-
-        // Failed...
-        if(!InputStream.IsOk())
-            return false;
-
-    // Pass the input stream through the zip input stream for decompression...
-    wxZipInputStream ZipInputStream(InputStream);
-
-    // Initialize progress dialog...
-    wxProgressDialog *pProgressDialog = new 
-        wxProgressDialog(wxT("Loading"),
-                         wxT("Decompressing experimental media..."), 
-                         ZipInputStream.GetTotalEntries(), NULL, 
-                         wxPD_APP_MODAL | wxPD_AUTO_HIDE | wxPD_SMOOTH);
-
-    // Set progress bar to zero...
-    unProgress = 0;
-    pProgressDialog->Update(unProgress);
-
-    // Now unpack the experiment into the cache...
-    while(wxZipEntry *pZipEntry = ZipInputStream.GetNextEntry())
+    // Open the experiment, reading only its central directory...
     {
-        // Get the name of the entry...
-        wxString sName = pZipEntry->GetName();
+        // Lock...
+        wxMutexLocker Lock(ArchiveMutex);
 
-        // Update progress, but check for user abort...
-        if(!pProgressDialog->Update(unProgress++))
-        {
-            // Alert user...
-            wxMessageBox(wxT("The experiment load was cancelled..."));
-            
-            // Cleanup...
-            EnableUI(false, true);
+        // Open, leaving the old archive to anything still reading it...
+        pArchive.reset(new ExperimentArchive);
+        if(!pArchive->Open(std::string(sPath.fn_str())))
             return false;
-        }
 
-        // Is this a directory?
-        if(pZipEntry->IsDir())
-        {   
-            // It doesn't exist yet...
-            if(!::wxDirExists(sCachePath + wxT("/") + sName))
-            {
-                // Create directory and check for error...
-                if(!wxFileName::Mkdir(sCachePath + wxT("/") + sName))
-                {
-                    // Alert user...
-                    wxMessageBox(wxT("Can't create ") + sCachePath + wxT("/") + 
-                                 sName);
-                    
-                    // Cleanup...
-                    EnableUI(false, true);
-                    return false;
-                }
-            }
-        }
-        
-        // This is a file...
-        else
+        // Everything in it stays there until it's first needed. The control
+        //  data is read straight out of it and never needs extracting...
+        Unextracted.clear();
+        Extracted.clear();
+        for(size_t Index = 0; Index < pArchive->Entries().size(); ++Index)
         {
-            // Create output file for writing...
-            wxFFileOutputStream OutputStream(sCachePath + wxT("/") + sName);
-
-                // Failed...
-                if(!OutputStream.IsOk())
-                {
-                    // Alert user...
-                    wxMessageBox(wxT("Can't create ") + sCachePath + wxT("/") + 
-                                 sName);
-                    
-                    // Cleanup...
-                    EnableUI(false, true);
-                    return false;
-                }
-
-            // Decompress file out to disk...
-            ZipInputStream.Read(OutputStream);
-            
-                // Failed...
-                if(!OutputStream.IsOk())
-                {
-                    // Alert user...
-                    wxMessageBox(wxT("Can't write to ") + sCachePath + wxT("/") 
-                                 + sName);
-                    
-                    // Cleanup...
-                    EnableUI(false, true);
-                    return false;
-                }
-
-            // Close output stream and cleanup...
-            OutputStream.Close();
+            // Skip directories, the cache already has those we use...
+            ExperimentArchive::Entry const &Member =
+                pArchive->Entries()[Index];
+            if(Member.bDirectory ||
+               Member.sName == "control/control.xml")
+                continue;
+
+            // Remember it by the name it will have in the cache...
+            Unextracted[wxString(Member.sName.c_str(), wxConvLocal)] =
+                Member.sName;
         }
     }
-    
+
+    // Read the control data into memory...
+    ExperimentArchive::Entry const *pControl =
+        pArchive->Find("control/control.xml");
+    if(pControl && pArchive->Read(*pControl, ControlData))
+    {
+        wxMemoryInputStream ControlInputStream(
+            ControlData.data(), ControlData.size());
+        XmlControlDocument.Load(ControlInputStream);
+    }
+
     // Parse control data...
-            
-        // Allocate and load...
-        wxXmlDocument   XmlControlDocument(GetCachePath() + 
-                                           wxT("/control/control.xml"));
         
         // Find the root node and verify it is the control node...
-        if(!XmlControlDocument.IsOk() ||  /* Potential problem, should be && */
+        if(!XmlControlDocument.IsOk() ||
            XmlControlDocument.GetRoot()->GetName() != wxT("control"))
         {
             // Alert user...
@@ -376,21 +686,24 @@ bool Experiment::Load(const wxString _sPath)
                         pMainFrame->MediaGrid->
                             SetCellValue(nRow, MainFrame::TECHNICIAN, sValue);
 
-                        // Length...
+                        // Length, if it was indexed...
+                        MediaIndex Index;
+                        sValue = wxT("?");
+                        if(Index.Load(std::string(GetMediaIndexPath(
+                            pMediaNode->GetNodeContent()).fn_str())))
+                            sValue = MainFrame::FormatMediaLength(
+                                Index.Length());
                         pMainFrame->MediaGrid->
-                            SetCellValue(nRow, MainFrame::LENGTH, wxT("?"));
+                            SetCellValue(nRow, MainFrame::LENGTH, sValue);
 
                         // Size...
                         
-                            // Open media...
-                            wxFileName  MediaFile(GetCachePath() + 
-                                                  wxT("/media/") + 
-                                                  pMediaNode->GetNodeContent());
-
-                            // Calculate size...
-                            wxULongLong ulFileSize = 
-                                MediaFile.GetSize() / 1024;
-                            ulTotalSize += MediaFile.GetSize();
+                            // Calculate size, from the archive's central
+                            //  directory...
+                            wxULongLong const ulMediaSize = GetMediaSize(
+                                pMediaNode->GetNodeContent());
+                            wxULongLong ulFileSize = ulMediaSize / 1024;
+                            ulTotalSize += ulMediaSize;
 
                             // Format and add to grid...
                             pMainFrame->MediaGrid->SetCellValue(nRow, 
@@ -430,9 +743,6 @@ bool Experiment::Load(const wxString _sPath)
 
     // Done...
 
-        // Kill the progress dialog so we can enable menu items on Mac...
-        delete pProgressDialog;
-
         // Trigger load ok flag...
         bLoadOk = true;
         
@@ -504,35 +814,180 @@ bool Experiment::RecursivelyRemoveDirectory(wxString sPath)
     return bSuccessful;
 }
 
-// Save experiment...
-bool Experiment::Save()
+// Remember a file in the cache has the same contents as an entry in the
+//  archive, as it is now...
+void Experiment::RememberArchived(
+    wxString const &sName, std::string const &sMember)
+{
+    // Variables...
+    struct stat     Status;
+    ArchivedFile    Archived;
+
+    // Can't tell if it changes without knowing how it is now...
+    wxString const sCachedPath = sCachePath + wxT("/") + sName;
+    if(stat(sCachedPath.fn_str(), &Status) != 0)
+    {
+        Extracted.erase(sName);
+        return;
+    }
+
+    // Remember...
+    Archived.sMember    = sMember;
+    Archived.ulSize     = Status.st_size;
+    Archived.Modified   = Status.st_mtime;
+    Extracted[sName]    = Archived;
+}
+
+// Remove a file from the cache, or forget it if still in the archive...
+bool Experiment::RemoveFromCache(wxString const &sName)
 {
-    // No path to save to...
-    if(sPath == wxEmptyString)
+    // Variables...
+    std::vector<wxString>   Names;
+    wxString const          sCachedPath = sCachePath + wxT("/") + sName;
+
+    // Forget whatever is still in the archive...
+    {
+        // Lock...
+        wxMutexLocker Lock(ArchiveMutex);
+
+        // Forget...
+        FindUnextracted(sName, Names);
+        for(size_t Index = 0; Index < Names.size(); ++Index)
+            Unextracted.erase(Names[Index]);
+
+        // Nor is what was extracted the same as anything in it now...
+        Extracted.erase(sName);
+        wxString const sDirectory = sName + wxT("/");
+        while(true)
+        {
+            std::map<wxString, ArchivedFile>::iterator Archived =
+                Extracted.lower_bound(sDirectory);
+            if(Archived == Extracted.end() ||
+               !Archived->first.StartsWith(sDirectory))
+                break;
+            Extracted.erase(Archived);
+        }
+    }
+
+    // Remove whatever was extracted, a whole directory of it if need be...
+    if(::wxDirExists(sCachedPath))
+        return RecursivelyRemoveDirectory(sCachedPath);
+    if(::wxFileExists(sCachedPath))
+        return ::wxRemoveFile(sCachedPath);
+
+    // Never extracted, so it's gone if it was ever there...
+    return !Names.empty();
+}
+
+// Remove a piece of media, its frame index, and its trajectories from the
+//  experiment...
+bool Experiment::RemoveMedia(wxString const &sMediaTitle)
+{
+    // Remove the media...
+    if(!RemoveFromCache(wxT("media/") + sMediaTitle))
         return false;
 
-    // Create the output stream...
-    wxFFileOutputStream OutputStream(GetPath());
-    
-        // Failed...
-        if(!OutputStream.IsOk())
-            return false;
+    // Its frame index is no use now either, if it had one...
+    RemoveFromCache(wxT("analysis/") + sMediaTitle + wxT(".index"));
 
-    // Alert user...
-    pMainFrame->SetStatusText(wxT("Saving, please be patient..."));
+    // Nor are its trajectories, which new media under the same title would
+    //  otherwise pick up...
+    RemoveFromCache(wxT("analysis/") + sMediaTitle + wxT(".trajectory"));
 
-    // Create the zip output stream...
-    wxZipOutputStream ZipOutputStream(OutputStream);
+    // Done...
+    return true;
+}
 
-    // Set compression level to store to make it fast...
-    ZipOutputStream.SetLevel(0);
-    
-    // Create the control data stream...
-    wxTextOutputStream ControlOutputStream(ZipOutputStream);
-    
-    // Write control data...
-    ZipOutputStream.PutNextDirEntry(wxT("control"));
-    ZipOutputStream.PutNextEntry(wxT("control/control.xml"));
+// Rename a file in the cache, or what it will be extracted as if still in
+//  the archive...
+bool Experiment::RenameInCache(
+    wxString const &sOriginalName, wxString const &sNewName)
+{
+    // Variables...
+    std::vector<wxString>   Names;
+    wxString const          sCachedPath = sCachePath + wxT("/") + sOriginalName;
+
+    // Remember whatever is still in the archive by its new name...
+    {
+        // Lock...
+        wxMutexLocker Lock(ArchiveMutex);
+
+        // Rename each...
+        FindUnextracted(sOriginalName, Names);
+        for(size_t Index = 0; Index < Names.size(); ++Index)
+        {
+            Unextracted[sNewName + Names[Index].Mid(sOriginalName.Length())] =
+                Unextracted[Names[Index]];
+            Unextracted.erase(Names[Index]);
+        }
+
+        // Whatever was extracted is still the same as the entry it came
+        //  from, just under its new name...
+        std::vector<wxString> ArchivedNames;
+        if(Extracted.count(sOriginalName))
+            ArchivedNames.push_back(sOriginalName);
+        wxString const sDirectory = sOriginalName + wxT("/");
+        for(std::map<wxString, ArchivedFile>::const_iterator Archived =
+                Extracted.lower_bound(sDirectory);
+            Archived != Extracted.end() &&
+                Archived->first.StartsWith(sDirectory);
+          ++Archived)
+            ArchivedNames.push_back(Archived->first);
+        for(size_t Index = 0; Index < ArchivedNames.size(); ++Index)
+        {
+            Extracted[sNewName +
+                      ArchivedNames[Index].Mid(sOriginalName.Length())] =
+                Extracted[ArchivedNames[Index]];
+            Extracted.erase(ArchivedNames[Index]);
+        }
+    }
+
+    // Rename whatever was extracted...
+    if(::wxDirExists(sCachedPath) || ::wxFileExists(sCachedPath))
+        return ::wxRenameFile(sCachedPath, sCachePath + wxT("/") + sNewName,
+                              false);
+
+    // Never extracted, so that was all of it if it was ever there...
+    return !Names.empty();
+}
+
+// Rename a piece of media, its frame index, and its trajectories...
+bool Experiment::RenameMedia(
+    wxString const &sOriginalTitle, wxString const &sNewTitle)
+{
+    // Rename the media...
+    if(!RenameInCache(wxT("media/") + sOriginalTitle,
+                      wxT("media/") + sNewTitle))
+        return false;
+
+    // Its frame index goes with it. If that fails it's just rebuilt...
+    RenameInCache(wxT("analysis/") + sOriginalTitle + wxT(".index"),
+                  wxT("analysis/") + sNewTitle + wxT(".index"));
+
+    // So do its trajectories...
+    RenameInCache(wxT("analysis/") + sOriginalTitle + wxT(".trajectory"),
+                  wxT("analysis/") + sNewTitle + wxT(".trajectory"));
+
+    // Done...
+    return true;
+}
+
+// Save experiment...
+bool Experiment::Save()
+{
+    // Variables...
+    std::vector<wxString>   Names;
+    std::vector<wxString>   Pending;
+    wxMemoryOutputStream    ControlOutputStream;
+
+    // No path to save to, or already saving...
+    if(sPath == wxEmptyString || pSaveThread)
+        return false;
+
+    // Nothing is extracted from the archive while working out what to save...
+    wxMutexLocker Lock(ArchiveMutex);
+
+    // Write control data into memory...
     
         // Format...
             
@@ -630,45 +1085,211 @@ bool Experiment::Save()
                 }
 
         // Write...
-        XmlControlDocument.Save(ZipOutputStream, 2);
+        XmlControlDocument.Save(ControlOutputStream, 2);
+        std::string ControlData(ControlOutputStream.GetSize(), '\0');
+        ControlOutputStream.CopyTo(&ControlData[0], ControlData.size());
 
-    // Write media...
-    
-        // Create directory in archive...
-        ZipOutputStream.PutNextDirEntry(wxT("media"));
-    
-        // Archive each file...
+    // Find everything else to save, by the name it has in the cache...
+
+        // Each piece of media, whether still in the archive or not...
         for(int nRow = 0; 
             nRow < pMainFrame->MediaGrid->GetNumberRows(); 
             nRow++)
         {
-            // Try to open the media...
-            wxFFileInputStream MediaEntry(GetCachePath() + wxT("/media/") + 
-                                            pMainFrame->MediaGrid->
-                                            GetCellValue(nRow, MainFrame::TITLE));
+            // Whatever of it is still in the archive...
+            wxString const sName = wxT("media/") +
+                pMainFrame->MediaGrid->GetCellValue(nRow, MainFrame::TITLE);
+            FindUnextracted(sName, Pending);
+            Names.insert(Names.end(), Pending.begin(), Pending.end());
+
+            // Whatever of it is in the cache, a whole directory if need be...
+            wxString const sCachedPath = sCachePath + wxT("/") + sName;
+            if(::wxFileExists(sCachedPath))
+                Names.push_back(sName);
+            else if(::wxDirExists(sCachedPath))
+            {
+                wxArrayString Files;
+                wxDir::GetAllFiles(sCachedPath, &Files);
+                for(size_t Index = 0; Index < Files.GetCount(); ++Index)
+                    Names.push_back(Files[Index].Mid(sCachePath.Length() + 1));
+            }
 
-                // This shouldn't happen...
-                if(!MediaEntry.IsOk())
-                {
-                    // Log it and skip to next media...
-                    wxLogError(wxT("Can't save with experiment: ") +
-                               GetCachePath() + wxT("/media/") + 
-                                pMainFrame->MediaGrid->
-                                    GetCellValue(nRow, MainFrame::TITLE));
-                    continue;
-                }
+            // This shouldn't happen...
+            else if(Pending.empty())
+                wxLogError(wxT("Can't save with experiment: ") + sCachedPath);
+        }
 
-            // Create the entry...
-            ZipOutputStream.PutNextEntry(wxT("media/") + 
-                pMainFrame->MediaGrid->GetCellValue(nRow, MainFrame::TITLE));
-                                    
-            // Compress the media into the zip...
-            ZipOutputStream.Write(MediaEntry);
+        // Analysis results, whether still in the archive or not...
+        FindUnextracted(wxT("analysis"), Pending);
+        Names.insert(Names.end(), Pending.begin(), Pending.end());
+        wxDir       AnalysisDirectory(GetCachePath() + wxT("/analysis"));
+        wxString    sAnalysisName;
+        bool        bMoreAnalysis = AnalysisDirectory.IsOpened() &&
+                        AnalysisDirectory.GetFirst(&sAnalysisName, 
+                                                   wxEmptyString, 
+                                                   wxDIR_FILES);
+        while(bMoreAnalysis)
+        {
+            Names.push_back(wxT("analysis/") + sAnalysisName);
+            bMoreAnalysis = AnalysisDirectory.GetNext(&sAnalysisName);
         }
 
-    // Clear need save flag...
-    ClearNeedSave();
-    
+    // Find which archive entry each is the same as, if any, and add up how
+    //  much of the archive could stay right where it is...
+    std::string const sTarget(sPath.fn_str());
+    bool const bOverArchive =
+        pArchive->IsOpen() && pArchive->GetPath() == sTarget;
+    std::vector<std::string> Entries(Names.size());
+    std::vector<ExperimentArchive::Entry const *> Sources(Names.size(), NULL);
+    uint64_t ulKept = 0;
+    for(size_t Index = 0; Index < Names.size(); ++Index)
+    {
+        // Name it will have in the archive...
+        Entries[Index] = std::string(Names[Index].mb_str(wxConvLocal));
+
+        // Never extracted, or extracted and not changed since...
+        std::string sMember;
+        if(Unextracted.count(Names[Index]))
+            sMember = Unextracted[Names[Index]];
+        else if(!FindArchived(Names[Index], sMember))
+            continue;
+        Sources[Index] = pArchive->Find(sMember);
+
+        // Under the same name, so it could stay...
+        if(Sources[Index] && Sources[Index]->sName == Entries[Index])
+            ulKept += Sources[Index]->ulCompressedSize;
+    }
+
+    // Saving over the archive we loaded from, so update it in place, keeping
+    //  what's unchanged and appending the rest. Unless at least half of it
+    //  would be left unused then, in which case write it all over again.
+    //  Whole archives are written next to where they go first...
+    bool const bInPlace = bOverArchive && ulKept >= pArchive->GetSize() / 2;
+    std::string sTemporaryPath;
+    if(!bInPlace)
+    {
+        sTemporaryPath = std::string(
+            wxFileName::CreateTempFileName(sPath).fn_str());
+        if(sTemporaryPath.empty())
+        {
+            // Alert user...
+            wxLogError(wxT("Unable to save to ") + sPath);
+
+            // Abort...
+            return false;
+        }
+
+        // It's only readable by us, but replaces whatever was there, so give
+        //  it the same permissions, or those a new file would have...
+        struct stat Status;
+        mode_t Mode = 0;
+        if(stat(sTarget.c_str(), &Status) == 0)
+            Mode = Status.st_mode & 07777;
+        else
+        {
+            mode_t const Mask = umask(0);
+            umask(Mask);
+            Mode = 0666 & ~Mask;
+        }
+        if(chmod(sTemporaryPath.c_str(), Mode) != 0)
+        {
+            // Nothing more we can do about it...
+        }
+    }
+
+    // Work out how each entry is saved, starting with the directories, kept
+    //  if they're already there, and control data...
+    std::vector<SaveThread::Item> Items;
+    SaveThread::Item Saving;
+    Saving.ulSize   = 0;
+    Saving.Modified = 0;
+    Saving.bSaved   = false;
+    char const *Directories[] = { "control/", "media/", "analysis/" };
+    for(size_t Index = 0; Index < WXSIZEOF(Directories); ++Index)
+    {
+        ExperimentArchive::Entry const *pDirectory =
+            bInPlace ? pArchive->Find(Directories[Index]) : NULL;
+        Saving.Do       = pDirectory ? SaveThread::KEEP :
+                                       SaveThread::ADD_DIRECTORY;
+        Saving.sName    = Directories[Index];
+        if(pDirectory)
+            Saving.Member = *pDirectory;
+        Items.push_back(Saving);
+    }
+    Saving.Do       = SaveThread::ADD_DATA;
+    Saving.sName    = "control/control.xml";
+    Saving.sData    = ControlData;
+    Items.push_back(Saving);
+    Saving.sData.clear();
+
+    // Then everything else...
+    for(size_t Index = 0; Index < Names.size(); ++Index)
+    {
+        // Named...
+        Saving.sName        = Entries[Index];
+        Saving.sCacheName   = Names[Index];
+
+        // Unchanged, so it stays where it is if it's under the same name,
+        //  or is copied as it is...
+        if(Sources[Index])
+        {
+            Saving.Do       = (bInPlace &&
+                               Sources[Index]->sName == Entries[Index]) ?
+                                SaveThread::KEEP : SaveThread::COPY;
+            Saving.Member   = *Sources[Index];
+        }
+
+        // New or changed, so save it from the cache, noting how it is now
+        //  so if it changes while being saved it's saved again next time...
+        else
+        {
+            struct stat Status;
+            Saving.Do       = SaveThread::ADD_FILE;
+            Saving.sData    = std::string(
+                (sCachePath + wxT("/") + Names[Index]).fn_str());
+            if(stat(Saving.sData.c_str(), &Status) != 0)
+            {
+                // This shouldn't happen. Saving without it would lose it...
+                wxLogError(wxT("Can't save with experiment: ") + Names[Index]);
+
+                // Cleanup and abort...
+                if(!sTemporaryPath.empty())
+                    ::wxRemoveFile(wxString(sTemporaryPath.c_str(),
+                                            wxConvFile));
+                return false;
+            }
+            Saving.ulSize   = Status.st_size;
+            Saving.Modified = Status.st_mtime;
+        }
+
+        // Add it...
+        Items.push_back(Saving);
+    }
+
+    // Start saving...
+    pSaveThread = new SaveThread(*pMainFrame,
+        pArchive->IsOpen() ? pArchive->GetPath() : std::string(), sTarget,
+        sTemporaryPath, Items);
+    if(pSaveThread->Create() != wxTHREAD_NO_ERROR ||
+       pSaveThread->Run() != wxTHREAD_NO_ERROR)
+    {
+        // Alert user...
+        wxLogError(wxT("Unable to start saving..."));
+
+        // Cleanup...
+        delete pSaveThread;
+        pSaveThread = NULL;
+        if(!sTemporaryPath.empty())
+            ::wxRemoveFile(wxString(sTemporaryPath.c_str(), wxConvFile));
+        return false;
+    }
+
+    // Anything changed from here on still needs saving after...
+    unSavingRevision = unRevision;
+
+    // Alert user...
+    pMainFrame->SetStatusText(wxT("Saving..."));
+
     // Done...
     return true;
 }
@@ -676,6 +1297,10 @@ bool Experiment::Save()
 // Save the experiment under a new file name...
 bool Experiment::SaveAs(const wxString _sPath)
 {
+    // Already saving...
+    if(pSaveThread)
+        return false;
+
     // Store the new path...
     sPath = _sPath;
     
@@ -695,11 +1320,31 @@ void Experiment::TriggerNeedSave()
 
     // Set...
     bNeedSave = true;
+
+    // Anything saving now started from how it was before...
+  ++unRevision;
 }
 
 // Deconstructor...
 Experiment::~Experiment()
 {
+    // Stop any media import in progress, it's writing into the cache...
+    if(pMediaImporter)
+    {
+        pMainFrame->SetStatusText(
+            wxT("Cancelling media import, please be patient..."));
+        pMediaImporter->Cancel();
+        FinishImportingMedia();
+    }
+
+    // Let any save in progress finish first, it's reading from the cache...
+    if(pSaveThread)
+    {
+        pMainFrame->SetStatusText(
+            wxT("Finishing saving, please be patient..."));
+        FinishSave();
+    }
+
     // Disable UI...
     EnableUI(false, true);
     
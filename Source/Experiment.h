@@ -15,7 +15,23 @@
     
     // wxWidgets...
     #include <wx/dir.h>
+    #include <wx/mstream.h>
     #include <wx/progdlg.h>
+    #include <wx/thread.h>
+
+    // Saved experiment archive, and saving it in the background...
+    #include "ExperimentArchive.h"
+    #include "SaveThread.h"
+
+    // Importing media in the background...
+    #include "MediaImporter.h"
+
+    // Standard libraries and STL...
+    #include <ctime>
+    #include <map>
+    #include <memory>
+    #include <string>
+    #include <vector>
 
 // Forward declarations...
 class MainFrame;
@@ -34,31 +50,92 @@ class Experiment
             // Clear need save flag...
             void ClearNeedSave();
 
+            // Wait for the media import in progress to finish, if it hasn't
+            //  already, and forget it...
+            void FinishImportingMedia();
+
+            // Wait for the save in progress to finish, if it hasn't already,
+            //  and take in what it saved. Returns false if it failed, or
+            //  there wasn't one...
+            bool FinishSave();
+
             // Get new unique cache file name...
             wxString GetUniqueCacheFileName() const;
 
             // Get the path to experiment cache...
             wxString &GetCachePath();
 
+            // Get the media import in progress, if it's the one with this
+            //  serial number. NULL otherwise...
+            MediaImporter *GetMediaImporter(unsigned int const unSerial);
+
+            // Get the path to the frame index kept for a piece of media,
+            //  extracting it from the archive first if need be...
+            wxString GetMediaIndexPath(wxString const &sMediaTitle);
+
+            // Get the path to a piece of media in the cache, extracting it
+            //  from the archive first if it hasn't been yet. Safe from any
+            //  thread...
+            wxString GetMediaPath(wxString const &sMediaTitle);
+
+            // Get the size of a piece of media, whether or not it has been
+            //  extracted yet...
+            wxULongLong GetMediaSize(wxString const &sMediaTitle);
+
             // Get the full path, file name, and extension to file on disk...
             wxString &GetPath();
 
+            // Get the path to the trajectories saved for a piece of media,
+            //  extracting them from the archive first if need be...
+            wxString GetTrajectoryPath(wxString const &sMediaTitle);
+
+            // Start importing media into the cache in the background. The
+            //  main frame is told as each is imported. Returns false if it
+            //  couldn't be started, or an import is already in progress...
+            bool ImportMedia(std::vector<MediaImporter::Item> const &Items);
+
             // Has this file ever been saved?
             bool IsEverBeenSaved() const;
 
+            // Is a media import in progress, or one by this title still
+            //  being imported?
+            bool IsImportingMedia() const;
+            bool IsImportingMedia(wxString const &sTitle) const;
+
             // Does the experiment need to be saved?
             bool IsNeedSave() const;
 
             // Experiment loaded ok?
             bool IsLoadOk() const;
 
-            // Load experiment...
+            // Has the save in progress finished, so finishing it won't wait?
+            bool IsSaveFinished() const;
+
+            // Is a save in progress, or finished but not yet taken in?
+            bool IsSaving() const;
+
+            // Load experiment. Only the archive's central directory and
+            //  control data are read, everything else stays in the archive
+            //  until it's first needed...
             bool Load(const wxString _sPath);
 
-            // Save experiment...
+            // Remove a piece of media, its frame index, and its trajectories
+            //  from the experiment...
+            bool RemoveMedia(wxString const &sMediaTitle);
+
+            // Rename a piece of media, its frame index, and its
+            //  trajectories...
+            bool RenameMedia(wxString const &sOriginalTitle,
+                             wxString const &sNewTitle);
+
+            // Start saving the experiment in the background, from how it is
+            //  now. Saving over the archive it was loaded from only appends
+            //  what changed, unless that has left too much of it unused. The
+            //  main frame is told when it's finished. Returns false if it
+            //  couldn't be started, or a save is already in progress...
             bool Save();
             
-            // Save the experiment under a new file name...
+            // Start saving the experiment under a new file name...
             bool SaveAs(const wxString _sPath);
 
             // Flag experiment as needing a save...
@@ -78,9 +155,41 @@ class Experiment
             // Enable or disable UI, and optionally reset GUI...
             void EnableUI(bool bEnable, bool bReset = false);
 
+            // Extract a file, or every file under a directory, from the
+            //  archive into the cache, unless already there. The name is
+            //  relative to the cache. Only locks to find and record what it
+            //  extracts, not while extracting. Returns false if any couldn't
+            //  be...
+            bool ExtractFromArchive(wxString const &sName);
+
+            // Find the archive entry a file in the cache still has the same
+            //  contents as, going by its size and when it was modified.
+            //  Returns false if it has none. Lock first...
+            bool FindArchived(wxString const &sName,
+                              std::string &sMember) const;
+
+            // Find what is still in the archive of a file, or every file
+            //  under a directory, by cache name. Lock first...
+            void FindUnextracted(wxString const &sName,
+                                 std::vector<wxString> &Names) const;
+
+            // Remove a file from the cache, or forget it if still in the
+            //  archive...
+            bool RemoveFromCache(wxString const &sName);
+
+            // Rename a file in the cache, or what it will be extracted as if
+            //  still in the archive...
+            bool RenameInCache(wxString const &sOriginalName,
+                               wxString const &sNewName);
+
             // Recursively remove directory and all of its contents... (be careful)
             bool RecursivelyRemoveDirectory(wxString sPath);
 
+            // Remember a file in the cache has the same contents as an entry
+            //  in the archive, as it is now. Lock first...
+            void RememberArchived(wxString const &sName,
+                                  std::string const &sMember);
+
         // Attributes...
         
             // Main frame...
@@ -92,12 +201,45 @@ class Experiment
             // The location of the unpacked experiment cached on disk...
             wxString    sCachePath;
 
+            // The archive it was loaded from, and what in it hasn't been
+            //  extracted into the cache yet, by the name it will have there.
+            //  Guarded by the mutex. Reopening replaces the archive rather
+            //  than reusing it, so an extraction can hold on to the one it
+            //  started with and read it without the lock...
+            std::shared_ptr<ExperimentArchive> pArchive;
+            std::map<wxString, std::string> Unextracted;
+            wxMutex             ArchiveMutex;
+
+            // Files in the cache known to be the same as an entry in the
+            //  archive, because they were extracted from it or saved to it
+            //  and haven't changed since. Guarded by the mutex too...
+            typedef struct ArchivedFile
+            {
+                // The entry...
+                std::string     sMember;
+
+                // Size and modification time of the file back then...
+                uint64_t        ulSize;
+                time_t          Modified;
+
+            }ArchivedFile;
+            std::map<wxString, ArchivedFile> Extracted;
+
             // Loaded ok...
             bool        bLoadOk;
             
             // Needs save...
             bool        bNeedSave;
 
+            // Save in progress, if any, and how many changes had been made
+            //  when it started and have been made so far...
+            SaveThread         *pSaveThread;
+            unsigned int        unSavingRevision;
+            unsigned int        unRevision;
+
+            // Media import in progress, if any...
+            MediaImporter      *pMediaImporter;
+
         // Helper classes...
             
             // Recursive scan of directories and their contents...
@@ -0,0 +1,647 @@
+/*
+  Name:         ExperimentArchive.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Read only view of a saved experiment's zip archive...
+*/
+
+// Includes...
+#include "ExperimentArchive.h"
+#ifdef HAVE_CONFIG_H
+    #include "config.h"
+#endif
+#include <wx/wfstream.h>
+#include <wx/mstream.h>
+#include <wx/zstream.h>
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_MMAN_H
+    #include <sys/mman.h>
+#endif
+
+// Signatures of the records we look for...
+static uint32_t const LocalHeaderSignature          = 0x04034b50;
+static uint32_t const CentralHeaderSignature        = 0x02014b50;
+static uint32_t const EndSignature                  = 0x06054b50;
+static uint32_t const Zip64EndSignature             = 0x06064b50;
+static uint32_t const Zip64LocatorSignature         = 0x07064b50;
+
+// Fixed sizes of those records, before any variable length fields...
+static size_t const LocalHeaderSize                 = 30;
+static size_t const CentralHeaderSize               = 46;
+static size_t const EndSize                         = 22;
+static size_t const Zip64EndSize                    = 56;
+static size_t const Zip64LocatorSize                = 20;
+
+// Longest comment the end record can have, which is how far back from the end
+//  of the archive it can be...
+static size_t const MaximumCommentSize              = 0xFFFF;
+
+// Extra field holding the sizes and offset too big for the central header...
+static uint16_t const Zip64ExtraField               = 0x0001;
+
+// Compression methods...
+static uint16_t const StoredMethod                  = 0;
+static uint16_t const DeflatedMethod                = 8;
+
+// Bytes copied at a time when extracting without a mapping...
+static size_t const CopyChunkSize                   = 1 << 20;
+
+// Read little endian integers from a record...
+static uint16_t Read16(uint8_t const *pBytes)
+{
+    return pBytes[0] | (pBytes[1] << 8);
+}
+static uint32_t Read32(uint8_t const *pBytes)
+{
+    return Read16(pBytes) | ((uint32_t) Read16(pBytes + 2) << 16);
+}
+static uint64_t Read64(uint8_t const *pBytes)
+{
+    return Read32(pBytes) | ((uint64_t) Read32(pBytes + 4) << 32);
+}
+
+// Write all of a buffer to a descriptor...
+static bool WriteAll(int const nDescriptor, uint8_t const *pData, size_t Size)
+{
+    // Keep writing until it's all out...
+    while(Size > 0)
+    {
+        ssize_t const Count = write(nDescriptor, pData, Size);
+        if(Count <= 0)
+            return false;
+        pData  += Count;
+        Size   -= Count;
+    }
+
+    // Done...
+    return true;
+}
+
+// Mapping default constructor...
+ExperimentArchive::Mapping::Mapping()
+    : pMapping(NULL),
+      MappingSize(0),
+      pData(NULL),
+      DataSize(0)
+{
+
+}
+
+// The entry's data...
+uint8_t const *ExperimentArchive::Mapping::Data() const
+{
+    return pData;
+}
+
+// Let go of it...
+void ExperimentArchive::Mapping::Release()
+{
+    // Unmap...
+#ifdef HAVE_SYS_MMAN_H
+    if(pMapping)
+        munmap(pMapping, MappingSize);
+#endif
+
+    // Forget...
+    pMapping    = NULL;
+    MappingSize = 0;
+    pData       = NULL;
+    DataSize    = 0;
+    Buffer.clear();
+}
+
+// Its size...
+size_t ExperimentArchive::Mapping::Size() const
+{
+    return DataSize;
+}
+
+// Mapping deconstructor...
+ExperimentArchive::Mapping::~Mapping()
+{
+    Release();
+}
+
+// Default constructor...
+ExperimentArchive::ExperimentArchive()
+    : nDescriptor(-1),
+      ulSize(0)
+{
+
+}
+
+// Close the archive, if any...
+void ExperimentArchive::Close()
+{
+    // Close the descriptor...
+    if(nDescriptor >= 0)
+        close(nDescriptor);
+    nDescriptor = -1;
+
+    // Forget everything about it...
+    sPath.clear();
+    ulSize = 0;
+    Members.clear();
+    EntryIndex.clear();
+}
+
+// Every entry, in central directory order...
+std::vector<ExperimentArchive::Entry> const &ExperimentArchive::Entries() const
+{
+    return Members;
+}
+
+// Extract an entry to a file of its own...
+bool ExperimentArchive::Extract(
+    Entry const &Member, std::string const &sDestination) const
+{
+    // Nothing to extract from a directory...
+    if(Member.bDirectory)
+        return false;
+
+    // Stored, so copy it straight out...
+    if(Member.unMethod == StoredMethod)
+    {
+        // Find it...
+        uint64_t ulOffset = 0;
+        if(!FindData(Member, ulOffset) ||
+           ulOffset + Member.ulCompressedSize > ulSize)
+            return false;
+
+        // Create the file...
+        int const nOutput = open(sDestination.c_str(),
+                                 O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(nOutput < 0)
+            return false;
+
+        // Copy out of a mapping, if it can be mapped. The kernel reads ahead
+        //  of us and we never touch a page twice...
+        bool        bCopied = false;
+        Mapping     View;
+        if(Map(Member, View) && View.pMapping)
+        {
+        #ifdef HAVE_SYS_MMAN_H
+            madvise(View.pMapping, View.MappingSize, MADV_SEQUENTIAL);
+        #endif
+            bCopied = WriteAll(nOutput, View.Data(), View.Size());
+        }
+
+        // Otherwise a chunk at a time...
+        else
+        {
+            // Copy...
+            std::vector<uint8_t> Chunk(CopyChunkSize);
+            uint64_t ulDone = 0;
+            bCopied = true;
+            while(bCopied && ulDone < Member.ulCompressedSize)
+            {
+                size_t const Size = (size_t) std::min<uint64_t>(
+                    Chunk.size(), Member.ulCompressedSize - ulDone);
+                bCopied = ReadAt(ulOffset + ulDone, Chunk.data(), Size) &&
+                          WriteAll(nOutput, Chunk.data(), Size);
+                ulDone += Size;
+            }
+        }
+
+        // Finish, leaving nothing behind if that failed...
+        if(close(nOutput) != 0)
+            bCopied = false;
+        if(!bCopied)
+            std::remove(sDestination.c_str());
+        return bCopied;
+    }
+
+    // Deflated, so inflate it out...
+    if(Member.unMethod == DeflatedMethod)
+    {
+        // Find it...
+        uint64_t ulOffset = 0;
+        if(!FindData(Member, ulOffset))
+            return false;
+
+        // Open the archive as a stream positioned at the data...
+        wxFFileInputStream Input(wxString(sPath.c_str(), wxConvFile));
+        if(!Input.IsOk() || Input.SeekI(ulOffset) == wxInvalidOffset)
+            return false;
+
+        // Inflate into the file, raw deflate without a zlib header...
+        bool bInflated = false;
+        {
+            wxZlibInputStream   Inflater(Input, wxZLIB_NO_HEADER);
+            wxFFileOutputStream Output(
+                wxString(sDestination.c_str(), wxConvFile));
+            if(Output.IsOk())
+            {
+                Inflater.Read(Output);
+                uint64_t const ulInflated = Output.TellO();
+                bInflated = Output.Close() &&
+                            ulInflated == Member.ulUncompressedSize;
+            }
+        }
+
+        // Leave nothing behind if that failed...
+        if(!bInflated)
+            std::remove(sDestination.c_str());
+        return bInflated;
+    }
+
+    // Some other compression we don't know...
+    return false;
+}
+
+// Find an entry by name...
+ExperimentArchive::Entry const *ExperimentArchive::Find(
+    std::string const &sName) const
+{
+    // Look it up...
+    std::map<std::string, size_t>::const_iterator Found =
+        EntryIndex.find(sName);
+    return (Found != EntryIndex.end()) ? &Members[Found->second] : NULL;
+}
+
+// Find where an entry's data starts, past its local header...
+bool ExperimentArchive::FindData(Entry const &Member, uint64_t &ulOffset) const
+{
+    // Read its local header...
+    uint8_t Header[LocalHeaderSize];
+    if(!ReadAt(Member.ulLocalHeaderOffset, Header, sizeof(Header)) ||
+       Read32(Header) != LocalHeaderSignature)
+        return false;
+
+    // The data follows its name and extra field, which needn't be the same
+    //  length as in the central directory...
+    ulOffset = Member.ulLocalHeaderOffset + LocalHeaderSize +
+               Read16(Header + 26) + Read16(Header + 28);
+
+    // Done...
+    return true;
+}
+
+// Path to the archive...
+std::string const &ExperimentArchive::GetPath() const
+{
+    return sPath;
+}
+
+// Size of the archive in bytes...
+uint64_t ExperimentArchive::GetSize() const
+{
+    return ulSize;
+}
+
+// Is an archive open?
+bool ExperimentArchive::IsOpen() const
+{
+    return (nDescriptor >= 0);
+}
+
+// Map a stored entry into memory without copying it...
+bool ExperimentArchive::Map(Entry const &Member, Mapping &View) const
+{
+    // Let go of whatever it had...
+    View.Release();
+
+    // Only stored entries are the same in the archive as out...
+    if(Member.bDirectory || Member.unMethod != StoredMethod)
+        return false;
+
+    // Find it...
+    uint64_t ulOffset = 0;
+    if(!FindData(Member, ulOffset) ||
+       ulOffset + Member.ulCompressedSize > ulSize)
+        return false;
+    View.DataSize = (size_t) Member.ulCompressedSize;
+
+    // Nothing in it...
+    if(View.DataSize == 0)
+        return true;
+
+    // Map from the page its data starts on...
+#ifdef HAVE_SYS_MMAN_H
+    uint64_t const ulPageSize   = sysconf(_SC_PAGESIZE);
+    uint64_t const ulPageOffset = ulOffset - (ulOffset % ulPageSize);
+    View.MappingSize = (size_t) (ulOffset - ulPageOffset) + View.DataSize;
+    void *pMapping = mmap(NULL, View.MappingSize, PROT_READ, MAP_SHARED,
+                          nDescriptor, (off_t) ulPageOffset);
+    if(pMapping != MAP_FAILED)
+    {
+        View.pMapping   = pMapping;
+        View.pData      =
+            static_cast<uint8_t const *>(pMapping) + (ulOffset - ulPageOffset);
+        return true;
+    }
+    View.MappingSize = 0;
+#endif
+
+    // Can't map it, read it in instead...
+    View.Buffer.resize(View.DataSize);
+    if(!ReadAt(ulOffset, View.Buffer.data(), View.DataSize))
+    {
+        View.Release();
+        return false;
+    }
+    View.pData = View.Buffer.data();
+
+    // Done...
+    return true;
+}
+
+// Open an archive and read its central directory...
+bool ExperimentArchive::Open(std::string const &_sPath)
+{
+    // Variables...
+    struct stat             Status;
+    std::vector<uint8_t>    Chunk;
+
+    // Close whatever was open before...
+    Close();
+
+    // Open it and find out how big it is...
+    nDescriptor = open(_sPath.c_str(), O_RDONLY);
+    if(nDescriptor < 0)
+        return false;
+    if(fstat(nDescriptor, &Status) != 0 ||
+       static_cast<uint64_t>(Status.st_size) < EndSize)
+    {
+        Close();
+        return false;
+    }
+    sPath   = _sPath;
+    ulSize  = Status.st_size;
+
+    // Look backwards from the end for the end record, a chunk at a time. The
+    //  first chunk is far enough back to hold it and the longest comment it
+    //  can have, so it's normally there. Any further back is only where an
+    //  update cut short left the last complete one...
+    uint64_t ulChunkEnd = ulSize;
+    while(true)
+    {
+        // Read the chunk...
+        uint64_t const ulChunkOffset = ulChunkEnd - std::min<uint64_t>(
+            ulChunkEnd, EndSize + MaximumCommentSize + Zip64LocatorSize);
+        Chunk.resize((size_t) (ulChunkEnd - ulChunkOffset));
+        if(!ReadAt(ulChunkOffset, Chunk.data(), Chunk.size()))
+            break;
+
+        // Try every end record signature in it, last first...
+        for(size_t End = Chunk.size() - sizeof(uint32_t) + 1; End-- > 0;)
+        {
+            if(Read32(&Chunk[End]) == EndSignature &&
+               ulChunkOffset + End + EndSize <= ulSize &&
+               ReadEnd(ulChunkOffset + End))
+                return true;
+        }
+
+        // Nowhere left to look...
+        if(ulChunkOffset == 0)
+            break;
+
+        // The next chunk back overlaps this one by just less than a
+        //  signature, so one across the two isn't missed...
+        ulChunkEnd = ulChunkOffset + sizeof(uint32_t) - 1;
+    }
+
+    // Not a zip archive, or not one we understand...
+    Close();
+    return false;
+}
+
+// Read an entry into memory whole...
+bool ExperimentArchive::Read(
+    Entry const &Member, std::vector<uint8_t> &Data) const
+{
+    // Start over...
+    Data.clear();
+
+    // Stored, so just copy it out of its mapping...
+    if(Member.unMethod == StoredMethod)
+    {
+        Mapping View;
+        if(!Map(Member, View))
+            return false;
+        Data.assign(View.Data(), View.Data() + View.Size());
+        return true;
+    }
+
+    // Deflated, so inflate it...
+    if(Member.unMethod == DeflatedMethod)
+    {
+        // Find it...
+        uint64_t ulOffset = 0;
+        if(!FindData(Member, ulOffset))
+            return false;
+
+        // Open the archive as a stream positioned at the data...
+        wxFFileInputStream Input(wxString(sPath.c_str(), wxConvFile));
+        if(!Input.IsOk() || Input.SeekI(ulOffset) == wxInvalidOffset)
+            return false;
+
+        // Inflate it...
+        Data.resize((size_t) Member.ulUncompressedSize);
+        wxZlibInputStream Inflater(Input, wxZLIB_NO_HEADER);
+        return Data.empty() ||
+               Inflater.ReadAll(Data.data(), Data.size());
+    }
+
+    // Some other compression we don't know...
+    return false;
+}
+
+// Read exactly the given number of raw bytes at an offset into the archive...
+bool ExperimentArchive::ReadAt(
+    uint64_t const ulOffset, void *pBuffer, size_t const Size) const
+{
+    // Keep reading until we have it all...
+    size_t Done = 0;
+    while(Done < Size)
+    {
+        ssize_t const Count = pread(nDescriptor,
+            static_cast<uint8_t *>(pBuffer) + Done, Size - Done,
+            (off_t) (ulOffset + Done));
+        if(Count <= 0)
+            return false;
+        Done += Count;
+    }
+
+    // Done...
+    return true;
+}
+
+// Read the end record at an offset, and the central directory it points to...
+bool ExperimentArchive::ReadEnd(uint64_t const ulEndOffset)
+{
+    // Variables...
+    uint8_t End[EndSize];
+    uint8_t Locator[Zip64LocatorSize];
+
+    // Start over, in case an earlier one didn't pan out...
+    Members.clear();
+    EntryIndex.clear();
+
+    // Read it...
+    if(!ReadAt(ulEndOffset, End, sizeof(End)))
+        return false;
+
+    // Where the central directory is, how big it is, and how many entries.
+    //  It ends right where the end record starts...
+    uint64_t ulEntries          = Read16(End + 10);
+    uint64_t ulDirectorySize    = Read32(End + 12);
+    uint64_t ulDirectoryOffset  = Read32(End + 16);
+    uint64_t ulDirectoryEnd     = ulEndOffset;
+
+    // Too big for the end record, so the real numbers are in the zip64 end
+    //  record, which the locator just before it points to...
+    if(ulEndOffset >= Zip64LocatorSize &&
+       ReadAt(ulEndOffset - Zip64LocatorSize, Locator, sizeof(Locator)) &&
+       Read32(Locator) == Zip64LocatorSignature)
+    {
+        // Read the zip64 end record...
+        uint8_t Zip64End[Zip64EndSize];
+        uint64_t const ulZip64EndOffset = Read64(Locator + 8);
+        if(!ReadAt(ulZip64EndOffset, Zip64End, sizeof(Zip64End)) ||
+           Read32(Zip64End) != Zip64EndSignature)
+            return false;
+
+        // Take its numbers instead. The central directory ends where it
+        //  starts...
+        ulEntries           = Read64(Zip64End + 32);
+        ulDirectorySize     = Read64(Zip64End + 40);
+        ulDirectoryOffset   = Read64(Zip64End + 48);
+        ulDirectoryEnd      = ulZip64EndOffset;
+    }
+
+    // Anything else isn't really an end record, just bytes that look like
+    //  one, or one we don't understand...
+    if(ulDirectoryOffset > ulDirectoryEnd ||
+       ulDirectoryEnd - ulDirectoryOffset != ulDirectorySize ||
+       ulEntries > ulDirectorySize / CentralHeaderSize)
+        return false;
+
+    // Read the central directory...
+    if(!ReadCentralDirectory(ulDirectoryOffset, ulDirectorySize, ulEntries))
+    {
+        Members.clear();
+        EntryIndex.clear();
+        return false;
+    }
+
+    // Done...
+    return true;
+}
+
+// Read the central directory...
+bool ExperimentArchive::ReadCentralDirectory(
+    uint64_t const ulOffset, uint64_t const ulDirectorySize,
+    uint64_t const ulEntries)
+{
+    // Variables...
+    std::vector<uint8_t> Directory;
+
+    // It has to be inside the archive...
+    if(ulOffset > ulSize || ulDirectorySize > ulSize - ulOffset)
+        return false;
+
+    // Read it whole...
+    Directory.resize((size_t) ulDirectorySize);
+    if(!ReadAt(ulOffset, Directory.data(), Directory.size()))
+        return false;
+
+    // Parse each header...
+    size_t Position = 0;
+    Members.reserve((size_t) ulEntries);
+    for(uint64_t ulEntry = 0; ulEntry < ulEntries; ++ulEntry)
+    {
+        // Variables...
+        Entry Member;
+
+        // Check the fixed part is there...
+        if(Position + CentralHeaderSize > Directory.size())
+            return false;
+        uint8_t const *pHeader = &Directory[Position];
+        if(Read32(pHeader) != CentralHeaderSignature)
+            return false;
+
+        // Lengths of the variable parts, and check they're there too...
+        size_t const NameLength     = Read16(pHeader + 28);
+        size_t const ExtraLength    = Read16(pHeader + 30);
+        size_t const CommentLength  = Read16(pHeader + 32);
+        if(Position + CentralHeaderSize + NameLength + ExtraLength +
+            CommentLength > Directory.size())
+            return false;
+
+        // Fill in what we need...
+        Member.unFlags              = Read16(pHeader + 8);
+        Member.unMethod             = Read16(pHeader + 10);
+        Member.unModifiedTime       = Read16(pHeader + 12);
+        Member.unModifiedDate       = Read16(pHeader + 14);
+        Member.unCRC                = Read32(pHeader + 16);
+        Member.ulCompressedSize     = Read32(pHeader + 20);
+        Member.ulUncompressedSize   = Read32(pHeader + 24);
+        Member.ulLocalHeaderOffset  = Read32(pHeader + 42);
+        Member.sName.assign(
+            reinterpret_cast<char const *>(pHeader + CentralHeaderSize),
+            NameLength);
+        Member.bDirectory = !Member.sName.empty() &&
+                            Member.sName[Member.sName.size() - 1] == '/';
+
+        // Any of those too big for the header are in the zip64 extra field,
+        //  in this order, but only the ones that were too big...
+        uint8_t const *pExtra = pHeader + CentralHeaderSize + NameLength;
+        uint8_t const *pExtraEnd = pExtra + ExtraLength;
+        while(pExtra + 4 <= pExtraEnd)
+        {
+            // Field's id and size...
+            uint16_t const unId     = Read16(pExtra);
+            uint16_t const unSize   = Read16(pExtra + 2);
+            uint8_t const *pField   = pExtra + 4;
+            uint8_t const *pFieldEnd = pField + unSize;
+            if(pFieldEnd > pExtraEnd)
+                return false;
+
+            // The one we want...
+            if(unId == Zip64ExtraField)
+            {
+                if(Member.ulUncompressedSize == 0xFFFFFFFF &&
+                   pField + 8 <= pFieldEnd)
+                {
+                    Member.ulUncompressedSize = Read64(pField);
+                    pField += 8;
+                }
+                if(Member.ulCompressedSize == 0xFFFFFFFF &&
+                   pField + 8 <= pFieldEnd)
+                {
+                    Member.ulCompressedSize = Read64(pField);
+                    pField += 8;
+                }
+                if(Member.ulLocalHeaderOffset == 0xFFFFFFFF &&
+                   pField + 8 <= pFieldEnd)
+                    Member.ulLocalHeaderOffset = Read64(pField);
+            }
+
+            // Next...
+            pExtra = pFieldEnd;
+        }
+
+        // Keep it...
+        EntryIndex[Member.sName] = Members.size();
+        Members.push_back(Member);
+
+        // Next...
+        Position += CentralHeaderSize + NameLength + ExtraLength +
+                    CommentLength;
+    }
+
+    // Done...
+    return true;
+}
+
+// Deconstructor...
+ExperimentArchive::~ExperimentArchive()
+{
+    // Close...
+    Close();
+}
+
@@ -0,0 +1,214 @@
+/*
+  Name:         ExperimentArchive.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Read only view of a saved experiment's zip archive, found by
+                way of its central directory alone. Nothing is decompressed
+                or copied when it is opened, so how long that takes depends on
+                the number of entries and not their size. Entries stored
+                without compression, which is how media is saved, can be
+                memory mapped straight out of the archive at their offset.
+                Any entry can be extracted to a file of its own when something
+                needs it as one. Zip64 archives, for experiments over 4 GB,
+                are understood. If an update in place was cut short, the last
+                complete central directory is found further back...
+*/
+
+// Multiple include protection...
+#ifndef _EXPERIMENTARCHIVE_H_
+#define _EXPERIMENTARCHIVE_H_
+
+// Includes...
+
+    // Standard libraries and STL...
+    #include <cstddef>
+    #include <cstdint>
+    #include <map>
+    #include <string>
+    #include <vector>
+
+// ExperimentArchive class...
+class ExperimentArchive
+{
+    // Public types...
+    public:
+
+        // An entry in the central directory...
+        typedef struct Entry
+        {
+            // Name, as stored...
+            std::string         sName;
+
+            // General purpose flags, and how it is compressed, zero if
+            //  stored...
+            uint16_t            unFlags;
+            uint16_t            unMethod;
+
+            // When it was last modified, in MS-DOS form...
+            uint16_t            unModifiedTime;
+            uint16_t            unModifiedDate;
+
+            // Checksum of the uncompressed data...
+            uint32_t            unCRC;
+
+            // Sizes, compressed and not...
+            uint64_t            ulCompressedSize;
+            uint64_t            ulUncompressedSize;
+
+            // Byte offset of its local header from the start of the
+            //  archive...
+            uint64_t            ulLocalHeaderOffset;
+
+            // Is it a directory?
+            bool                bDirectory;
+
+        }Entry;
+
+        // A stored entry mapped into memory, or read into it where the
+        //  platform can't map. Unmapped when destroyed...
+        class Mapping
+        {
+            // Public methods...
+            public:
+
+                // Default constructor...
+                Mapping();
+
+                // Accessors...
+
+                    // The entry's data... θ(1)
+                    uint8_t const  *Data() const;
+
+                    // Its size... θ(1)
+                    size_t          Size() const;
+
+                // Mutators...
+
+                    // Let go of it...
+                    void            Release();
+
+                // Deconstructor releases...
+               ~Mapping();
+
+            // Protected attributes...
+            protected:
+
+                // The whole mapping, starting on a page boundary, and where
+                //  the entry's data is in it...
+                void               *pMapping;
+                size_t              MappingSize;
+                uint8_t const      *pData;
+                size_t              DataSize;
+
+                // Read in rather than mapped...
+                std::vector<uint8_t> Buffer;
+
+            // Private methods...
+            private:
+
+                // Not copyable...
+                Mapping(Mapping const &);
+                Mapping &operator=(Mapping const &);
+
+            // The archive fills it in...
+            friend class ExperimentArchive;
+        };
+
+    // Public methods...
+    public:
+
+        // Default constructor...
+        ExperimentArchive();
+
+        // Accessors...
+
+            // Every entry, in central directory order... θ(1)
+            std::vector<Entry> const &Entries() const;
+
+            // Find an entry by name, or null if there isn't one... O(log n)
+            Entry const        *Find(std::string const &sName) const;
+
+            // Find where an entry's data starts, past its local header.
+            //  Returns false if the header is corrupt...
+            bool                FindData(Entry const &Member,
+                                         uint64_t &ulOffset) const;
+
+            // Path to the archive, empty if none is open... θ(1)
+            std::string const  &GetPath() const;
+
+            // Size of the archive in bytes... θ(1)
+            uint64_t            GetSize() const;
+
+            // Is an archive open?
+            bool                IsOpen() const;
+
+            // Extract an entry to a file of its own, replacing whatever was
+            //  there. Stored entries are copied straight out of a mapping,
+            //  others are inflated. Returns false on any error, in which
+            //  case nothing is left behind...
+            bool                Extract(Entry const &Member,
+                                        std::string const &sDestination) const;
+
+            // Map a stored entry into memory without copying it. Returns false
+            //  if it is compressed or can't be read...
+            bool                Map(Entry const &Member,
+                                    Mapping &View) const;
+
+            // Read an entry into memory whole, inflating it if need be.
+            //  Meant for small entries. Returns false if it can't be...
+            bool                Read(Entry const &Member,
+                                     std::vector<uint8_t> &Data) const;
+
+            // Read exactly the given number of raw bytes at an offset into
+            //  the archive...
+            bool                ReadAt(uint64_t const ulOffset, void *pBuffer,
+                                       size_t const Size) const;
+
+        // Mutators...
+
+            // Close the archive, if any...
+            void                Close();
+
+            // Open an archive and read its central directory. Returns false
+            //  if it isn't a zip archive we understand...
+            bool                Open(std::string const &sPath);
+
+        // Deconstructor closes...
+       ~ExperimentArchive();
+
+    // Protected methods...
+    protected:
+
+        // Read the end record at an offset, and the central directory it
+        //  points to. Returns false if it isn't really one...
+        bool                    ReadEnd(uint64_t const ulEndOffset);
+
+        // Read the central directory, given where it is...
+        bool                    ReadCentralDirectory(
+                                    uint64_t const ulOffset,
+                                    uint64_t const ulDirectorySize,
+                                    uint64_t const ulEntries);
+
+    // Protected attributes...
+    protected:
+
+        // Path to the archive, and the descriptor it's open on...
+        std::string             sPath;
+        int                     nDescriptor;
+
+        // Its size...
+        uint64_t                ulSize;
+
+        // Every entry, and where each is by name...
+        std::vector<Entry>      Members;
+        std::map<std::string, size_t> EntryIndex;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        ExperimentArchive(ExperimentArchive const &);
+        ExperimentArchive &operator=(ExperimentArchive const &);
+};
+
+#endif
+
@@ -0,0 +1,621 @@
+/*
+  Name:         ExperimentArchiveWriter.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Writes a saved experiment's zip archive an entry at a time...
+*/
+
+// Includes...
+#include "ExperimentArchiveWriter.h"
+#ifdef HAVE_CONFIG_H
+    #include "config.h"
+#endif
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Signatures of the records we write...
+static uint32_t const LocalHeaderSignature          = 0x04034b50;
+static uint32_t const CentralHeaderSignature        = 0x02014b50;
+static uint32_t const EndSignature                  = 0x06054b50;
+static uint32_t const Zip64EndSignature             = 0x06064b50;
+static uint32_t const Zip64LocatorSignature         = 0x07064b50;
+
+// Fixed sizes of those records, before any variable length fields...
+static size_t const LocalHeaderSize                 = 30;
+static size_t const Zip64EndSize                    = 56;
+
+// Extra field holding the sizes and offset too big for the headers, and how
+//  big it is in a local header, where it always has both sizes...
+static uint16_t const Zip64ExtraField               = 0x0001;
+static size_t const Zip64LocalExtraSize             = 20;
+
+// Anything this big or bigger needs zip64, and so does this many entries...
+static uint64_t const Zip64Threshold                = 0xFFFFFFFF;
+static uint64_t const Zip64EntriesThreshold         = 0xFFFF;
+
+// Versions needed to extract, plain and zip64, with Unix as the host...
+static uint16_t const PlainVersion                  = 20;
+static uint16_t const Zip64Version                  = 45;
+static uint16_t const UnixHost                      = 3 << 8;
+
+// Flag saying the sizes and checksum follow the data, which ours never do...
+static uint16_t const DataDescriptorFlag            = 0x0008;
+
+// Stored compression method...
+static uint16_t const StoredMethod                  = 0;
+
+// Permissions kept in the high half of the external attributes...
+static uint32_t const FileAttributes                = 0100644U << 16;
+static uint32_t const DirectoryAttributes           = (040755U << 16) | 0x10;
+
+// Bytes copied at a time...
+static size_t const CopyChunkSize                   = 1 << 20;
+
+// Append little endian integers to a record...
+static void Put16(std::vector<uint8_t> &Record, uint16_t const unValue)
+{
+    Record.push_back(unValue & 0xFF);
+    Record.push_back(unValue >> 8);
+}
+static void Put32(std::vector<uint8_t> &Record, uint32_t const unValue)
+{
+    Put16(Record, unValue & 0xFFFF);
+    Put16(Record, unValue >> 16);
+}
+static void Put64(std::vector<uint8_t> &Record, uint64_t const ulValue)
+{
+    Put32(Record, ulValue & 0xFFFFFFFF);
+    Put32(Record, ulValue >> 32);
+}
+
+// Convert a time to MS-DOS form, which can't go back before 1980...
+static void ToDosTime(
+    time_t const Time, uint16_t &unDosTime, uint16_t &unDosDate)
+{
+    // Break it down...
+    struct tm Local;
+    localtime_r(&Time, &Local);
+    if(Local.tm_year < 80)
+    {
+        unDosTime = 0;
+        unDosDate = (1 << 5) | 1;
+        return;
+    }
+
+    // Pack it...
+    unDosTime = (Local.tm_hour << 11) | (Local.tm_min << 5) |
+                (Local.tm_sec / 2);
+    unDosDate = ((Local.tm_year - 80) << 9) | ((Local.tm_mon + 1) << 5) |
+                Local.tm_mday;
+}
+
+// Update a running CRC-32 with some more data. Start with zero...
+static uint32_t UpdateCRC(
+    uint32_t const unCRC, uint8_t const *pData, size_t const Size)
+{
+    // Table for each byte value, made once...
+    struct Table
+    {
+        uint32_t Values[256];
+        Table()
+        {
+            for(uint32_t unByte = 0; unByte < 256; ++unByte)
+            {
+                uint32_t unValue = unByte;
+                for(int nBit = 0; nBit < 8; ++nBit)
+                    unValue = (unValue & 1) ? 0xEDB88320 ^ (unValue >> 1) :
+                                              unValue >> 1;
+                Values[unByte] = unValue;
+            }
+        }
+    };
+    static Table const CRCTable;
+
+    // Run each byte through it...
+    uint32_t unUpdated = ~unCRC;
+    for(size_t Index = 0; Index < Size; ++Index)
+        unUpdated = CRCTable.Values[(unUpdated ^ pData[Index]) & 0xFF] ^
+                    (unUpdated >> 8);
+    return ~unUpdated;
+}
+
+// Default constructor...
+ExperimentArchiveWriter::ExperimentArchiveWriter()
+    : nDescriptor(-1),
+      bCreated(false),
+      ulOriginalSize(0),
+      ulOffset(0)
+{
+
+}
+
+// Give up...
+void ExperimentArchiveWriter::Abort()
+{
+    // Nothing being written...
+    if(nDescriptor < 0)
+        return;
+
+    // A new archive goes altogether, an updated one back to how it was...
+    if(bCreated)
+    {
+        close(nDescriptor);
+        std::remove(sPath.c_str());
+    }
+    else
+    {
+        if(ftruncate(nDescriptor, (off_t) ulOriginalSize) != 0)
+        {
+            // Nothing more we can do about it...
+        }
+        close(nDescriptor);
+    }
+
+    // Forget it...
+    nDescriptor = -1;
+    sPath.clear();
+    Directory.clear();
+}
+
+// Add an entry holding the given data...
+bool ExperimentArchiveWriter::AddData(
+    std::string const &sName, void const *pData, size_t const Size)
+{
+    // Describe it...
+    ExperimentArchive::Entry Member;
+    Member.sName                = sName;
+    Member.unFlags              = 0;
+    Member.unMethod             = StoredMethod;
+    Member.unCRC                =
+        UpdateCRC(0, static_cast<uint8_t const *>(pData), Size);
+    Member.ulCompressedSize     = Size;
+    Member.ulUncompressedSize   = Size;
+    Member.bDirectory           = false;
+    ToDosTime(std::time(NULL), Member.unModifiedTime, Member.unModifiedDate);
+
+    // Write it...
+    if(!BeginEntry(Member) || !Write(pData, Size))
+        return false;
+
+    // List it...
+    Directory.push_back(Member);
+    return true;
+}
+
+// Add a directory entry...
+bool ExperimentArchiveWriter::AddDirectory(std::string const &sName)
+{
+    // Describe it...
+    ExperimentArchive::Entry Member;
+    Member.sName                = sName;
+    Member.unFlags              = 0;
+    Member.unMethod             = StoredMethod;
+    Member.unCRC                = 0;
+    Member.ulCompressedSize     = 0;
+    Member.ulUncompressedSize   = 0;
+    Member.bDirectory           = true;
+    ToDosTime(std::time(NULL), Member.unModifiedTime, Member.unModifiedDate);
+
+    // Write its header, which is all there is of it...
+    if(!BeginEntry(Member))
+        return false;
+
+    // List it...
+    Directory.push_back(Member);
+    return true;
+}
+
+// Add an entry holding a copy of a file...
+bool ExperimentArchiveWriter::AddFile(
+    std::string const &sName, std::string const &sSource)
+{
+    // Variables...
+    struct stat Status;
+
+    // Open it and find out how big it is...
+    int const nSource = open(sSource.c_str(), O_RDONLY);
+    if(nSource < 0)
+        return false;
+    if(fstat(nSource, &Status) != 0)
+    {
+        close(nSource);
+        return false;
+    }
+
+    // We read it once, front to back...
+#ifdef HAVE_POSIX_FADVISE
+    posix_fadvise(nSource, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // Describe it. The checksum is only known once it's been read...
+    ExperimentArchive::Entry Member;
+    Member.sName                = sName;
+    Member.unFlags              = 0;
+    Member.unMethod             = StoredMethod;
+    Member.unCRC                = 0;
+    Member.ulCompressedSize     = Status.st_size;
+    Member.ulUncompressedSize   = Status.st_size;
+    Member.bDirectory           = false;
+    ToDosTime(Status.st_mtime, Member.unModifiedTime, Member.unModifiedDate);
+
+    // Start it...
+    if(!BeginEntry(Member))
+    {
+        close(nSource);
+        return false;
+    }
+
+    // Copy it a chunk at a time, checksumming as we go...
+    std::vector<uint8_t> Chunk(CopyChunkSize);
+    uint64_t ulDone = 0;
+    bool bCopied = true;
+    while(bCopied && ulDone < Member.ulUncompressedSize)
+    {
+        size_t const Wanted = (size_t) std::min<uint64_t>(
+            Chunk.size(), Member.ulUncompressedSize - ulDone);
+        ssize_t const Count = read(nSource, Chunk.data(), Wanted);
+        bCopied = (Count > 0) && Write(Chunk.data(), Count);
+        if(bCopied)
+        {
+            Member.unCRC = UpdateCRC(Member.unCRC, Chunk.data(), Count);
+            ulDone += Count;
+        }
+    }
+    close(nSource);
+
+        // Couldn't, or it got shorter while we were at it...
+        if(!bCopied)
+            return false;
+
+    // Now the checksum is known, write the header again with it...
+    if(!WriteLocalHeader(Member))
+        return false;
+
+    // List it...
+    Directory.push_back(Member);
+    return true;
+}
+
+// Start updating an open archive in place...
+bool ExperimentArchiveWriter::Append(ExperimentArchive const &Existing)
+{
+    // Variables...
+    struct stat Status;
+
+    // Give up on whatever came before...
+    Abort();
+
+    // Open it for writing...
+    nDescriptor = open(Existing.GetPath().c_str(), O_WRONLY);
+    if(nDescriptor < 0)
+        return false;
+
+    // Make sure it hasn't changed since it was opened for reading...
+    if(fstat(nDescriptor, &Status) != 0 ||
+       static_cast<uint64_t>(Status.st_size) != Existing.GetSize())
+    {
+        close(nDescriptor);
+        nDescriptor = -1;
+        return false;
+    }
+
+    // New entries go after its old end, leaving all of it alone until the
+    //  new central directory is written...
+    sPath           = Existing.GetPath();
+    bCreated        = false;
+    ulOriginalSize  = Existing.GetSize();
+    ulOffset        = ulOriginalSize;
+
+    // Done...
+    return true;
+}
+
+// Start an entry at the end of what has been written...
+bool ExperimentArchiveWriter::BeginEntry(ExperimentArchive::Entry &Member)
+{
+    // Nothing being written...
+    if(nDescriptor < 0)
+        return false;
+
+    // It starts here...
+    Member.ulLocalHeaderOffset = ulOffset;
+
+    // Write its header and step past it...
+    if(!WriteLocalHeader(Member))
+        return false;
+    ulOffset += LocalHeaderSize + Member.sName.size();
+    if(Member.ulCompressedSize >= Zip64Threshold ||
+       Member.ulUncompressedSize >= Zip64Threshold)
+        ulOffset += Zip64LocalExtraSize;
+
+    // Done...
+    return true;
+}
+
+// Copy an entry raw out of an archive under the given name...
+bool ExperimentArchiveWriter::Copy(
+    ExperimentArchive const &Source, ExperimentArchive::Entry const &Member,
+    std::string const &sName)
+{
+    // Find where its data is...
+    uint64_t ulDataOffset = 0;
+    if(!Source.FindData(Member, ulDataOffset))
+        return false;
+
+    // Describe the copy, the same but for its name. Its sizes and checksum
+    //  go in its header now, not after its data...
+    ExperimentArchive::Entry Copied = Member;
+    Copied.sName    = sName;
+    Copied.unFlags &= ~DataDescriptorFlag;
+
+    // Start it...
+    if(!BeginEntry(Copied))
+        return false;
+
+    // Copy its data a chunk at a time, as it is...
+    std::vector<uint8_t> Chunk(CopyChunkSize);
+    uint64_t ulDone = 0;
+    while(ulDone < Copied.ulCompressedSize)
+    {
+        size_t const Size = (size_t) std::min<uint64_t>(
+            Chunk.size(), Copied.ulCompressedSize - ulDone);
+        if(!Source.ReadAt(ulDataOffset + ulDone, Chunk.data(), Size) ||
+           !Write(Chunk.data(), Size))
+            return false;
+        ulDone += Size;
+    }
+
+    // List it...
+    Directory.push_back(Copied);
+    return true;
+}
+
+// Start a new archive...
+bool ExperimentArchiveWriter::Create(std::string const &_sPath)
+{
+    // Give up on whatever came before...
+    Abort();
+
+    // Create it...
+    nDescriptor = open(_sPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(nDescriptor < 0)
+        return false;
+
+    // Everything goes from the start...
+    sPath           = _sPath;
+    bCreated        = true;
+    ulOriginalSize  = 0;
+    ulOffset        = 0;
+
+    // Done...
+    return true;
+}
+
+// Write the central directory and the end records, and close...
+bool ExperimentArchiveWriter::Finish()
+{
+    // Variables...
+    std::vector<uint8_t> Records;
+
+    // Nothing being written...
+    if(nDescriptor < 0)
+        return false;
+
+    // The central directory goes here...
+    uint64_t const ulDirectoryOffset = ulOffset;
+
+    // List each entry...
+    for(size_t Index = 0; Index < Directory.size(); ++Index)
+    {
+        // Whichever of its sizes and offset are too big go in the zip64
+        //  extra field instead, in this order...
+        ExperimentArchive::Entry const &Member = Directory[Index];
+        std::vector<uint8_t> Extra;
+        if(Member.ulUncompressedSize >= Zip64Threshold)
+            Put64(Extra, Member.ulUncompressedSize);
+        if(Member.ulCompressedSize >= Zip64Threshold)
+            Put64(Extra, Member.ulCompressedSize);
+        if(Member.ulLocalHeaderOffset >= Zip64Threshold)
+            Put64(Extra, Member.ulLocalHeaderOffset);
+        uint16_t const unVersion = Extra.empty() ? PlainVersion : Zip64Version;
+
+        // Its header...
+        Put32(Records, CentralHeaderSignature);
+        Put16(Records, UnixHost | unVersion);
+        Put16(Records, unVersion);
+        Put16(Records, Member.unFlags);
+        Put16(Records, Member.unMethod);
+        Put16(Records, Member.unModifiedTime);
+        Put16(Records, Member.unModifiedDate);
+        Put32(Records, Member.unCRC);
+        Put32(Records, std::min(Member.ulCompressedSize, Zip64Threshold));
+        Put32(Records, std::min(Member.ulUncompressedSize, Zip64Threshold));
+        Put16(Records, Member.sName.size());
+        Put16(Records, Extra.empty() ? 0 : 4 + Extra.size());
+        Put16(Records, 0);
+        Put16(Records, 0);
+        Put16(Records, 0);
+        Put32(Records, Member.bDirectory ? DirectoryAttributes :
+                                           FileAttributes);
+        Put32(Records, std::min(Member.ulLocalHeaderOffset, Zip64Threshold));
+
+        // Its name and extra field...
+        Records.insert(Records.end(), Member.sName.begin(),
+                       Member.sName.end());
+        if(!Extra.empty())
+        {
+            Put16(Records, Zip64ExtraField);
+            Put16(Records, Extra.size());
+            Records.insert(Records.end(), Extra.begin(), Extra.end());
+        }
+    }
+    uint64_t const ulDirectorySize = Records.size();
+
+    // Too many entries, or the directory too big or too far in, so its real
+    //  numbers go in a zip64 end record with a locator pointing to it...
+    bool const bZip64 = Directory.size() >= Zip64EntriesThreshold ||
+                        ulDirectorySize >= Zip64Threshold ||
+                        ulDirectoryOffset >= Zip64Threshold;
+    if(bZip64)
+    {
+        // The zip64 end record...
+        uint64_t const ulZip64EndOffset = ulDirectoryOffset + Records.size();
+        Put32(Records, Zip64EndSignature);
+        Put64(Records, Zip64EndSize - 12);
+        Put16(Records, UnixHost | Zip64Version);
+        Put16(Records, Zip64Version);
+        Put32(Records, 0);
+        Put32(Records, 0);
+        Put64(Records, Directory.size());
+        Put64(Records, Directory.size());
+        Put64(Records, ulDirectorySize);
+        Put64(Records, ulDirectoryOffset);
+
+        // Its locator...
+        Put32(Records, Zip64LocatorSignature);
+        Put32(Records, 0);
+        Put64(Records, ulZip64EndOffset);
+        Put32(Records, 1);
+    }
+
+    // The end record, with whatever fits...
+    Put32(Records, EndSignature);
+    Put16(Records, 0);
+    Put16(Records, 0);
+    Put16(Records, std::min<uint64_t>(Directory.size(), Zip64EntriesThreshold));
+    Put16(Records, std::min<uint64_t>(Directory.size(), Zip64EntriesThreshold));
+    Put32(Records, std::min(ulDirectorySize, Zip64Threshold));
+    Put32(Records, std::min(ulDirectoryOffset, Zip64Threshold));
+    Put16(Records, 0);
+
+    // Every entry has to be on disk before the central directory listing it
+    //  is, so whenever the machine goes down the last complete central
+    //  directory only lists what's really there. Then the central directory
+    //  itself, before it's closed...
+    if(fsync(nDescriptor) != 0 ||
+       !Write(Records.data(), Records.size()) ||
+       ftruncate(nDescriptor, (off_t) ulOffset) != 0 ||
+       fsync(nDescriptor) != 0)
+    {
+        // Undo it...
+        Abort();
+        return false;
+    }
+
+    // Close it. The descriptor is gone whether or not that worked, and may
+    //  already be someone else's, so it's never touched again...
+    bool const bClosed = (close(nDescriptor) == 0);
+    nDescriptor = -1;
+
+    // Closing failed. A new archive goes altogether. An updated one is
+    //  already on disk in full, so it's left as it is rather than cut back
+    //  to how it was through a path that may have changed, but still
+    //  reported...
+    if(!bClosed && bCreated)
+        std::remove(sPath.c_str());
+
+    // Done with it...
+    sPath.clear();
+    Directory.clear();
+    return bClosed;
+}
+
+// Is an archive being written?
+bool ExperimentArchiveWriter::IsOpen() const
+{
+    return (nDescriptor >= 0);
+}
+
+// Keep an entry of the archive being updated where it is...
+bool ExperimentArchiveWriter::Keep(ExperimentArchive::Entry const &Member)
+{
+    // Only what was there before we started adding to it...
+    if(nDescriptor < 0 || bCreated ||
+       Member.ulLocalHeaderOffset >= ulOriginalSize)
+        return false;
+
+    // List it again...
+    Directory.push_back(Member);
+    return true;
+}
+
+// Write bytes at the end of what has been written...
+bool ExperimentArchiveWriter::Write(void const *pData, size_t const Size)
+{
+    // Keep writing until it's all out...
+    size_t Done = 0;
+    while(Done < Size)
+    {
+        ssize_t const Count = pwrite(nDescriptor,
+            static_cast<uint8_t const *>(pData) + Done, Size - Done,
+            (off_t) (ulOffset + Done));
+        if(Count <= 0)
+            return false;
+        Done += Count;
+    }
+    ulOffset += Size;
+
+    // Done...
+    return true;
+}
+
+// Write an entry's local header at its offset...
+bool ExperimentArchiveWriter::WriteLocalHeader(
+    ExperimentArchive::Entry const &Member)
+{
+    // Variables...
+    std::vector<uint8_t> Header;
+
+    // Too big for the header, so both sizes go in the zip64 extra field...
+    bool const bZip64 = Member.ulCompressedSize >= Zip64Threshold ||
+                        Member.ulUncompressedSize >= Zip64Threshold;
+
+    // Its header...
+    Put32(Header, LocalHeaderSignature);
+    Put16(Header, bZip64 ? Zip64Version : PlainVersion);
+    Put16(Header, Member.unFlags);
+    Put16(Header, Member.unMethod);
+    Put16(Header, Member.unModifiedTime);
+    Put16(Header, Member.unModifiedDate);
+    Put32(Header, Member.unCRC);
+    Put32(Header, std::min(Member.ulCompressedSize, Zip64Threshold));
+    Put32(Header, std::min(Member.ulUncompressedSize, Zip64Threshold));
+    Put16(Header, Member.sName.size());
+    Put16(Header, bZip64 ? Zip64LocalExtraSize : 0);
+
+    // Its name and extra field...
+    Header.insert(Header.end(), Member.sName.begin(), Member.sName.end());
+    if(bZip64)
+    {
+        Put16(Header, Zip64ExtraField);
+        Put16(Header, Zip64LocalExtraSize - 4);
+        Put64(Header, Member.ulUncompressedSize);
+        Put64(Header, Member.ulCompressedSize);
+    }
+
+    // Write it where the entry starts...
+    size_t Done = 0;
+    while(Done < Header.size())
+    {
+        ssize_t const Count = pwrite(nDescriptor, &Header[Done],
+            Header.size() - Done,
+            (off_t) (Member.ulLocalHeaderOffset + Done));
+        if(Count <= 0)
+            return false;
+        Done += Count;
+    }
+
+    // Done...
+    return true;
+}
+
+// Deconstructor...
+ExperimentArchiveWriter::~ExperimentArchiveWriter()
+{
+    // Give up, unless finished...
+    Abort();
+}
+
@@ -0,0 +1,132 @@
+/*
+  Name:         ExperimentArchiveWriter.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Writes a saved experiment's zip archive an entry at a time,
+                every one of them stored rather than deflated. It can create
+                a new archive, or update an existing one in place. When
+                updating, entries that haven't changed are kept right where
+                they are and only listed again in the new central directory,
+                while new ones are appended after the old end of the archive.
+                The old central directory is left alone until the new one is
+                written, so an update that fails is undone by cutting the
+                archive back to its old size, and one cut short by a crash
+                still has the old one to be read from. Everything is flushed
+                to disk before the new central directory is written, and that
+                again before finishing. Entries can also be copied raw from
+                another archive, as they are, without inflating or
+                checksumming them again. Zip64 records are written whenever
+                sizes, offsets, or the number of entries need them...
+*/
+
+// Multiple include protection...
+#ifndef _EXPERIMENTARCHIVEWRITER_H_
+#define _EXPERIMENTARCHIVEWRITER_H_
+
+// Includes...
+
+    // Saved experiment archive...
+    #include "ExperimentArchive.h"
+
+    // Standard libraries and STL...
+    #include <cstddef>
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+
+// ExperimentArchiveWriter class...
+class ExperimentArchiveWriter
+{
+    // Public methods...
+    public:
+
+        // Default constructor...
+        ExperimentArchiveWriter();
+
+        // Accessors...
+
+            // Is an archive being written?
+            bool                IsOpen() const;
+
+        // Mutators...
+
+            // Give up, removing a new archive, or cutting one being updated
+            //  back to how it was...
+            void                Abort();
+
+            // Add an entry holding the given data...
+            bool                AddData(std::string const &sName,
+                                        void const *pData, size_t const Size);
+
+            // Add a directory entry. The name should end in a slash...
+            bool                AddDirectory(std::string const &sName);
+
+            // Add an entry holding a copy of a file...
+            bool                AddFile(std::string const &sName,
+                                        std::string const &sSource);
+
+            // Start updating an open archive in place. Anything it has can
+            //  then be kept, and anything added goes after its end...
+            bool                Append(ExperimentArchive const &Existing);
+
+            // Copy an entry raw out of an archive under the given name,
+            //  compressed or not, as it is...
+            bool                Copy(ExperimentArchive const &Source,
+                                     ExperimentArchive::Entry const &Member,
+                                     std::string const &sName);
+
+            // Start a new archive, replacing whatever was there...
+            bool                Create(std::string const &sPath);
+
+            // Write the central directory and the end records, flush it all
+            //  to disk, and close. Aborts if any of that fails...
+            bool                Finish();
+
+            // Keep an entry of the archive being updated where it is... θ(1)
+            bool                Keep(ExperimentArchive::Entry const &Member);
+
+        // Deconstructor aborts, unless finished...
+       ~ExperimentArchiveWriter();
+
+    // Protected methods...
+    protected:
+
+        // Start an entry at the end of what has been written, writing its
+        //  local header. Everything but where it starts should already be
+        //  filled in, and its sizes can't change after...
+        bool                    BeginEntry(ExperimentArchive::Entry &Member);
+
+        // Write bytes at the end of what has been written...
+        bool                    Write(void const *pData, size_t const Size);
+
+        // Write an entry's local header at its offset...
+        bool                    WriteLocalHeader(
+                                    ExperimentArchive::Entry const &Member);
+
+    // Protected attributes...
+    protected:
+
+        // Path to the archive, and the descriptor it's open on...
+        std::string             sPath;
+        int                     nDescriptor;
+
+        // Was it created, rather than being updated? If updated, how big it
+        //  was before...
+        bool                    bCreated;
+        uint64_t                ulOriginalSize;
+
+        // Where the next byte goes...
+        uint64_t                ulOffset;
+
+        // Every entry to list in the central directory...
+        std::vector<ExperimentArchive::Entry> Directory;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        ExperimentArchiveWriter(ExperimentArchiveWriter const &);
+        ExperimentArchiveWriter &operator=(ExperimentArchiveWriter const &);
+};
+
+#endif
+
@@ -0,0 +1,217 @@
+/*
+  Name:         FramePool.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Pool of frame buffers that plugs into cv::Mat as its
+                allocator...
+*/
+
+// Includes...
+#include "FramePool.h"
+
+// Constructor...
+FramePool::FramePool(
+    unsigned int const _unBuffers, int const _nRows, int const _nColumns,
+    int const _nType)
+    : unOutstanding(0),
+      unBuffers(0),
+      bReleased(false)
+{
+    // Size of one frame...
+    size_t const Size = (size_t) _nRows * _nColumns * CV_ELEM_SIZE(_nType);
+
+    // Make the buffers up front, with room on the free list for all of them
+    //  and then some so returning one never has to grow it. Nothing to make
+    //  if the shape isn't known yet...
+    FreeBuffers.reserve(2 * _unBuffers);
+    for(unsigned int unBuffer = 0; Size > 0 && unBuffer < _unBuffers; 
+        ++unBuffer)
+    {
+        Buffer NewBuffer;
+        NewBuffer.pData = (unsigned char *) cv::fastMalloc(Size);
+        NewBuffer.Size  = Size;
+        FreeBuffers.push_back(NewBuffer);
+      ++unBuffers;
+    }
+}
+
+// Get a frame of the given shape backed by a pooled buffer...
+cv::Mat FramePool::Acquire(
+    int const nRows, int const nColumns, int const nType)
+{
+    // Variables...
+    cv::Mat Frame;
+
+    // Have it allocate from us...
+    Frame.allocator = this;
+    Frame.create(nRows, nColumns, nType);
+
+    // Done...
+    return Frame;
+}
+
+// Back a new matrix with a pooled buffer...
+cv::UMatData *FramePool::allocate(
+    int dims, int const *sizes, int type, void *data, size_t *step,
+    cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const
+{
+    // Work out the total size, filling in any steps not given as packed. Same
+    //  as OpenCV's own allocator...
+    size_t Total = CV_ELEM_SIZE(type);
+    for(int nDimension = dims - 1; nDimension >= 0; --nDimension)
+    {
+        // Steps wanted...
+        if(step)
+        {
+            // Caller's own data has its own steps...
+            if(data && step[nDimension] != CV_AUTOSTEP)
+                Total = step[nDimension];
+
+            // Otherwise packed...
+            else
+                step[nDimension] = Total;
+        }
+
+        // Next dimension out...
+        Total *= sizes[nDimension];
+    }
+
+    // Describe the buffer, which is the caller's if they brought one...
+    cv::UMatData *pMatData = new cv::UMatData(this);
+    pMatData->data = pMatData->origdata = 
+        data ? (unsigned char *) data : TakeBuffer(Total);
+    pMatData->size = Total;
+    if(data)
+        pMatData->flags |= cv::UMatData::USER_ALLOCATED;
+
+    // Done...
+    return pMatData;
+}
+
+// Nothing to do for an existing matrix's data...
+bool FramePool::allocate(
+    cv::UMatData *data, cv::AccessFlag accessflags,
+    cv::UMatUsageFlags usageFlags) const
+{
+    return data != NULL;
+}
+
+// Number of buffers made so far...
+unsigned int FramePool::Buffers() const
+{
+    // Lock and check...
+    wxMutexLocker Lock(Mutex);
+    return unBuffers;
+}
+
+// The last matrix referring to a buffer let go of it...
+void FramePool::deallocate(cv::UMatData *data) const
+{
+    // Variables...
+    bool bLastOut = false;
+
+    // Nothing...
+    if(!data)
+        return;
+
+    // Both kinds of reference should be gone...
+    CV_Assert(data->urefcount == 0 && data->refcount == 0);
+
+    // Take back the buffer, unless it was the caller's own...
+    if(!(data->flags & cv::UMatData::USER_ALLOCATED))
+        bLastOut = ReturnBuffer(data->origdata, data->size);
+    delete data;
+
+    // The pool was only waiting on this one...
+    if(bLastOut)
+        delete this;
+}
+
+// Done with the pool...
+void FramePool::Release()
+{
+    // Variables...
+    bool bDelete = false;
+
+    // Free whatever buffers are back already and note whether any are out...
+    {
+        // Lock...
+        wxMutexLocker Lock(Mutex);
+
+        // Free...
+        bReleased = true;
+        for(size_t Index = 0; Index < FreeBuffers.size(); ++Index)
+            cv::fastFree(FreeBuffers[Index].pData);
+        FreeBuffers.clear();
+
+        // Nobody holds one...
+        bDelete = (unOutstanding == 0);
+    }
+
+    // Nothing left to wait for...
+    if(bDelete)
+        delete this;
+}
+
+// Put a buffer back on the free list...
+bool FramePool::ReturnBuffer(unsigned char *pBuffer, size_t const Size) const
+{
+    // Lock...
+    wxMutexLocker Lock(Mutex);
+
+    // One fewer out...
+  --unOutstanding;
+
+    // Nobody will ask for it again, so free it...
+    if(bReleased)
+    {
+        cv::fastFree(pBuffer);
+        return (unOutstanding == 0);
+    }
+
+    // Otherwise keep it for the next frame...
+    Buffer ReturnedBuffer;
+    ReturnedBuffer.pData    = pBuffer;
+    ReturnedBuffer.Size     = Size;
+    FreeBuffers.push_back(ReturnedBuffer);
+
+    // Pool lives on...
+    return false;
+}
+
+// Take a free buffer of the given size...
+unsigned char *FramePool::TakeBuffer(size_t const Size) const
+{
+    // Lock...
+    wxMutexLocker Lock(Mutex);
+
+    // One more out...
+  ++unOutstanding;
+
+    // Any left for a frame of some other shape won't ever be used...
+    while(!FreeBuffers.empty() && FreeBuffers.back().Size != Size)
+    {
+        cv::fastFree(FreeBuffers.back().pData);
+        FreeBuffers.pop_back();
+      --unBuffers;
+    }
+
+    // Every buffer is out, so make another...
+    if(FreeBuffers.empty())
+    {
+      ++unBuffers;
+        return (unsigned char *) cv::fastMalloc(Size);
+    }
+
+    // Take one...
+    unsigned char *pBuffer = FreeBuffers.back().pData;
+    FreeBuffers.pop_back();
+
+    // Done...
+    return pBuffer;
+}
+
+// Only Release() may delete it...
+FramePool::~FramePool()
+{
+    // Release() already freed everything...
+}
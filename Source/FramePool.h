@@ -0,0 +1,128 @@
+/*
+  Name:         FramePool.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Pool of frame buffers that plugs into cv::Mat as its allocator.
+                A cv::Mat created through it takes a free buffer from the pool
+                instead of the heap. When the last cv::Mat referring to that
+                buffer lets go, whichever thread that happens on, the buffer
+                goes back on the free list for the next frame. Whoever created
+                the pool calls Release() instead of deleting it. It frees itself
+                once every buffer is back, since some consumer may still hold a
+                frame after its producer has gone...
+*/
+
+// Multiple include protection...
+#ifndef _FRAMEPOOL_H_
+#define _FRAMEPOOL_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/thread.h>
+
+    // OpenCV...
+    #include <opencv2/opencv.hpp>
+
+    // Standard libraries and STL...
+    #include <cstddef>
+    #include <vector>
+
+// FramePool class...
+class FramePool : public cv::MatAllocator
+{
+    // Public methods...
+    public:
+
+        // Constructor preallocates the given number of buffers, each the size
+        //  of a frame of the given shape. More are made only if every one of
+        //  them is held at once...
+        FramePool(unsigned int const unBuffers, int const nRows,
+                  int const nColumns, int const nType);
+
+        // Accessors...
+
+            // Number of buffers made so far, free or not...
+            unsigned int        Buffers() const;
+
+        // Mutators...
+
+            // Get an uninitialized frame of the given shape backed by a pooled
+            //  buffer. Normally just takes one off the free list. A cv::Mat
+            //  made from it that is later recreated in a different shape, as
+            //  by a decoder, still allocates from the pool... θ(1)
+            cv::Mat             Acquire(int const nRows, int const nColumns,
+                                        int const nType);
+
+            // Done with the pool. It frees itself once every buffer has come
+            //  back, which may be right away...
+            void                Release();
+
+        // cv::MatAllocator interface...
+
+            // Back a new matrix with a pooled buffer...
+            virtual cv::UMatData *allocate(
+                int dims, int const *sizes, int type, void *data,
+                size_t *step, cv::AccessFlag flags,
+                cv::UMatUsageFlags usageFlags) const;
+
+            // Nothing to do for an existing matrix's data...
+            virtual bool        allocate(
+                cv::UMatData *data, cv::AccessFlag accessflags,
+                cv::UMatUsageFlags usageFlags) const;
+
+            // The last matrix referring to a buffer let go of it...
+            virtual void        deallocate(cv::UMatData *data) const;
+
+    // Protected types...
+    protected:
+
+        // A buffer and its size...
+        typedef struct Buffer
+        {
+            unsigned char  *pData;
+            size_t          Size;
+
+        }Buffer;
+
+    // Protected methods...
+    protected:
+
+        // Only Release() may delete it...
+       ~FramePool();
+
+        // Take a free buffer of the given size, making one if there are
+        //  none. Free ones of any other size are freed... θ(1) usually
+        unsigned char      *TakeBuffer(size_t const Size) const;
+
+        // Put a buffer back on the free list. Returns true if the pool was
+        //  released and this was the last one out... θ(1)
+        bool                ReturnBuffer(unsigned char *pBuffer,
+                                         size_t const Size) const;
+
+    // Protected attributes...
+    protected:
+
+        // Guards everything below. Buffers come back on whatever thread the
+        //  last reference to them happened to be dropped on...
+        mutable wxMutex             Mutex;
+
+        // Buffers not held by anybody, and how many are held...
+        mutable std::vector<Buffer> FreeBuffers;
+        mutable unsigned int        unOutstanding;
+
+        // Buffers made in all...
+        mutable unsigned int        unBuffers;
+
+        // Has the owner released it?
+        mutable bool                bReleased;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        FramePool(FramePool const &);
+        FramePool &operator=(FramePool const &);
+};
+
+#endif
+
@@ -0,0 +1,465 @@
+/*
+  Name:         FrameSource.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Somewhere the capture thread can get frames from...
+*/
+
+// Includes...
+#include "FrameSource.h"
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+// Size of the synthetic frames and how many worms are in them...
+static int const            SyntheticWidth      = 640;
+static int const            SyntheticHeight     = 480;
+static unsigned int const   SyntheticWorms      = 8;
+
+// Shape of a synthetic worm, in pixels, and how fast it crawls in pixels per
+//  frame...
+static unsigned int const   SyntheticSegments   = 12;
+static double const         SyntheticLength     = 80.0;
+static double const         SyntheticAmplitude  = 6.0;
+static int const            SyntheticThickness  = 5;
+static double const         SyntheticSpeed      = 1.0;
+
+// How far behind the nominal rate a replay may fall before it stops trying to
+//  catch up, in seconds...
+static double const         MaximumReplayLag    = 1.0;
+
+// Current time in seconds...
+static double Now()
+{
+    return cv::getTickCount() / cv::getTickFrequency();
+}
+
+// Wrap a coordinate into [0, dSize), however far negative it has gone...
+static double Wrap(double const dCoordinate, double const dSize)
+{
+    // A tiny negative remainder can round up to dSize once it's shifted...
+    double dWrapped = std::fmod(dCoordinate, dSize);
+    if(dWrapped < 0.0)
+        dWrapped += dSize;
+    return (dWrapped < dSize) ? dWrapped : 0.0;
+}
+
+// Make a source from its description...
+FrameSource *FrameSource::Create(
+    wxString const &sDescription, double const dFramesPerSecond)
+{
+    // Split into kind and argument...
+    wxString const sKind        = sDescription.BeforeFirst(wxT(':')).Lower();
+    wxString const sArgument    = sDescription.AfterFirst(wxT(':'));
+
+    // Camera, the first one if no index...
+    if(sKind.IsEmpty() || sKind == wxT("camera"))
+    {
+        long lIndex = 0;
+        if(!sArgument.IsEmpty() && !sArgument.ToLong(&lIndex))
+            return NULL;
+        return new CameraFrameSource(lIndex);
+    }
+
+    // Video file...
+    if(sKind == wxT("video"))
+        return new VideoFrameSource(sArgument);
+
+    // Directory of images...
+    if(sKind == wxT("images"))
+        return new ImageSequenceFrameSource(sArgument, dFramesPerSecond);
+
+    // Generated worms...
+    if(sKind == wxT("synthetic"))
+        return new SyntheticFrameSource(dFramesPerSecond);
+
+    // Don't know it...
+    return NULL;
+}
+
+// Default constructor...
+FrameSource::FrameSource()
+    : bReplay(true),
+      dReplayStart(0.0),
+      unReplayed(0)
+{
+
+}
+
+// Move on to the next frame, waiting until it's due when replaying...
+bool FrameSource::Grab()
+{
+    // There are no more...
+    if(!GrabFrame())
+        return false;
+
+    // Going as fast as possible, or paced by itself...
+    double const dFramesPerSecond = GetFramesPerSecond();
+    if(!bReplay || IsLive() || dFramesPerSecond <= 0.0)
+        return true;
+
+    // When this frame is due...
+    double const dNow = Now();
+    if(unReplayed == 0)
+        dReplayStart = dNow;
+    double const dDue = dReplayStart + unReplayed / dFramesPerSecond;
+  ++unReplayed;
+
+    // Early, so wait...
+    if(dDue > dNow)
+        wxMilliSleep((unsigned long) ((dDue - dNow) * 1000.0));
+
+    // Fallen too far behind, so start the clock over rather than rushing
+    //  through a burst of frames to catch up...
+    else if(dNow - dDue > MaximumReplayLag)
+    {
+        dReplayStart    = dNow;
+        unReplayed      = 1;
+    }
+
+    // Done...
+    return true;
+}
+
+// Is it live, and so paced by itself?
+bool FrameSource::IsLive() const
+{
+    return false;
+}
+
+// Replay at the nominal frame rate, or go as fast as possible...
+void FrameSource::SetReplay(bool const _bReplay)
+{
+    bReplay     = _bReplay;
+    unReplayed  = 0;
+}
+
+// Deconstructor...
+FrameSource::~FrameSource()
+{
+
+}
+
+// Camera constructor...
+CameraFrameSource::CameraFrameSource(int const _nIndex)
+    : nIndex(_nIndex)
+{
+
+}
+
+// Frame rate the camera reports...
+double CameraFrameSource::GetFramesPerSecond() const
+{
+    return Capture.get(cv::CAP_PROP_FPS);
+}
+
+// Move on to the next frame...
+bool CameraFrameSource::GrabFrame()
+{
+    return Capture.grab();
+}
+
+// Always live...
+bool CameraFrameSource::IsLive() const
+{
+    return true;
+}
+
+// Open the camera...
+bool CameraFrameSource::Open()
+{
+    return Capture.open(nIndex);
+}
+
+// Retrieve the frame last grabbed...
+bool CameraFrameSource::Retrieve(cv::Mat &Frame)
+{
+    return Capture.retrieve(Frame) && !Frame.empty();
+}
+
+// Video constructor...
+VideoFrameSource::VideoFrameSource(wxString const &_sPath)
+    : sPath(_sPath)
+{
+
+}
+
+// Frame rate the container reports...
+double VideoFrameSource::GetFramesPerSecond() const
+{
+    return Capture.get(cv::CAP_PROP_FPS);
+}
+
+// Move on to the next frame...
+bool VideoFrameSource::GrabFrame()
+{
+    return Capture.grab();
+}
+
+// Open the video...
+bool VideoFrameSource::Open()
+{
+    return Capture.open(std::string(sPath.fn_str()));
+}
+
+// Decode the frame last grabbed...
+bool VideoFrameSource::Retrieve(cv::Mat &Frame)
+{
+    return Capture.retrieve(Frame) && !Frame.empty();
+}
+
+// Image sequence constructor...
+ImageSequenceFrameSource::ImageSequenceFrameSource(
+    wxString const &_sDirectory, double const _dFramesPerSecond)
+    : sDirectory(_sDirectory),
+      unGrabbed(0),
+      dFramesPerSecond(_dFramesPerSecond)
+{
+
+}
+
+// Rate to replay at...
+double ImageSequenceFrameSource::GetFramesPerSecond() const
+{
+    return dFramesPerSecond;
+}
+
+// Move on to the next frame...
+bool ImageSequenceFrameSource::GrabFrame()
+{
+    // There are no more...
+    if(unGrabbed >= Images.size())
+        return false;
+
+    // Next...
+  ++unGrabbed;
+    return true;
+}
+
+// Is the first name before the second, comparing runs of digits by their
+//  value?
+bool ImageSequenceFrameSource::IsNaturallyBefore(
+    wxString const &sFirst, wxString const &sSecond)
+{
+    // Variables...
+    size_t  First   = 0;
+    size_t  Second  = 0;
+
+    // Compare a character or a run of digits at a time...
+    while(First < sFirst.Length() && Second < sSecond.Length())
+    {
+        // Both start a number...
+        if(wxIsdigit(sFirst[First]) && wxIsdigit(sSecond[Second]))
+        {
+            // Skip leading zeroes...
+            while(First < sFirst.Length() && sFirst[First] == wxT('0'))
+              ++First;
+            while(Second < sSecond.Length() && sSecond[Second] == wxT('0'))
+              ++Second;
+
+            // Find the ends of the runs...
+            size_t FirstEnd = First;
+            while(FirstEnd < sFirst.Length() && wxIsdigit(sFirst[FirstEnd]))
+              ++FirstEnd;
+            size_t SecondEnd = Second;
+            while(SecondEnd < sSecond.Length() &&
+                  wxIsdigit(sSecond[SecondEnd]))
+              ++SecondEnd;
+
+            // A longer number is a bigger one...
+            if(FirstEnd - First != SecondEnd - Second)
+                return (FirstEnd - First) < (SecondEnd - Second);
+
+            // Same length, so the first digit to differ decides...
+            int const nOrder = sFirst.Mid(First, FirstEnd - First).Cmp(
+                sSecond.Mid(Second, SecondEnd - Second));
+            if(nOrder != 0)
+                return nOrder < 0;
+
+            // Same number, so carry on after it...
+            First   = FirstEnd;
+            Second  = SecondEnd;
+            continue;
+        }
+
+        // Otherwise compare characters, ignoring case...
+        wxChar const FirstCharacter     = wxTolower(sFirst[First]);
+        wxChar const SecondCharacter    = wxTolower(sSecond[Second]);
+        if(FirstCharacter != SecondCharacter)
+            return FirstCharacter < SecondCharacter;
+
+        // Next...
+      ++First;
+      ++Second;
+    }
+
+    // One is a prefix of the other, so the shorter goes first...
+    return (sFirst.Length() - First) < (sSecond.Length() - Second);
+}
+
+// Is it an image we can read, going by its extension?
+bool ImageSequenceFrameSource::IsImage(wxString const &sPath)
+{
+    // Check the extension...
+    wxString const sExtension = wxFileName(sPath).GetExt().Lower();
+    return (sExtension == wxT("png")   ||
+            sExtension == wxT("jpg")   ||
+            sExtension == wxT("jpeg")  ||
+            sExtension == wxT("bmp")   ||
+            sExtension == wxT("tif")   ||
+            sExtension == wxT("tiff"));
+}
+
+// Every image in a directory, or matching a wildcard pattern, in natural
+//  order...
+bool ImageSequenceFrameSource::List(
+    wxString const &sPattern, std::vector<wxString> &Images)
+{
+    // Variables...
+    wxArrayString   Files;
+    wxString        sDirectory  = sPattern;
+    wxString        sFileSpec;
+
+    // Start over...
+    Images.clear();
+
+    // A pattern, so split it into the directory and what to match in it...
+    if(!wxDir::Exists(sDirectory) && ::wxIsWild(sPattern))
+    {
+        wxFileName const Pattern(sPattern);
+        sDirectory  = Pattern.GetPath();
+        sFileSpec   = Pattern.GetFullName();
+    }
+
+    // Can't read it...
+    if(!wxDir::Exists(sDirectory))
+        return false;
+
+    // Find every file directly in it, keeping only images...
+    wxDir::GetAllFiles(sDirectory, &Files, sFileSpec, wxDIR_FILES);
+    for(size_t Index = 0; Index < Files.GetCount(); ++Index)
+        if(IsImage(Files[Index]))
+            Images.push_back(Files[Index]);
+
+    // Put them in order...
+    std::sort(Images.begin(), Images.end(), IsNaturallyBefore);
+
+    // Done...
+    return true;
+}
+
+// List the images...
+bool ImageSequenceFrameSource::Open()
+{
+    // Start from the first...
+    unGrabbed = 0;
+
+    // Find them, and make sure there is at least one...
+    return List(sDirectory, Images) && !Images.empty();
+}
+
+// Read the image last grabbed...
+bool ImageSequenceFrameSource::Retrieve(cv::Mat &Frame)
+{
+    // Nothing grabbed yet...
+    if(unGrabbed == 0)
+        return false;
+
+    // Read it as eight bit colour, like a camera's frames, whatever depth
+    //  and channels it was saved with...
+    Frame = cv::imread(std::string(Images[unGrabbed - 1].fn_str()),
+                       cv::IMREAD_COLOR);
+    return !Frame.empty();
+}
+
+// Synthetic constructor...
+SyntheticFrameSource::SyntheticFrameSource(double const _dFramesPerSecond)
+    : unFrame(0),
+      dFramesPerSecond(_dFramesPerSecond)
+{
+
+}
+
+// Rate to replay at...
+double SyntheticFrameSource::GetFramesPerSecond() const
+{
+    return dFramesPerSecond;
+}
+
+// Move on to the next frame. They never run out...
+bool SyntheticFrameSource::GrabFrame()
+{
+  ++unFrame;
+    return true;
+}
+
+// Scatter the worms...
+bool SyntheticFrameSource::Open()
+{
+    // Same worms every time, so runs can be compared...
+    Random = cv::RNG(0x51174E4);
+    unFrame = 0;
+
+    // Scatter them, each heading its own way...
+    Worms.resize(SyntheticWorms);
+    for(unsigned int unWorm = 0; unWorm < Worms.size(); ++unWorm)
+    {
+        Worms[unWorm].Start     = cv::Point2d(
+            Random.uniform(0.0, (double) SyntheticWidth),
+            Random.uniform(0.0, (double) SyntheticHeight));
+        Worms[unWorm].dHeading  = Random.uniform(0.0, 2.0 * CV_PI);
+        Worms[unWorm].dPhase    = Random.uniform(0.0, 2.0 * CV_PI);
+    }
+
+    // Done...
+    return true;
+}
+
+// Draw the worms where they are on the frame last grabbed...
+bool SyntheticFrameSource::Retrieve(cv::Mat &Frame)
+{
+    // Dark, noisy background, like a plate under darkfield...
+    Frame.create(SyntheticHeight, SyntheticWidth, CV_8UC1);
+    Random.fill(Frame, cv::RNG::NORMAL, 30.0, 8.0);
+
+    // Draw each worm crawling along its heading and wrapping around the
+    //  edges, wiggling side to side as it goes...
+    std::vector<cv::Point> Body(SyntheticSegments);
+    for(unsigned int unWorm = 0; unWorm < Worms.size(); ++unWorm)
+    {
+        // Where its tail is now...
+        SyntheticWorm const &Worm = Worms[unWorm];
+        double const dCos = std::cos(Worm.dHeading);
+        double const dSin = std::sin(Worm.dHeading);
+        double const dCrawled = unFrame * SyntheticSpeed;
+        double const dTailX = Wrap(
+            Worm.Start.x + dCrawled * dCos, SyntheticWidth);
+        double const dTailY = Wrap(
+            Worm.Start.y + dCrawled * dSin, SyntheticHeight);
+
+        // Lay its body out from there...
+        for(unsigned int unSegment = 0; unSegment < SyntheticSegments;
+          ++unSegment)
+        {
+            // Along and across it...
+            double const dAlong = SyntheticLength * unSegment /
+                (SyntheticSegments - 1);
+            double const dAcross = SyntheticAmplitude * std::sin(
+                Worm.dPhase + unFrame * 0.2 + dAlong * 0.08);
+
+            // Into the frame...
+            Body[unSegment] = cv::Point(
+                (int) (dTailX + dAlong * dCos - dAcross * dSin),
+                (int) (dTailY + dAlong * dSin + dAcross * dCos));
+        }
+
+        // Draw it...
+        cv::polylines(Frame, Body, false, cv::Scalar(230),
+                      SyntheticThickness, cv::LINE_AA);
+    }
+
+    // Done...
+    return true;
+}
+
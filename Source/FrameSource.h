@@ -0,0 +1,288 @@
+/*
+  Name:         FrameSource.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Somewhere the capture thread can get frames from. A camera, a
+                video file, a directory of numbered images, or a generator of
+                synthetic worms. Anything but the camera can be replayed at
+                its nominal frame rate, so it stands in for a camera, or read
+                as fast as it can be, to see how fast everything downstream
+                of it can go. Either way capture, recording, and live tracking
+                can be exercised on a machine with no camera at all...
+*/
+
+// Multiple include protection...
+#ifndef _FRAMESOURCE_H_
+#define _FRAMESOURCE_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+
+    // OpenCV...
+    #include <opencv2/opencv.hpp>
+
+    // Standard libraries and STL...
+    #include <vector>
+
+// FrameSource class...
+class FrameSource
+{
+    // Public methods...
+    public:
+
+        // Make a source from its description. Returns NULL if it isn't one
+        //  we know. Descriptions look like...
+        //
+        //      camera:0            Camera by index
+        //      video:<path>        Video file
+        //      images:<directory>  Every image in a directory, or matching
+        //                          a wildcard pattern, in natural order
+        //      synthetic           Generated worms
+        //
+        //  Images and synthetic worms have no rate of their own, so they
+        //  take the given one...
+        static FrameSource     *Create(wxString const &sDescription,
+                                       double const dFramesPerSecond);
+
+        // Default constructor...
+        FrameSource();
+
+        // Accessors...
+
+            // Nominal frame rate, zero if unknown. Only valid once open...
+            virtual double      GetFramesPerSecond() const = 0;
+
+            // Is it live, and so paced by itself?
+            virtual bool        IsLive() const;
+
+        // Mutators...
+
+            // Move on to the next frame without retrieving it. When
+            //  replaying, waits until it's due. Returns false at the end...
+            bool                Grab();
+
+            // Open it. Returns false if it can't be...
+            virtual bool        Open() = 0;
+
+            // Retrieve the frame last grabbed, reusing the given buffer where
+            //  possible. Returns false on error...
+            virtual bool        Retrieve(cv::Mat &Frame) = 0;
+
+            // Replay at the nominal frame rate, or go as fast as possible...
+            void                SetReplay(bool const bReplay);
+
+        // Deconstructor...
+        virtual                ~FrameSource();
+
+    // Protected methods...
+    protected:
+
+        // Move on to the next frame. Returns false at the end...
+        virtual bool            GrabFrame() = 0;
+
+    // Protected attributes...
+    protected:
+
+        // Replaying at the nominal frame rate, when we started, and frames
+        //  grabbed since...
+        bool                    bReplay;
+        double                  dReplayStart;
+        unsigned int            unReplayed;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        FrameSource(FrameSource const &);
+        FrameSource &operator=(FrameSource const &);
+};
+
+// CameraFrameSource class...
+class CameraFrameSource : public FrameSource
+{
+    // Public methods...
+    public:
+
+        // Constructor takes the camera's index...
+        CameraFrameSource(int const nIndex);
+
+        // Accessors...
+
+            // Frame rate the camera reports...
+            virtual double      GetFramesPerSecond() const;
+
+            // Always live...
+            virtual bool        IsLive() const;
+
+        // Mutators...
+
+            // Open the camera...
+            virtual bool        Open();
+
+            // Retrieve the frame last grabbed...
+            virtual bool        Retrieve(cv::Mat &Frame);
+
+    // Protected methods...
+    protected:
+
+        // Move on to the next frame...
+        virtual bool            GrabFrame();
+
+    // Protected attributes...
+    protected:
+
+        // The camera and its index...
+        cv::VideoCapture        Capture;
+        int                     nIndex;
+};
+
+// VideoFrameSource class...
+class VideoFrameSource : public FrameSource
+{
+    // Public methods...
+    public:
+
+        // Constructor takes the video's path...
+        VideoFrameSource(wxString const &sPath);
+
+        // Accessors...
+
+            // Frame rate the container reports...
+            virtual double      GetFramesPerSecond() const;
+
+        // Mutators...
+
+            // Open the video...
+            virtual bool        Open();
+
+            // Decode the frame last grabbed...
+            virtual bool        Retrieve(cv::Mat &Frame);
+
+    // Protected methods...
+    protected:
+
+        // Move on to the next frame...
+        virtual bool            GrabFrame();
+
+    // Protected attributes...
+    protected:
+
+        // The video and its path...
+        cv::VideoCapture        Capture;
+        wxString                sPath;
+};
+
+// ImageSequenceFrameSource class...
+class ImageSequenceFrameSource : public FrameSource
+{
+    // Public methods...
+    public:
+
+        // Constructor takes the directory and the rate to replay at...
+        ImageSequenceFrameSource(wxString const &sDirectory,
+                                 double const dFramesPerSecond);
+
+        // Accessors...
+
+            // Rate to replay at...
+            virtual double      GetFramesPerSecond() const;
+
+            // Is the first name before the second, comparing runs of digits
+            //  by their value, so frame2 comes before frame10?
+            static bool         IsNaturallyBefore(wxString const &sFirst,
+                                                  wxString const &sSecond);
+
+            // Is it an image we can read, going by its extension?
+            static bool         IsImage(wxString const &sPath);
+
+            // Every image in a directory, or every one matching a wildcard
+            //  pattern like frames/*.tif, in natural order. Returns false if
+            //  the directory can't be read... O(n log n)
+            static bool         List(wxString const &sPattern,
+                                     std::vector<wxString> &Images);
+
+        // Mutators...
+
+            // List the images...
+            virtual bool        Open();
+
+            // Read the image last grabbed...
+            virtual bool        Retrieve(cv::Mat &Frame);
+
+    // Protected methods...
+    protected:
+
+        // Move on to the next frame...
+        virtual bool            GrabFrame();
+
+    // Protected attributes...
+    protected:
+
+        // The directory, the images in it, and how many have been
+        //  grabbed...
+        wxString                sDirectory;
+        std::vector<wxString>   Images;
+        unsigned int            unGrabbed;
+
+        // Rate to replay at...
+        double                  dFramesPerSecond;
+};
+
+// SyntheticFrameSource class...
+class SyntheticFrameSource : public FrameSource
+{
+    // Public methods...
+    public:
+
+        // Constructor takes the rate to replay at...
+        SyntheticFrameSource(double const dFramesPerSecond);
+
+        // Accessors...
+
+            // Rate to replay at...
+            virtual double      GetFramesPerSecond() const;
+
+        // Mutators...
+
+            // Scatter the worms...
+            virtual bool        Open();
+
+            // Draw the worms where they are on the frame last grabbed...
+            virtual bool        Retrieve(cv::Mat &Frame);
+
+    // Protected methods...
+    protected:
+
+        // Move on to the next frame...
+        virtual bool            GrabFrame();
+
+    // Protected types...
+    protected:
+
+        // Where a worm starts, which way it heads, and where it is in its
+        //  wiggle...
+        typedef struct SyntheticWorm
+        {
+            cv::Point2d         Start;
+            double              dHeading;
+            double              dPhase;
+
+        }SyntheticWorm;
+
+    // Protected attributes...
+    protected:
+
+        // The worms, and the frame we're on...
+        std::vector<SyntheticWorm> Worms;
+        unsigned int            unFrame;
+
+        // Rate to replay at...
+        double                  dFramesPerSecond;
+
+        // Noise for the background...
+        cv::RNG                 Random;
+};
+
+#endif
+
@@ -0,0 +1,217 @@
+/*
+  Name:         HabituationAnalyzer.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Measures each worm's response to a schedule of tap stimuli as
+                the frames go by...
+*/
+
+// Includes...
+#include "HabituationAnalyzer.h"
+#include "SlitherMath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Default constructor...
+HabituationAnalyzer::HabituationAnalyzer()
+    : dFramesPerSecond(0.0),
+      unNextStimulus(0),
+      bWindowOpen(false),
+      unWindowStimulus(0),
+      unWindowEnd(0)
+{
+
+}
+
+// Feed the worms as they are after the given frame...
+void HabituationAnalyzer::Advance(
+    unsigned int const unFrame, std::vector<Worm *> const &Worms)
+{
+    // Nothing scheduled or no way to tell when...
+    if(Stimuli() == 0 || dFramesPerSecond <= 0.0)
+        return;
+
+    // Make room for any worms found since last frame, unmeasured so far...
+    if(Responses.size() < Worms.size() * Stimuli())
+        Responses.resize(Worms.size() * Stimuli(),
+                         std::numeric_limits<float>::quiet_NaN());
+
+    // The open window has run its course...
+    if(bWindowOpen && unFrame >= unWindowEnd)
+        EndWindow();
+
+    // The next stimulus lands. Any window still open is cut short...
+    if(unNextStimulus < Stimuli() &&
+       unFrame >= GetStimulusFrame(unNextStimulus))
+    {
+        // Start watching...
+        if(bWindowOpen)
+            EndWindow();
+        StartWindow(unFrame, Worms);
+        return;
+    }
+
+    // Nothing being watched...
+    if(!bWindowOpen)
+        return;
+
+    // Accumulate how far each watched worm moved since last frame...
+    for(unsigned int unWorm = 0; unWorm < Watches.size(); ++unWorm)
+    {
+        // Get its watch...
+        Watch &CurrentWatch = Watches[unWorm];
+        if(!CurrentWatch.bWatching)
+            continue;
+
+        // Accumulate...
+        CvPoint const &Centre = Worms[unWorm]->Centre();
+        CvPoint2D32f const Now = cvPoint2D32f(Centre.x, Centre.y);
+        CurrentWatch.fPath += 
+            SlitherMath::DistanceBetweenTwoPoints(CurrentWatch.Last, Now);
+        CurrentWatch.Last   = Now;
+
+        // Keep its response current...
+        UpdateResponse(unWorm);
+    }
+}
+
+// Stop watching the current stimulus...
+void HabituationAnalyzer::EndWindow()
+{
+    // Each watched worm's response is already current, so just stop...
+    bWindowOpen = false;
+    Watches.clear();
+}
+
+// Get a worm's response to a stimulus...
+float HabituationAnalyzer::GetResponse(
+    unsigned int const unWorm, unsigned int const unStimulus) const
+{
+    // Not tracked yet...
+    size_t const Index = unWorm * Stimuli() + unStimulus;
+    if(Index >= Responses.size())
+        return std::numeric_limits<float>::quiet_NaN();
+
+    // Lookup...
+    return Responses[Index];
+}
+
+// Every response, worm after worm...
+std::vector<float> const &HabituationAnalyzer::GetResponses() const
+{
+    return Responses;
+}
+
+// Get the frame a stimulus lands on...
+unsigned int HabituationAnalyzer::GetStimulusFrame(
+    unsigned int const unStimulus) const
+{
+    // Variables...
+    double dTime = StimulusSchedule.dFirstStimulus;
+
+    // Habituating taps are evenly spaced...
+    if(unStimulus < StimulusSchedule.unStimuli)
+        dTime += unStimulus * StimulusSchedule.dInterval;
+
+    // Recovery taps follow the last of them after a delay...
+    else
+        dTime += (StimulusSchedule.unStimuli > 0 ?
+                    (StimulusSchedule.unStimuli - 1) *
+                        StimulusSchedule.dInterval : 0.0) +
+                 StimulusSchedule.dRecoveryDelay +
+                 (unStimulus - StimulusSchedule.unStimuli) *
+                    StimulusSchedule.dInterval;
+
+    // Convert to frames...
+    return (unsigned int) lround(dTime * dFramesPerSecond);
+}
+
+// Forget all responses...
+void HabituationAnalyzer::Reset()
+{
+    // Start from the first stimulus again...
+    unNextStimulus  = 0;
+    bWindowOpen     = false;
+    Watches.clear();
+    Responses.clear();
+}
+
+// Set the frame rate...
+void HabituationAnalyzer::SetFrameRate(double const _dFramesPerSecond)
+{
+    dFramesPerSecond = _dFramesPerSecond;
+}
+
+// Set the schedule...
+void HabituationAnalyzer::SetSchedule(Schedule const &NewSchedule)
+{
+    // Store and start over...
+    StimulusSchedule = NewSchedule;
+    Reset();
+}
+
+// Start watching the next stimulus...
+void HabituationAnalyzer::StartWindow(
+    unsigned int const unFrame, std::vector<Worm *> const &Worms)
+{
+    // Open the window...
+    bWindowOpen         = true;
+    unWindowStimulus    = unNextStimulus++;
+    unWindowEnd         = unFrame + std::max(1L,
+        lround(StimulusSchedule.dResponseWindow * dFramesPerSecond));
+
+    // Note where every worm is and which way it faces...
+    Watches.resize(Worms.size());
+    for(unsigned int unWorm = 0; unWorm < Worms.size(); ++unWorm)
+    {
+        // Get the worm and its watch...
+        Worm const &CurrentWorm  = *Worms[unWorm];
+        Watch      &CurrentWatch = Watches[unWorm];
+
+        // Only worms that have actually been seen can be watched...
+        CurrentWatch.bWatching = CurrentWorm.Refreshes() > 0;
+        if(!CurrentWatch.bWatching)
+            continue;
+
+        // Where it is...
+        CvPoint const &Centre = CurrentWorm.Centre();
+        CurrentWatch.Start  = cvPoint2D32f(Centre.x, Centre.y);
+        CurrentWatch.Last   = CurrentWatch.Start;
+        CurrentWatch.fPath  = 0.0f;
+
+        // Which way it faces, from centre to head...
+        CvPoint const &Head = CurrentWorm.Head();
+        float const fAxisX  = Head.x - Centre.x;
+        float const fAxisY  = Head.y - Centre.y;
+        float const fLength = sqrtf(fAxisX * fAxisX + fAxisY * fAxisY);
+        CurrentWatch.Axis   = (fLength > 0.0f) ?
+            cvPoint2D32f(fAxisX / fLength, fAxisY / fLength) :
+            cvPoint2D32f(0.0f, 0.0f);
+
+        // No response yet...
+        UpdateResponse(unWorm);
+    }
+}
+
+// Update a watched worm's response so far...
+void HabituationAnalyzer::UpdateResponse(unsigned int const unWorm)
+{
+    // Get its watch...
+    Watch const &CurrentWatch = Watches[unWorm];
+
+    // Which way did it go, relative to where it was facing?
+    float const fAlongAxis =
+        (CurrentWatch.Last.x - CurrentWatch.Start.x) * CurrentWatch.Axis.x +
+        (CurrentWatch.Last.y - CurrentWatch.Start.y) * CurrentWatch.Axis.y;
+
+    // Store how far it went, backwards being negative...
+    Responses[unWorm * Stimuli() + unWindowStimulus] =
+        (fAlongAxis < 0.0f) ? -CurrentWatch.fPath : CurrentWatch.fPath;
+}
+
+// Total stimuli in the schedule...
+unsigned int HabituationAnalyzer::Stimuli() const
+{
+    return StimulusSchedule.unStimuli + StimulusSchedule.unRecoveryStimuli;
+}
+
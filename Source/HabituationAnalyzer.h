@@ -0,0 +1,167 @@
+/*
+  Name:         HabituationAnalyzer.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Measures each worm's response to a schedule of tap stimuli as
+                the frames go by. When a stimulus lands, every worm's centre
+                and head axis are noted. Until the response window closes, the
+                distance its centre travels is accumulated frame by frame. The
+                response is that distance, negated if the net displacement ran
+                against the head axis, as in a reversal. Only constant work is
+                done per worm per frame, so the results are complete as soon
+                as the last frame is...
+*/
+
+// Multiple include protection...
+#ifndef _HABITUATIONANALYZER_H_
+#define _HABITUATIONANALYZER_H_
+
+// Includes...
+
+    // Worm class...
+    #include "Worm.h"
+
+    // OpenCV types...
+    #include <opencv2/core/types_c.h>
+
+    // Standard libraries and STL...
+    #include <vector>
+
+// HabituationAnalyzer class...
+class HabituationAnalyzer
+{
+    // Public types...
+    public:
+
+        // When stimuli are delivered and how long to watch after each, in
+        //  seconds. A run of habituating taps at a fixed interval is followed
+        //  after a delay by a run of recovery taps at the same interval...
+        typedef struct Schedule
+        {
+            // Default constructor disables it...
+            Schedule()
+                : dFirstStimulus(0.0),
+                  dInterval(0.0),
+                  unStimuli(0),
+                  dRecoveryDelay(0.0),
+                  unRecoveryStimuli(0),
+                  dResponseWindow(0.0)
+            {
+            }
+
+            // First tap and the time between taps...
+            double          dFirstStimulus;
+            double          dInterval;
+
+            // Number of habituating taps...
+            unsigned int    unStimuli;
+
+            // Time from the last habituating tap to the first recovery tap,
+            //  and the number of recovery taps...
+            double          dRecoveryDelay;
+            unsigned int    unRecoveryStimuli;
+
+            // How long after each tap a response is measured over...
+            double          dResponseWindow;
+
+        }Schedule;
+
+    // Public methods...
+    public:
+
+        // Default constructor...
+        HabituationAnalyzer();
+
+        // Accessors...
+
+            // Get a worm's response to a stimulus in pixels, positive if
+            //  forwards and negative if backwards. NaN if it wasn't tracked
+            //  when the stimulus landed or the stimulus hasn't come yet. The
+            //  stimulus being watched right now reports its response so
+            //  far... θ(1)
+            float               GetResponse(unsigned int const unWorm,
+                                            unsigned int const unStimulus) const;
+
+            // Every response, worm after worm, Stimuli() per worm...
+            std::vector<float> const &GetResponses() const;
+
+            // Total stimuli in the schedule, recovery ones included... θ(1)
+            unsigned int        Stimuli() const;
+
+        // Mutators...
+
+            // Feed the worms as they are after the given frame... O(n) in
+            //  worms
+            void                Advance(unsigned int const unFrame,
+                                        std::vector<Worm *> const &Worms);
+
+            // Forget all responses, keeping the schedule and frame rate...
+            void                Reset();
+
+            // Set the frame rate, needed to place the stimuli on frames. Zero
+            //  if unknown, which disables the analysis...
+            void                SetFrameRate(double const dFramesPerSecond);
+
+            // Set the schedule, which also resets...
+            void                SetSchedule(Schedule const &NewSchedule);
+
+    // Protected types...
+    protected:
+
+        // A worm's progress through the stimulus being watched...
+        typedef struct Watch
+        {
+            // Was it tracked when the stimulus landed?
+            bool            bWatching;
+
+            // Where it was and which way it was facing then...
+            CvPoint2D32f    Start;
+            CvPoint2D32f    Axis;
+
+            // Where it was on the last frame and how far it has gone since
+            //  the stimulus...
+            CvPoint2D32f    Last;
+            float           fPath;
+
+        }Watch;
+
+    // Protected methods...
+    protected:
+
+        // Stop watching the current stimulus...
+        void                EndWindow();
+
+        // Get the frame a stimulus lands on... θ(1)
+        unsigned int        GetStimulusFrame(unsigned int const unStimulus)
+                                const;
+
+        // Start watching the next stimulus...
+        void                StartWindow(unsigned int const unFrame,
+                                        std::vector<Worm *> const &Worms);
+
+        // Update a watched worm's response so far...
+        void                UpdateResponse(unsigned int const unWorm);
+
+    // Protected attributes...
+    protected:
+
+        // The schedule and frame rate...
+        Schedule            StimulusSchedule;
+        double              dFramesPerSecond;
+
+        // Index of the next stimulus to land...
+        unsigned int        unNextStimulus;
+
+        // Is a response window open, for which stimulus, and when it closes...
+        bool                bWindowOpen;
+        unsigned int        unWindowStimulus;
+        unsigned int        unWindowEnd;
+
+        // Every worm's progress through the open window...
+        std::vector<Watch>  Watches;
+
+        // Every worm's responses, Stimuli() per worm...
+        std::vector<float>  Responses;
+};
+
+#endif
+
@@ -9,6 +9,7 @@
 #include "MainFrame.h"
 #include "ImageAnalysisWindow.h"
 #include "Resources/slither.xpm"
+#include <cassert>
 
 // Constructor...
 ImageAnalysisWindow::ImageAnalysisWindow(MainFrame *Parent)
@@ -69,21 +70,18 @@ void ImageAnalysisWindow::OnPaint(wxPaintEvent &Event)
 }
 
 // Set the image to show...
-void ImageAnalysisWindow::SetImage(IplImage const &IntelImage)
+void ImageAnalysisWindow::SetImage(cv::Mat const &Image)
 {
-    // Variables...
-    unsigned char          *pRawImageData       = NULL;
-    CvSize                  ImageSize           = cvSize(0, 0);
+    // wxImage wants packed three channel rows...
+    assert(Image.type() == CV_8UC3 && Image.isContinuous());
 
-    // Get the frame's raw data...
-    cvGetRawData(&IntelImage, &pRawImageData, NULL, &ImageSize);
-
-    // Convert the raw data into something wxWidgets understands...
-    wxImage Image = wxImage(
-        IntelImage.width, IntelImage.height, pRawImageData, true);
+    // Wrap the frame's raw data in something wxWidgets understands. Nothing
+    //  is copied until the bitmap is made, and the data is never written...
+    wxImage const WrappedImage(
+        Image.cols, Image.rows, const_cast<unsigned char *>(Image.data), true);
 
     // Turn the image into a bitmap...
-    Bitmap = wxBitmap(Image);
+    Bitmap = wxBitmap(WrappedImage);
     
     // Resize the window...
     SetClientSize(Bitmap.GetWidth(), Bitmap.GetHeight());
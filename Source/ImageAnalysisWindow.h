@@ -32,7 +32,7 @@ class ImageAnalysisWindow : public ImageAnalysisWindow_Base
             ImageAnalysisWindow(MainFrame *Parent);
             
             // Set the image to display...
-            void SetImage(IplImage const &IntelImage);
+            void SetImage(cv::Mat const &Image);
             
             // Deconstructor...
            ~ImageAnalysisWindow();
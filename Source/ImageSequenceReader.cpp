@@ -0,0 +1,334 @@
+/*
+  Name:         ImageSequenceReader.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Decodes a sequence of still images to 8-bit grayscale frames
+                on several threads at once...
+*/
+
+// Includes...
+#include "ImageSequenceReader.h"
+#include "FrameSource.h"
+#ifdef HAVE_CONFIG_H
+    #include "config.h"
+#endif
+#include <wx/dir.h>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Frames the reader may hold on to beyond the ones queued. The frame being
+//  analyzed, and the ones the tracker's thinking displays still refer to...
+static unsigned int const SpareFrames = 4;
+
+// Constructor...
+ImageSequenceReader::ImageSequenceReader(
+    unsigned int const unDepth, unsigned int const _unThreads)
+    : pPool(NULL),
+      FrameDecoded(QueueMutex),
+      FrameRead(QueueMutex),
+      Queue(std::max(unDepth, 1U)),
+      unNextDecode(0),
+      unNextRead(0),
+      bStopping(false),
+      unThreads(std::max(_unThreads, 1U))
+{
+
+}
+
+// Decoder thread constructor...
+ImageSequenceReader::DecoderThread::DecoderThread(
+    ImageSequenceReader &_Reader)
+    : wxThread(wxTHREAD_JOINABLE),
+      Reader(_Reader)
+{
+
+}
+
+// Decoder thread entry point...
+wxThread::ExitCode ImageSequenceReader::DecoderThread::Entry()
+{
+    // Decode until there are no more or asked to stop...
+    Reader.DecodeAhead();
+
+    // Done...
+    return NULL;
+}
+
+// Decode an image into a pooled buffer...
+bool ImageSequenceReader::Decode(
+    wxString const &sPath, std::vector<uchar> &Encoded, cv::Mat &DecodedFrame)
+{
+    // Variables...
+    struct stat Status;
+
+    // Open it and find out how big it is...
+    int const nDescriptor = open(sPath.fn_str(), O_RDONLY);
+    if(nDescriptor < 0)
+        return false;
+    if(fstat(nDescriptor, &Status) != 0 || Status.st_size <= 0)
+    {
+        close(nDescriptor);
+        return false;
+    }
+
+    // We read it once, front to back...
+#ifdef HAVE_POSIX_FADVISE
+    posix_fadvise(nDescriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // Read it all, reusing this thread's buffer from the last image...
+    size_t const Size = Status.st_size;
+    Encoded.resize(Size);
+    size_t Done = 0;
+    while(Done < Size)
+    {
+        ssize_t const Count = read(nDescriptor, &Encoded[Done], Size - Done);
+        if(Count <= 0)
+            break;
+        Done += Count;
+    }
+    close(nDescriptor);
+
+        // Short read...
+        if(Done != Size)
+            return false;
+
+    // Decode into a pooled buffer the shape of the first frame. If this one
+    //  turns out different, the decoder reallocates it from the pool...
+    DecodedFrame = pPool->Acquire(FrameSize.height, FrameSize.width, CV_8UC1);
+    return !cv::imdecode(Encoded, cv::IMREAD_GRAYSCALE, &DecodedFrame).empty();
+}
+
+// Decode images until there are no more or asked to stop...
+void ImageSequenceReader::DecodeAhead()
+{
+    // Encoded image, buffer reused each time...
+    std::vector<uchar> Encoded;
+
+    // Keep decoding until the end or asked to stop...
+    while(true)
+    {
+        // Variables...
+        cv::Mat         DecodedFrame;
+        unsigned int    unFrame = 0;
+
+        // Claim the next frame, once there is room for it in the queue...
+        {
+            // Lock...
+            wxMutexLocker Lock(QueueMutex);
+
+            // Wait...
+            while(!bStopping && unNextDecode < Wanted.size() &&
+                  unNextDecode >= unNextRead + Queue.size())
+                FrameRead.Wait();
+
+            // Asked to stop, or there are no more...
+            if(bStopping || unNextDecode >= Wanted.size())
+                break;
+
+            // Claim...
+            unFrame = unNextDecode;
+          ++unNextDecode;
+        }
+
+        // The one a full queue ahead of it is claimed next time around, so
+        //  have the kernel start reading it in now...
+        if(unFrame + Queue.size() < Wanted.size())
+            Prefetch(Images[Wanted[unFrame + Queue.size()]]);
+
+        // Decode, without holding up the reader or the other decoders...
+        bool const bSucceeded =
+            Decode(Images[Wanted[unFrame]], Encoded, DecodedFrame);
+
+        // Queue it in its place...
+        {
+            // Lock...
+            wxMutexLocker Lock(QueueMutex);
+
+            // Store...
+            Slot &Decoded       = Queue[unFrame % Queue.size()];
+            Decoded.Frame       = DecodedFrame;
+            Decoded.bDecoded    = true;
+            Decoded.bFailed     = !bSucceeded;
+
+            // Wake the reader, if it was waiting for this one...
+            FrameDecoded.Broadcast();
+        }
+    }
+}
+
+// Total number of images in the sequence...
+unsigned int ImageSequenceReader::GetTotalFrames() const
+{
+    return Images.size();
+}
+
+// Is the path a directory or wildcard pattern, rather than a single file?
+bool ImageSequenceReader::IsSequence(wxString const &sPath)
+{
+    return wxDir::Exists(sPath) || ::wxIsWild(sPath);
+}
+
+// Open a sequence and start decoding ahead...
+bool ImageSequenceReader::Open(
+    wxString const &sPattern, unsigned int const unFirstFrame,
+    unsigned int const unStride)
+{
+    // Already open...
+    if(!Decoders.empty())
+        return false;
+
+    // Find every image, in order...
+    if(!ImageSequenceFrameSource::List(sPattern, Images))
+        return false;
+
+    // Pick out the ones to read...
+    Wanted.clear();
+    for(unsigned int unImage = unFirstFrame; unImage < Images.size();
+        unImage += std::max(unStride, 1U))
+        Wanted.push_back(unImage);
+
+        // There are none...
+        if(Wanted.empty())
+            return false;
+
+    // Have the kernel start reading in the first queue's worth...
+    for(unsigned int unFrame = 0;
+        unFrame < std::min<size_t>(Queue.size(), Wanted.size()); ++unFrame)
+        Prefetch(Images[Wanted[unFrame]]);
+
+    // Find out what shape they are from the first...
+    cv::Mat const FirstImage =
+        cv::imread(std::string(Images[Wanted[0]].fn_str()),
+                   cv::IMREAD_GRAYSCALE);
+    if(FirstImage.empty())
+        return false;
+    FrameSize = FirstImage.size();
+
+    // Make enough buffers for a full queue and everything the reader holds...
+    pPool = new FramePool(Queue.size() + SpareFrames,
+                          FrameSize.height, FrameSize.width, CV_8UC1);
+
+    // Start decoding. Any more threads than the queue is deep would only
+    //  wait for room...
+    unsigned int const unDecoders =
+        std::min<size_t>(unThreads, std::min(Queue.size(), Wanted.size()));
+    for(unsigned int unDecoder = 0; unDecoder < unDecoders; ++unDecoder)
+    {
+        // Create...
+        DecoderThread *pDecoder = new DecoderThread(*this);
+
+        // Couldn't start it, so stop whichever did...
+        if(pDecoder->Create() != wxTHREAD_NO_ERROR ||
+           pDecoder->Run() != wxTHREAD_NO_ERROR)
+        {
+            delete pDecoder;
+            Stop();
+            return false;
+        }
+
+        // Keep track of it...
+        Decoders.push_back(pDecoder);
+    }
+
+    // Done...
+    return true;
+}
+
+// Tell the kernel we'll be reading an image soon...
+void ImageSequenceReader::Prefetch(wxString const &sPath)
+{
+#ifdef HAVE_POSIX_FADVISE
+
+    // Open it...
+    int const nDescriptor = open(sPath.fn_str(), O_RDONLY);
+    if(nDescriptor < 0)
+        return;
+
+    // Ask for all of it to be read in. This doesn't wait, and the pages stay
+    //  cached after we close it...
+    posix_fadvise(nDescriptor, 0, 0, POSIX_FADV_WILLNEED);
+    close(nDescriptor);
+
+#else
+
+    // Nothing we can do...
+    (void) sPath;
+
+#endif
+}
+
+// Get the next frame...
+bool ImageSequenceReader::Read(cv::Mat &NextFrame)
+{
+    // Lock...
+    wxMutexLocker Lock(QueueMutex);
+
+    // There are no more, or never were...
+    if(unNextRead >= Wanted.size() || Decoders.empty())
+        return false;
+
+    // Wait for it to be decoded. It will be, whichever thread claimed it...
+    Slot &Next = Queue[unNextRead % Queue.size()];
+    while(!Next.bDecoded && !bStopping)
+        FrameDecoded.Wait();
+
+    // Stopped, or it couldn't be decoded...
+    if(!Next.bDecoded || Next.bFailed)
+        return false;
+
+    // Take it, leaving nothing behind in its slot...
+    NextFrame = Next.Frame;
+    Next.Frame.release();
+    Next.bDecoded = false;
+  ++unNextRead;
+
+    // Let the decoders fill the space...
+    FrameRead.Broadcast();
+
+    // Done...
+    return true;
+}
+
+// Stop decoding and wait for every thread to finish...
+void ImageSequenceReader::Stop()
+{
+    // Not running...
+    if(Decoders.empty())
+        return;
+
+    // Ask them to stop, waking any waiting for room...
+    {
+        // Lock...
+        wxMutexLocker Lock(QueueMutex);
+
+        // Ask and wake...
+        bStopping = true;
+        FrameRead.Broadcast();
+        FrameDecoded.Broadcast();
+    }
+
+    // Wait for each to finish whatever image it was on...
+    for(unsigned int unDecoder = 0; unDecoder < Decoders.size(); ++unDecoder)
+    {
+        Decoders[unDecoder]->Wait();
+        delete Decoders[unDecoder];
+    }
+    Decoders.clear();
+}
+
+// Deconstructor...
+ImageSequenceReader::~ImageSequenceReader()
+{
+    // Stop decoding...
+    Stop();
+
+    // Let go of anything still queued...
+    Queue.clear();
+
+    // Release the pool, which lives on until every frame handed out is...
+    if(pPool)
+        pPool->Release();
+}
+
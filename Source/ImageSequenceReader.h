@@ -0,0 +1,176 @@
+/*
+  Name:         ImageSequenceReader.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Decodes a sequence of still images, like a timelapse saved as
+                numbered PNG or TIFF frames, to 8-bit grayscale frames in
+                order. Unlike a video each image stands on its own, so several
+                threads decode ahead at once, each taking the next image not
+                yet claimed. The kernel is told which files are coming up so
+                it can read them in while the images before are decoded. The
+                reader gets them back in order, no further ahead than a fixed
+                number of frames. Frames are decoded into buffers from a pool,
+                as with the VideoReader. The images are listed when opened, so
+                how many there are is known before the first is decoded...
+*/
+
+// Multiple include protection...
+#ifndef _IMAGESEQUENCEREADER_H_
+#define _IMAGESEQUENCEREADER_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/thread.h>
+
+    // OpenCV...
+    #include <opencv2/opencv.hpp>
+
+    // Frame buffer pool...
+    #include "FramePool.h"
+
+    // Standard libraries and STL...
+    #include <vector>
+
+// ImageSequenceReader class...
+class ImageSequenceReader
+{
+    // Public methods...
+    public:
+
+        // Constructor takes how many frames to decode ahead by, and how many
+        //  threads to decode them with...
+        ImageSequenceReader(unsigned int const unDepth,
+                            unsigned int const unThreads);
+
+        // Accessors...
+
+            // Is the path a directory or wildcard pattern, rather than a
+            //  single file?
+            static bool         IsSequence(wxString const &sPath);
+
+            // Total number of images in the sequence. Only valid once
+            //  open...
+            unsigned int        GetTotalFrames() const;
+
+        // Mutators...
+
+            // Open every image in a directory, or matching a wildcard
+            //  pattern, in natural order, and start decoding ahead from the
+            //  given one. Only every unStride'th image is read, the ones in
+            //  between are never touched. Returns false if there are no
+            //  images, the first can't be decoded, or decoding can't start...
+            bool                Open(wxString const &sPattern,
+                                     unsigned int const unFirstFrame = 0,
+                                     unsigned int const unStride = 1);
+
+            // Get the next frame, waiting for it to be decoded if it hasn't
+            //  been yet. The frame must not be written to. Returns false once
+            //  there are no more, or one couldn't be decoded... θ(1)
+            bool                Read(cv::Mat &NextFrame);
+
+            // Stop decoding and wait for every thread to finish. Frames
+            //  already read stay valid...
+            void                Stop();
+
+        // Deconstructor stops...
+       ~ImageSequenceReader();
+
+    // Protected types...
+    protected:
+
+        // A thread decoding ahead...
+        class DecoderThread : public wxThread
+        {
+            // Public methods...
+            public:
+
+                // Constructor takes the reader it decodes for...
+                DecoderThread(ImageSequenceReader &Reader);
+
+            // Protected methods...
+            protected:
+
+                // Thread entry point...
+                virtual ExitCode Entry();
+
+            // Protected attributes...
+            protected:
+
+                // The reader it decodes for...
+                ImageSequenceReader &Reader;
+        };
+
+        // A place in the ring for a frame, once it's decoded...
+        typedef struct Slot
+        {
+            // The frame...
+            cv::Mat             Frame;
+
+            // Has it been decoded, and did that fail?
+            bool                bDecoded;
+            bool                bFailed;
+
+        }Slot;
+
+    // Protected methods...
+    protected:
+
+        // Decode images until there are no more or asked to stop. Each
+        //  decoder thread runs this...
+        void                    DecodeAhead();
+
+        // Decode an image into a pooled buffer. Returns false if it can't be
+        //  read or decoded...
+        bool                    Decode(wxString const &sPath,
+                                       std::vector<uchar> &Encoded,
+                                       cv::Mat &DecodedFrame);
+
+        // Tell the kernel we'll be reading an image soon...
+        static void             Prefetch(wxString const &sPath);
+
+    // Protected attributes...
+    protected:
+
+        // Every image in the sequence, and the ones to read, in order...
+        std::vector<wxString>   Images;
+        std::vector<unsigned int> Wanted;
+
+        // Pool the frames are decoded into. Released rather than deleted,
+        //  frames may outlive us...
+        FramePool              *pPool;
+
+        // Shape of the first frame, which the rest are assumed to have...
+        cv::Size                FrameSize;
+
+        // Guards everything below, and the conditions signalled when a frame
+        //  is decoded or read...
+        wxMutex                 QueueMutex;
+        wxCondition             FrameDecoded;
+        wxCondition             FrameRead;
+
+        // Ring of frames decoded or being decoded. The wanted frame n goes in
+        //  slot n modulo its size...
+        std::vector<Slot>       Queue;
+
+        // Next wanted frame to claim for decoding, and to read...
+        unsigned int            unNextDecode;
+        unsigned int            unNextRead;
+
+        // Has it been asked to stop?
+        bool                    bStopping;
+
+        // Decoder threads, none until opened...
+        std::vector<DecoderThread *> Decoders;
+        unsigned int            unThreads;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        ImageSequenceReader(ImageSequenceReader const &);
+        ImageSequenceReader &operator=(ImageSequenceReader const &);
+};
+
+#endif
+
@@ -0,0 +1,156 @@
+/*
+  Name:         LiveTrackingThread.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Tracks worms in the camera feed while it is being captured...
+*/
+
+// Includes...
+#include "LiveTrackingThread.h"
+
+// How long to sleep when no new frame is waiting, in milliseconds...
+static unsigned int const PollMilliseconds = 2;
+
+// Gray buffers to start the pool with. The frame being tracked, and the ones
+//  the tracker's thinking displays still refer to...
+static unsigned int const PooledFrames = 4;
+
+// Constructor...
+LiveTrackingThread::LiveTrackingThread(
+    TripleBuffer<CapturedFrame> &_Frames, WormTracker &_Tracker)
+    : wxThread(wxTHREAD_JOINABLE),
+      Frames(_Frames),
+      Tracker(_Tracker),
+      pPool(NULL),
+      unLastFrame(0),
+      bTrackedAny(false),
+      dLatency(0.0),
+      dWorstLatency(0.0),
+      unSkipped(0),
+      unTracked(0),
+      bStopping(false),
+      bStarted(false)
+{
+
+}
+
+// Thread entry point...
+wxThread::ExitCode LiveTrackingThread::Entry()
+{
+    // Keep tracking until asked to stop...
+    while(!bStopping.load(std::memory_order_acquire))
+    {
+        // Nothing new since the last frame, so wait for one...
+        if(!Frames.Acquire())
+        {
+            Sleep(PollMilliseconds);
+            continue;
+        }
+
+        // Track the newest...
+        Track(Frames.Front());
+    }
+
+    // Done...
+    return NULL;
+}
+
+// Seconds from capture to tracked of the last frame...
+double LiveTrackingThread::GetLatency() const
+{
+    return dLatency.load(std::memory_order_relaxed);
+}
+
+// Frames skipped because a newer one was already waiting...
+unsigned int LiveTrackingThread::GetSkipped() const
+{
+    return unSkipped.load(std::memory_order_relaxed);
+}
+
+// Frames tracked...
+unsigned int LiveTrackingThread::GetTracked() const
+{
+    return unTracked.load(std::memory_order_relaxed);
+}
+
+// Longest any frame took from capture to tracked...
+double LiveTrackingThread::GetWorstLatency() const
+{
+    return dWorstLatency.load(std::memory_order_relaxed);
+}
+
+// Start tracking...
+bool LiveTrackingThread::Start()
+{
+    // Start...
+    if(Create() != wxTHREAD_NO_ERROR || Run() != wxTHREAD_NO_ERROR)
+        return false;
+    bStarted = true;
+
+    // Done...
+    return true;
+}
+
+// Stop tracking and wait for the thread to finish the frame it is on...
+void LiveTrackingThread::Stop()
+{
+    // Not running...
+    if(!bStarted)
+        return;
+
+    // Ask it to stop and wait for it...
+    bStopping.store(true, std::memory_order_release);
+    Wait();
+    bStarted = false;
+}
+
+// Track a frame...
+void LiveTrackingThread::Track(CapturedFrame const &Frame)
+{
+    // Count whatever was published and replaced while we were busy...
+    if(bTrackedAny && Frame.unFrame > unLastFrame + 1)
+        unSkipped.fetch_add(
+            Frame.unFrame - unLastFrame - 1, std::memory_order_relaxed);
+    unLastFrame = Frame.unFrame;
+    bTrackedAny = true;
+
+    // First frame, so make the pool now that we know the shape, and time
+    //  reversals by the camera's rate. It's only nominal, since some frames
+    //  are skipped...
+    if(!pPool)
+    {
+        pPool = new FramePool(PooledFrames, Frame.Image.rows, Frame.Image.cols,
+                              CV_8UC1);
+        Tracker.SetFrameRate(Frame.dFramesPerSecond);
+    }
+
+    // Convert to gray in a buffer of our own, since the tracker holds on to
+    //  it and the capture thread will reuse its slot...
+    cv::Mat GrayImage =
+        pPool->Acquire(Frame.Image.rows, Frame.Image.cols, CV_8UC1);
+    if(Frame.Image.channels() == 1)
+        Frame.Image.copyTo(GrayImage);
+    else
+        cv::cvtColor(Frame.Image, GrayImage, cv::COLOR_BGR2GRAY);
+
+    // Track...
+    Tracker.Advance(GrayImage);
+
+    // Note how long it took from capture...
+    double const dFrameLatency = RecordingThread::Now() - Frame.dCaptureTime;
+    dLatency.store(dFrameLatency, std::memory_order_relaxed);
+    if(dFrameLatency > dWorstLatency.load(std::memory_order_relaxed))
+        dWorstLatency.store(dFrameLatency, std::memory_order_relaxed);
+    unTracked.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Deconstructor...
+LiveTrackingThread::~LiveTrackingThread()
+{
+    // Stop tracking...
+    Stop();
+
+    // Release the pool, which lives on until every frame handed out is...
+    if(pPool)
+        pPool->Release();
+}
+
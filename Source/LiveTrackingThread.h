@@ -0,0 +1,119 @@
+/*
+  Name:         LiveTrackingThread.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Tracks worms in the camera feed while it is being captured.
+                Only the newest frame matters, so whatever the capture thread
+                published while the tracker was busy with the last one is
+                skipped rather than queued. The tracker never falls further
+                behind than a single frame, at the cost of a lower and uneven
+                rate when it can't keep up. How many frames it tracked and
+                skipped, and how long each took from capture to tracked, are
+                counted for the capture pane...
+*/
+
+// Multiple include protection...
+#ifndef _LIVETRACKINGTHREAD_H_
+#define _LIVETRACKINGTHREAD_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/thread.h>
+
+    // Captured frames...
+    #include "RecordingThread.h"
+
+    // Lock free newest frame hand over...
+    #include "TripleBuffer.h"
+
+    // Frame buffer pool...
+    #include "FramePool.h"
+
+    // Worm tracker...
+    #include "WormTracker.h"
+
+    // Standard libraries...
+    #include <atomic>
+
+// LiveTrackingThread class...
+class LiveTrackingThread : public wxThread
+{
+    // Public methods...
+    public:
+
+        // Constructor takes the newest captured frame to track, and the
+        //  tracker to track it with. Both must outlive the thread...
+        LiveTrackingThread(TripleBuffer<CapturedFrame> &Frames,
+                           WormTracker &Tracker);
+
+        // Accessors. Safe from any thread while it runs...
+
+            // Seconds from capture to tracked of the last frame, and the
+            //  longest any took... θ(1)
+            double              GetLatency() const;
+            double              GetWorstLatency() const;
+
+            // Frames skipped because a newer one was already waiting... θ(1)
+            unsigned int        GetSkipped() const;
+
+            // Frames tracked... θ(1)
+            unsigned int        GetTracked() const;
+
+        // Mutators...
+
+            // Start tracking. Returns false if the thread couldn't be
+            //  started...
+            bool                Start();
+
+            // Stop tracking and wait for the thread to finish the frame it
+            //  is on...
+            void                Stop();
+
+        // Deconstructor...
+       ~LiveTrackingThread();
+
+    // Protected methods...
+    protected:
+
+        // Thread entry point...
+        virtual ExitCode        Entry();
+
+        // Track a frame...
+        void                    Track(CapturedFrame const &Frame);
+
+    // Protected attributes...
+    protected:
+
+        // Where frames come from, and what tracks them...
+        TripleBuffer<CapturedFrame> &Frames;
+        WormTracker            &Tracker;
+
+        // Gray buffers the tracker holds on to for its thinking displays.
+        //  Made on the first frame, once we know its shape...
+        FramePool              *pPool;
+
+        // The last frame tracked, if any...
+        unsigned int            unLastFrame;
+        bool                    bTrackedAny;
+
+        // Counters...
+        std::atomic<double>     dLatency;
+        std::atomic<double>     dWorstLatency;
+        std::atomic<unsigned int> unSkipped;
+        std::atomic<unsigned int> unTracked;
+
+        // Set when asked to stop...
+        std::atomic<bool>       bStopping;
+        bool                    bStarted;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        LiveTrackingThread(LiveTrackingThread const &);
+        LiveTrackingThread &operator=(LiveTrackingThread const &);
+};
+
+#endif
+
@@ -49,6 +49,7 @@ BEGIN_EVENT_TABLE(MainFrame, MainFrame_Base)
 
     // Capture...
     EVT_TIMER               (TIMER_CAPTURE, MainFrame::OnCaptureFrameReadyTimer)
+    EVT_BUTTON              (ID_CAPTURE_ENDED, MainFrame::OnCaptureEnded)
 
     // Analysis grid popup menu events...
     EVT_MENU                (ID_ANALYSIS_COPY_CLIPBOARD,
@@ -58,6 +59,17 @@ BEGIN_EVENT_TABLE(MainFrame, MainFrame_Base)
 
     // Analysis...
     EVT_BUTTON              (ID_ANALYSIS_ENDED, MainFrame::OnEndAnalysis)
+    EVT_BUTTON              (ID_EXPORT_PROGRESS, MainFrame::OnExportProgress)
+    EVT_BUTTON              (ID_EXPORT_ENDED, MainFrame::OnExportEnded)
+
+    // Saving...
+    EVT_BUTTON              (ID_SAVE_PROGRESS, MainFrame::OnSaveProgress)
+    EVT_BUTTON              (ID_SAVE_ENDED, MainFrame::OnSaveEnded)
+
+    // Importing media...
+    EVT_BUTTON              (ID_IMPORT_PROGRESS, MainFrame::OnImportProgress)
+    EVT_BUTTON              (ID_IMPORT_MEDIA, MainFrame::OnImportedMedia)
+    EVT_BUTTON              (ID_IMPORT_ENDED, MainFrame::OnImportEnded)
     EVT_TIMER               (TIMER_ANALYSIS, 
                                 MainFrame::OnAnalysisFrameReadyTimer)
 
@@ -70,8 +82,15 @@ MainFrame::MainFrame(wxWindow *Parent)
       pExperiment(NULL),
       pMediaPlayer(NULL),
       CaptureTimer(this, TIMER_CAPTURE),
+      nCapturePreviewWidth(0),
+      nCapturePreviewHeight(0),
+      pLiveTrackingThread(NULL),
       pAnalysisThread(NULL),
-      AnalysisTimer(this, TIMER_ANALYSIS)
+      AnalysisTimer(this, TIMER_ANALYSIS),
+      pResultsExporter(NULL),
+      pAnalysisGridTable(new AnalysisGridTable),
+      nAnalysisSortColumn(wxNOT_FOUND),
+      bAnalysisSortAscending(true)
 {
     // Set the title...
     SetTitle(wxT("Slither"));
@@ -245,6 +264,13 @@ MainFrame::MainFrame(wxWindow *Parent)
             unIndex < MicroscopeTable.size(); unIndex++)
             ChosenMicroscopeName->Append(MicroscopeTable[unIndex].GetName());
 
+        // Back the analysis grid with a virtual table, so cells are only
+        //  formatted when drawn. Clicking a column label sorts by it...
+        AnalysisGrid->SetTable(pAnalysisGridTable, true);
+        AnalysisGrid->EnableEditing(false);
+        AnalysisGrid->Connect(wxEVT_GRID_LABEL_LEFT_CLICK,
+            wxGridEventHandler(MainFrame::OnAnalysisLabelLeftClick), NULL, this);
+
         // Trigger default choices...
         wxCommandEvent  DummyCommandEvent;
         DummyCommandEvent.SetInt(0);
@@ -356,7 +382,31 @@ void MainFrame::OnAnalysisCellRightClick(wxGridEvent &Event)
     AnalysisGrid->PopupMenu(&Menu, Event.GetPosition());
 }
 
-// Copy analysis grid contents to clipboard...
+// Analysis grid column label left clicked...
+void MainFrame::OnAnalysisLabelLeftClick(wxGridEvent &Event)
+{
+    // Not a column label, let the grid handle it...
+    if(Event.GetCol() < 0)
+    {
+        Event.Skip();
+        return;
+    }
+
+    // Same column again flips the direction, otherwise start ascending...
+    if(Event.GetCol() == nAnalysisSortColumn)
+        bAnalysisSortAscending = !bAnalysisSortAscending;
+    else
+    {
+        nAnalysisSortColumn     = Event.GetCol();
+        bAnalysisSortAscending  = true;
+    }
+
+    // Sort and show which column it is by...
+    pAnalysisGridTable->Sort(nAnalysisSortColumn, bAnalysisSortAscending);
+    AnalysisGrid->SetSortingColumn(nAnalysisSortColumn, bAnalysisSortAscending);
+}
+
+// Copy the analysis summary to clipboard...
 void MainFrame::OnAnalysisCopyClipboard(wxCommandEvent &Event)
 {
     // Variables...
@@ -385,8 +435,11 @@ void MainFrame::OnAnalysisCopyClipboard(wxCommandEvent &Event)
         return;
     }
 
-    // Get the contents of the analysis results grid...
-    sContents = GetAnalysisResults();
+    // Format the per worm summary of every row in the grid, accumulated or
+    //  not. Only the summary, since it is bounded by the number of worms. Per
+    //  frame rows can be saved to disk instead...
+    sContents = wxString::FromUTF8(ResultsExporter::FormatSummary(
+        *pAnalysisGridTable, ResultsExporter::TAB_SEPARATED).c_str());
 
     // Add to clipboard...
     wxTheClipboard->SetData(new wxTextDataObject(sContents));
@@ -398,19 +451,23 @@ void MainFrame::OnAnalysisFrameReadyTimer(wxTimerEvent &Event)
     // Variables...
     wxString sTemp;
 
-    // Get the thinking image...
-    IplImage *pThinkingImage = Tracker.GetThinkingImage();
-    
+    // Get the tracker's state as of the last frame it finished...
+    std::shared_ptr<TrackerSnapshot const> const Snapshot = 
+        Tracker.GetSnapshot();
+
+    // Only bother drawing what the tracker was thinking if anyone can see
+    //  it, and then only if it changed...
+    if(pImageAnalysisWindow->IsShown() && Tracker.AcquireThinkingDisplay())
+    {
+        // Rasterize and display...
+        Tracker.GetThinkingDisplay().Rasterize(ThinkingImage);
+        pImageAnalysisWindow->SetImage(ThinkingImage);
+    }
+
         // Not ready yet...
-        if(!pThinkingImage)
+        if(Snapshot->unCurrentFrame == 0)
             return;
 
-    // Display the image...
-    pImageAnalysisWindow->SetImage(*pThinkingImage);
-    
-    // Cleanup...
-    cvReleaseImage(&pThinkingImage);
-
     // Update status every half a second...
     if(pAnalysisThread->StatusUpdateStopWatch.Time() >= 500)
     {
@@ -433,13 +490,13 @@ void MainFrame::OnAnalysisFrameReadyTimer(wxTimerEvent &Event)
             }
 
         // Get current position...
-        int const nCurrentFrame = Tracker.GetCurrentFrameIndex();
+        int const nCurrentFrame = Snapshot->unCurrentFrame;
 
         // Get total number of frames...
-        int const nTotalFrames = Tracker.GetTotalFrames();
+        int const nTotalFrames = Snapshot->unTotalFrames;
 
         // Show number tracking...
-        sTemp.Printf(wxT("%d"), Tracker.Tracking());
+        sTemp.Printf(wxT("%d"), Snapshot->Tracking());
         AnalysisWormsTrackingStatus->ChangeValue(sTemp);
         
         // We have the information we need to compute progress...
@@ -485,36 +542,85 @@ void MainFrame::OnAnalysisFrameReadyTimer(wxTimerEvent &Event)
 // Save the results of the analysis window to disk...
 void MainFrame::OnAnalysisSaveToDisk(wxCommandEvent &Event)
 {
+    // Variables...
+    std::vector<ResultsExporter::AnalyzedMedia> Exported = Analyzed;
+    ResultsExporter::Format                     OutputFormat;
+
     // Cache the last location saved to...
     wxStandardPaths StandardPaths = wxStandardPaths::Get();
     static wxString sLastPath = StandardPaths.GetDocumentsDir();
 
+    // Already exporting or still analyzing...
+    if(pResultsExporter || AnalysisTimer.IsRunning())
+    {
+        // Alert user...
+        wxMessageBox(wxT("Please wait for the current analysis or export to"
+                         " finish first."));
+        return;
+    }
+
     // Prepare save dialog...
     //  2020/06/10 - updating for wxGTK 3
     wxFileDialog FileDialog(this, wxT("Save analysis results..."), sLastPath, 
                             ExperimentTitle->GetValue() + 
-                                wxT(" Analysis Results.txt"),
-                            wxT("Tab delimited text file (*.txt)|*.txt"),
+                                wxT(" Analysis Results.csv"),
+                            wxT("Comma separated values (*.csv)|*.csv|"
+                                "Tab delimited text file (*.txt)|*.txt"),
                             wxFD_SAVE | wxFD_OVERWRITE_PROMPT | wxFD_PREVIEW);
 
         // Show save as dialog and check if user hit cancel...
         if(wxID_CANCEL == FileDialog.ShowModal())
             return;
 
-    // Open the file to save to...
-    std::ofstream UserFile(FileDialog.GetPath().fn_str(), 
-                           std::ios::out | std::ios::trunc);
+    // Include every frame's rows of each piece of media analyzed into the
+    //  grid, for whichever had any saved...
+    for(size_t Media = 0; Media < Exported.size(); ++Media)
+    {
+        wxString const sTrajectoryPath = pExperiment->GetTrajectoryPath(
+            wxString::FromUTF8(Exported[Media].sTitle.c_str()));
+        if(::wxFileExists(sTrajectoryPath))
+            Exported[Media].sTrajectoryPath = sTrajectoryPath.fn_str();
+    }
 
-    // Could not open for writing...
-    if(!UserFile.is_open())
+    // Create the exporter, with the summary of every row in the grid, and
+    //  check for error...
+    OutputFormat = FileDialog.GetFilterIndex() == 1
+                    ? ResultsExporter::TAB_SEPARATED
+                    : ResultsExporter::COMMA_SEPARATED;
+    pResultsExporter = new ResultsExporter(*this, FileDialog.GetPath(),
+        OutputFormat,
+        ResultsExporter::FormatSummary(*pAnalysisGridTable, OutputFormat),
+        Exported);
+    if(pResultsExporter->Create() != wxTHREAD_NO_ERROR)
     {
-        // Alert and abort...
-        wxLogError(wxT("There was a problem saving the analysis results."));
+        // Alert...
+        wxLogError(wxT("Unable to create ResultsExporter..."));
+
+        // Cleanup and abort...
+        delete pResultsExporter;
+        pResultsExporter = NULL;
         return;
     }
 
-    // Write out the file...
-    UserFile << GetAnalysisResults().mb_str();
+    // Run the thread and check for error...
+    pResultsExporter->SetPriority(WXTHREAD_MIN_PRIORITY);
+    if(pResultsExporter->Run() != wxTHREAD_NO_ERROR)
+    {
+        // Alert...
+        wxLogError(wxT("Unable to start the ResultsExporter..."));
+
+        // Cleanup and abort...
+        delete pResultsExporter;
+        pResultsExporter = NULL;
+        return;
+    }
+
+    // No analysing until it's done, that would rewrite the trajectories
+    //  being read...
+    BeginAnalysisButton->Disable();
+
+    // Alert user...
+    AnalysisStatusList->Append(wxT("Saving analysis results..."));
 
     // Update the last location saved to...
     sLastPath = ::wxPathOnly(FileDialog.GetPath());
@@ -530,6 +636,15 @@ void MainFrame::OnBeginAnalysis(wxCommandEvent &Event)
     if(AnalysisTimer.IsRunning())
         return;
 
+    // Still exporting. It reads the trajectories analysis would rewrite...
+    if(pResultsExporter)
+    {
+        // Alert user...
+        wxMessageBox(wxT("Please wait for the current export to finish"
+                         " first."));
+        return;
+    }
+
     // They don't have a single media selected...
     if(MediaGrid->GetSelectedRows().GetCount() != 1)
     {
@@ -545,6 +660,13 @@ void MainFrame::OnBeginAnalysis(wxCommandEvent &Event)
         return;
     }
 
+    // Load the stimulus schedule for the analysis type, empty if body size...
+    Tracker.SetHabituationSchedule(
+        GetHabituationSchedule(ChosenAnalysisType->GetCurrentSelection()));
+
+    // Load the reversal detection thresholds...
+    Tracker.SetReversalSettings(GetReversalSettings());
+
     // Load the artificial intelligence settings...
     Tracker.SetArtificialIntelligenceMagic(
         ThresholdSpinner->GetValue(),
@@ -603,6 +725,10 @@ void MainFrame::OnBeginAnalysis(wxCommandEvent &Event)
         // Show the image analysis window...
         pImageAnalysisWindow->Show();
 
+    // Remember which media this was, to find its trajectories afterwards...
+    sAnalyzedMediaTitle = 
+        MediaGrid->GetCellValue(MediaGrid->GetSelectedRows()[0], TITLE);
+
     // Create the analysis thread and check for error...
     pAnalysisThread = new AnalysisThread(*this);
     if(pAnalysisThread->Create() != wxTHREAD_NO_ERROR)
@@ -642,38 +768,11 @@ void MainFrame::OnCancelAnalysis(wxCommandEvent &Event)
 // An analysis type was chosen...
 void MainFrame::OnChooseAnalysisType(wxCommandEvent &Event)
 {
-    // Objects...
-    wxGridCellAttr *pColumnAttributes   = NULL;
-    wxString        sTemp;
-
-    // We've only implemented analysis body size so far...
-    if(Event.GetSelection() != ANALYSIS_BODY_SIZE)
-    {
-        // Revert selection to body size analysis...
-        wxCommandEvent  DummyCommandEvent;
-        DummyCommandEvent.SetInt(0);
-        ChosenAnalysisType->SetSelection(ANALYSIS_BODY_SIZE);
-        OnChooseAnalysisType(DummyCommandEvent);
-        
-        // Alert user...
-        wxMessageDialog Message(this, 
-                                wxT("Sorry, but that is not implemented yet."), 
-                                wxT("Analysis Type"), wxICON_INFORMATION);
-        Message.ShowModal();
-        
-        // Abort...
-        return;
-    }
-
-    // Clear analysis grid...
-        
-        // Remove all rows, if any
-        if(AnalysisGrid->GetNumberRows() > 0)
-            AnalysisGrid->DeleteRows(0, AnalysisGrid->GetNumberRows());
-
-        // Remove all columns, if any...
-        if(AnalysisGrid->GetNumberCols() > 0)
-            AnalysisGrid->DeleteCols(0, AnalysisGrid->GetNumberCols());
+    // Clear analysis grid of rows and columns, and forget what was in it...
+    pAnalysisGridTable->Reset();
+    Analyzed.clear();
+    nAnalysisSortColumn = wxNOT_FOUND;
+    AnalysisGrid->UnsetSortingColumn();
 
     // Set row sizes...
     AnalysisGrid->SetRowMinimalAcceptableHeight(25);
@@ -681,88 +780,37 @@ void MainFrame::OnChooseAnalysisType(wxCommandEvent &Event)
     // Initialize grid for body size analysis
     if(Event.GetSelection() == ANALYSIS_BODY_SIZE)
     {
-        // Create columns with thirty stimulus and  three recovery taps...
-        for(int nColumn = 0; nColumn < 3; nColumn++)
-        {
-            // Append column and check for error...
-            if(!AnalysisGrid->AppendCols(1))
-                return;
-
-            // Generate column label...
-            switch(nColumn)
-            {
-                // Label depends on the column...
-                case 0: sTemp = wxT("Length"); break;
-                case 1: sTemp = wxT("Width"); break;
-                case 2: sTemp = wxT("Area"); break;
-            }
-            
-            // Set column label
-            AnalysisGrid->SetColLabelValue(nColumn, sTemp);
-
-            // Set column attributes...
-            pColumnAttributes = AnalysisGrid->GetOrCreateCellAttr(0, nColumn);
-            pColumnAttributes->SetReadOnly();
-            AnalysisGrid->SetColAttr(nColumn, pColumnAttributes);
-        }
-    }
-
-    // Initialize grid for long term habituation...
-    else if(Event.GetSelection() == ANALYSIS_LONG_TERM_HABITUATION)
-    {
-        // Create columns with thirty stimulus and  three recovery taps...
-        for(int nColumn = 0; nColumn < 5 + 3; nColumn++)
-        {
-            // Append column and check for error...
-            if(!AnalysisGrid->AppendCols(1))
-                return;
-
-            // Set column label...
-            
-                // First thirty are stimulus taps...
-                if(nColumn < 5)
-                    AnalysisGrid->SetColLabelValue(nColumn, 
-                        wxString::Format(wxT("Stimulus %d"), nColumn + 1));
-                
-                // Last three are recovery taps...
-                else
-                    AnalysisGrid->SetColLabelValue(nColumn, 
-                        wxString::Format(wxT("Recovery %d"), nColumn + 1 - 30));                
-
-            // Set column attributes...
-            pColumnAttributes = AnalysisGrid->GetOrCreateCellAttr(0, nColumn);
-            pColumnAttributes->SetReadOnly();
-            AnalysisGrid->SetColAttr(nColumn, pColumnAttributes);
-        }
+        // Length, width, and area...
+        pAnalysisGridTable->AddColumn(wxT("Length"), wxT(" mm"));
+        pAnalysisGridTable->AddColumn(wxT("Width"), wxT(" mm"));
+        pAnalysisGridTable->AddColumn(wxT("Area"), wxT(" mm²"));
+
+        // How often each reversed and for how long in all...
+        pAnalysisGridTable->AddColumn(wxT("Reversals"), wxEmptyString);
+        pAnalysisGridTable->AddColumn(wxT("Reversal duration"), wxT(" s"));
     }
 
-    // Initialize grid for short term habituation...
-    else if(Event.GetSelection() == ANALYSIS_SHORT_TERM_HABITUATION)
+    // Initialize grid for either habituation analysis...
+    else if(Event.GetSelection() == ANALYSIS_LONG_TERM_HABITUATION ||
+            Event.GetSelection() == ANALYSIS_SHORT_TERM_HABITUATION)
     {
-        // Create columns with thirty stimulus and  three recovery taps...
-        for(int nColumn = 0; nColumn < 30 + 3; nColumn++)
-        {
-            // Append column and check for error...
-            if(!AnalysisGrid->AppendCols(1))
-                return;
-
-            // Set column label...
-            
-                // First thirty are stimulus taps...
-                if(nColumn < 30)
-                    AnalysisGrid->SetColLabelValue(nColumn, 
-                        wxString::Format(wxT("Stimulus %d"), nColumn + 1));
-                
-                // Last three are recovery taps...
-                else
-                    AnalysisGrid->SetColLabelValue(nColumn, 
-                        wxString::Format(wxT("Recovery %d - 30"), nColumn + 1));                
-
-            // Set column attributes...
-            pColumnAttributes = AnalysisGrid->GetOrCreateCellAttr(0, nColumn);
-            pColumnAttributes->SetReadOnly();
-            AnalysisGrid->SetColAttr(nColumn, pColumnAttributes);
-        }
+        // One column per stimulus in the schedule...
+        HabituationAnalyzer::Schedule const Schedule = 
+            GetHabituationSchedule(Event.GetSelection());
+
+        // Habituating taps first...
+        for(unsigned int unStimulus = 0; unStimulus < Schedule.unStimuli; 
+            unStimulus++)
+            pAnalysisGridTable->AddColumn(
+                wxString::Format(wxT("Stimulus %u"), unStimulus + 1), 
+                wxT(" mm"));
+
+        // Then recovery taps...
+        for(unsigned int unStimulus = 0; 
+            unStimulus < Schedule.unRecoveryStimuli; unStimulus++)
+            pAnalysisGridTable->AddColumn(
+                wxString::Format(wxT("Recovery %u"), unStimulus + 1), 
+                wxT(" mm"));
     }
     
     // This should not happen... (unknown analysis type)
@@ -777,21 +825,16 @@ void MainFrame::OnChooseAnalysisType(wxCommandEvent &Event)
         Notice.ShowModal();
         return;
     }
-    
-    
-    // Add blank rows to be filled in later by individual worms...
-    for(unsigned int unRow = 0; unRow < 15; unRow++)
+
+    // Size columns to their labels, but wide enough for a value. Sizing to
+    //  contents would format every cell...
+    for(int nColumn = 0; nColumn < AnalysisGrid->GetNumberCols(); nColumn++)
     {
-        // Append new row...
-        AnalysisGrid->AppendRows(100);
-        
-        /* Set empty row label...
-        AnalysisGrid->SetRowLabelValue(unRow, wxT(""));*/
+        AnalysisGrid->AutoSizeColLabelSize(nColumn);
+        if(AnalysisGrid->GetColSize(nColumn) < 100)
+            AnalysisGrid->SetColSize(nColumn, 100);
     }
     
-    // Automatically resize all columns and rows to fit contents...
-    AnalysisGrid->AutoSize();
-    
     // Trigger analysis results sizer to recalculate layout...
     AnalysisGrid->GetContainingSizer()->Layout();
 }
@@ -799,16 +842,72 @@ void MainFrame::OnChooseAnalysisType(wxCommandEvent &Event)
 // Capture was toggled...
 void MainFrame::OnCapture(wxCommandEvent &Event)
 {
-    // Capture is being disabled, capture thread will notice this by itself...
+    // Variables...
+    wxConfig   &Configuration = *::wxGetApp().pConfiguration;
+
+    // Capture is being disabled, capture thread will notice this by itself.
+    //  Disable the button until it has, since it still owns the frame ring
+    //  and preview...
     if(!GetToolBar()->GetToolState(ID_CAPTURE))
+    {
+        GetToolBar()->EnableTool(ID_CAPTURE, false);
+        StopLiveTracking();
         return;
+    }
 
     // Disable the button until capture thread is ready...
     GetToolBar()->EnableTool(ID_CAPTURE, false);
 
+    // Nothing to preview or track yet. The last capture thread is done with
+    //  both, or the button wouldn't have been pressable, and the live
+    //  tracker is stopped, so neither side of either is active...
+    StopLiveTracking();
+    CapturePreview.Reset();
+    LiveFrames.Reset();
+
+    // Track worms in the feed as it is captured, if asked to...
+    if(Configuration.Read(wxT("/Capture/LiveTracking"), false))
+    {
+        // Set up the tracker from the same controls and configuration the
+        //  analysis one is, rather than copying it, since an analysis may be
+        //  using it. Measure body size only, since a stimulus schedule needs
+        //  every frame. The frame rate is the feed's, set once it starts...
+        double dDiameter = 1.0;
+        FieldOfViewDiameter->GetValue().ToDouble(&dDiameter);
+        LiveTracker.SetFieldOfViewDiameter(dDiameter);
+        LiveTracker.SetHabituationSchedule(HabituationAnalyzer::Schedule());
+        LiveTracker.SetReversalSettings(GetReversalSettings());
+        LiveTracker.SetArtificialIntelligenceMagic(
+            ThresholdSpinner->GetValue(),
+            MaxThresholdValueSpinner->GetValue(),
+            MinimumCandidateSizeSpinner->GetValue(),
+            MaximumCandidateSizeSpinner->GetValue(),
+            InletDetectionCheckBox->IsChecked(),
+            InletCorrectionSpinner->GetValue());
+        LiveTracker.Reset(0);
+
+        // Start it. The capture thread feeds it once it sees it...
+        pLiveTrackingThread = new LiveTrackingThread(LiveFrames, LiveTracker);
+        if(!pLiveTrackingThread->Start())
+        {
+            // Alert...
+            wxLogError(wxT("Unable to start the LiveTrackingThread..."));
+
+            // Carry on capturing without...
+            delete pLiveTrackingThread;
+            pLiveTrackingThread = NULL;
+        }
+    }
+
     // Switch to the capture notebook pane...
     MainNotebook->ChangeSelection(CAPTURE_PANE);
 
+    // Scale previews to the panel from the first frame...
+    wxSize const PanelSize = CaptureImagePanel->GetSize();
+    nCapturePreviewWidth.store(PanelSize.GetWidth(), std::memory_order_relaxed);
+    nCapturePreviewHeight.store(
+        PanelSize.GetHeight(), std::memory_order_relaxed);
+
     // Create the capture thread and check for error...
     CaptureThread *pCaptureThread = new CaptureThread(this);
     if(pCaptureThread->Create() != wxTHREAD_NO_ERROR)
@@ -817,6 +916,7 @@ void MainFrame::OnCapture(wxCommandEvent &Event)
         wxLogError(wxT("Unable to create CaptureThread..."));
 
         // Cleanup and abort...
+        StopLiveTracking();
         GetToolBar()->EnableTool(ID_CAPTURE, true);
         delete pCaptureThread;
         return;
@@ -833,72 +933,115 @@ void MainFrame::OnCapture(wxCommandEvent &Event)
         wxLogError(wxT("Unable to start the CaptureThread..."));
 
         // Cleanup and abort...
+        StopLiveTracking();
         GetToolBar()->EnableTool(ID_CAPTURE, true);
         delete pCaptureThread;
         return;    
     }
 }
 
-// A frame has just been captured and is ready to be displayed and stored...
+// Capture thread has finished, whether asked to or not...
+void MainFrame::OnCaptureEnded(wxCommandEvent &Event)
+{
+    // Capture was started again since, so the live tracker is the new one's...
+    if(GetToolBar()->GetToolState(ID_CAPTURE))
+        return;
+
+    // Nothing left to feed the live tracker, such as when a replay ran out...
+    StopLiveTracking();
+}
+
+// A frame has just been captured and is ready to be displayed...
 void MainFrame::OnCaptureFrameReadyTimer(wxTimerEvent &Event)
 {
     // Variables...
-    IplImage               *pCapturedIntelImage = NULL;
-    unsigned char          *pRawImageData       = NULL;
-    int                     nStep               = 0;
-    CvSize                  Size;
     int                     x                   = 0;
     int                     y                   = 0;
     int                     nWidth              = 0;
     int                     nHeight             = 0;
 
-    // No frame to grab...
-    if(CaptureFrameBuffer.empty())
+    // Show how far behind the recording is, if recording...
+    if(CaptureFrameBuffer.Capacity() > 0)
+        SetStatusText(wxString::Format(
+            wxT("Recording... %u of %u frames waiting, %llu dropped, "
+                "%llu stalls"),
+            CaptureFrameBuffer.Depth(), CaptureFrameBuffer.Capacity(),
+            (unsigned long long) CaptureFrameBuffer.Drops(),
+            (unsigned long long) CaptureFrameBuffer.Stalls()));
+
+    // Let the capture thread know what size to make the next preview...
+    CaptureImagePanel->GetSize(&nWidth, &nHeight);
+    nCapturePreviewWidth.store(nWidth, std::memory_order_relaxed);
+    nCapturePreviewHeight.store(nHeight, std::memory_order_relaxed);
+
+    // No new frame to show...
+    if(!CapturePreview.Acquire())
         return;
 
-    // Get the most recent frame...
-    pCapturedIntelImage = (IplImage *) CaptureFrameBuffer.back();
+    // The most recent frame, already scaled and converted by the capture
+    //  thread, which won't touch it until we acquire another...
+    CapturePreviewFrame const &Preview = CapturePreview.Front();
 
     // Display frame on capture panel, but only if it is visible...
-    if(MainNotebook->GetSelection() == CAPTURE_PANE)
+    if(MainNotebook->GetSelection() == CAPTURE_PANE && !Preview.Image.empty())
     {
-        // Get the frame's raw data...
-        cvGetRawData(pCapturedIntelImage, &pRawImageData, &nStep, &Size);
+        // Wrap it in something wxWidgets understands, without copying...
+        wxImage WxImage = wxImage(Preview.Image.cols, Preview.Image.rows,
+                                  Preview.Image.data, true);
 
-        // Convert the raw data into something wxWidgets understands...
-        wxImage WxImage = wxImage(pCapturedIntelImage->width, 
-                                  pCapturedIntelImage->height, 
-                                  pRawImageData, true);
-        
         // Get the device context for the video panel...
         wxBufferedPaintDC  DeviceContext(CaptureImagePanel);
 
         // Get the rectangle surrounding the current clipping region...
         DeviceContext.GetClippingBox(&x, &y, &nWidth, &nHeight);
 
-        // Get the width and height of the video preview panel...
-        CaptureImagePanel->GetSize(&nWidth, &nHeight); 
-
-        // Turn the image into a bitmap, scaled to the panel's dimensions...
-        wxBitmap Bitmap = wxBitmap(WxImage.Scale(nWidth, nHeight));
+        // Paint it onto the panel's surface. It's already the panel's size,
+        //  unless the panel was resized since...
+        DeviceContext.DrawBitmap(wxBitmap(WxImage), x, y);
 
-        // Paint the bitmap onto the panel's surface...
-        DeviceContext.DrawBitmap(Bitmap, x, y);
-    }
+        // Show what the live tracker sees over it, if it's running...
+        if(pLiveTrackingThread)
+        {
+            // The tracker's state as of the last frame it finished...
+            std::shared_ptr<TrackerSnapshot const> const Snapshot =
+                LiveTracker.GetSnapshot();
+
+            // Mark each worm, scaled like the frame...
+            double const dScaleX =
+                (double) Preview.Image.cols / Preview.FrameSize.width;
+            double const dScaleY =
+                (double) Preview.Image.rows / Preview.FrameSize.height;
+            double       dTotalLength = 0.0;
+            DeviceContext.SetPen(*wxGREEN_PEN);
+            DeviceContext.SetBrush(*wxTRANSPARENT_BRUSH);
+            for(unsigned int unWorm = 0; unWorm < Snapshot->Tracking();
+              ++unWorm)
+            {
+                // Circle it...
+                TrackerSnapshot::WormSummary const &Summary =
+                    Snapshot->Worms[unWorm];
+                DeviceContext.DrawCircle(
+                    x + (int)(Summary.Centre.x * dScaleX),
+                    y + (int)(Summary.Centre.y * dScaleY), 8);
+
+                // Add to the total length...
+                dTotalLength += Summary.dLength;
+            }
 
-    // Flush buffer to disk from oldest to newest...
-    while(!CaptureFrameBuffer.empty())
-    {
-        // Retrieve oldest... (to preserve order)
-        pCapturedIntelImage = (IplImage *) CaptureFrameBuffer.front();
-        
-        /* TODO: Write frame to disk here */
-        
-            /* increasing buffer -> warning for slow codec */
-        
-        // Deallocate the image and remove its dead pointer from buffer...
-        CaptureFrameBuffer.pop_front();
-        cvReleaseImage(&pCapturedIntelImage);
+            // Summarize...
+            wxString const sLiveStatus = wxString::Format(
+                wxT("%u worms, mean length %.3f mm, latency %.0f ms "
+                    "(worst %.0f ms), %u frames tracked, %u skipped"),
+                Snapshot->Tracking(),
+                Snapshot->Tracking() ? Snapshot->ConvertPixelsToMillimeters(
+                    dTotalLength / Snapshot->Tracking()) : 0.0,
+                pLiveTrackingThread->GetLatency() * 1000.0,
+                pLiveTrackingThread->GetWorstLatency() * 1000.0,
+                pLiveTrackingThread->GetTracked(),
+                pLiveTrackingThread->GetSkipped());
+            DeviceContext.SetTextForeground(*wxGREEN);
+            DeviceContext.DrawText(sLiveStatus, x + 5, y + 5);
+        }
     }
 }
 
@@ -1031,17 +1174,12 @@ void MainFrame::OnChooseMicroscopeTotalZoom(wxCommandEvent &Event)
 // Analysis thread is informing us that it has terminated...
 void MainFrame::OnEndAnalysis(wxCommandEvent &Event)
 {
-    // Get the thinking image...
-    IplImage *pThinkingImage = Tracker.GetThinkingImage();
-    
-    // Show it, if any...
-    if(pThinkingImage)
+    // Show the last thinking display, if the timer didn't get to it...
+    if(Tracker.AcquireThinkingDisplay())
     {
-        // Display the image...
-        pImageAnalysisWindow->SetImage(*pThinkingImage);
-    
-        // Cleanup...
-        cvReleaseImage(&pThinkingImage);
+        // Rasterize and display...
+        Tracker.GetThinkingDisplay().Rasterize(ThinkingImage);
+        pImageAnalysisWindow->SetImage(ThinkingImage);
     }
 
     // Unlock the UI...
@@ -1082,112 +1220,178 @@ void MainFrame::OnEndAnalysis(wxCommandEvent &Event)
         // Alert user...
         AnalysisStatusList->Append(wxT("Analysis ended..."));
 
+        // The analysis thread left trajectories behind to save...
+        if(Tracker.GetTrajectories().Rows() > 0)
+            pExperiment->TriggerNeedSave();
+
         // Refresh the main frame...
         Refresh();
                     
     // Remove all rows, if any and if the user doesn't want to accumulate
     //  results...
-    if(AnalysisGrid->GetNumberRows() > 0 && !AccumulateCheckBox->IsChecked())
-        AnalysisGrid->DeleteRows(0, AnalysisGrid->GetNumberRows());
+    if(!AccumulateCheckBox->IsChecked())
+    {
+        pAnalysisGridTable->Clear();
+        Analyzed.clear();
+    }
+
+    // Remember this media's results start after any accumulated already. If
+    //  it was analyzed into the grid before, its trajectories were just
+    //  overwritten, so the earlier rows no longer have any of their own...
+    for(size_t Media = 0; Media < Analyzed.size(); ++Media)
+    {
+        if(wxString::FromUTF8(Analyzed[Media].sTitle.c_str()) ==
+           sAnalyzedMediaTitle)
+        {
+            Analyzed.erase(Analyzed.begin() + Media);
+            break;
+        }
+    }
+    Analyzed.push_back(ResultsExporter::AnalyzedMedia());
+    Analyzed.back().sTitle = sAnalyzedMediaTitle.ToUTF8().data();
+    Analyzed.back().unFirstWorm = pAnalysisGridTable->GetNumberRows() + 1;
+
+    // Get the tracker's final state. The analysis thread is done with it, but
+    //  this way we don't have to take its word for it...
+    std::shared_ptr<TrackerSnapshot const> const Snapshot = 
+        Tracker.GetSnapshot();
 
     // Body size analysis...
     if(ChosenAnalysisType->GetCurrentSelection() == ANALYSIS_BODY_SIZE)
     {
+        // Worms are numbered on from any results accumulated already...
+        unsigned int const unFirstWorm = 
+            pAnalysisGridTable->GetNumberRows() + 1;
+
         // Output analysis results for each worm...
-        for(unsigned int unWormIndex = 0; unWormIndex < Tracker.Tracking();
+        for(unsigned int unWormIndex = 0; unWormIndex < Snapshot->Tracking();
             unWormIndex++)
         {
-            // Append a new row for this worm and check if ok...
-            if(!AnalysisGrid->AppendRows())
-            {
-                // Alert user...
-                wxLogError(wxT("Out of memory! Check your field of view"
-                               " diameter."));
-                
-                // Abort...
-                break;
-            }
-            
-            // Get the index of the new row...
-            int const nNewRow = AnalysisGrid->GetNumberRows() - 1;
-
             // Get the worm at this index...
-            Worm const &CurrentWorm = Tracker.GetWorm(unWormIndex);
-
-            // Set row label...
-            AnalysisGrid->SetRowLabelValue(nNewRow, 
-                wxString::Format(wxT("Worm %d"), nNewRow + 1));
-                
-            // Length...
-            AnalysisGrid->SetCellValue(nNewRow, ANALYSIS_BODY_SIZE_COLUMN_LENGTH,
-                wxString::Format(wxT("%.3f mm"), 
-                    Tracker.ConvertPixelsToMillimeters(CurrentWorm.Length())));
-
-            // Width...
-            AnalysisGrid->SetCellValue(nNewRow, ANALYSIS_BODY_SIZE_COLUMN_WIDTH,
-                wxString::Format(wxT("%.3f mm"), 
-                    Tracker.ConvertPixelsToMillimeters(CurrentWorm.Width())));
-                    
-            // Area...
-            AnalysisGrid->SetCellValue(nNewRow, ANALYSIS_BODY_SIZE_COLUMN_AREA,
-                wxString::Format(wxT("%.3f mm²"), 
-                    Tracker.ConvertSquarePixelsToSquareMillimeters(
-                        CurrentWorm.Area())));
+            TrackerSnapshot::WormSummary const &CurrentWorm = 
+                Snapshot->Worms[unWormIndex];
+
+            // Length, width, area, and reversals, in the order of the
+            //  columns...
+            float Values[ANALYSIS_BODY_SIZE_COLUMNS];
+            Values[ANALYSIS_BODY_SIZE_COLUMN_LENGTH] = 
+                Snapshot->ConvertPixelsToMillimeters(CurrentWorm.dLength);
+            Values[ANALYSIS_BODY_SIZE_COLUMN_WIDTH] = 
+                Snapshot->ConvertPixelsToMillimeters(CurrentWorm.dWidth);
+            Values[ANALYSIS_BODY_SIZE_COLUMN_AREA] = 
+                Snapshot->ConvertSquarePixelsToSquareMillimeters(
+                    CurrentWorm.dArea);
+            Values[ANALYSIS_BODY_SIZE_COLUMN_REVERSALS] = 
+                CurrentWorm.unReversals;
+            Values[ANALYSIS_BODY_SIZE_COLUMN_REVERSAL_DURATION] = 
+                CurrentWorm.dReversalSeconds;
+
+            // Append a row for this worm...
+            pAnalysisGridTable->AppendRow(unFirstWorm + unWormIndex, Values);
         }
     }
     
-    // Long term habituation analysis...
-    else if(ChosenAnalysisType->GetCurrentSelection() == 
-            ANALYSIS_LONG_TERM_HABITUATION)
-    {
-    
-    }
-    
-    // Short term habituation analysis...
+    // Either habituation analysis...
     else
     {
-    
+        // Worms are numbered on from any results accumulated already...
+        unsigned int const unFirstWorm = 
+            pAnalysisGridTable->GetNumberRows() + 1;
+
+        // One value per stimulus column. If the schedule changed since the
+        //  columns were made, the ones left over stay unmeasured...
+        std::vector<float> Values(pAnalysisGridTable->GetNumberCols());
+
+        // Output each worm's response to each stimulus...
+        for(unsigned int unWormIndex = 0; unWormIndex < Snapshot->Tracking();
+            unWormIndex++)
+        {
+            // Convert each response. Unmeasured ones stay NaN...
+            for(unsigned int unStimulus = 0; unStimulus < Values.size(); 
+                unStimulus++)
+                Values[unStimulus] = Snapshot->ConvertPixelsToMillimeters(
+                    Snapshot->Response(unWormIndex, unStimulus));
+
+            // Append a row for this worm...
+            pAnalysisGridTable->AppendRow(unFirstWorm + unWormIndex, 
+                                          Values.data());
+        }
     }
-    
-    // Automatically resize all columns and rows to fit contents...
-    AnalysisGrid->AutoSize();
+
+    // Show the new rows all at once, keeping any sort order...
+    pAnalysisGridTable->Flush();
+    if(nAnalysisSortColumn != wxNOT_FOUND)
+        pAnalysisGridTable->Sort(nAnalysisSortColumn, bAnalysisSortAscending);
     
     // Trigger analysis results sizer to recalculate layout...
     AnalysisGrid->GetContainingSizer()->Layout();
 }
 
+// Results exporter has made progress...
+void MainFrame::OnExportProgress(wxCommandEvent &Event)
+{
+    // Show it on the analysis gauge, which is idle while exporting...
+    AnalysisGauge->SetRange(100);
+    AnalysisGauge->SetValue(Event.GetInt());
+}
+
+// Results exporter has finished...
+void MainFrame::OnExportEnded(wxCommandEvent &Event)
+{
+    // The thread deletes itself...
+    pResultsExporter = NULL;
+
+    // Analysis can start again...
+    BeginAnalysisButton->Enable();
+
+    // Reset the gauge...
+    AnalysisGauge->SetValue(0);
+
+    // Alert user...
+    if(Event.GetInt())
+        AnalysisStatusList->Append(wxT("Analysis results saved..."));
+    else
+        wxLogError(wxT("There was a problem saving the analysis results."));
+}
+
 // Extract frame button...
 void MainFrame::OnExtractFrame(wxCommandEvent &Event)
 {
     // Variables...
-    CvCapture  *pCapture    = NULL;
+    cv::VideoCapture    Capture;
+    MediaIndex          Index;
+    cv::Mat             OriginalImage;
 
-    // Pause the video...
+    // Pause the video and note where...
     pMediaPlayer->Pause();
+    double const dPosition = wxLongLong(pMediaPlayer->Tell()).ToDouble();
 
     // Initialize capture from AVI...
-    pCapture = cvCreateFileCapture(sCurrentMediaPath.fn_str());
+    if(!Capture.open(std::string(sCurrentMediaPath.fn_str())))
+        return;
+
+    // Seek to the frame showing, by way of the index so the codec doesn't
+    //  have to guess where a time lands...
+    if(LoadMediaIndex(wxFileName(sCurrentMediaPath).GetFullName(), Index))
+        Index.Seek(Capture, Index.FrameAtTime(dPosition));
+
+    // No index, so leave it to the codec...
+    else
+        Capture.set(cv::CAP_PROP_POS_MSEC, dPosition);
 
-        // Failed...
-        if(!pCapture)
-            return;
-    
-    // Seek...
-    cvSetCaptureProperty(pCapture, CV_CAP_PROP_POS_MSEC, pMediaPlayer->Tell());
-    
     // Retrieve the captured image...
-    IplImage const *pOriginalImage = cvQueryFrame(pCapture);
-    
-        // Can't read it...
-        if(!pOriginalImage)
+    if(!Capture.read(OriginalImage) || OriginalImage.empty())
+        return;
+
+    // Prompt user to add it now...
+
+        // The last one may still be being imported from...
+        if(pExperiment->IsImportingMedia())
         {
-            // Cleanup and abort...
-            cvReleaseCapture(&pCapture);
+            SetStatusText(wxT("Still importing media, please wait..."));
             return;
         }
 
-    // Prompt user to add it now...
-
         // Remove old, if present...
         if(::wxFileExists(wxT("Frame.png")))
             ::wxRemoveFile(wxT("Frame.png"));
@@ -1196,25 +1400,19 @@ void MainFrame::OnExtractFrame(wxCommandEvent &Event)
 	//so we can save it (cvSaveImage is deprecated)
         // Save to temporary file name..
         //cvSaveImage("Frame.png", pOriginalImage);
-	cv::Mat pOriginalMatImage = cv::cvarrToMat( pOriginalImage );
-	cv::imwrite("Frame.png", pOriginalMatImage);
+	cv::imwrite("Frame.png", OriginalImage);
 
 
         // Get the media grid drop target...
         MediaGridDropTarget *pDropTarget = 
             (MediaGridDropTarget *) GetDropTarget();
         
-        // Prompt to add...
+        // Prompt to add. It's removed once it has been...
         wxArrayString sFileNameArray;
         sFileNameArray.Add(wxT("Frame.png"));
-        pDropTarget->OnDropFiles(0, 0, sFileNameArray);
-
-        // Cleanup...
-        if(::wxFileExists(wxT("Frame.png")))
+        if(!pDropTarget->AddMedia(sFileNameArray, true) &&
+           ::wxFileExists(wxT("Frame.png")))
             ::wxRemoveFile(wxT("Frame.png"));
-
-    // Release the capture...
-    cvReleaseCapture(&pCapture);
 }
 
 // User has selected to go fullscreen...
@@ -1239,7 +1437,8 @@ void MainFrame::OnImportMedia(wxCommandEvent &Event)
     //  2020/06/10 - Updating for wxGTK 3 
     wxFileDialog FileDialog(this, wxT("Please select media to import..."), 
       wxStandardPaths::Get().GetDocumentsDir(), wxEmptyString, 
-        wxT("Images (*.jpg;*.jpeg;*.png;*.bmp)|*.jpg;*.jpeg;*.png;*.bmp|"
+        wxT("Images (*.jpg;*.jpeg;*.png;*.bmp;*.tif;*.tiff)|"
+            "*.jpg;*.jpeg;*.png;*.bmp;*.tif;*.tiff|"
             "Videos (*.mov;*.avi;*.mpg;*.mpeg)|*.mov;*.avi;*.mpg;*.mpeg"),
         wxFD_OPEN | wxFD_PREVIEW | wxFD_MULTIPLE | wxFD_FILE_MUST_EXIST);
 
@@ -1257,52 +1456,133 @@ void MainFrame::OnImportMedia(wxCommandEvent &Event)
     pDropTarget->OnDropFiles(0, 0, sFileNameArray);
 }
 
-// Get the analysis results formatted into a string...
-wxString const MainFrame::GetAnalysisResults()
+// Media import has ended...
+void MainFrame::OnImportEnded(wxCommandEvent &Event)
 {
-    // Variables...
-    wxString sContents;
-    
-    // Add worm number column label...
-    sContents += wxT("Worm #\t");
+    // It was for an experiment that's gone...
+    if(!pExperiment || !pExperiment->GetMediaImporter(Event.GetExtraLong()))
+        return;
 
-    // Add column names...
-    for(int nColumn = 0; nColumn < AnalysisGrid->GetNumberCols(); ++nColumn)
-    {
-        // Append column label...
-        sContents += AnalysisGrid->GetColLabelValue(nColumn);
-        
-        // Seperate with a tab if not last column...
-        if(nColumn + 1 < AnalysisGrid->GetNumberCols())
-            sContents += wxT("\t");
-    }
-    
-    // Seperate column names from rest of data...
-    sContents += wxT("\n\n");
-    
-    // Add each row...
-    for(int nRow = 0; nRow < AnalysisGrid->GetNumberRows(); ++nRow)
+    // Forget it...
+    pExperiment->FinishImportingMedia();
+    SetStatusText(wxT("Finished importing media..."));
+}
+
+// A piece of media has been imported, or failed to be...
+void MainFrame::OnImportedMedia(wxCommandEvent &Event)
+{
+    // Find the import it's from. It was for an experiment that's gone...
+    MediaImporter *pImporter =
+        pExperiment ? pExperiment->GetMediaImporter(Event.GetExtraLong())
+                    : NULL;
+    if(!pImporter)
+        return;
+
+    // Add it to the media grid...
+    MediaGridDropTarget *pDropTarget = (MediaGridDropTarget *) GetDropTarget();
+    pDropTarget->AddImported(pImporter->GetItem(Event.GetInt()));
+}
+
+// Media import has made progress...
+void MainFrame::OnImportProgress(wxCommandEvent &Event)
+{
+    // It was for an experiment that's gone...
+    if(!pExperiment || !pExperiment->GetMediaImporter(Event.GetExtraLong()))
+        return;
+
+    // Show it in the status bar...
+    SetStatusText(
+        wxString::Format(wxT("Importing media, %d%%..."), Event.GetInt()));
+}
+
+// Format a media length for the media grid...
+wxString MainFrame::FormatMediaLength(double const dMilliseconds)
+{
+    // Calculate minutes and seconds of media...
+    int const nMinutes = (int) (dMilliseconds / 60000.0);
+    int const nSeconds = ((int) (dMilliseconds / 1000.0)) % 60;
+
+    // Format...
+    wxString sDuration;
+    sDuration.Printf(wxT("%2i:%02i"), nMinutes, nSeconds);
+    return sDuration;
+}
+
+// Get the stimulus schedule for an analysis type...
+HabituationAnalyzer::Schedule MainFrame::GetHabituationSchedule(
+    int const nAnalysisType) const
+{
+    // Variables...
+    HabituationAnalyzer::Schedule   Schedule;
+    wxConfig                       &Configuration = 
+        *::wxGetApp().pConfiguration;
+    wxString                        sGroup;
+
+    // Defaults depend on the type. Short term taps every ten seconds, long
+    //  term every minute, with fewer taps and a longer rest before recovery...
+    switch(nAnalysisType)
     {
-        // Append row label...
-        sContents += AnalysisGrid->GetRowLabelValue(nRow) + wxT("\t");
-        
-        // Add each cell's value...
-        for(int nColumn = 0; nColumn < AnalysisGrid->GetNumberCols(); ++nColumn)
-        {
-            // Append column label...
-            sContents += AnalysisGrid->GetCellValue(nRow, nColumn);
-            
-            // Seperate with a tab if not last column...
-            if(nColumn + 1 < AnalysisGrid->GetNumberCols())
-                sContents += wxT("\t");
-        }
-        
-        // Seperate each row by new line...
-        sContents += wxT("\n");
+        // Short term habituation...
+        case ANALYSIS_SHORT_TERM_HABITUATION:
+            sGroup                      = wxT("/Analysis/ShortTermHabituation/");
+            Schedule.dInterval          = 10.0;
+            Schedule.unStimuli          = 30;
+            Schedule.dRecoveryDelay     = 30.0;
+            break;
+
+        // Long term habituation...
+        case ANALYSIS_LONG_TERM_HABITUATION:
+            sGroup                      = wxT("/Analysis/LongTermHabituation/");
+            Schedule.dInterval          = 60.0;
+            Schedule.unStimuli          = 5;
+            Schedule.dRecoveryDelay     = 600.0;
+            break;
+
+        // Nothing to schedule...
+        default: return Schedule;
     }
-    
+
+    // Common defaults...
+    Schedule.dFirstStimulus     = 10.0;
+    Schedule.unRecoveryStimuli  = 3;
+    Schedule.dResponseWindow    = 2.0;
+
+    // Let the user's configuration override any of them...
+    Configuration.Read(sGroup + wxT("FirstStimulus"), 
+                       &Schedule.dFirstStimulus, Schedule.dFirstStimulus);
+    Configuration.Read(sGroup + wxT("Interval"), 
+                       &Schedule.dInterval, Schedule.dInterval);
+    Configuration.Read(sGroup + wxT("RecoveryDelay"), 
+                       &Schedule.dRecoveryDelay, Schedule.dRecoveryDelay);
+    Configuration.Read(sGroup + wxT("ResponseWindow"), 
+                       &Schedule.dResponseWindow, Schedule.dResponseWindow);
+
     // Done...
-    return sContents;
+    return Schedule;
+}
+
+// Get the reversal detection thresholds...
+ReversalDetector::Settings MainFrame::GetReversalSettings() const
+{
+    // Variables...
+    ReversalDetector::Settings  Settings;
+    wxConfig                   &Configuration = *::wxGetApp().pConfiguration;
+    long                        lWindow = 0;
+
+    // Let the user's configuration override any of the defaults...
+    Configuration.Read(wxT("/Analysis/Reversals/Window"), 
+                       &lWindow, Settings.unWindow);
+    Settings.unWindow = (lWindow > 0) ? lWindow : Settings.unWindow;
+    Configuration.Read(wxT("/Analysis/Reversals/ReverseSpeed"), 
+                       &Settings.dReverseSpeed, Settings.dReverseSpeed);
+    Configuration.Read(wxT("/Analysis/Reversals/ForwardSpeed"), 
+                       &Settings.dForwardSpeed, Settings.dForwardSpeed);
+    Configuration.Read(wxT("/Analysis/Reversals/MinimumHeadConfidence"), 
+                       &Settings.dMinimumHeadConfidence, 
+                       Settings.dMinimumHeadConfidence);
+
+    // Done...
+    return Settings;
 }
 
 // Get the total size of all media in the media grid...
@@ -1316,19 +1596,9 @@ wxULongLong MainFrame::GetTotalMediaSize()
         unRow < (unsigned) MediaGrid->GetNumberRows(); 
         unRow++)
     {
-        // Find the media...
-        wxString sPath = pExperiment->GetCachePath() + wxT("/media/") + 
-                         MediaGrid->GetCellValue(unRow, TITLE);
-
-        // Load it...
-        wxFileName MediaFile(sPath);
-
-            // Failed...
-            if(!MediaFile.IsOk())
-                continue;
-
-        // Size...
-        ulTotalSize += MediaFile.GetSize();
+        // Size, whether or not it has been extracted yet...
+        ulTotalSize += pExperiment->GetMediaSize(
+            MediaGrid->GetCellValue(unRow, TITLE));
     }
     
     // Done...
@@ -1338,6 +1608,10 @@ wxULongLong MainFrame::GetTotalMediaSize()
 // Is experiment contain a media by a specific name?
 bool MainFrame::IsExperimentContainMedia(wxString sName)
 {
+    // Still being imported...
+    if(pExperiment && pExperiment->IsImportingMedia(sName))
+        return true;
+
     // Search the media list...
     for(int nRow = 0; nRow < MediaGrid->GetNumberRows(); nRow++)
     {
@@ -1354,6 +1628,10 @@ bool MainFrame::IsExperimentContainMedia(wxString sName)
 // Is experiment contain a media by a specific name, except a row?
 bool MainFrame::IsExperimentContainMediaExceptRow(wxString sName, int nSkipRow)
 {
+    // Still being imported...
+    if(pExperiment && pExperiment->IsImportingMedia(sName))
+        return true;
+
     // Search the media list...
     for(int nRow = 0; nRow < MediaGrid->GetNumberRows(); nRow++)
     {
@@ -1378,6 +1656,29 @@ bool MainFrame::IsExperimentLoaded() const
     return (pExperiment && pExperiment->IsLoadOk());
 }
 
+// Get the frame index for a piece of media in the experiment...
+bool MainFrame::LoadMediaIndex(wxString const &sMediaTitle, MediaIndex &Index)
+{
+    // Where it is kept...
+    wxString const sIndexPath = pExperiment->GetMediaIndexPath(sMediaTitle);
+
+    // Already indexed...
+    if(Index.Load(std::string(sIndexPath.fn_str())))
+        return true;
+
+    // Index it now...
+    wxString const sMediaPath = pExperiment->GetMediaPath(sMediaTitle);
+    if(!Index.Build(std::string(sMediaPath.fn_str())))
+        return false;
+
+    // Keep it for next time. Still usable if that fails...
+    if(!Index.Save(std::string(sIndexPath.fn_str())))
+        ::wxRemoveFile(sIndexPath);
+
+    // Done...
+    return true;
+}
+
 // Media has just been loaded for play back...
 void MainFrame::OnMediaLoaded(wxMediaEvent& Event)
 {
@@ -1485,9 +1786,9 @@ void MainFrame::OnPlay(wxCommandEvent &Event)
         wxArrayInt SelectedRows = MediaGrid->GetSelectedRows();
         int nRow = SelectedRows[0];
         
-        // Generate complete path...
-        wxString sPath = pExperiment->GetCachePath() + wxT("/media/") +
-                         MediaGrid->GetCellValue(nRow, TITLE);
+        // Generate complete path, extracting it first if need be...
+        wxString sPath = pExperiment->GetMediaPath(
+            MediaGrid->GetCellValue(nRow, TITLE));
 
     // Load media and check for error...
     if(!pMediaPlayer->Load(sPath))
@@ -1502,16 +1803,8 @@ void MainFrame::OnPlay(wxCommandEvent &Event)
     sCurrentMediaPath = sPath;
 
     // Update media length in the media grid...
-
-        // Calculate minutes and seconds of media...
-        wxLongLong llMediaLength = pMediaPlayer->Length();
-        int nMinutes = (int) (llMediaLength / 60000).GetValue();
-        int nSeconds = (int) ((llMediaLength % 60000) / 1000).GetValue();
-
-        // Format string and update field...
-        wxString sDuration;
-        sDuration.Printf(wxT("%2i:%02i"), nMinutes, nSeconds);
-        MediaGrid->SetCellValue(nRow, LENGTH, sDuration);
+    MediaGrid->SetCellValue(nRow, LENGTH,
+        FormatMediaLength(wxLongLong(pMediaPlayer->Length()).ToDouble()));
 }
 
 // Experiment has changed handler...
@@ -1646,16 +1939,14 @@ void MainFrame::OnRemove(wxCommandEvent &Event)
             if(Message.ShowModal() == wxID_CANCEL)
                 continue;
 
-        // Generate a complete path to the media selected...
-        wxString sPath = pExperiment->GetCachePath() + wxT("/media/") + 
-                         MediaGrid->GetCellValue(SelectedRows[nIndex], TITLE);
-
-        // Remove it and check for error...
-        if(!::wxRemoveFile(sPath))
+        // Remove it with its frame index and trajectories, checking errors...
+        wxString const sTitle =
+            MediaGrid->GetCellValue(SelectedRows[nIndex], TITLE);
+        if(!pExperiment->RemoveMedia(sTitle))
         {
             // Log it and skip to next...
             wxLogError(wxString::Format(wxT("Unable to delete:\n\n%s\n(Row: %d)"),
-                             sPath.c_str(), SelectedRows[nIndex]));
+                             sTitle.c_str(), SelectedRows[nIndex]));
             continue;
         }
 
@@ -1724,11 +2015,8 @@ void MainFrame::OnRename(wxCommandEvent &Event)
         return;
     }
 
-    // Rename the file...
-    if(!::wxRenameFile(pExperiment->GetCachePath() + wxT("/media/") + 
-                         sOriginalName, 
-                       pExperiment->GetCachePath() + wxT("/media/") + 
-                         Dialog.GetValue(), false))
+    // Rename the file, and its frame index and trajectories with it...
+    if(!pExperiment->RenameMedia(sOriginalName, Dialog.GetValue()))
     {
         // Log error and then abort...
         wxLogError(wxT("Unable to rename media..."));
@@ -1752,26 +2040,38 @@ void MainFrame::OnRevert(wxCommandEvent &Event)
 // Save command event handler...
 void MainFrame::OnSave(wxCommandEvent &Event)
 {
+    // Still saving from last time...
+    if(pExperiment->IsSaving())
+    {
+        SetStatusText(wxT("Still saving, please wait..."));
+        return;
+    }
+
     // Experiment hasn't been saved yet...
     if(!pExperiment->IsEverBeenSaved())
     {
         // Use save as instead then...
         ProcessCommand(wxID_SAVEAS);    
+        return;
     }
 
-    // Save experiment and check for error...
+    // Start saving experiment and check for error. The rest happens in the
+    //  background...
     if(!pExperiment->Save())
         SetStatusText(wxString(wxT("Unable to write to ")) + 
                       pExperiment->GetPath());
-
-    // Saved ok...
-    else
-        SetStatusText(wxString(wxT("Saved...")));
 }
 
 // Save as command event handler...
 void MainFrame::OnSaveAs(wxCommandEvent &Event)
 {
+    // Still saving from last time...
+    if(pExperiment->IsSaving())
+    {
+        SetStatusText(wxT("Still saving, please wait..."));
+        return;
+    }
+
     // Prepare save as dialog...
     //  2020/06/10 - updating for wxGTK 3
     wxFileDialog FileDialog(this, wxT("Save Slither experiment as..."), 
@@ -1784,10 +2084,25 @@ void MainFrame::OnSaveAs(wxCommandEvent &Event)
     if(wxID_CANCEL == FileDialog.ShowModal())
         return;
 
-    // Save experiment and check for error...
+    // Start saving experiment and check for error. The rest happens in the
+    //  background...
     if(!pExperiment->SaveAs(FileDialog.GetPath()))
         SetStatusText(wxString(wxT("Unable to write to ")) + 
                       pExperiment->GetPath());
+}
+
+// Experiment save has ended...
+void MainFrame::OnSaveEnded(wxCommandEvent &Event)
+{
+    // The experiment it was for is gone and already finished with it, or
+    //  this is another one still saving...
+    if(!pExperiment || !pExperiment->IsSaveFinished())
+        return;
+
+    // Take in what was saved and check for error...
+    if(!pExperiment->FinishSave())
+        SetStatusText(wxString(wxT("Unable to write to ")) +
+                      pExperiment->GetPath());
 
     // Saved ok...
     else
@@ -1795,6 +2110,13 @@ void MainFrame::OnSaveAs(wxCommandEvent &Event)
                       pExperiment->GetPath().c_str()));
 }
 
+// Experiment save has made progress...
+void MainFrame::OnSaveProgress(wxCommandEvent &Event)
+{
+    // Show it in the status bar...
+    SetStatusText(wxString::Format(wxT("Saving, %d%%..."), Event.GetInt()));
+}
+
 // Frame resized...
 void MainFrame::OnSize(wxSizeEvent &Event)
 {
@@ -2064,6 +2386,9 @@ void MainFrame::OnSystemClose(wxCloseEvent &Event)
         pCaptureThread->Delete();*/
     if(AnalysisTimer.IsRunning())
         pAnalysisThread->Delete();
+    if(pResultsExporter)
+        pResultsExporter->Delete();
+    StopLiveTracking();
 
     // An experiment needs to be saved...
     if(pExperiment && pExperiment->IsNeedSave())
@@ -2158,3 +2483,15 @@ void MainFrame::ShowTip()
     delete pTipProvider;
 }
 
+// Stop the live tracking thread, if one was started...
+void MainFrame::StopLiveTracking()
+{
+    // Not running...
+    if(!pLiveTrackingThread)
+        return;
+
+    // Stop it and wait for it...
+    delete pLiveTrackingThread;
+    pLiveTrackingThread = NULL;
+}
+
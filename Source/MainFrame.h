@@ -15,9 +15,25 @@
     
     // Capture thread...
     #include "CaptureThread.h"
+
+    // Live tracking thread...
+    #include "LiveTrackingThread.h"
     
     // Analysis thread...
     #include "AnalysisThread.h"
+
+    // Results exporter thread...
+    #include "ResultsExporter.h"
+
+    // Analysis results grid table...
+    #include "AnalysisGridTable.h"
+
+    // Media frame index...
+    #include "MediaIndex.h"
+
+    // Lock free hand over between threads...
+    #include "RingBuffer.h"
+    #include "TripleBuffer.h"
     
     // OpenCV...
     //  Updated for OpenCV 4
@@ -30,6 +46,7 @@
     #include <opencv2/imgcodecs/legacy/constants_c.h>
     
     // STL stuff...
+    #include <atomic>
     #include <list>
     #include <map>
     #include <vector>
@@ -123,8 +140,17 @@ class MainFrame : public MainFrame_Base
         static int wxCMPFUNC_CONV 
             CompareIntegers(int *pnFirst, int *pnSecond);
 
-        // Get the analysis results formatted into a string...
-        wxString const GetAnalysisResults();
+        // Format a media length for the media grid...
+        static wxString FormatMediaLength(double const dMilliseconds);
+
+        // Get the stimulus schedule for an analysis type from the user's
+        //  configuration, with no stimuli unless it is a habituation one...
+        HabituationAnalyzer::Schedule GetHabituationSchedule(
+            int const nAnalysisType) const;
+
+        // Get the reversal detection thresholds from the user's
+        //  configuration...
+        ReversalDetector::Settings GetReversalSettings() const;
 
         // Get the total size of all media in the media grid...
         wxULongLong GetTotalMediaSize();
@@ -137,6 +163,11 @@ class MainFrame : public MainFrame_Base
 
         // Is there an experiment loaded?
         bool IsExperimentLoaded() const;
+
+        // Get the frame index for a piece of media in the experiment,
+        //  building it and keeping it with the experiment if it doesn't have
+        //  one yet. Safe to call from any thread...
+        bool LoadMediaIndex(wxString const &sMediaTitle, MediaIndex &Index);
         
         // System handlers...
         void OnSystemClose(wxCloseEvent &Event);
@@ -145,8 +176,13 @@ class MainFrame : public MainFrame_Base
         void OnNew(wxCommandEvent &Event);
         void OnOpen(wxCommandEvent &Event);
         void OnImportMedia(wxCommandEvent &Event);
+        void OnImportProgress(wxCommandEvent &Event);
+        void OnImportedMedia(wxCommandEvent &Event);
+        void OnImportEnded(wxCommandEvent &Event);
         void OnSave(wxCommandEvent &Event);
         void OnSaveAs(wxCommandEvent &Event);
+        void OnSaveProgress(wxCommandEvent &Event);
+        void OnSaveEnded(wxCommandEvent &Event);
         void OnRevert(wxCommandEvent &Event);
         void OnClose(wxCommandEvent &Event);
         void OnQuit(wxCommandEvent &Event);
@@ -185,6 +221,7 @@ class MainFrame : public MainFrame_Base
 
         // Capture event handlers...
         void OnCapture(wxCommandEvent &Event); /* toggle button */
+        void OnCaptureEnded(wxCommandEvent &Event);
         void OnCaptureFrameReadyTimer(wxTimerEvent &Event);
 
         // Analysis event handlers...
@@ -195,11 +232,14 @@ class MainFrame : public MainFrame_Base
         void OnAnalyze(wxCommandEvent &Event);
         void OnBeginAnalysis(wxCommandEvent &Event);
         void OnAnalysisCellRightClick(wxGridEvent &Event);
+        void OnAnalysisLabelLeftClick(wxGridEvent &Event);
         void OnAnalysisCopyClipboard(wxCommandEvent &Event);
         void OnAnalysisSaveToDisk(wxCommandEvent &Event);
         void OnAnalysisFrameReadyTimer(wxTimerEvent &Event);
         void OnCancelAnalysis(wxCommandEvent &Event);
         void OnEndAnalysis(wxCommandEvent &Event);
+        void OnExportProgress(wxCommandEvent &Event);
+        void OnExportEnded(wxCommandEvent &Event);
         void OnResetAIToDefaults(wxCommandEvent &Event);
 
         // Image analysis window has been toggled...
@@ -208,6 +248,9 @@ class MainFrame : public MainFrame_Base
         // Show the tip window...
         void ShowTip();
 
+        // Stop the live tracking thread, if one was started...
+        void StopLiveTracking();
+
         // This class handles wxWidgets events...
         DECLARE_EVENT_TABLE()
 
@@ -250,7 +293,15 @@ class MainFrame : public MainFrame_Base
             ID_CAPTURE_FRAME_READY,
             ID_ANALYSIS_ENDED,
             ID_ANALYSIS_COPY_CLIPBOARD,
-            ID_ANALYSIS_SAVE_TO_DISK
+            ID_ANALYSIS_SAVE_TO_DISK,
+            ID_EXPORT_PROGRESS,
+            ID_EXPORT_ENDED,
+            ID_SAVE_PROGRESS,
+            ID_SAVE_ENDED,
+            ID_IMPORT_PROGRESS,
+            ID_IMPORT_MEDIA,
+            ID_IMPORT_ENDED,
+            ID_CAPTURE_ENDED
         };
         
         // Timer IDs...
@@ -273,7 +324,10 @@ class MainFrame : public MainFrame_Base
         {
             ANALYSIS_BODY_SIZE_COLUMN_LENGTH    = 0,
             ANALYSIS_BODY_SIZE_COLUMN_WIDTH,
-            ANALYSIS_BODY_SIZE_COLUMN_AREA
+            ANALYSIS_BODY_SIZE_COLUMN_AREA,
+            ANALYSIS_BODY_SIZE_COLUMN_REVERSALS,
+            ANALYSIS_BODY_SIZE_COLUMN_REVERSAL_DURATION,
+            ANALYSIS_BODY_SIZE_COLUMNS
         };
         
         // Microscope table...
@@ -288,6 +342,9 @@ class MainFrame : public MainFrame_Base
         // Image analysis window...
         ImageAnalysisWindow    *pImageAnalysisWindow;
 
+        // Last thinking display rasterized for it. Buffer reused each time...
+        cv::Mat                 ThinkingImage;
+
         // Experiment...
         Experiment             *pExperiment;
 
@@ -297,13 +354,43 @@ class MainFrame : public MainFrame_Base
         // Capture thread timer...
         wxTimer                 CaptureTimer;
 
-        // Capture frame queue...
-        //std::list<IplImage *>   CaptureFrameBuffer;
-	std::list<cv::Mat *>	CaptureFrameBuffer;
+        // Capture frame ring. The capture thread produces, the recording
+        //  thread consumes...
+        RingBuffer<CapturedFrame> CaptureFrameBuffer;
+
+        // Newest captured frame, scaled to the panel. The capture thread
+        //  publishes, the capture timer shows...
+        TripleBuffer<CapturePreviewFrame> CapturePreview;
+
+        // Size of the panel, for the capture thread to scale to...
+        std::atomic<int>        nCapturePreviewWidth;
+        std::atomic<int>        nCapturePreviewHeight;
+
+        // Live tracking thread, if one was started, the newest captured frame
+        //  for it, and its own tracker...
+        LiveTrackingThread     *pLiveTrackingThread;
+        TripleBuffer<CapturedFrame> LiveFrames;
+        WormTracker             LiveTracker;
 
         // Analysis thread and timer...
         AnalysisThread         *pAnalysisThread;
         wxTimer                 AnalysisTimer;
+
+        // Title of the media last analyzed...
+        wxString                sAnalyzedMediaTitle;
+
+        // Media analyzed into the results grid since it was last cleared, in
+        //  order, and the number of the first worm each added...
+        std::vector<ResultsExporter::AnalyzedMedia> Analyzed;
+
+        // Results exporter thread, if one is running...
+        ResultsExporter        *pResultsExporter;
+
+        // Table behind the analysis grid, owned by the grid, and the column
+        //  it is sorted by, if any...
+        AnalysisGridTable      *pAnalysisGridTable;
+        int                     nAnalysisSortColumn;
+        bool                    bAnalysisSortAscending;
         
         // Worm tracker...
         WormTracker             Tracker;
@@ -0,0 +1,677 @@
+/*
+  Name:         MediaImporter.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Copies media into an experiment's cache on several threads at
+                once, cloning it where the filesystem can...
+*/
+
+// Includes...
+#include "MediaImporter.h"
+#include "MainFrame.h"
+#ifdef HAVE_CONFIG_H
+    #include "config.h"
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_IOCTL_H
+    #include <sys/ioctl.h>
+#endif
+#ifdef HAVE_LINUX_FS_H
+    #include <linux/fs.h>
+#endif
+
+// Size of the pieces a file is split into when it can't be cloned, so that
+//  even a single large video is copied on every thread...
+static uint64_t const ChunkSize = 64 * 1024 * 1024;
+
+// Size of the buffer a chunk is read into when the kernel can't copy it...
+static size_t const BufferSize = 1024 * 1024;
+
+// Next import's number...
+std::atomic<unsigned int> MediaImporter::unNextSerial(1);
+
+// Copy a range of one file into the same place in another, letting the kernel
+//  do it if it can...
+static bool CopyRange(int const nSource, int const nDestination,
+                      uint64_t ulOffset, uint64_t const ulEnd)
+{
+    // Let the kernel copy it, which keeps it from passing through here and
+    //  may share or copy it on the device itself...
+#ifdef HAVE_COPY_FILE_RANGE
+    while(ulOffset < ulEnd)
+    {
+        // Copy as much as it will...
+        loff_t lSourceOffset        = ulOffset;
+        loff_t lDestinationOffset   = ulOffset;
+        ssize_t const Count = copy_file_range(
+            nSource, &lSourceOffset, nDestination, &lDestinationOffset,
+            ulEnd - ulOffset, 0);
+
+            // It can't, or not between these two. Do the rest ourselves...
+            if(Count <= 0)
+                break;
+
+        // Next...
+        ulOffset += Count;
+    }
+#endif
+
+    // Read and write whatever is left ourselves...
+    std::vector<char> Buffer(std::min<uint64_t>(BufferSize, ulEnd - ulOffset));
+    while(ulOffset < ulEnd)
+    {
+        // Read as much as fits...
+        ssize_t const Count = pread(
+            nSource, &Buffer[0],
+            std::min<uint64_t>(Buffer.size(), ulEnd - ulOffset), ulOffset);
+
+            // Failed, or it got shorter...
+            if(Count <= 0)
+                return false;
+
+        // Write all of it...
+        for(ssize_t Written = 0; Written < Count; )
+        {
+            // Write what's left...
+            ssize_t const Wrote = pwrite(
+                nDestination, &Buffer[Written], Count - Written,
+                ulOffset + Written);
+
+                // Failed...
+                if(Wrote <= 0)
+                    return false;
+
+            // Next...
+            Written += Wrote;
+        }
+
+        // Next...
+        ulOffset += Count;
+    }
+
+    // Done...
+    return true;
+}
+
+// Constructor...
+MediaImporter::MediaImporter(
+    MainFrame &_Frame, std::vector<Item> const &_Items)
+    : Frame(_Frame),
+      Items(_Items),
+      Progresses(_Items.size()),
+      unSerial(unNextSerial++),
+      ulTotal(0),
+      ulCopied(0),
+      unLastPercent(0),
+      bStopping(false),
+      unThreads(1),
+      unRunning(0)
+{
+    // Import on every processor, unless told otherwise. Read here, the
+    //  configuration isn't safe from the threads...
+    long lThreads = 0;
+  ::wxGetApp().pConfiguration->Read(
+        wxT("/Import/Threads"), &lThreads, lThreads);
+    unThreads = (lThreads > 0) ?
+        lThreads : std::max(wxThread::GetCPUCount(), 1);
+
+    // Nothing is started on yet, and there's this much to copy...
+    for(unsigned int unItem = 0; unItem < Items.size(); ++unItem)
+    {
+        // Outcome not known yet...
+        Items[unItem].bImported = false;
+        Items[unItem].bCloned   = false;
+        Items[unItem].nWidth    = 0;
+        Items[unItem].nHeight   = 0;
+
+        // Not started...
+        Progress &Pending       = Progresses[unItem];
+        Pending.At              = PENDING;
+        Pending.nSource         = -1;
+        Pending.nDestination    = -1;
+        Pending.ulChunks        = 0;
+        Pending.ulNextChunk     = 0;
+        Pending.ulChunksDone    = 0;
+        Pending.bFailed         = false;
+
+        // Count it...
+        ulTotal += Items[unItem].ulSize;
+    }
+}
+
+// Importer thread constructor...
+MediaImporter::ImporterThread::ImporterThread(MediaImporter &_Importer)
+    : wxThread(wxTHREAD_JOINABLE),
+      Importer(_Importer)
+{
+
+}
+
+// Importer thread entry point...
+wxThread::ExitCode MediaImporter::ImporterThread::Entry()
+{
+    // Import until there's nothing more to claim or asked to stop...
+    Importer.Work();
+
+    // Done...
+    return NULL;
+}
+
+// Stop claiming anything more...
+void MediaImporter::Cancel()
+{
+    // Lock...
+    wxMutexLocker Lock(ProgressMutex);
+
+    // Ask...
+    bStopping = true;
+}
+
+// Copy one chunk of a file...
+bool MediaImporter::CopyChunk(
+    unsigned int const unItem, uint64_t const ulChunk)
+{
+    // Variables...
+    Progress const     &Copying     = Progresses[unItem];
+    uint64_t const      ulOffset    = ulChunk * ChunkSize;
+
+    // Copy...
+    return CopyRange(Copying.nSource, Copying.nDestination, ulOffset,
+                     ulOffset + GetChunkBytes(unItem, ulChunk));
+}
+
+// Copy one image of a directory of them...
+bool MediaImporter::CopyImage(
+    unsigned int const unItem, uint64_t const ulImage)
+{
+    // Variables...
+    Item const         &Importing   = Items[unItem];
+    std::string const   sName       = "/" + Importing.Images[ulImage].sName;
+    bool                bCopied     = false;
+    struct stat         Status;
+
+    // Open it, and where it goes, replacing whatever was there...
+    int const nSource =
+        open((Importing.sSourcePath + sName).c_str(), O_RDONLY);
+    int const nDestination =
+        open((Importing.sDestinationPath + sName).c_str(),
+             O_WRONLY | O_CREAT | O_TRUNC, 0666);
+
+    // Share its extents if the filesystem can, or copy all of it as it is
+    //  now...
+    if(nSource >= 0 && nDestination >= 0 && fstat(nSource, &Status) == 0)
+    {
+#if defined(HAVE_LINUX_FS_H) && defined(FICLONE)
+        bCopied = (ioctl(nDestination, FICLONE, nSource) == 0);
+#endif
+        if(!bCopied)
+            bCopied = CopyRange(nSource, nDestination, 0, Status.st_size);
+    }
+
+    // Close both...
+    if(nSource >= 0)
+        close(nSource);
+    if(nDestination >= 0 && close(nDestination) != 0)
+        bCopied = false;
+
+    // Done...
+    return bCopied;
+}
+
+// Close a file, and finish with it one way or another...
+void MediaImporter::Finish(unsigned int const unItem)
+{
+    // Variables...
+    Item           &Imported    = Items[unItem];
+    Progress       &Finished    = Progresses[unItem];
+
+    // Close it. Nobody else is using it now...
+    if(Finished.nSource >= 0)
+        close(Finished.nSource);
+    if(Finished.nDestination >= 0)
+        close(Finished.nDestination);
+
+    // Failed, so don't leave what was copied of it behind. Only its own
+    //  images, in case the directory was there already...
+    if(Finished.bFailed)
+    {
+        if(Imported.bSequence)
+        {
+            for(size_t Image = 0; Image < Imported.Images.size(); ++Image)
+                std::remove((Imported.sDestinationPath + "/" +
+                             Imported.Images[Image].sName).c_str());
+            rmdir(Imported.sDestinationPath.c_str());
+        }
+        else if(Finished.nDestination >= 0)
+            std::remove(Imported.sDestinationPath.c_str());
+    }
+
+    // Imported...
+    else
+    {
+        // Done with the original, if asked. Its directory only goes if
+        //  nothing else was in it...
+        if(Imported.bRemoveSource && Imported.bSequence)
+        {
+            for(size_t Image = 0; Image < Imported.Images.size(); ++Image)
+                std::remove((Imported.sSourcePath + "/" +
+                             Imported.Images[Image].sName).c_str());
+            rmdir(Imported.sSourcePath.c_str());
+        }
+        else if(Imported.bRemoveSource)
+            std::remove(Imported.sSourcePath.c_str());
+
+        // Find out what it is, while the rest are still being copied...
+        Probe(Imported);
+        Imported.bImported = true;
+    }
+    Finished.nSource        = -1;
+    Finished.nDestination   = -1;
+
+    // Nobody wants to know any more...
+    {
+        wxMutexLocker Lock(ProgressMutex);
+        if(bStopping)
+            return;
+    }
+
+    // Tell the main frame in a thread safe way...
+    wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                         MainFrame::ID_IMPORT_MEDIA);
+    Event.SetInt(unItem);
+    Event.SetExtraLong(unSerial);
+    wxPostEvent(&Frame, Event);
+}
+
+// Bytes in one chunk of a file, or one image of a directory...
+uint64_t MediaImporter::GetChunkBytes(
+    unsigned int const unItem, uint64_t const ulChunk) const
+{
+    // An image...
+    if(Items[unItem].bSequence)
+        return Items[unItem].Images[ulChunk].ulSize;
+
+    // A chunk, the last of which may be short...
+    return std::min(ChunkSize, Items[unItem].ulSize - ulChunk * ChunkSize);
+}
+
+// Number of chunks a file is split into, or images in a directory...
+uint64_t MediaImporter::GetChunks(unsigned int const unItem) const
+{
+    // Each image...
+    if(Items[unItem].bSequence)
+        return Items[unItem].Images.size();
+
+    // Each chunk...
+    return (Items[unItem].ulSize + ChunkSize - 1) / ChunkSize;
+}
+
+// A file imported, or not...
+MediaImporter::Item const &MediaImporter::GetItem(
+    unsigned int const unItem) const
+{
+    return Items[unItem];
+}
+
+// Number that identifies this import...
+unsigned int MediaImporter::GetSerial() const
+{
+    return unSerial;
+}
+
+// Is a file by this title still being imported?
+bool MediaImporter::IsImporting(wxString const &sTitle) const
+{
+    // Lock...
+    wxMutexLocker Lock(ProgressMutex);
+
+    // Search the ones not done yet...
+    for(unsigned int unItem = 0; unItem < Items.size(); ++unItem)
+    {
+        if(Progresses[unItem].At != DONE &&
+           Items[unItem].sTitle.Lower() == sTitle.Lower())
+            return true;
+    }
+
+    // Not found...
+    return false;
+}
+
+// Get a file ready to be copied, cloning it if possible...
+bool MediaImporter::Prepare(unsigned int const unItem)
+{
+    // Variables...
+    Item           &Importing   = Items[unItem];
+    Progress       &Preparing   = Progresses[unItem];
+    struct stat     Status;
+
+    // A directory of images. Make it, and let its images be claimed...
+    if(Importing.bSequence)
+    {
+        if(mkdir(Importing.sDestinationPath.c_str(), 0777) != 0 &&
+           errno != EEXIST)
+            return false;
+        Preparing.ulChunks = GetChunks(unItem);
+        return true;
+    }
+
+    // Open it, and find out how big it is now...
+    Preparing.nSource = open(Importing.sSourcePath.c_str(), O_RDONLY);
+    if(Preparing.nSource < 0 || fstat(Preparing.nSource, &Status) != 0)
+        return false;
+    Importing.ulSize = Status.st_size;
+
+    // Open where it goes, replacing whatever was there...
+    Preparing.nDestination = open(Importing.sDestinationPath.c_str(),
+                                  O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if(Preparing.nDestination < 0)
+        return false;
+
+    // Share its extents if the filesystem can. Then there's nothing to
+    //  copy...
+#if defined(HAVE_LINUX_FS_H) && defined(FICLONE)
+    if(ioctl(Preparing.nDestination, FICLONE, Preparing.nSource) == 0)
+    {
+        Importing.bCloned = true;
+        return true;
+    }
+#endif
+
+    // Otherwise make it full size up front, so chunks can be written in any
+    //  order...
+    if(ftruncate(Preparing.nDestination, Importing.ulSize) != 0)
+        return false;
+    Preparing.ulChunks = GetChunks(unItem);
+
+    // Done...
+    return true;
+}
+
+// Probe a file's resolution, and index it if it's a video...
+void MediaImporter::Probe(Item &Imported)
+{
+    // Directory of images. The first says what they all should be...
+    if(Imported.bSequence)
+    {
+        if(!Imported.Images.empty())
+        {
+            cv::Mat const Image = cv::imread(
+                Imported.sDestinationPath + "/" + Imported.Images[0].sName,
+                cv::IMREAD_UNCHANGED);
+            Imported.nWidth  = Image.cols;
+            Imported.nHeight = Image.rows;
+        }
+    }
+
+    // Video. Index every frame, so it never has to be done when it's
+    //  needed, and ask the container for its resolution...
+    else if(Imported.bVideo)
+    {
+        // Index...
+        Imported.Index.Build(Imported.sDestinationPath);
+
+        // Resolution...
+        cv::VideoCapture Capture(Imported.sDestinationPath);
+        if(Capture.isOpened())
+        {
+            Imported.nWidth  = Capture.get(cv::CAP_PROP_FRAME_WIDTH);
+            Imported.nHeight = Capture.get(cv::CAP_PROP_FRAME_HEIGHT);
+        }
+    }
+
+    // Still. Has to be decoded to be sure of its resolution...
+    else
+    {
+        cv::Mat const Image =
+            cv::imread(Imported.sDestinationPath, cv::IMREAD_UNCHANGED);
+        Imported.nWidth  = Image.cols;
+        Imported.nHeight = Image.rows;
+    }
+}
+
+// Post progress to the main frame, if the percentage changed...
+void MediaImporter::ReportProgress()
+{
+    // Work out the percentage. Sizes may have changed since they were
+    //  added up...
+    unsigned int const unPercent = (ulTotal > 0) ?
+        std::min<uint64_t>(ulCopied * 100 / ulTotal, 100) : 100;
+
+    // Nothing new to say...
+    if(unPercent == unLastPercent)
+        return;
+    unLastPercent = unPercent;
+
+    // Initialize event...
+    wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                         MainFrame::ID_IMPORT_PROGRESS);
+    Event.SetInt(unPercent);
+    Event.SetExtraLong(unSerial);
+
+    // Send in a thread-safe way...
+    wxPostEvent(&Frame, Event);
+}
+
+// Start importing...
+bool MediaImporter::Start()
+{
+    // Already started, or nothing to import...
+    if(!Importers.empty() || Items.empty())
+        return false;
+
+    // Any more threads than there are chunks would have nothing to do...
+    uint64_t ulChunks = 0;
+    for(unsigned int unItem = 0; unItem < Items.size(); ++unItem)
+        ulChunks += std::max<uint64_t>(GetChunks(unItem), 1);
+    unsigned int const unImporters = std::min<uint64_t>(unThreads, ulChunks);
+
+    // Count them all as running first, so the last to finish is the last...
+    unRunning = unImporters;
+
+    // Start them...
+    for(unsigned int unImporter = 0; unImporter < unImporters; ++unImporter)
+    {
+        // Create...
+        ImporterThread *pImporter = new ImporterThread(*this);
+
+        // Couldn't start it, so stop whichever did...
+        if(pImporter->Create() != wxTHREAD_NO_ERROR ||
+           pImporter->Run() != wxTHREAD_NO_ERROR)
+        {
+            delete pImporter;
+            Cancel();
+            Wait();
+            return false;
+        }
+
+        // Keep track of it...
+        Importers.push_back(pImporter);
+    }
+
+    // Done...
+    return true;
+}
+
+// Wait for every thread to finish...
+void MediaImporter::Wait()
+{
+    // Wait for each to finish whatever it was on...
+    for(unsigned int unImporter = 0; unImporter < Importers.size();
+        ++unImporter)
+    {
+        Importers[unImporter]->Wait();
+        delete Importers[unImporter];
+    }
+    Importers.clear();
+
+    // If stopped, some may have been started on but not finished...
+    for(unsigned int unItem = 0; unItem < Items.size(); ++unItem)
+    {
+        // Finished or never started...
+        Progress &Unfinished = Progresses[unItem];
+        if(Unfinished.At == PENDING || Unfinished.At == DONE)
+            continue;
+
+        // Remove what was copied of it...
+        Unfinished.At       = DONE;
+        Unfinished.bFailed  = true;
+        Finish(unItem);
+    }
+}
+
+// Import until there's nothing more to claim...
+void MediaImporter::Work()
+{
+    // Keep claiming...
+    for(;;)
+    {
+        // Variables...
+        unsigned int    unItem      = 0;
+        uint64_t        ulChunk     = 0;
+        bool            bPrepare    = false;
+        bool            bFinish     = false;
+
+        // Claim the first file nobody has started on, or the next chunk of
+        //  the first still being copied...
+        {
+            // Lock...
+            wxMutexLocker Lock(ProgressMutex);
+
+            // Asked to stop...
+            if(bStopping)
+                break;
+
+            // Find it...
+            for(unItem = 0; unItem < Items.size(); ++unItem)
+            {
+                // Nobody has started on it...
+                Progress &Claiming = Progresses[unItem];
+                if(Claiming.At == PENDING)
+                {
+                    Claiming.At = PREPARING;
+                    bPrepare    = true;
+                    break;
+                }
+
+                // It has a chunk left...
+                if(Claiming.At == COPYING &&
+                   Claiming.ulNextChunk < Claiming.ulChunks)
+                {
+                    ulChunk = Claiming.ulNextChunk++;
+                    break;
+                }
+            }
+
+            // Nothing left to claim. Whatever's left is somebody else's...
+            if(unItem == Items.size())
+                break;
+        }
+
+        // Open it and try cloning it, without holding up the others...
+        if(bPrepare)
+        {
+            // Prepare...
+            bool const bPrepared = Prepare(unItem);
+
+            // Let it be copied, or finish with it now...
+            {
+                // Lock...
+                wxMutexLocker Lock(ProgressMutex);
+
+                // Cloned, empty, or it can't be copied at all...
+                Progress &Prepared = Progresses[unItem];
+                if(!bPrepared || bStopping || Items[unItem].bCloned ||
+                   Prepared.ulChunks == 0)
+                {
+                    Prepared.At         = DONE;
+                    Prepared.bFailed    = !bPrepared || bStopping;
+                    bFinish             = true;
+
+                    // Count it as copied if it was cloned...
+                    if(!Prepared.bFailed)
+                    {
+                        ulCopied += Items[unItem].ulSize;
+                        ReportProgress();
+                    }
+                }
+
+                // Ready for its chunks to be claimed...
+                else
+                    Prepared.At = COPYING;
+            }
+        }
+
+        // Copy a chunk, without holding up the others...
+        else
+        {
+            // Copy...
+            bool const bCopied = Items[unItem].bSequence
+                                    ? CopyImage(unItem, ulChunk)
+                                    : CopyChunk(unItem, ulChunk);
+
+            // Count it...
+            {
+                // Lock...
+                wxMutexLocker Lock(ProgressMutex);
+                Progress &Copying = Progresses[unItem];
+              ++Copying.ulChunksDone;
+
+                // Nothing more of it needs copying if it failed or we're
+                //  stopping. Finish once every chunk claimed is back...
+                if(!bCopied || bStopping)
+                {
+                    Copying.bFailed     = true;
+                    Copying.ulChunks    = Copying.ulNextChunk;
+                }
+
+                // Copied...
+                else
+                {
+                    ulCopied += GetChunkBytes(unItem, ulChunk);
+                    ReportProgress();
+                }
+
+                // That was the last one...
+                if(Copying.ulChunksDone == Copying.ulChunks)
+                {
+                    Copying.At  = DONE;
+                    bFinish     = true;
+                }
+            }
+        }
+
+        // Finish with it, probing it while the others carry on copying...
+        if(bFinish)
+            Finish(unItem);
+    }
+
+    // The last to finish tells the main frame they're all done...
+    if(--unRunning == 0)
+    {
+        // Nobody wants to know any more...
+        {
+            wxMutexLocker Lock(ProgressMutex);
+            if(bStopping)
+                return;
+        }
+
+        // Tell in a thread safe way...
+        wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                             MainFrame::ID_IMPORT_ENDED);
+        Event.SetExtraLong(unSerial);
+        wxPostEvent(&Frame, Event);
+    }
+}
+
+// Deconstructor...
+MediaImporter::~MediaImporter()
+{
+    // Stop and wait for every thread...
+    Cancel();
+    Wait();
+}
+
@@ -0,0 +1,272 @@
+/*
+  Name:         MediaImporter.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Copies media into an experiment's cache on several threads at
+                once, so the UI carries on while it does. Each file is first
+                cloned, which on a filesystem that shares extents takes no
+                time and no space whatever its size. Otherwise it is split
+                into chunks, and each thread takes the next chunk not yet
+                claimed of the first file not yet finished. The kernel copies
+                each chunk itself where it can, without it passing through
+                us, and we read and write it where it can't. As soon as a file
+                is copied, the thread that finished it probes it too, indexing
+                a video's frames and finding its resolution, while the others
+                carry on copying. A directory of images is copied an image at
+                a time instead, each thread taking the next not yet claimed.
+                The main frame is told as each is imported, so it can be
+                worked with before the rest are...
+*/
+
+// Multiple include protection...
+#ifndef _MEDIAIMPORTER_H_
+#define _MEDIAIMPORTER_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/datetime.h>
+    #include <wx/thread.h>
+
+    // Frame index built for a video...
+    #include "MediaIndex.h"
+
+    // Standard libraries and STL...
+    #include <atomic>
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+
+// Forward declarations...
+class MainFrame;
+
+// MediaImporter class...
+class MediaImporter
+{
+    // Public types...
+    public:
+
+        // An image in a directory of them to import...
+        typedef struct SequenceImage
+        {
+            // Its name in the directory, and its size...
+            std::string                 sName;
+            uint64_t                    ulSize;
+
+        }SequenceImage;
+
+        // A file, or directory of images, to import...
+        typedef struct Item
+        {
+            // Where it's copied from, and to...
+            std::string                 sSourcePath;
+            std::string                 sDestinationPath;
+
+            // Its title in the experiment...
+            wxString                    sTitle;
+
+            // Its size and when it was last modified...
+            uint64_t                    ulSize;
+            wxDateTime                  Modified;
+
+            // Is it a video, to be indexed?
+            bool                        bVideo;
+
+            // Is it a directory of images, copied an image at a time, and
+            //  which are they?
+            bool                        bSequence;
+            std::vector<SequenceImage>  Images;
+
+            // Remove the source once it's been imported?
+            bool                        bRemoveSource;
+
+            // Was it imported, and was it cloned rather than copied?
+            bool                        bImported;
+            bool                        bCloned;
+
+            // Resolution, or zero if it couldn't be found...
+            int                         nWidth;
+            int                         nHeight;
+
+            // Frame index, if a video that could be indexed...
+            MediaIndex                  Index;
+
+        }Item;
+
+    // Public methods...
+    public:
+
+        // Constructor takes where to post progress, and every file to
+        //  import...
+        MediaImporter(MainFrame &_Frame, std::vector<Item> const &_Items);
+
+        // Accessors...
+
+            // A file imported, or not. Only once the main frame has been
+            //  told it's done...
+            Item const         &GetItem(unsigned int const unItem) const;
+
+            // Number that identifies this import in the events it posts...
+            unsigned int        GetSerial() const;
+
+            // Is a file by this title, ignoring case, still being imported?
+            bool                IsImporting(wxString const &sTitle) const;
+
+        // Mutators...
+
+            // Stop claiming anything more. Whatever is partly copied is
+            //  removed once waited for...
+            void                Cancel();
+
+            // Start importing. Returns false if it couldn't be started...
+            bool                Start();
+
+            // Wait for every thread to finish...
+            void                Wait();
+
+        // Deconstructor cancels and waits...
+       ~MediaImporter();
+
+    // Protected types...
+    protected:
+
+        // A thread importing...
+        class ImporterThread : public wxThread
+        {
+            // Public methods...
+            public:
+
+                // Constructor takes the importer it works for...
+                ImporterThread(MediaImporter &Importer);
+
+            // Protected methods...
+            protected:
+
+                // Thread entry point...
+                virtual ExitCode Entry();
+
+            // Protected attributes...
+            protected:
+
+                // The importer it works for...
+                MediaImporter &Importer;
+        };
+
+        // How far along a file is...
+        typedef enum Stage
+        {
+            // Nobody has started on it...
+            PENDING = 0,
+
+            // Being opened and cloned...
+            PREPARING,
+
+            // Being copied a chunk at a time...
+            COPYING,
+
+            // Finished with, imported or not...
+            DONE
+
+        }Stage;
+
+        // Where each file is up to...
+        typedef struct Progress
+        {
+            // How far along...
+            Stage               At;
+
+            // Descriptors it's copied from and to, while copying...
+            int                 nSource;
+            int                 nDestination;
+
+            // Chunks in all, the next to claim, and how many are done. Each
+            //  image is a chunk of a directory of them...
+            uint64_t            ulChunks;
+            uint64_t            ulNextChunk;
+            uint64_t            ulChunksDone;
+
+            // Did anything fail?
+            bool                bFailed;
+
+        }Progress;
+
+    // Protected methods...
+    protected:
+
+        // Copy one chunk of a file, letting the kernel do it if it can...
+        bool                    CopyChunk(unsigned int const unItem,
+                                          uint64_t const ulChunk);
+
+        // Copy one image of a directory of them, cloning it if possible...
+        bool                    CopyImage(unsigned int const unItem,
+                                          uint64_t const ulImage);
+
+        // Close a file, remove what's left of it if it failed, and probe it
+        //  and tell the main frame if it didn't...
+        void                    Finish(unsigned int const unItem);
+
+        // Bytes in one chunk of a file, or one image of a directory...
+        uint64_t                GetChunkBytes(unsigned int const unItem,
+                                              uint64_t const ulChunk) const;
+
+        // Number of chunks a file is split into, or images in a directory...
+        uint64_t                GetChunks(unsigned int const unItem) const;
+
+        // Work out where a file is going and clone it there if possible.
+        //  Otherwise get it ready to be copied a chunk at a time. Returns
+        //  false if it can't be...
+        bool                    Prepare(unsigned int const unItem);
+
+        // Probe a file's resolution, and index it if it's a video...
+        static void             Probe(Item &Imported);
+
+        // Post progress to the main frame, if the percentage changed. Lock
+        //  first...
+        void                    ReportProgress();
+
+        // Import until there's nothing more to claim, or asked to stop.
+        //  Each thread runs this...
+        void                    Work();
+
+    // Protected attributes...
+    protected:
+
+        // Main frame to post progress to...
+        MainFrame              &Frame;
+
+        // Every file to import, and where each is up to...
+        std::vector<Item>       Items;
+        std::vector<Progress>   Progresses;
+
+        // Number that identifies this import, and the next one's...
+        unsigned int            unSerial;
+        static std::atomic<unsigned int> unNextSerial;
+
+        // Guards where each file is up to and everything below...
+        mutable wxMutex         ProgressMutex;
+
+        // Bytes to copy in all, and copied so far, and the last percentage
+        //  reported...
+        uint64_t                ulTotal;
+        uint64_t                ulCopied;
+        unsigned int            unLastPercent;
+
+        // Has it been asked to stop?
+        bool                    bStopping;
+
+        // Importer threads, none until started, and how many are still
+        //  running...
+        std::vector<ImporterThread *> Importers;
+        unsigned int            unThreads;
+        std::atomic<unsigned int> unRunning;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        MediaImporter(MediaImporter const &);
+        MediaImporter &operator=(MediaImporter const &);
+};
+
+#endif
+
@@ -0,0 +1,331 @@
+/*
+  Name:         MediaIndex.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Frame index for a video...
+*/
+
+// Includes...
+#include "MediaIndex.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+// OpenCV 4.5.5 and later can hand over undecoded packets from the FFmpeg
+//  backend and say which ones are keyframes...
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && \
+    (CV_VERSION_MINOR > 5 || (CV_VERSION_MINOR == 5 && \
+     CV_VERSION_REVISION >= 5)))
+    #define SLITHER_INDEX_RAW_PACKETS
+#endif
+
+// The on disk header is read straight in, so its layout must never move...
+static_assert(sizeof(MediaIndex::Header) == 40,
+              "media index header layout changed");
+
+// Magic at the start of the file...
+static char const HeaderMagic[8] = {'S', 'L', 'I', 'I', 'N', 'D', 'X', '\0'};
+
+// Whether this machine stores numbers the way the file does...
+static bool IsLittleEndian()
+{
+    // Check the first byte of a known value...
+    uint32_t const unProbe = 1;
+    return *reinterpret_cast<uint8_t const *>(&unProbe) == 1;
+}
+
+// Default constructor...
+MediaIndex::MediaIndex()
+    : dFramesPerSecond(0.0),
+      bKeyframesKnown(false)
+{
+
+}
+
+// Index a video by reading through every packet in it...
+bool MediaIndex::Build(std::string const &sMediaPath)
+{
+    // Variables...
+    cv::VideoCapture    Capture;
+    uint32_t            unFrame = 0;
+
+    // Start over...
+    Clear();
+
+    // Ask for packets as they are in the file, if the backend can do that.
+    //  Nothing is decoded, so this is mostly just reading the file...
+#ifdef SLITHER_INDEX_RAW_PACKETS
+    bKeyframesKnown = Capture.open(
+        sMediaPath, cv::CAP_FFMPEG, std::vector<int>{cv::CAP_PROP_FORMAT, -1});
+#endif
+
+    // Otherwise decode every frame, which is slower but still only once...
+    if(!bKeyframesKnown && !Capture.open(sMediaPath))
+        return false;
+
+    // Note the nominal frame rate...
+    dFramesPerSecond = Capture.get(cv::CAP_PROP_FPS);
+
+    // Note every frame's time, and whether it's a keyframe if we can tell...
+    while(Capture.grab())
+    {
+        // Time, falling back on the nominal rate if there isn't one...
+        double dMilliseconds = Capture.get(cv::CAP_PROP_POS_MSEC);
+        if(dMilliseconds < 0.0 && dFramesPerSecond > 0.0)
+            dMilliseconds = unFrame * 1000.0 / dFramesPerSecond;
+        Timestamps.push_back(dMilliseconds);
+
+        // Keyframe...
+#ifdef SLITHER_INDEX_RAW_PACKETS
+        if(bKeyframesKnown &&
+           Capture.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0.0)
+            Keyframes.push_back(unFrame);
+#endif
+
+        // Next...
+      ++unFrame;
+    }
+
+    // Packets come in decoding order, but frames are shown in presentation
+    //  order, so the nth frame shown has the nth earliest time. A keyframe
+    //  starts its group of pictures in both, so its number is the same...
+    std::sort(Timestamps.begin(), Timestamps.end());
+
+    // Couldn't tell which were keyframes after all...
+    if(Keyframes.empty())
+        bKeyframesKnown = false;
+
+    // Done...
+    return !Timestamps.empty();
+}
+
+// Forget everything...
+void MediaIndex::Clear()
+{
+    dFramesPerSecond    = 0.0;
+    bKeyframesKnown     = false;
+    Timestamps.clear();
+    Keyframes.clear();
+}
+
+// Frame shown at the given time...
+uint32_t MediaIndex::FrameAtTime(double const dMilliseconds) const
+{
+    // Nothing indexed...
+    if(Timestamps.empty())
+        return 0;
+
+    // Last frame to start showing at or before then...
+    std::vector<double>::const_iterator const Later = std::upper_bound(
+        Timestamps.begin(), Timestamps.end(), dMilliseconds);
+    if(Later == Timestamps.begin())
+        return 0;
+    return static_cast<uint32_t>((Later - Timestamps.begin()) - 1);
+}
+
+// Number of frames...
+uint32_t MediaIndex::Frames() const
+{
+    return static_cast<uint32_t>(Timestamps.size());
+}
+
+// Nominal frame rate...
+double MediaIndex::GetFramesPerSecond() const
+{
+    return dFramesPerSecond;
+}
+
+// Is anything indexed?
+bool MediaIndex::IsOk() const
+{
+    return !Timestamps.empty();
+}
+
+// Latest keyframe at or before the given frame...
+uint32_t MediaIndex::KeyframeAtOrBefore(uint32_t const unFrame) const
+{
+    // Don't know, so let the backend work it out...
+    if(!bKeyframesKnown)
+        return unFrame;
+
+    // Find the first keyframe after it and take the one before...
+    std::vector<uint32_t>::const_iterator const Later = std::upper_bound(
+        Keyframes.begin(), Keyframes.end(), unFrame);
+    return (Later == Keyframes.begin()) ? 0 : *(Later - 1);
+}
+
+// Length, from the start of the first frame to the end of the last...
+double MediaIndex::Length() const
+{
+    // Nothing indexed...
+    if(Timestamps.empty())
+        return 0.0;
+
+    // The last frame lasts as long as any other, if we know how long...
+    return Timestamps.back() - Timestamps.front() +
+        ((dFramesPerSecond > 0.0) ? 1000.0 / dFramesPerSecond : 0.0);
+}
+
+// Read in a saved index...
+bool MediaIndex::Load(std::string const &sPath)
+{
+    // Variables...
+    Header      FileHeader;
+    bool        bSuccess    = true;
+    struct stat Status;
+
+    // Start over...
+    Clear();
+
+    // Only little endian machines read the format directly...
+    if(!IsLittleEndian())
+        return false;
+
+    // Open...
+    FILE *pFile = fopen(sPath.c_str(), "rb");
+    if(!pFile)
+        return false;
+
+    // Read and check the header...
+    bSuccess = fread(&FileHeader, sizeof(FileHeader), 1, pFile) == 1 &&
+               !memcmp(FileHeader.Magic, HeaderMagic, sizeof(HeaderMagic)) &&
+               FileHeader.unVersion <= Version &&
+               FileHeader.unHeaderSize >= sizeof(FileHeader) &&
+               fseek(pFile, FileHeader.unHeaderSize, SEEK_SET) == 0;
+
+    // The tables it says follow have to fit in the file, before making room
+    //  for them...
+    bSuccess = bSuccess && fstat(fileno(pFile), &Status) == 0 &&
+               uint64_t(FileHeader.unHeaderSize) +
+                   uint64_t(FileHeader.unFrames) * sizeof(double) +
+                   uint64_t(FileHeader.unKeyframes) * sizeof(uint32_t) <=
+                   uint64_t(Status.st_size);
+
+    // Read the tables...
+    if(bSuccess)
+    {
+        // Make room...
+        Timestamps.resize(FileHeader.unFrames);
+        Keyframes.resize(FileHeader.unKeyframes);
+
+        // Read...
+        bSuccess = (Timestamps.empty() ||
+                    fread(&Timestamps[0], sizeof(double), Timestamps.size(),
+                          pFile) == Timestamps.size()) &&
+                   (Keyframes.empty() ||
+                    fread(&Keyframes[0], sizeof(uint32_t), Keyframes.size(),
+                          pFile) == Keyframes.size());
+    }
+
+    // Done with the file...
+    fclose(pFile);
+
+    // Corrupt...
+    if(!bSuccess)
+    {
+        Clear();
+        return false;
+    }
+
+    // The rest of the header...
+    dFramesPerSecond    = FileHeader.dFramesPerSecond;
+    bKeyframesKnown     = FileHeader.unKeyframesKnown && !Keyframes.empty();
+
+    // Done...
+    return true;
+}
+
+// Keyframe closest to the given frame...
+uint32_t MediaIndex::NearestKeyframe(uint32_t const unFrame) const
+{
+    // Don't know, so any will do...
+    if(!bKeyframesKnown)
+        return unFrame;
+
+    // Find the keyframes either side of it...
+    std::vector<uint32_t>::const_iterator const Later = std::lower_bound(
+        Keyframes.begin(), Keyframes.end(), unFrame);
+
+        // None after...
+        if(Later == Keyframes.end())
+            return Keyframes.back();
+
+        // None before, or it is one...
+        if(Later == Keyframes.begin() || *Later == unFrame)
+            return *Later;
+
+    // Take whichever is closer...
+    uint32_t const unBefore = *(Later - 1);
+    return (unFrame - unBefore <= *Later - unFrame) ? unBefore : *Later;
+}
+
+// Write it out...
+bool MediaIndex::Save(std::string const &sPath) const
+{
+    // Variables...
+    Header  FileHeader;
+    bool    bSuccess    = true;
+
+    // Only little endian machines write the format directly...
+    if(!IsLittleEndian())
+        return false;
+
+    // Open for writing...
+    FILE *pFile = fopen(sPath.c_str(), "wb");
+    if(!pFile)
+        return false;
+
+    // Write the header...
+    memset(&FileHeader, 0, sizeof(FileHeader));
+    memcpy(FileHeader.Magic, HeaderMagic, sizeof(HeaderMagic));
+    FileHeader.unVersion        = Version;
+    FileHeader.unHeaderSize     = sizeof(FileHeader);
+    FileHeader.dFramesPerSecond = dFramesPerSecond;
+    FileHeader.unFrames         = static_cast<uint32_t>(Timestamps.size());
+    FileHeader.unKeyframes      = static_cast<uint32_t>(Keyframes.size());
+    FileHeader.unKeyframesKnown = bKeyframesKnown ? 1 : 0;
+    bSuccess = fwrite(&FileHeader, sizeof(FileHeader), 1, pFile) == 1;
+
+    // Write the tables...
+    if(bSuccess && !Timestamps.empty())
+        bSuccess = fwrite(&Timestamps[0], sizeof(double), Timestamps.size(),
+                          pFile) == Timestamps.size();
+    if(bSuccess && !Keyframes.empty())
+        bSuccess = fwrite(&Keyframes[0], sizeof(uint32_t), Keyframes.size(),
+                          pFile) == Keyframes.size();
+
+    // Close, which can fail too...
+    bSuccess = (fclose(pFile) == 0) && bSuccess;
+
+    // Done...
+    return bSuccess;
+}
+
+// Seek an open capture so the next frame read is the given one...
+bool MediaIndex::Seek(cv::VideoCapture &Capture, uint32_t const unFrame) const
+{
+    // Jump to where decoding has to start from...
+    uint32_t const unKeyframe = KeyframeAtOrBefore(unFrame);
+    if(!Capture.set(cv::CAP_PROP_POS_FRAMES, static_cast<double>(unKeyframe)))
+        return false;
+
+    // Skip the rest of the way without retrieving any of them...
+    for(uint32_t unSkipped = unKeyframe; unSkipped < unFrame; ++unSkipped)
+        if(!Capture.grab())
+            return false;
+
+    // Done...
+    return true;
+}
+
+// Presentation time of a frame...
+double MediaIndex::TimeOfFrame(uint32_t const unFrame) const
+{
+    // Past the end, so just the last...
+    if(unFrame >= Timestamps.size())
+        return Timestamps.empty() ? 0.0 : Timestamps.back();
+
+    // Lookup...
+    return Timestamps[unFrame];
+}
+
@@ -0,0 +1,144 @@
+/*
+  Name:         MediaIndex.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Frame index for a video. It has every frame's presentation
+                time, which frames are keyframes, and how many frames there
+                are, so nothing has to trust the container's frame count or
+                the codec's idea of where a seek by time lands. It is built
+                once, when the video is imported, by reading every packet
+                without decoding any where the backend allows that. Then it is
+                kept with the experiment. The layout on disk is...
+
+                    Header
+                    Timestamps      (one double per frame, in milliseconds)
+                    Keyframes       (one uint32_t frame number per keyframe)
+
+                Everything is little endian...
+*/
+
+// Multiple include protection...
+#ifndef _MEDIAINDEX_H_
+#define _MEDIAINDEX_H_
+
+// Includes...
+
+    // OpenCV...
+    #include <opencv2/opencv.hpp>
+
+    // Standard libraries and STL...
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+
+// MediaIndex class...
+class MediaIndex
+{
+    // Public constants...
+    public:
+
+        // Current format version...
+        static uint32_t const   Version     = 1;
+
+    // Public types. These are the on disk structures, so fixed width only...
+    public:
+
+        // File header...
+        typedef struct Header
+        {
+            // "SLIINDX" and a terminator...
+            char            Magic[8];
+
+            // Format version and size of this header...
+            uint32_t        unVersion;
+            uint32_t        unHeaderSize;
+
+            // Nominal frame rate the container reported...
+            double          dFramesPerSecond;
+
+            // Entries in each table...
+            uint32_t        unFrames;
+            uint32_t        unKeyframes;
+
+            // Non-zero if the backend could tell us the keyframes. Otherwise
+            //  none are listed and any frame is treated as one...
+            uint32_t        unKeyframesKnown;
+
+            // Reserved, always zero...
+            uint32_t        unReserved;
+
+        }Header;
+
+    // Public methods...
+    public:
+
+        // Default constructor...
+        MediaIndex();
+
+        // Accessors...
+
+            // Number of frames, zero if not indexed... θ(1)
+            uint32_t            Frames() const;
+
+            // Frame shown at the given time, in milliseconds from the
+            //  start... O(log n)
+            uint32_t            FrameAtTime(double const dMilliseconds) const;
+
+            // Nominal frame rate, zero if unknown... θ(1)
+            double              GetFramesPerSecond() const;
+
+            // Is anything indexed?
+            bool                IsOk() const;
+
+            // Latest keyframe at or before the given frame, which is where
+            //  decoding has to start from to get to it... O(log n)
+            uint32_t            KeyframeAtOrBefore(uint32_t const unFrame)
+                                    const;
+
+            // Length, from the start of the first frame to the end of the
+            //  last, in milliseconds... θ(1)
+            double              Length() const;
+
+            // Keyframe closest to the given frame, either side... O(log n)
+            uint32_t            NearestKeyframe(uint32_t const unFrame) const;
+
+            // Write it out. Returns false on any error...
+            bool                Save(std::string const &sPath) const;
+
+            // Seek an open capture so the next frame read is the given one.
+            //  Jumps to the keyframe at or before it and then skips forward
+            //  without decoding into anything... O(n) in frames skipped
+            bool                Seek(cv::VideoCapture &Capture,
+                                     uint32_t const unFrame) const;
+
+            // Presentation time of a frame, in milliseconds... θ(1)
+            double              TimeOfFrame(uint32_t const unFrame) const;
+
+        // Mutators...
+
+            // Index a video by reading through every packet in it. Returns
+            //  false if it can't be read... O(n)
+            bool                Build(std::string const &sMediaPath);
+
+            // Forget everything...
+            void                Clear();
+
+            // Read in a saved index. Returns false if it's missing, corrupt,
+            //  or from a newer version...
+            bool                Load(std::string const &sPath);
+
+    // Protected attributes...
+    protected:
+
+        // Nominal frame rate...
+        double                  dFramesPerSecond;
+
+        // Every frame's presentation time, in milliseconds...
+        std::vector<double>     Timestamps;
+
+        // Every keyframe, in order, and whether we know them...
+        std::vector<uint32_t>   Keyframes;
+        bool                    bKeyframesKnown;
+};
+
+#endif
+
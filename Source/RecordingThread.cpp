@@ -0,0 +1,159 @@
+/*
+  Name:         RecordingThread.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Encodes captured frames to disk on its own thread...
+*/
+
+// Includes...
+#include "RecordingThread.h"
+#include <algorithm>
+#include <string>
+
+// How long to sleep when no frames are waiting, in milliseconds...
+static unsigned int const PollMilliseconds = 5;
+
+// Frame rate to record at if the camera doesn't say...
+static double const DefaultFramesPerSecond = 30.0;
+
+// Constructor...
+RecordingThread::RecordingThread(
+    RingBuffer<CapturedFrame> &_Ring, wxString const &_sPath,
+    int const _nFourCC, double const _dMaxLatency)
+    : wxThread(wxTHREAD_JOINABLE),
+      Ring(_Ring),
+      sPath(_sPath),
+      nFourCC(_nFourCC),
+      bFailed(false),
+      dMaxLatency(_dMaxLatency),
+      dWorstLatency(0.0),
+      unRecorded(0),
+      unShed(0),
+      bStopping(false),
+      bStarted(false)
+{
+
+}
+
+// Thread entry point...
+wxThread::ExitCode RecordingThread::Entry()
+{
+    // Keep recording until asked to stop...
+    while(true)
+    {
+        // Check before draining, so nothing published before the stop is
+        //  left behind...
+        bool const bLast = bStopping.load(std::memory_order_acquire);
+
+        // Record everything waiting, oldest first...
+        while(Ring.Acquire())
+            Record(Ring.Front());
+
+        // Let the capture thread have the last slot back...
+        Ring.Release();
+
+        // Done...
+        if(bLast)
+            break;
+
+        // Wait for more...
+        Sleep(PollMilliseconds);
+    }
+
+    // Finish the file...
+    Writer.release();
+
+    // Say how it went...
+    if(unRecorded > 0)
+        wxLogStatus(wxT("Recorded %u frames to %s, %u shed, worst latency "
+                        "%.0f ms..."),
+                    unRecorded, sPath.c_str(), unShed, dWorstLatency * 1000.0);
+
+    // Done...
+    return NULL;
+}
+
+// Current time on the clock frames are stamped with...
+double RecordingThread::Now()
+{
+    return cv::getTickCount() / cv::getTickFrequency();
+}
+
+// Encode a frame, or shed it if it waited too long...
+void RecordingThread::Record(CapturedFrame const &Frame)
+{
+    // Couldn't open the file, so just keep the ring moving...
+    if(bFailed)
+        return;
+
+    // How long it waited...
+    double const dLatency = Now() - Frame.dCaptureTime;
+    dWorstLatency = std::max(dWorstLatency, dLatency);
+
+    // Too long, so the codec is behind. Shed it so we can catch up, and warn
+    //  the first time...
+    if(dMaxLatency > 0.0 && dLatency > dMaxLatency)
+    {
+        // Warn...
+        if(unShed == 0)
+            wxLogWarning(wxT("The codec can't keep up with the camera, so "
+                             "some frames are being left out of the "
+                             "recording. Try a faster codec, or a lower "
+                             "resolution or frame rate..."));
+
+        // Shed...
+      ++unShed;
+        return;
+    }
+
+    // Open the file on the first frame, now that we know its shape...
+    if(!Writer.isOpened())
+    {
+        // Open...
+        double const dFramesPerSecond = (Frame.dFramesPerSecond > 0.0) ?
+            Frame.dFramesPerSecond : DefaultFramesPerSecond;
+        if(!Writer.open(std::string(sPath.fn_str()), nFourCC,
+                        dFramesPerSecond, Frame.Image.size(),
+                        Frame.Image.channels() > 1))
+        {
+            // Alert...
+            wxLogError(wxT("Unable to record to ") + sPath +
+                       wxT(". Check that the directory exists and is "
+                           "writable, and that the codec is installed..."));
+
+            // Don't try again...
+            bFailed = true;
+            return;
+        }
+    }
+
+    // Encode...
+    Writer.write(Frame.Image);
+  ++unRecorded;
+}
+
+// Start recording...
+bool RecordingThread::Start()
+{
+    // Start...
+    if(Create() != wxTHREAD_NO_ERROR || Run() != wxTHREAD_NO_ERROR)
+        return false;
+    bStarted = true;
+
+    // Done...
+    return true;
+}
+
+// Record whatever is still waiting, close the file, and wait for the thread
+//  to finish...
+void RecordingThread::Stop()
+{
+    // Not running...
+    if(!bStarted)
+        return;
+
+    // Ask it to stop and wait for it...
+    bStopping.store(true, std::memory_order_release);
+    Wait();
+    bStarted = false;
+}
+
@@ -0,0 +1,120 @@
+/*
+  Name:         RecordingThread.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Encodes captured frames to disk on its own thread. It is the
+                only consumer of the capture frame ring, so the camera never
+                waits on the codec. If the codec falls behind, the ring fills
+                and drops frames by its own policy. Any frame that has waited
+                longer than a configured latency is shed rather than encoded,
+                so the recording catches up instead of falling further
+                behind...
+*/
+
+// Multiple include protection...
+#ifndef _RECORDINGTHREAD_H_
+#define _RECORDINGTHREAD_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/thread.h>
+
+    // OpenCV...
+    #include <opencv2/opencv.hpp>
+
+    // Lock free frame ring...
+    #include "RingBuffer.h"
+
+    // Standard libraries...
+    #include <atomic>
+
+// A frame as captured, with when it was...
+typedef struct CapturedFrame
+{
+    // The image...
+    cv::Mat         Image;
+
+    // Its place in the capture, counting from zero...
+    unsigned int    unFrame;
+
+    // When it was captured, in seconds on cv::getTickCount()'s clock...
+    double          dCaptureTime;
+
+    // Frame rate the camera reported, zero if unknown...
+    double          dFramesPerSecond;
+
+}CapturedFrame;
+
+// RecordingThread class...
+class RecordingThread : public wxThread
+{
+    // Public methods...
+    public:
+
+        // Constructor takes the ring to record from, the file to record to,
+        //  the codec's four character code, and the longest a frame may wait
+        //  to be encoded, in seconds...
+        RecordingThread(RingBuffer<CapturedFrame> &Ring,
+                        wxString const &sPath, int const nFourCC,
+                        double const dMaxLatency);
+
+        // Accessors...
+
+            // Current time on the clock frames are stamped with, in
+            //  seconds... θ(1)
+            static double       Now();
+
+        // Mutators...
+
+            // Start recording. Returns false if the thread couldn't be
+            //  started...
+            bool                Start();
+
+            // Record whatever is still waiting, close the file, and wait for
+            //  the thread to finish...
+            void                Stop();
+
+    // Protected methods...
+    protected:
+
+        // Thread entry point...
+        virtual ExitCode        Entry();
+
+        // Encode a frame, or shed it if it waited too long...
+        void                    Record(CapturedFrame const &Frame);
+
+    // Protected attributes...
+    protected:
+
+        // The ring we consume...
+        RingBuffer<CapturedFrame>  &Ring;
+
+        // Where and how to encode...
+        cv::VideoWriter         Writer;
+        wxString                sPath;
+        int                     nFourCC;
+        bool                    bFailed;
+
+        // Longest a frame may wait, and the longest any has...
+        double                  dMaxLatency;
+        double                  dWorstLatency;
+
+        // Frames encoded and shed...
+        unsigned int            unRecorded;
+        unsigned int            unShed;
+
+        // Set when asked to stop...
+        std::atomic<bool>       bStopping;
+        bool                    bStarted;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        RecordingThread(RecordingThread const &);
+        RecordingThread &operator=(RecordingThread const &);
+};
+
+#endif
+
@@ -0,0 +1,245 @@
+/*
+  Name:         ResultsExporter.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Background thread that writes analysis results out as comma or
+                tab separated text...
+*/
+
+// Includes...
+#include "ResultsExporter.h"
+#include "MainFrame.h"
+#include <climits>
+#include <cmath>
+
+// Size of the output file's write buffer...
+static size_t const WriteBufferSize = 1 << 20;
+
+// Constructor...
+ResultsExporter::ResultsExporter(
+    MainFrame &_Frame,
+    wxString const &_sPath,
+    Format const _OutputFormat,
+    std::string const &_sSummary,
+    std::vector<AnalyzedMedia> const &_Analyzed)
+    : wxThread(wxTHREAD_DETACHED),
+      Frame(_Frame),
+      sPath(_sPath.fn_str()),
+      OutputFormat(_OutputFormat),
+      sSummary(_sSummary),
+      Analyzed(_Analyzed),
+      unLastPercent(UINT_MAX),
+      bSuccess(false)
+{
+
+}
+
+// Thread entry point...
+void *ResultsExporter::Entry()
+{
+    // Variables...
+    char                    *pWriteBuffer   = NULL;
+
+    // Open the output...
+    FILE *pFile = fopen(sPath.c_str(), "w");
+
+        // Failed...
+        if(!pFile)
+            return NULL;
+
+    // Write through a large buffer so rows go out in big writes...
+    pWriteBuffer = new char[WriteBufferSize];
+    setvbuf(pFile, pWriteBuffer, _IOFBF, WriteBufferSize);
+
+    // Write the per worm summary...
+    ReportProgress(0);
+    bSuccess = fwrite(sSummary.data(), 1, sSummary.size(), pFile) ==
+                sSummary.size();
+
+    // Then every row per frame of each piece of media, if there were any...
+    for(unsigned int unMedia = 0; bSuccess && unMedia < Analyzed.size();
+        ++unMedia)
+    {
+        if(!Analyzed[unMedia].sTrajectoryPath.empty())
+            bSuccess = WriteTrajectories(pFile, Analyzed[unMedia], unMedia);
+    }
+
+    // Close, which flushes, and release the buffer after...
+    if(fclose(pFile) != 0)
+        bSuccess = false;
+    delete [] pWriteBuffer;
+
+    // Don't leave a partial file behind...
+    if(!bSuccess)
+        remove(sPath.c_str());
+
+    // Done...
+    ReportProgress(100);
+    return NULL;
+}
+
+// Format the per worm summary from every row of the results grid...
+std::string ResultsExporter::FormatSummary(
+    AnalysisGridTable &Table, Format const OutputFormat)
+{
+    // Variables...
+    char const      cSeparator  = Separator(OutputFormat);
+    std::string     sSummary;
+
+    // Column names, with their units if they have any...
+    sSummary += "Worm #";
+    for(int nColumn = 0; nColumn < Table.GetNumberCols(); ++nColumn)
+    {
+        // Label...
+        sSummary += cSeparator;
+        sSummary += Table.GetColLabelValue(nColumn).ToUTF8().data();
+
+        // Units...
+        wxString const sUnits =
+            Table.GetColUnits(nColumn).Strip(wxString::both);
+        if(!sUnits.IsEmpty())
+            sSummary += std::string(" (") + sUnits.ToUTF8().data() + ")";
+    }
+
+    // Separated from the data...
+    sSummary += "\n\n";
+
+    // Each worm, in the order shown...
+    for(int nRow = 0; nRow < Table.GetNumberRows(); ++nRow)
+    {
+        // Its label...
+        sSummary += Table.GetRowLabelValue(nRow).ToUTF8().data();
+
+        // Each value, left blank if not measured...
+        for(int nColumn = 0; nColumn < Table.GetNumberCols(); ++nColumn)
+        {
+            // Separate...
+            sSummary += cSeparator;
+
+            // Format...
+            float const fValue = Table.GetFloat(nRow, nColumn);
+            if(!std::isnan(fValue))
+            {
+                char szValue[32] = {0};
+                snprintf(szValue, sizeof(szValue), "%.3f", fValue);
+                sSummary += szValue;
+            }
+        }
+
+        // End of row...
+        sSummary += '\n';
+    }
+
+    // Done...
+    return sSummary;
+}
+
+// Thread exit callback...
+void ResultsExporter::OnExit()
+{
+    // Inform main thread in a thread safe way that the export has ended...
+
+        // Initialize event...
+        wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                             MainFrame::ID_EXPORT_ENDED);
+        Event.SetInt(bSuccess);
+
+        // Send in a thread-safe way...
+        wxPostEvent(&Frame, Event);
+}
+
+// Post progress to the main frame, if the percentage changed...
+void ResultsExporter::ReportProgress(unsigned int const unPercent)
+{
+    // Nothing new to say...
+    if(unPercent == unLastPercent)
+        return;
+    unLastPercent = unPercent;
+
+    // Initialize event...
+    wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                         MainFrame::ID_EXPORT_PROGRESS);
+    Event.SetInt(unPercent);
+
+    // Send in a thread-safe way...
+    wxPostEvent(&Frame, Event);
+}
+
+// Column separator for a format...
+char ResultsExporter::Separator(Format const OutputFormat)
+{
+    return (OutputFormat == TAB_SEPARATED) ? '\t' : ',';
+}
+
+// Stream every row of a piece of media's trajectory file out...
+bool ResultsExporter::WriteTrajectories(
+    FILE *pFile, AnalyzedMedia const &Media, unsigned int const unMedia)
+{
+    // Variables...
+    TrajectoryFile          Trajectories;
+    TrajectoryStore::Chunk  Block;
+    char const              c           = Separator(OutputFormat);
+    char                    szLine[512] = {0};
+    uint64_t                ulRowsDone  = 0;
+
+    // Open it...
+    if(!Trajectories.Open(Media.sTrajectoryPath))
+        return false;
+
+    // Scale from the analysis that produced it...
+    double const dScale = Trajectories.GetMillimetersPerPixel();
+
+    // Which media these are, then column names, separated from the data...
+    if(fprintf(pFile, "\nMedia%c%s\n", c, Media.sTitle.c_str()) < 0)
+        return false;
+    snprintf(szLine, sizeof(szLine),
+        "\nFrame%cWorm #%cCentre X (mm)%cCentre Y (mm)%cHead X (mm)%c"
+        "Head Y (mm)%cTail X (mm)%cTail Y (mm)%cLength (mm)%cWidth (mm)%c"
+        "Area (mm²)\n\n", c, c, c, c, c, c, c, c, c, c);
+    if(fputs(szLine, pFile) == EOF)
+        return false;
+
+    // One block at a time, reusing the same storage for each...
+    for(uint32_t unBlock = 0; unBlock < Trajectories.Blocks(); ++unBlock)
+    {
+        // Cancelled...
+        if(TestDestroy())
+            return false;
+
+        // Decode it...
+        Block.Resize(0);
+        if(!Trajectories.ReadBlock(unBlock, Block))
+            return false;
+
+        // Write each row, numbering worms as the summary does...
+        for(size_t Row = 0; Row < Block.Rows(); ++Row)
+        {
+            // Format...
+            int const nLength = snprintf(szLine, sizeof(szLine),
+                "%u%cWorm %u%c%.3f%c%.3f%c%.3f%c%.3f%c%.3f%c%.3f%c%.3f%c%.3f"
+                "%c%.3f\n",
+                Block.Frame[Row],   c,
+                Block.Worm[Row] + Media.unFirstWorm,    c,
+                dScale * Block.CentreX[Row],    c,
+                dScale * Block.CentreY[Row],    c,
+                dScale * Block.HeadX[Row],      c,
+                dScale * Block.HeadY[Row],      c,
+                dScale * Block.TailX[Row],      c,
+                dScale * Block.TailY[Row],      c,
+                dScale * Block.Length[Row],     c,
+                dScale * Block.Width[Row],      c,
+                dScale * dScale * Block.Area[Row]);
+
+            // Write...
+            if(fwrite(szLine, 1, nLength, pFile) != (size_t) nLength)
+                return false;
+        }
+
+        // Update progress, each piece of media an equal share...
+        ulRowsDone += Block.Rows();
+        ReportProgress((unsigned int) (100 * (unMedia * Trajectories.Rows() +
+            ulRowsDone) / (Analyzed.size() * Trajectories.Rows())));
+    }
+
+    // Done...
+    return true;
+}
@@ -0,0 +1,130 @@
+/*
+  Name:         ResultsExporter.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Background thread that writes analysis results out as comma or
+                tab separated text. The per worm summary is every row of the
+                results grid, including those accumulated over several pieces
+                of media, and the per frame rows of each are streamed a block
+                at a time out of its saved trajectory file, so memory use stays
+                the same however long the recordings were and the UI never
+                waits on it...
+*/
+
+// Multiple include protection...
+#ifndef _RESULTSEXPORTER_H_
+#define _RESULTSEXPORTER_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/thread.h>
+
+    // Analysis results grid, and trajectories...
+    #include "AnalysisGridTable.h"
+    #include "TrajectoryFile.h"
+
+    // Standard libraries and STL...
+    #include <cstdio>
+    #include <string>
+    #include <vector>
+
+// Forward declarations...
+class MainFrame;
+
+// ResultsExporter class...
+class ResultsExporter : public wxThread
+{
+    // Public types...
+    public:
+
+        // Output formats...
+        typedef enum Format
+        {
+            COMMA_SEPARATED = 0,
+            TAB_SEPARATED
+
+        }Format;
+
+        // A piece of media analyzed into the results grid...
+        typedef struct AnalyzedMedia
+        {
+            // Its title, in UTF-8...
+            std::string     sTitle;
+
+            // Number its first worm was given in the grid, which the rest
+            //  are numbered on from...
+            unsigned int    unFirstWorm;
+
+            // Trajectory file to stream its per frame rows from, empty if
+            //  there isn't one...
+            std::string     sTrajectoryPath;
+
+        }AnalyzedMedia;
+
+    // Public methods...
+    public:
+
+        // Constructor takes where to post progress, where to write, in what
+        //  format, the summary already formatted, and every piece of media
+        //  in it to stream per frame rows for...
+        ResultsExporter(
+            MainFrame &_Frame,
+            wxString const &_sPath,
+            Format const _OutputFormat,
+            std::string const &_sSummary,
+            std::vector<AnalyzedMedia> const &_Analyzed);
+
+        // Format the per worm summary from every row of the results grid,
+        //  including any accumulated. Bounded by the number of worms, so
+        //  done on the UI thread, which owns the grid...
+        static std::string FormatSummary(
+            AnalysisGridTable &Table, Format const OutputFormat);
+
+        // Thread entry point...
+        virtual void *Entry();
+
+        // Thread exit callback...
+        void OnExit();
+
+    // Protected methods...
+    protected:
+
+        // Column separator for a format...
+        static char Separator(Format const OutputFormat);
+
+        // Post progress to the main frame, if the percentage changed...
+        void ReportProgress(unsigned int const unPercent);
+
+        // Stream every row of a piece of media's trajectory file out,
+        //  reporting progress as the given share of the whole after those
+        //  before it. Returns false on a write or decode error, or if
+        //  cancelled...
+        bool WriteTrajectories(FILE *pFile, AnalyzedMedia const &Media,
+                               unsigned int const unMedia);
+
+    // Protected attributes...
+    protected:
+
+        // Main frame to post progress and completion to...
+        MainFrame                              &Frame;
+
+        // Where to write and in what format...
+        std::string                             sPath;
+        Format                                  OutputFormat;
+
+        // Per worm summary, already formatted...
+        std::string                             sSummary;
+
+        // Every piece of media analyzed into it...
+        std::vector<AnalyzedMedia>              Analyzed;
+
+        // Last percentage reported...
+        unsigned int                            unLastPercent;
+
+        // Whether the whole export succeeded...
+        bool                                    bSuccess;
+};
+
+#endif
+
@@ -0,0 +1,264 @@
+/*
+  Name:         ReversalDetector.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Watches every worm for reversals as the frames go by...
+*/
+
+// Includes...
+#include "ReversalDetector.h"
+#include <algorithm>
+#include <cmath>
+
+// Most samples a worm's ring can hold...
+unsigned int const ReversalDetector::Capacity;
+
+// Default constructor...
+ReversalDetector::ReversalDetector()
+    : dReversePixelsPerFrame(0.0),
+      dForwardPixelsPerFrame(0.0),
+      dPixelsPerMillimeter(0.0),
+      dFramesPerSecond(30.0)
+{
+
+}
+
+// Feed the worms as they are after the given frame...
+void ReversalDetector::Advance(
+    unsigned int const unFrame, std::vector<Worm *> const &Worms)
+{
+    // Make room for any worms found since last frame, starting out blank...
+    if(Tracks.size() < Worms.size())
+        Tracks.resize(Worms.size(), Track());
+
+    // Check each worm...
+    for(unsigned int unWorm = 0; unWorm < Worms.size(); ++unWorm)
+    {
+        // Get the worm and its track...
+        Worm const &CurrentWorm = *Worms[unWorm];
+        Track      &WormTrack   = Tracks[unWorm];
+
+        // Not seen on this frame, so there's nothing new to go on...
+        if(CurrentWorm.Refreshes() == WormTrack.unRefreshes)
+            continue;
+        WormTrack.unRefreshes = CurrentWorm.Refreshes();
+
+        // Sample it and see which way it's going now...
+        AddSample(WormTrack, unFrame, CurrentWorm);
+        UpdateDirection(WormTrack, CurrentWorm.HeadConfidence());
+    }
+}
+
+// Add a sample to a worm's ring, evicting the oldest if full...
+void ReversalDetector::AddSample(
+    Track &WormTrack, unsigned int unFrame, Worm const &CurrentWorm)
+{
+    // Get the new sample...
+    CvPoint const &Centre   = CurrentWorm.Centre();
+    CvPoint const &Head     = CurrentWorm.Head();
+
+    // Full, so the next slot holds the oldest sample. Take it out of the sums...
+    if(WormTrack.unSamples == CurrentSettings.unWindow)
+    {
+        WormTrack.lCentreX -= WormTrack.Centres[WormTrack.unNext].x;
+        WormTrack.lCentreY -= WormTrack.Centres[WormTrack.unNext].y;
+        WormTrack.lHeadX   -= WormTrack.Heads[WormTrack.unNext].x;
+        WormTrack.lHeadY   -= WormTrack.Heads[WormTrack.unNext].y;
+    }
+    else
+        ++WormTrack.unSamples;
+
+    // Store the new one in its place and add it to the sums...
+    WormTrack.Centres[WormTrack.unNext]  = Centre;
+    WormTrack.Heads[WormTrack.unNext]    = Head;
+    WormTrack.Frames[WormTrack.unNext]   = unFrame;
+    WormTrack.lCentreX  += Centre.x;
+    WormTrack.lCentreY  += Centre.y;
+    WormTrack.lHeadX    += Head.x;
+    WormTrack.lHeadY    += Head.y;
+    WormTrack.unLastFrame = unFrame;
+
+    // Move along...
+    WormTrack.unNext = (WormTrack.unNext + 1) % CurrentSettings.unWindow;
+}
+
+// Is the worm reversing right now?
+bool ReversalDetector::IsReversing(unsigned int const unWorm) const
+{
+    // Not tracked yet...
+    if(unWorm >= Tracks.size())
+        return false;
+
+    // Check...
+    return Tracks[unWorm].CurrentDirection == BACKWARDS;
+}
+
+// Total frames the worm has spent reversing...
+unsigned int ReversalDetector::ReversalFrames(unsigned int const unWorm) const
+{
+    // Not tracked yet...
+    if(unWorm >= Tracks.size())
+        return 0;
+
+    // Completed reversals, plus however long the current one has gone on...
+    Track const &WormTrack = Tracks[unWorm];
+    return WormTrack.unReversalFrames +
+        ((WormTrack.CurrentDirection == BACKWARDS) ?
+            WormTrack.unLastFrame - WormTrack.unReversalStart : 0);
+}
+
+// Number of reversals the worm has started...
+unsigned int ReversalDetector::Reversals(unsigned int const unWorm) const
+{
+    // Not tracked yet...
+    if(unWorm >= Tracks.size())
+        return 0;
+
+    // Lookup...
+    return Tracks[unWorm].unReversals;
+}
+
+// Total time the worm has spent reversing, in seconds...
+double ReversalDetector::ReversalSeconds(unsigned int const unWorm) const
+{
+    return ReversalFrames(unWorm) / dFramesPerSecond;
+}
+
+// Forget every worm...
+void ReversalDetector::Reset()
+{
+    Tracks.clear();
+}
+
+// Set the scale...
+void ReversalDetector::SetScale(
+    double const _dPixelsPerMillimeter, double const _dFramesPerSecond)
+{
+    // Store, assuming a typical camera if the media didn't say...
+    dPixelsPerMillimeter    = _dPixelsPerMillimeter;
+    dFramesPerSecond        = (_dFramesPerSecond > 0.0) ?
+                                _dFramesPerSecond : 30.0;
+
+    // Convert the speed thresholds from mm/s to pixels per frame...
+    dReversePixelsPerFrame  = CurrentSettings.dReverseSpeed *
+                                dPixelsPerMillimeter / dFramesPerSecond;
+    dForwardPixelsPerFrame  = CurrentSettings.dForwardSpeed *
+                                dPixelsPerMillimeter / dFramesPerSecond;
+}
+
+// Set the thresholds...
+void ReversalDetector::SetSettings(Settings const &NewSettings)
+{
+    // Store, keeping the window to something the ring can hold that still has
+    //  two ends to measure between...
+    CurrentSettings             = NewSettings;
+    CurrentSettings.unWindow    =
+        std::min(std::max(CurrentSettings.unWindow, 2U), Capacity);
+
+    // The rings were laid out for the old window, so start over...
+    Reset();
+
+    // Convert the new speeds...
+    SetScale(dPixelsPerMillimeter, dFramesPerSecond);
+}
+
+// Carry on from where another detector left off...
+void ReversalDetector::Stitch(
+    ReversalDetector const &Later, std::vector<unsigned int> const &WormMap,
+    unsigned int const unFrameOffset)
+{
+    // Make room for any worms new to us...
+    for(unsigned int unWorm = 0; unWorm < WormMap.size(); ++unWorm)
+        if(Tracks.size() <= WormMap[unWorm])
+            Tracks.resize(WormMap[unWorm] + 1, Track());
+
+    // Each of its worms it has a track for...
+    for(unsigned int unWorm = 0;
+        unWorm < Later.Tracks.size() && unWorm < WormMap.size(); ++unWorm)
+    {
+        // Its track is the more recent, so start from that...
+        Track       Stitched    = Later.Tracks[unWorm];
+        Track const &Ours       = Tracks[WormMap[unWorm]];
+
+        // Its frames carry on from ours...
+        for(unsigned int unSample = 0; unSample < Capacity; ++unSample)
+            Stitched.Frames[unSample] += unFrameOffset;
+        Stitched.unReversalStart   += unFrameOffset;
+        Stitched.unLastFrame       += unFrameOffset;
+
+        // Add on our counts. A reversal of ours still under way when we
+        //  stopped ends there...
+        Stitched.unReversals       += Ours.unReversals;
+        Stitched.unReversalFrames  += ReversalFrames(WormMap[unWorm]);
+        Stitched.unRefreshes       += Ours.unRefreshes;
+
+        // Store...
+        Tracks[WormMap[unWorm]] = Stitched;
+    }
+}
+
+// Work out which way the worm is going now...
+void ReversalDetector::UpdateDirection(
+    Track &WormTrack, double const dHeadConfidence)
+{
+    // Need two samples to have a velocity...
+    if(WormTrack.unSamples < 2)
+        return;
+
+    // Not sure enough which end is the head to say which way is forwards...
+    if(dHeadConfidence < CurrentSettings.dMinimumHeadConfidence)
+        return;
+
+    // Find the newest and oldest samples in the ring...
+    unsigned int const unWindow = CurrentSettings.unWindow;
+    unsigned int const unNewest = (WormTrack.unNext + unWindow - 1) % unWindow;
+    unsigned int const unOldest =
+        (WormTrack.unSamples < unWindow) ? 0 : WormTrack.unNext;
+
+    // Velocity of the centre between them, in pixels per frame...
+    double const dFrames =
+        WormTrack.Frames[unNewest] - WormTrack.Frames[unOldest];
+    if(dFrames <= 0.0)
+        return;
+    double const dVelocityX =
+        (WormTrack.Centres[unNewest].x - WormTrack.Centres[unOldest].x) / dFrames;
+    double const dVelocityY =
+        (WormTrack.Centres[unNewest].y - WormTrack.Centres[unOldest].y) / dFrames;
+
+    // Mean centre to head axis over the ring, which the sums give us without
+    //  walking it...
+    double const dAxisX =
+        double(WormTrack.lHeadX - WormTrack.lCentreX) / WormTrack.unSamples;
+    double const dAxisY =
+        double(WormTrack.lHeadY - WormTrack.lCentreY) / WormTrack.unSamples;
+    double const dAxisLength = sqrt(dAxisX * dAxisX + dAxisY * dAxisY);
+    if(dAxisLength <= 0.0)
+        return;
+
+    // Speed along the axis, forwards being positive...
+    double const dSpeed =
+        (dVelocityX * dAxisX + dVelocityY * dAxisY) / dAxisLength;
+
+    // Going forwards fast enough to be sure of it. Ends any reversal...
+    if(dSpeed > dForwardPixelsPerFrame)
+    {
+        // Was reversing, so bank how long for...
+        if(WormTrack.CurrentDirection == BACKWARDS)
+            WormTrack.unReversalFrames +=
+                WormTrack.Frames[unNewest] - WormTrack.unReversalStart;
+
+        // Now going forwards...
+        WormTrack.CurrentDirection = FORWARDS;
+    }
+
+    // Going backwards fast enough to be sure of it. Only a worm seen going
+    //  forwards first can be said to have reversed...
+    else if(dSpeed < -dReversePixelsPerFrame &&
+            WormTrack.CurrentDirection == FORWARDS)
+    {
+        // Count it and time it from here...
+        WormTrack.CurrentDirection  = BACKWARDS;
+        WormTrack.unReversalStart   = WormTrack.Frames[unNewest];
+      ++WormTrack.unReversals;
+    }
+}
+
@@ -0,0 +1,190 @@
+/*
+  Name:         ReversalDetector.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Watches every worm for reversals as the frames go by. Each
+                worm keeps a small ring of its most recent centre and head
+                positions, with running sums over it. From those come its
+                velocity across the ring and a smoothed centre to head axis.
+                Moving along the axis faster than one threshold puts it in
+                forward motion and moving against it faster than another puts
+                it in reverse. Anything in between, or a head it isn't sure
+                of, leaves it as it was. Constant work per worm per frame, so
+                it is cheap enough to run live...
+*/
+
+// Multiple include protection...
+#ifndef _REVERSALDETECTOR_H_
+#define _REVERSALDETECTOR_H_
+
+// Includes...
+
+    // Worm class...
+    #include "Worm.h"
+
+    // OpenCV types...
+    #include <opencv2/core/types_c.h>
+
+    // Standard libraries and STL...
+    #include <vector>
+
+// ReversalDetector class...
+class ReversalDetector
+{
+    // Public constants...
+    public:
+
+        // Most samples a worm's ring can hold...
+        static unsigned int const   Capacity = 16;
+
+    // Public types...
+    public:
+
+        // Tunable thresholds...
+        typedef struct Settings
+        {
+            // Defaults...
+            Settings()
+                : unWindow(8),
+                  dReverseSpeed(0.05),
+                  dForwardSpeed(0.05),
+                  dMinimumHeadConfidence(0.6)
+            {
+            }
+
+            // Samples to measure velocity and heading over, at most
+            //  Capacity...
+            unsigned int    unWindow;
+
+            // Speed against the head axis that starts a reversal and speed
+            //  along it that ends one, in mm/s. The gap between them is the
+            //  hysteresis band...
+            double          dReverseSpeed;
+            double          dForwardSpeed;
+
+            // Don't judge direction unless at least this sure of the head...
+            double          dMinimumHeadConfidence;
+
+        }Settings;
+
+    // Public methods...
+    public:
+
+        // Default constructor...
+        ReversalDetector();
+
+        // Accessors...
+
+            // Is the worm reversing right now? θ(1)
+            bool                IsReversing(unsigned int const unWorm) const;
+
+            // Total frames the worm has spent reversing, including any
+            //  reversal still under way... θ(1)
+            unsigned int        ReversalFrames(unsigned int const unWorm) const;
+
+            // Number of reversals the worm has started... θ(1)
+            unsigned int        Reversals(unsigned int const unWorm) const;
+
+            // Total time the worm has spent reversing, in seconds... θ(1)
+            double              ReversalSeconds(unsigned int const unWorm)
+                                    const;
+
+        // Mutators...
+
+            // Feed the worms as they are after the given frame. Only those
+            //  refreshed on this frame are sampled... O(n) in worms
+            void                Advance(unsigned int const unFrame,
+                                        std::vector<Worm *> const &Worms);
+
+            // Forget every worm, keeping the settings and scale...
+            void                Reset();
+
+            // Set the scale, to convert the speed thresholds into pixels per
+            //  frame. An unknown frame rate of zero is taken as thirty...
+            void                SetScale(double const dPixelsPerMillimeter,
+                                         double const dFramesPerSecond);
+
+            // Set the thresholds...
+            void                SetSettings(Settings const &NewSettings);
+
+            // Carry on from where another detector left off, as when another
+            //  tracker analyzed the frames right after ours. Its worm n is our
+            //  worm WormMap[n], and its frames are offset by the given
+            //  amount... O(n) in worms
+            void                Stitch(ReversalDetector const &Later,
+                                       std::vector<unsigned int> const &WormMap,
+                                       unsigned int const unFrameOffset);
+
+    // Protected types...
+    protected:
+
+        // Which way a worm is going...
+        typedef enum Direction
+        {
+            UNKNOWN = 0,
+            FORWARDS,
+            BACKWARDS
+
+        }Direction;
+
+        // A worm's recent history and reversal counts...
+        typedef struct Track
+        {
+            // Ring of recent samples, the frame each was taken on, and where
+            //  the next goes...
+            CvPoint         Centres[Capacity];
+            CvPoint         Heads[Capacity];
+            unsigned int    Frames[Capacity];
+            unsigned int    unSamples;
+            unsigned int    unNext;
+
+            // Running sums of every sample in the ring...
+            long            lCentreX;
+            long            lCentreY;
+            long            lHeadX;
+            long            lHeadY;
+
+            // Refresh count as of the last sample...
+            unsigned int    unRefreshes;
+
+            // Current direction and, if reversing, since when...
+            Direction       CurrentDirection;
+            unsigned int    unReversalStart;
+
+            // The frame of the latest sample...
+            unsigned int    unLastFrame;
+
+            // Reversals started and frames spent in completed ones...
+            unsigned int    unReversals;
+            unsigned int    unReversalFrames;
+
+        }Track;
+
+    // Protected methods...
+    protected:
+
+        // Add a sample to a worm's ring, evicting the oldest if full... θ(1)
+        void                AddSample(Track &WormTrack, unsigned int unFrame,
+                                      Worm const &CurrentWorm);
+
+        // Work out which way the worm is going now... θ(1)
+        void                UpdateDirection(Track &WormTrack,
+                                            double const dHeadConfidence);
+
+    // Protected attributes...
+    protected:
+
+        // Thresholds, and the speeds converted to pixels per frame...
+        Settings            CurrentSettings;
+        double              dReversePixelsPerFrame;
+        double              dForwardPixelsPerFrame;
+
+        // Scale...
+        double              dPixelsPerMillimeter;
+        double              dFramesPerSecond;
+
+        // Every worm's track, in the tracker's order...
+        std::vector<Track>  Tracks;
+};
+
+#endif
+
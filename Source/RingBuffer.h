@@ -0,0 +1,328 @@
+/*
+  Name:         RingBuffer.h (definition and implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Lock free, bounded, single producer, single consumer ring of
+                slots. They are allocated once, and whatever storage a slot
+                holds is reused every time around. When the consumer falls a
+                whole ring behind, the producer either drops the newest or
+                the oldest frame, as asked. Neither side ever waits on the
+                other. Every slot carries its own state, so the producer can
+                take back the oldest unread slot without touching the
+                consumer's cursor, and it can never take the one the consumer
+                is holding...
+*/
+
+// Multiple include protection...
+#ifndef _RINGBUFFER_H_
+#define _RINGBUFFER_H_
+
+// Includes...
+
+    // Atomic slot states, cursors, and counters...
+    #include <atomic>
+
+    // Standard libraries...
+    #include <cstddef>
+    #include <cstdint>
+
+// RingBuffer class template...
+template <typename Type>
+class RingBuffer
+{
+    // Public types...
+    public:
+
+        // What to do when the producer finds the ring full...
+        typedef enum DropPolicy
+        {
+            // Take back the oldest frame the consumer hasn't read yet...
+            DROP_OLDEST = 0,
+
+            // Discard the frame being produced...
+            DROP_NEWEST
+
+        }DropPolicy;
+
+    // Public methods...
+    public:
+
+        // Default constructor. Holds nothing until configured...
+        RingBuffer()
+            : pSlots(NULL),
+              unCapacity(0),
+              Policy(DROP_OLDEST),
+              ulPublished(0),
+              ulDrops(0),
+              ulStalls(0),
+              ulConsumed(0),
+              pHeld(NULL)
+        {
+        }
+
+        // Producer side...
+
+            // Get the slot to fill with the next frame, or NULL if this frame
+            //  has to be dropped. Contents are whatever was in the slot last
+            //  time around, so reuse any storage already in there. Calling it
+            //  again before Publish() returns the same slot... θ(1)
+            Type *Back()
+            {
+                // Nowhere to put anything...
+                if(!unCapacity)
+                    return NULL;
+
+                // The slot the next frame goes in...
+                Slot &Next = pSlots[ulPublished.load(
+                    std::memory_order_relaxed) % unCapacity];
+
+                // Free, or already ours from an earlier call...
+                unsigned int unState = EMPTY;
+                if(Next.State.compare_exchange_strong(
+                    unState, WRITING, std::memory_order_acquire) ||
+                   unState == WRITING)
+                    return &Next.Value;
+
+                // Full, and the consumer is reading the oldest frame, so
+                //  there's nothing to take back either way...
+                if(unState == READING)
+                    return Stall();
+
+                // Full, and asked to keep what's already there...
+                if(Policy == DROP_NEWEST)
+                {
+                    ulDrops.fetch_add(1, std::memory_order_relaxed);
+                    return NULL;
+                }
+
+                // Full, so take back the oldest unread, unless the consumer
+                //  just beat us to it...
+                if(!Next.State.compare_exchange_strong(
+                    unState, WRITING, std::memory_order_acquire))
+                    return Stall();
+
+                // The oldest is gone...
+                ulDrops.fetch_add(1, std::memory_order_relaxed);
+                return &Next.Value;
+            }
+
+            // Hand the slot from Back() to the consumer as the newest frame.
+            //  Only call it if Back() returned a slot... θ(1)
+            void Publish()
+            {
+                // The frame's place in the sequence...
+                uint64_t const ulFrame =
+                    ulPublished.load(std::memory_order_relaxed);
+
+                // Mark the slot readable, then count it as published...
+                Slot &Next = pSlots[ulFrame % unCapacity];
+                Next.ulFrame = ulFrame;
+                Next.State.store(FULL, std::memory_order_release);
+                ulPublished.store(ulFrame + 1, std::memory_order_release);
+            }
+
+        // Consumer side...
+
+            // Let go of the slot we hold, if any, and take the oldest frame
+            //  that's waiting. Returns false if none are... O(n) in frames
+            //  dropped since the last call
+            bool Acquire()
+            {
+                // Done with the last one...
+                Release();
+
+                // Nowhere to get anything from...
+                if(!unCapacity)
+                    return false;
+
+                // Next frame we want, and the first still in the ring...
+                uint64_t ulNext = ulConsumed.load(std::memory_order_relaxed);
+                uint64_t const ulPublishedNow =
+                    ulPublished.load(std::memory_order_acquire);
+                if(ulPublishedNow - ulNext > unCapacity)
+                    ulNext = ulPublishedNow - unCapacity;
+
+                // Take the oldest still there...
+                for(; ulNext < ulPublishedNow; ++ulNext)
+                {
+                    // Its slot, if the producer's not writing in it...
+                    Slot &Candidate = pSlots[ulNext % unCapacity];
+                    unsigned int unState = FULL;
+                    if(!Candidate.State.compare_exchange_strong(
+                        unState, READING, std::memory_order_acquire))
+                        continue;
+
+                    // It was dropped, and this is a later frame in its
+                    //  place. Leave it for when we get there...
+                    if(Candidate.ulFrame != ulNext)
+                    {
+                        Candidate.State.store(FULL, std::memory_order_release);
+                        continue;
+                    }
+
+                    // Hold it...
+                    pHeld = &Candidate;
+                    ulConsumed.store(ulNext + 1, std::memory_order_relaxed);
+                    return true;
+                }
+
+                // Caught up...
+                ulConsumed.store(ulNext, std::memory_order_relaxed);
+                return false;
+            }
+
+            // Get the frame the consumer holds. The producer will not touch
+            //  it until the next Acquire() or Release()... θ(1)
+            Type const &Front() const { return pHeld->Value; }
+
+            // Let the producer have the held slot back... θ(1)
+            void Release()
+            {
+                // Not holding one...
+                if(!pHeld)
+                    return;
+
+                // Free it...
+                pHeld->State.store(EMPTY, std::memory_order_release);
+                pHeld = NULL;
+            }
+
+        // Either side...
+
+            // Number of slots... θ(1)
+            unsigned int Capacity() const { return unCapacity; }
+
+            // Frames published but not yet taken. Only a snapshot while the
+            //  other side is active... θ(1)
+            unsigned int Depth() const
+            {
+                // Count what's been published since the consumer's cursor...
+                uint64_t const ulConsumedNow =
+                    ulConsumed.load(std::memory_order_relaxed);
+                uint64_t const ulPublishedNow =
+                    ulPublished.load(std::memory_order_relaxed);
+                if(ulPublishedNow <= ulConsumedNow)
+                    return 0;
+
+                // The ring can't hold more than its capacity...
+                uint64_t const ulDepth = ulPublishedNow - ulConsumedNow;
+                return (ulDepth < unCapacity) ?
+                    static_cast<unsigned int>(ulDepth) : unCapacity;
+            }
+
+            // Frames dropped because the ring was full, under either
+            //  policy... θ(1)
+            uint64_t Drops() const
+                { return ulDrops.load(std::memory_order_relaxed); }
+
+            // Times the producer found the slot it needed held by the
+            //  consumer, so the newest had to be dropped whatever the
+            //  policy... θ(1)
+            uint64_t Stalls() const
+                { return ulStalls.load(std::memory_order_relaxed); }
+
+            // Allocate the slots, set the policy, and clear the counters.
+            //  Only safe while neither side is active... O(n)
+            void Configure(unsigned int const _unCapacity,
+                           DropPolicy const _Policy)
+            {
+                // Let go of the old slots...
+                delete [] pSlots;
+                pSlots = NULL;
+                pHeld = NULL;
+
+                // Make the new ones, all free...
+                unCapacity = _unCapacity;
+                Policy = _Policy;
+                if(unCapacity)
+                    pSlots = new Slot[unCapacity];
+
+                // Nothing published, taken, or dropped yet...
+                ulPublished.store(0, std::memory_order_relaxed);
+                ulDrops.store(0, std::memory_order_relaxed);
+                ulStalls.store(0, std::memory_order_relaxed);
+                ulConsumed.store(0, std::memory_order_relaxed);
+            }
+
+        // Deconstructor...
+       ~RingBuffer() { delete [] pSlots; }
+
+    // Protected types...
+    protected:
+
+        // Who a slot belongs to...
+        typedef enum SlotState
+        {
+            // The producer's to fill...
+            EMPTY = 0,
+
+            // The producer's, being filled...
+            WRITING,
+
+            // The consumer's to read, or the producer's to take back...
+            FULL,
+
+            // The consumer's, being read...
+            READING
+
+        }SlotState;
+
+        // A slot, on its own cache line so the two sides working in
+        //  neighbouring slots don't bounce each other's around...
+        typedef struct alignas(64) Slot
+        {
+            // Default constructor...
+            Slot() : State(EMPTY), ulFrame(0) {}
+
+            // SlotState, changed only by whoever it belongs to...
+            std::atomic<unsigned int>   State;
+
+            // Place in the sequence of the frame in it, so the consumer can
+            //  tell a frame dropped and replaced from the one it expected...
+            uint64_t                    ulFrame;
+
+            // The frame...
+            Type                        Value;
+
+        }Slot;
+
+    // Protected methods...
+    protected:
+
+        // The producer can't have a slot this time. Count it and drop the
+        //  newest... θ(1)
+        Type *Stall()
+        {
+            ulStalls.fetch_add(1, std::memory_order_relaxed);
+            ulDrops.fetch_add(1, std::memory_order_relaxed);
+            return NULL;
+        }
+
+    // Protected attributes...
+    protected:
+
+        // The slots, how many, and what to drop when they're all full...
+        Slot                                   *pSlots;
+        unsigned int                            unCapacity;
+        DropPolicy                              Policy;
+
+        // Frames published, and those dropped and stalled on. Written only
+        //  by the producer...
+        alignas(64) std::atomic<uint64_t>       ulPublished;
+        std::atomic<uint64_t>                   ulDrops;
+        std::atomic<uint64_t>                   ulStalls;
+
+        // Next frame the consumer wants, and the slot it holds. Written only
+        //  by the consumer...
+        alignas(64) std::atomic<uint64_t>       ulConsumed;
+        Slot                                   *pHeld;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        RingBuffer(RingBuffer const &);
+        RingBuffer &operator=(RingBuffer const &);
+};
+
+#endif
+
@@ -0,0 +1,210 @@
+/*
+  Name:         SaveThread.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Background thread that saves an experiment's archive...
+*/
+
+// Includes...
+#include "SaveThread.h"
+#include "MainFrame.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Constructor...
+SaveThread::SaveThread(
+    MainFrame &_Frame,
+    std::string const &_sSourcePath,
+    std::string const &_sTargetPath,
+    std::string const &_sTemporaryPath,
+    std::vector<Item> const &_Items)
+    : wxThread(wxTHREAD_JOINABLE),
+      Frame(_Frame),
+      sSourcePath(_sSourcePath),
+      sTargetPath(_sTargetPath),
+      sTemporaryPath(_sTemporaryPath),
+      Items(_Items),
+      unLastPercent(UINT_MAX),
+      bFinished(false),
+      bSucceeded(false)
+{
+
+}
+
+// Thread entry point...
+wxThread::ExitCode SaveThread::Entry()
+{
+    // Write it...
+    ReportProgress(0);
+    bSucceeded = Write();
+
+    // Don't leave a partial file behind...
+    if(!bSucceeded && !sTemporaryPath.empty())
+        std::remove(sTemporaryPath.c_str());
+
+    // Done. Inform main thread in a thread safe way...
+    bFinished = true;
+    wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                         MainFrame::ID_SAVE_ENDED);
+    Event.SetInt(bSucceeded);
+    wxPostEvent(&Frame, Event);
+    return NULL;
+}
+
+// Every entry, and whether each was saved...
+std::vector<SaveThread::Item> const &SaveThread::GetItems() const
+{
+    return Items;
+}
+
+// Has it finished?
+bool SaveThread::IsFinished() const
+{
+    return bFinished;
+}
+
+// Did the save as a whole succeed?
+bool SaveThread::IsSucceeded() const
+{
+    return bSucceeded;
+}
+
+// Post progress to the main frame, if the percentage changed...
+void SaveThread::ReportProgress(unsigned int const unPercent)
+{
+    // Nothing new to say...
+    if(unPercent == unLastPercent)
+        return;
+    unLastPercent = unPercent;
+
+    // Initialize event...
+    wxCommandEvent Event(wxEVT_COMMAND_BUTTON_CLICKED,
+                         MainFrame::ID_SAVE_PROGRESS);
+    Event.SetInt(unPercent);
+
+    // Send in a thread-safe way...
+    wxPostEvent(&Frame, Event);
+}
+
+// Write the archive...
+bool SaveThread::Write()
+{
+    // Variables...
+    ExperimentArchive       Source;
+    ExperimentArchiveWriter Writer;
+    uint64_t                ulTotal = 0;
+    uint64_t                ulDone  = 0;
+
+    // Add up how much there is to write, to measure progress by...
+    for(size_t Index = 0; Index < Items.size(); ++Index)
+    {
+        switch(Items[Index].Do)
+        {
+            case ADD_DATA:  ulTotal += Items[Index].sData.size(); break;
+            case ADD_FILE:  ulTotal += Items[Index].ulSize; break;
+            case COPY:      ulTotal += Items[Index].Member.ulCompressedSize;
+                            break;
+            default:        break;
+        }
+    }
+
+    // Open the archive saved from, if any, on its own descriptor...
+    if(!sSourcePath.empty() && !Source.Open(sSourcePath))
+        return false;
+
+    // Start a new archive, or updating the old one in place...
+    if(!(sTemporaryPath.empty() ? Writer.Append(Source) :
+                                  Writer.Create(sTemporaryPath)))
+        return false;
+
+    // Save each...
+    for(size_t Index = 0; Index < Items.size(); ++Index)
+    {
+        // Save it...
+        Item &Saving = Items[Index];
+        switch(Saving.Do)
+        {
+            // Directory...
+            case ADD_DIRECTORY:
+                Saving.bSaved = Writer.AddDirectory(Saving.sName);
+                break;
+
+            // Data held here...
+            case ADD_DATA:
+                Saving.bSaved = Writer.AddData(
+                    Saving.sName, Saving.sData.data(), Saving.sData.size());
+                ulDone += Saving.sData.size();
+                break;
+
+            // File in the cache...
+            case ADD_FILE:
+                Saving.bSaved = Writer.AddFile(Saving.sName, Saving.sData);
+                ulDone += Saving.ulSize;
+                break;
+
+            // Copied raw...
+            case COPY:
+                Saving.bSaved = Writer.Copy(Source, Saving.Member,
+                                            Saving.sName);
+                ulDone += Saving.Member.ulCompressedSize;
+                break;
+
+            // Left where it is...
+            case KEEP:
+                Saving.bSaved = Writer.Keep(Saving.Member);
+                break;
+        }
+
+        // Anything missing and the new archive would lose it, media that
+        //  may only have been in the old one included, so give up on it and
+        //  leave the old one as it was...
+        if(!Saving.bSaved)
+        {
+            // Alert user...
+            wxLogError(wxT("Unable to save ") +
+                       wxString(Saving.sName.c_str(), wxConvLocal) +
+                       wxT("..."));
+
+            // Abort...
+            Writer.Abort();
+            return false;
+        }
+
+        // Update progress, keeping the last percent for finishing...
+        if(ulTotal > 0)
+            ReportProgress((unsigned int) (ulDone * 99 / ulTotal));
+    }
+
+    // Write the central directory, and flush it all to disk...
+    if(!Writer.Finish())
+        return false;
+
+    // Written in place, so that's it...
+    if(sTemporaryPath.empty())
+    {
+        ReportProgress(100);
+        return true;
+    }
+
+    // Otherwise move it over the old one, which happens all at once...
+    if(std::rename(sTemporaryPath.c_str(), sTargetPath.c_str()) != 0)
+        return false;
+
+    // Make sure the rename is on disk too, by flushing its directory...
+    std::string::size_type const Slash = sTargetPath.rfind('/');
+    std::string const sDirectory = (Slash == std::string::npos) ?
+        std::string(".") : sTargetPath.substr(0, std::max<size_t>(Slash, 1));
+    int const nDirectory = open(sDirectory.c_str(), O_RDONLY);
+    if(nDirectory >= 0)
+    {
+        fsync(nDirectory);
+        close(nDirectory);
+    }
+
+    // Done...
+    ReportProgress(100);
+    return true;
+}
+
@@ -0,0 +1,151 @@
+/*
+  Name:         SaveThread.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Background thread that saves an experiment's archive, so the
+                UI carries on while even a large experiment is written. What
+                to write is worked out beforehand on the main thread, from a
+                snapshot of the media grid and the cache, so nothing the user
+                does in the meantime changes what this save writes. A whole
+                new archive goes to a temporary file next to the old one, is
+                flushed to disk, and only then renamed over it, so a crash
+                partway leaves the old one as it was. An archive updated in
+                place is flushed before its new central directory is written,
+                which leaves the old one readable too. Progress and completion
+                are posted to the main frame...
+*/
+
+// Multiple include protection...
+#ifndef _SAVETHREAD_H_
+#define _SAVETHREAD_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/thread.h>
+
+    // Saved experiment archive, and writing it...
+    #include "ExperimentArchive.h"
+    #include "ExperimentArchiveWriter.h"
+
+    // Standard libraries and STL...
+    #include <atomic>
+    #include <ctime>
+    #include <string>
+    #include <vector>
+
+// Forward declarations...
+class MainFrame;
+
+// SaveThread class...
+class SaveThread : public wxThread
+{
+    // Public types...
+    public:
+
+        // How an entry is saved...
+        typedef enum Action
+        {
+            // As a directory...
+            ADD_DIRECTORY = 0,
+
+            // From the data held here...
+            ADD_DATA,
+
+            // From a file in the cache...
+            ADD_FILE,
+
+            // Copied raw out of the archive saved from...
+            COPY,
+
+            // Left where it is in the archive being updated...
+            KEEP
+
+        }Action;
+
+        // An entry to save...
+        typedef struct Item
+        {
+            // How it's saved...
+            Action                      Do;
+
+            // Name in the new archive...
+            std::string                 sName;
+
+            // Data to save, or path to the file in the cache to save...
+            std::string                 sData;
+
+            // The file's name in the cache, and its size and modification
+            //  time when the snapshot was taken...
+            wxString                    sCacheName;
+            uint64_t                    ulSize;
+            time_t                      Modified;
+
+            // Entry copied or kept from the archive saved from...
+            ExperimentArchive::Entry    Member;
+
+            // Was it saved?
+            bool                        bSaved;
+
+        }Item;
+
+    // Public methods...
+    public:
+
+        // Constructor takes where to post progress, the archive to copy and
+        //  keep entries from if any, the path to save to, a temporary file to
+        //  write to first or empty to update the archive in place, and every
+        //  entry to save...
+        SaveThread(MainFrame &_Frame,
+                   std::string const &_sSourcePath,
+                   std::string const &_sTargetPath,
+                   std::string const &_sTemporaryPath,
+                   std::vector<Item> const &_Items);
+
+        // Accessors...
+
+            // Every entry, and whether each was saved. Only once finished...
+            std::vector<Item> const &GetItems() const;
+
+            // Has it finished, so it can be waited for without blocking?
+            bool                IsFinished() const;
+
+            // Did the save as a whole succeed? Only once finished...
+            bool                IsSucceeded() const;
+
+    // Protected methods...
+    protected:
+
+        // Thread entry point...
+        virtual ExitCode        Entry();
+
+        // Post progress to the main frame, if the percentage changed...
+        void                    ReportProgress(unsigned int const unPercent);
+
+        // Write the archive. Returns false if it couldn't be...
+        bool                    Write();
+
+    // Protected attributes...
+    protected:
+
+        // Main frame to post progress and completion to...
+        MainFrame                  &Frame;
+
+        // Archive saved from, where to save, and where to write first...
+        std::string                 sSourcePath;
+        std::string                 sTargetPath;
+        std::string                 sTemporaryPath;
+
+        // Every entry to save...
+        std::vector<Item>           Items;
+
+        // Last percentage reported...
+        unsigned int                unLastPercent;
+
+        // Has it finished, and did it succeed?
+        std::atomic<bool>           bFinished;
+        bool                        bSucceeded;
+};
+
+#endif
+
@@ -1,7 +1,9 @@
 /*
-  Name:         SlitherMath.cpp (definition)
+  Name:         SlitherMath.h (definition and implementation)
   Author:       Kip Warner (Kip@TheVertigo.com)
-  Description:  General Slither related math routines...
+  Description:  General Slither related math routines. Header only so the
+                trivial θ(1) helpers can be inlined straight into the Worm hot
+                loops without needing link time optimization...
 */
 
 // Multiple include protection...
@@ -22,7 +24,14 @@
     #include <opencv2/videoio/videoio_c.h>
     //#include <opencv2/imgcodecs/imgcodecs_c.h>  2020/06/10 - deprecated
     #include <opencv2/imgcodecs/legacy/constants_c.h>
-    
+
+    // Min / max templates...
+    #include <algorithm>
+
+    // Standard math routines...
+    #include <cfloat>
+    #include <cmath>
+
     // STL pair...
     #include <utility>
 
@@ -32,76 +41,379 @@ namespace SlitherMath
     // Constants...
 
         // The value of π...
-        double const Pi         = 3.1415926535897932384626433832795f;
+        constexpr double Pi         = 3.1415926535897932384626433832795;
 
         // Infinity... (kind of)
-        double const Infinity   = FLT_MAX;
+        constexpr double Infinity   = FLT_MAX;
 
     // Types...
 
         // Line segment...
         typedef std::pair<CvPoint2D32f, CvPoint2D32f> LineSegment;
 
-    // Functions. Mostly computational geometry related...
+        // Point traits. Every point type the geometry templates below accept
+        //  needs a specialization that knows how to read its coordinates.
+        //  Anything without one fails to compile rather than silently doing
+        //  the wrong thing...
+        template <typename PointType> struct PointTraits;
+
+            // Legacy C integral point...
+            template <> struct PointTraits<CvPoint>
+            {
+                // Coordinate type...
+                typedef int CoordinateType;
+
+                // Coordinate accessors...
+                static constexpr double X(CvPoint const &Point) { return Point.x; }
+                static constexpr double Y(CvPoint const &Point) { return Point.y; }
+            };
+
+            // Legacy C single precision point...
+            template <> struct PointTraits<CvPoint2D32f>
+            {
+                // Coordinate type...
+                typedef float CoordinateType;
+
+                // Coordinate accessors...
+                static constexpr double X(CvPoint2D32f const &Point) { return Point.x; }
+                static constexpr double Y(CvPoint2D32f const &Point) { return Point.y; }
+            };
+
+            // C++ API points of any precision. e.g. cv::Point, cv::Point2f...
+            template <typename Type> struct PointTraits<cv::Point_<Type> >
+            {
+                // Coordinate type...
+                typedef Type CoordinateType;
+
+                // Coordinate accessors...
+                static constexpr double X(cv::Point_<Type> const &Point) { return Point.x; }
+                static constexpr double Y(cv::Point_<Type> const &Point) { return Point.y; }
+            };
+
+    // Functions. Mostly computational geometry related. Everything templated
+    //  over the point type is constexpr capable when the point type is a
+    //  literal type...
+
+        // Calculate the square of the distance between two points. Cheaper
+        //  than the distance itself when only comparing... θ(1)
+        template <typename FirstPointType, typename SecondPointType>
+        constexpr double SquaredDistanceBetweenTwoPoints(
+            FirstPointType const &First, SecondPointType const &Second)
+        {
+            // Variables...
+            double const dDeltaX = PointTraits<SecondPointType>::X(Second) -
+                                   PointTraits<FirstPointType>::X(First);
+            double const dDeltaY = PointTraits<SecondPointType>::Y(Second) -
+                                   PointTraits<FirstPointType>::Y(First);
+
+            // Calculate...
+            return (dDeltaX * dDeltaX) + (dDeltaY * dDeltaY);
+        }
+
+        // Calculate the absolute distance between two points... θ(1)
+        template <typename FirstPointType, typename SecondPointType>
+        inline double DistanceBetweenTwoPoints(
+            FirstPointType const &First, SecondPointType const &Second)
+        {
+            // Return it...
+            return std::sqrt(SquaredDistanceBetweenTwoPoints(First, Second));
+        }
+
+        // Calculate the square of the length of a line segment... θ(1)
+        template <typename PointType>
+        constexpr double SquaredLengthOfLineSegment(
+            std::pair<PointType, PointType> const &A)
+        {
+            // Calculate...
+            return SquaredDistanceBetweenTwoPoints(A.first, A.second);
+        }
+
+        // Calculate the length of a line segment... θ(1)
+        template <typename PointType>
+        inline double LengthOfLineSegment(std::pair<PointType, PointType> const &A)
+        {
+            // Calculate...
+            return std::sqrt(SquaredLengthOfLineSegment(A));
+        }
 
-        // Adjust the distance of the second vertex by the given distance along
-        //  the radial... 
-        void AdjustDirectedLineSegmentLength(
-            LineSegment &A, double const dLength);
-        
-        // Clip line against the image rectangle...
-        void ClipLineSegment(CvSize const Size, LineSegment &A);
-        
         // Calculate the distance between the midpoints of two segments... θ(1)
-        double DistanceBetweenLineSegments(
-            LineSegment const &A, LineSegment const &B);
+        template <typename PointType>
+        inline double DistanceBetweenLineSegments(
+            std::pair<PointType, PointType> const &A,
+            std::pair<PointType, PointType> const &B)
+        {
+            // Traits...
+            typedef PointTraits<PointType> Traits;
 
-        // Calculate the absolute distance between two points...
-        double DistanceBetweenTwoPoints(
-            CvPoint const &First, CvPoint const &Second);
-        double DistanceBetweenTwoPoints(
-            CvPoint2D32f const &First, CvPoint2D32f const &Second);
+            // Just measure the length of the imaginary line segment joining
+            //  both segment's middles...
+            double const dDeltaX = ((Traits::X(B.second) - Traits::X(B.first)) -
+                                    (Traits::X(A.second) - Traits::X(A.first))) / 2.0;
+            double const dDeltaY = ((Traits::Y(B.second) - Traits::Y(B.first)) -
+                                    (Traits::Y(A.second) - Traits::Y(A.first))) / 2.0;
+            return std::sqrt((dDeltaX * dDeltaX) + (dDeltaY * dDeltaY));
+        }
 
-        // Is directed line segment Start->Second clockwise (> 0), 
-        //  counterclockwise (< 0), or collinear with respect to the directed 
+        // Is directed line segment Start->Second clockwise (> 0),
+        //  counterclockwise (< 0), or collinear with respect to the directed
         //  line segment Start->First? θ(1)
-        int Direction(
-            CvPoint2D32f const Start, 
-            CvPoint2D32f const First, 
-            CvPoint2D32f const Second);
+        template <typename PointType>
+        constexpr int Direction(
+            PointType const &Start,
+            PointType const &First,
+            PointType const &Second)
+        {
+            // Traits...
+            typedef PointTraits<PointType> Traits;
 
-        // Generate orthogonal of unit length from middle of given line segment
-        //  outwards... θ(1)
-        void GenerateOrthogonalToLineSegment(
-            LineSegment const &A, 
-            LineSegment &Orthogonal);
+            // Calculate the cross product, but do it with both vectors
+            //  translated back to the origin to make it work...
+            return (int) (((Traits::X(First) - Traits::X(Start)) *
+                           (Traits::Y(Second) - Traits::Y(Start))) -
+                          ((Traits::X(Second) - Traits::X(Start)) *
+                           (Traits::Y(First) - Traits::Y(Start))));
+        }
 
         // Can the collinear point be found on the line segment? θ(1)
-        bool IsCollinearPointOnLineSegment(
-            LineSegment const &A, 
-            CvPoint2D32f const &CollinearPoint);
-                                
+        template <typename PointType>
+        constexpr bool IsCollinearPointOnLineSegment(
+            std::pair<PointType, PointType> const &A,
+            PointType const &CollinearPoint)
+        {
+            // Traits...
+            typedef PointTraits<PointType> Traits;
+
+            // Found if it falls within the bounding box of the segment...
+            return ((std::min(Traits::X(A.first), Traits::X(A.second)) <=
+                        Traits::X(CollinearPoint)) &&
+                    (Traits::X(CollinearPoint) <=
+                        std::max(Traits::X(A.first), Traits::X(A.second)))) &&
+                   ((std::min(Traits::Y(A.first), Traits::Y(A.second)) <=
+                        Traits::Y(CollinearPoint)) &&
+                    (Traits::Y(CollinearPoint) <=
+                        std::max(Traits::Y(A.first), Traits::Y(A.second))));
+        }
+
         // Check if two line segments intersect... θ(1)
-        bool IsLineSegmentsIntersect(
-            LineSegment const &A, 
-            LineSegment const &B);
+        template <typename PointType>
+        constexpr bool IsLineSegmentsIntersect(
+            std::pair<PointType, PointType> const &A,
+            std::pair<PointType, PointType> const &B)
+        {
+            // Calculate the relative orientation of each endpoint with respect
+            //  to the other segment...
+            int const nDirection1 = Direction(B.first, B.second, A.first);
+            int const nDirection2 = Direction(B.first, B.second, A.second);
+            int const nDirection3 = Direction(A.first, A.second, B.first);
+            int const nDirection4 = Direction(A.first, A.second, B.second);
 
-        // Calculate the length of a line segment... θ(1)
-        double LengthOfLineSegment(LineSegment const &A);
-                                
-        // Rotate a line segment about a point counterclockwise by an angle...
-        void RotateLineSegmentAboutPoint(
-            LineSegment &LineToRotate, 
-            CvPoint2D32f const &Origin,
-            double const &dRadians);
+            /*
+               See pp.934-938 of Cormen et al, 2003, for the verbose
+               explanation of how this works. In short, it works by checking
+               for the straddling of line segments...
+            */
+
+            // Intersects when each straddles the other, or when an endpoint is
+            //  collinear with and lies upon the other segment. Otherwise the
+            //  necessary and sufficient condition has not been satisfied...
+            return (((nDirection1 > 0 && nDirection2 < 0) ||
+                     (nDirection1 < 0 && nDirection2 > 0)) &&
+                    ((nDirection3 > 0 && nDirection4 < 0) ||
+                     (nDirection3 < 0 && nDirection4 > 0))) ||
+                   ((nDirection1 == 0) && IsCollinearPointOnLineSegment(B, A.first)) ||
+                   ((nDirection2 == 0) && IsCollinearPointOnLineSegment(B, A.second)) ||
+                   ((nDirection3 == 0) && IsCollinearPointOnLineSegment(A, B.first)) ||
+                   ((nDirection4 == 0) && IsCollinearPointOnLineSegment(A, B.second));
+        }
 
         // Rotate a point around another to be used as the origin...
-        CvPoint2D32f &RotatePointAboutAnother(
+        inline CvPoint2D32f &RotatePointAboutAnother(
             CvPoint2D32f const &OldPointToRotate,
             CvPoint2D32f const &Origin,
             double const &dRadians,
-            CvPoint2D32f &NewPoint);
-};
+            CvPoint2D32f &NewPoint)
+        {
+            /* This is the decomposed form of the combined linear transformation
+               that translates back to origin, rotates about the origin, then
+               translates back again to the starting point, built from this
+               transformation...
+
+                | 1  0  r_x |     | cos(θ)  -sin(θ)   0 |     | 1  0 -r_x |   | x |
+                | 0  1  r_y |  *  | sin(θ)   cos(θ)   0 |  *  | 0  1 -r_y | * | y |
+                | 0  0  1   |     |    0        0     1 |     | 0  0   1  |   | 1 |
+
+                    (3)                    (2)                    (1)
+
+                (1) First translate coordinate system back to real origin.
+                (2) Rotate about the real origin.
+                (3) Restore coordinate system back.
+
+                Note: Transforms are applied in reverse order, like a stack.
+            */
+
+                // Variables...
+                double const    dCosine = std::cos(dRadians);
+                double const    dSine   = std::sin(dRadians);
+                CvPoint2D32f    TempPoint;
+
+                // Calculate new x-coordinate...
+                TempPoint.x = ((dCosine * OldPointToRotate.x) -
+                               (dSine * OldPointToRotate.y) +
+                               (Origin.x * (1 - dCosine)) +
+                               (Origin.y * dSine));
+
+                // Calculate new y-coordinate...
+                TempPoint.y = ((dSine * OldPointToRotate.x) +
+                               (dCosine * OldPointToRotate.y) +
+                               (Origin.y * (1 - dCosine)) -
+                               (Origin.x * dSine));
+
+            // Done...
+            NewPoint = TempPoint;
+            return NewPoint;
+        }
+
+        // Adjust the distance of the second vertex by the given distance along
+        //  the radial...
+        inline void AdjustDirectedLineSegmentLength(
+            LineSegment &A, double const dLength)
+        {
+            // Create vector from directed line segment...
+            CvPoint2D32f Vector = cvPoint2D32f(A.second.x - A.first.x,
+                                               A.second.y - A.first.y);
+
+            // Compute angle of vector in degrees, then convert to radians...
+            double const dThetaRadians = cvFastArctan(Vector.y, Vector.x) *
+                                            (Pi / 180.0);
+
+            // Adjust vector length to given...
+            Vector.x = (dLength * std::cos(dThetaRadians));
+            Vector.y = (dLength * std::sin(dThetaRadians));
+
+            // Translate back again...
+            A.second.x = A.first.x + Vector.x;
+            A.second.y = A.first.y + Vector.y;
+        }
+
+        // Clip line against the image rectangle...
+        inline void ClipLineSegment(CvSize const Size, LineSegment &A)
+        {
+            // Make a duplicate of the segment since Intel's clipping routine
+            //  handles integral values only...
+            CvPoint Start   = cvPointFrom32f(A.first);
+            CvPoint End     = cvPointFrom32f(A.second);
+
+            // Clip...
+            cvClipLine(Size, &Start, &End);
+
+            // To preserve double precision, use the original unclipped points
+            //  where they are still in a valid portion of the plane...
+
+                // Start was clipped, use the clipped value...
+                if((A.first.x < 0.0f || A.first.x > Size.width) ||
+                   (A.first.y < 0.0f || A.first.y > Size.height))
+                    A.first = cvPointTo32f(Start);
+
+                // End was clipped, use the clipped value...
+                if((A.second.x < 0.0f || A.second.x > Size.width) ||
+                   (A.second.y < 0.0f || A.second.y > Size.height))
+                    A.second = cvPointTo32f(End);
+        }
+
+        // Generate orthogonal of unit length from middle of given line segment
+        //  outwards... θ(1)
+        inline void GenerateOrthogonalToLineSegment(
+            LineSegment const &A,
+            LineSegment &Orthogonal)
+        {
+            // Start with the given line...
+            Orthogonal = A;
+
+            /* Shift the line segment's start to half way...
+            Orthogonal.first.x = ((A.second.x - A.first.x) / 2.0f) + A.first.x;
+            Orthogonal.first.y = ((A.second.y - A.first.y) / 2.0f) + A.first.y;*/
+
+            // Pivot the second point 90 degrees about the first...
+            RotatePointAboutAnother(Orthogonal.second, Orthogonal.first,
+                                    Pi / 2.0, Orthogonal.second);
+        }
+
+        // Rotate a line segment about a point counterclockwise by an angle...
+        inline void RotateLineSegmentAboutPoint(
+            LineSegment &LineToRotate,
+            CvPoint2D32f const &Origin,
+            double const &dRadians)
+        {
+            // Variables...
+            CvPoint2D32f NewPoint = cvPoint2D32f(0.0f, 0.0f);
+
+            // Apply rotation about the specified origin for the first
+            //  coordinate...
+            LineToRotate.first  = RotatePointAboutAnother(
+                LineToRotate.first, Origin, dRadians, NewPoint);
+
+            // Apply rotation about the specified origin for the second
+            //  coordinate...
+            LineToRotate.second = RotatePointAboutAnother(
+                LineToRotate.second, Origin, dRadians, NewPoint);
+        }
+
+    // Compile time self tests. These run on every build at no runtime cost and
+    //  guard the traits machinery and the constexpr helpers above...
+    namespace SelfTest
+    {
+        // A literal point type, since the OpenCV ones aren't...
+        struct LiteralPoint { double x; double y; };
+    }
+
+        // Teach the geometry templates about it...
+        template <> struct PointTraits<SelfTest::LiteralPoint>
+        {
+            // Coordinate type...
+            typedef double CoordinateType;
+
+            // Coordinate accessors...
+            static constexpr double X(SelfTest::LiteralPoint const &Point) { return Point.x; }
+            static constexpr double Y(SelfTest::LiteralPoint const &Point) { return Point.y; }
+        };
+
+    namespace SelfTest
+    {
+        // Segments used below...
+        constexpr std::pair<LiteralPoint, LiteralPoint> Horizontal(
+            LiteralPoint{0.0, 0.0}, LiteralPoint{4.0, 0.0});
+        constexpr std::pair<LiteralPoint, LiteralPoint> Vertical(
+            LiteralPoint{2.0, -2.0}, LiteralPoint{2.0, 2.0});
+        constexpr std::pair<LiteralPoint, LiteralPoint> Distant(
+            LiteralPoint{10.0, 10.0}, LiteralPoint{12.0, 10.0});
+
+        // 3-4-5 right triangle...
+        static_assert(SquaredDistanceBetweenTwoPoints(
+                        LiteralPoint{1.0, 1.0}, LiteralPoint{4.0, 5.0}) == 25.0,
+                      "squared distance between two points is broken");
+        static_assert(SquaredLengthOfLineSegment(Horizontal) == 16.0,
+                      "squared line segment length is broken");
+
+        // Orientation...
+        static_assert(Direction(LiteralPoint{0.0, 0.0}, LiteralPoint{1.0, 0.0},
+                                LiteralPoint{0.0, 1.0}) > 0,
+                      "direction should be clockwise");
+        static_assert(Direction(LiteralPoint{0.0, 0.0}, LiteralPoint{0.0, 1.0},
+                                LiteralPoint{1.0, 0.0}) < 0,
+                      "direction should be counterclockwise");
+        static_assert(Direction(LiteralPoint{0.0, 0.0}, LiteralPoint{1.0, 1.0},
+                                LiteralPoint{2.0, 2.0}) == 0,
+                      "direction should be collinear");
+
+        // Intersection...
+        static_assert(IsLineSegmentsIntersect(Horizontal, Vertical),
+                      "crossing segments should intersect");
+        static_assert(!IsLineSegmentsIntersect(Horizontal, Distant),
+                      "distant segments should not intersect");
+        static_assert(IsCollinearPointOnLineSegment(Horizontal, LiteralPoint{4.0, 0.0}),
+                      "segment end point should lie on the segment");
+    }
+}
 
 #endif
 
@@ -0,0 +1,141 @@
+/*
+  Name:         ThinkingDisplayList.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  What the tracker was thinking on a given frame, recorded as a
+                handful of vector primitives over the original gray frame rather
+                than drawn. Only whoever actually wants to look at it pays for
+                rasterizing it...
+*/
+
+// Includes...
+#include "ThinkingDisplayList.h"
+#include <opencv2/core/types_c.h>
+
+// Default constructor...
+ThinkingDisplayList::ThinkingDisplayList()
+    : unContours(0),
+      unLabels(0),
+      unLegendLength(0)
+{
+
+}
+
+// Record a contour outline...
+void ThinkingDisplayList::AddContour(CvContour const &Contour)
+{
+    // Need another outline's worth of storage...
+    if(unContours == Contours.size())
+        Contours.push_back(std::vector<cv::Point>());
+
+    // Get the next outline, keeping whatever capacity it already has...
+    std::vector<cv::Point> &Outline = Contours[unContours++];
+    Outline.resize(Contour.total);
+
+    // Copy the vertices out. The worm's own contour is rewritten on its next
+    //  refresh, so we can't just point at it...
+    cvCvtSeqToArray((CvSeq const *) &Contour, Outline.data(), CV_WHOLE_SEQ);
+}
+
+// Record a text label pointing at a point...
+void ThinkingDisplayList::AddLabel(char const *pszText, CvPoint Anchor)
+{
+    // Need another label's worth of storage...
+    if(unLabels == Labels.size())
+        Labels.push_back(Label());
+
+    // Fill it in, reusing the string's existing buffer...
+    Label &NewLabel = Labels[unLabels++];
+    NewLabel.sText.assign(pszText);
+    NewLabel.Anchor = cv::Point(Anchor.x, Anchor.y);
+}
+
+// Start a new frame over the given gray image...
+void ThinkingDisplayList::Begin(cv::Mat const &_GrayImage)
+{
+    // Reference the frame...
+    GrayImage = _GrayImage;
+
+    // Forget the old primitives without releasing their storage...
+    unContours      = 0;
+    unLabels        = 0;
+    unLegendLength  = 0;
+}
+
+// Forget everything, releasing storage too...
+void ThinkingDisplayList::Clear()
+{
+    // Release...
+    GrayImage.release();
+    Contours.clear();
+    Labels.clear();
+
+    // Reset counts...
+    unContours      = 0;
+    unLabels        = 0;
+    unLegendLength  = 0;
+}
+
+// Is there anything to show yet?
+bool ThinkingDisplayList::IsEmpty() const
+{
+    // No frame means nothing to draw over...
+    return GrayImage.empty();
+}
+
+// Draw everything onto a colour copy of the gray frame...
+void ThinkingDisplayList::Rasterize(cv::Mat &Output) const
+{
+    // Nothing to draw...
+    if(IsEmpty())
+    {
+        // Hand back nothing...
+        Output.release();
+        return;
+    }
+
+    // Copy in the original grayscale image as colour now...
+    Output.create(GrayImage.size(), CV_8UC3);
+    cv::cvtColor(GrayImage, Output, cv::COLOR_GRAY2BGR);
+
+    // Draw each contour in use, as closed outlines...
+    for(unsigned int unIndex = 0; unIndex < unContours; ++unIndex)
+        cv::polylines(Output, Contours[unIndex], true,
+                      cv::Scalar(0xfe, 0x00, 0x00), 1, cv::LINE_8);
+
+    // Draw each label...
+    for(unsigned int unIndex = 0; unIndex < unLabels; ++unIndex)
+    {
+        // Get the label...
+        Label const &CurrentLabel = Labels[unIndex];
+
+        // Draw label line...
+        cv::line(Output, CurrentLabel.Anchor + cv::Point(20, 20),
+                 CurrentLabel.Anchor, CV_RGB(0xfe, 0x00, 0x00));
+
+        // Draw text...
+        cv::putText(Output, CurrentLabel.sText,
+                    CurrentLabel.Anchor + cv::Point(25, 25),
+                    cv::FONT_HERSHEY_PLAIN, 0.7, CV_RGB(0xfe, 0x00, 0x00));
+    }
+
+    // Show one millimeter legend...
+
+        // Draw the legend line...
+        cv::line(Output,
+                 cv::Point(50, Output.rows - 5),
+                 cv::Point(50 + unLegendLength, Output.rows - 5),
+                 CV_RGB(0x00, 0x00, 0xff), 2);
+
+        // Draw label...
+        cv::putText(Output, "1 mm",
+                    cv::Point(50 + unLegendLength + 5, Output.rows - 3),
+                    cv::FONT_HERSHEY_PLAIN, 0.7, CV_RGB(0x00, 0x00, 0xff));
+}
+
+// Record the one millimeter legend length in pixels...
+void ThinkingDisplayList::SetLegend(unsigned int const unLength)
+{
+    // Store...
+    unLegendLength = unLength;
+}
+
@@ -0,0 +1,95 @@
+/*
+  Name:         ThinkingDisplayList.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  What the tracker was thinking on a given frame, recorded as a
+                handful of vector primitives over the original gray frame rather
+                than drawn. Only whoever actually wants to look at it pays for
+                rasterizing it...
+*/
+
+// Multiple include protection...
+#ifndef _THINKINGDISPLAYLIST_H_
+#define _THINKINGDISPLAYLIST_H_
+
+// Includes...
+
+    // OpenCV...
+    #include <opencv2/opencv.hpp>
+    #include <opencv2/imgproc/imgproc_c.h>
+
+    // Standard libraries and STL...
+    #include <string>
+    #include <vector>
+
+// ThinkingDisplayList class...
+class ThinkingDisplayList
+{
+    // Public methods...
+    public:
+
+        // Default constructor...
+        ThinkingDisplayList();
+
+        // Accessors...
+
+            // Is there anything to show yet?
+            bool                IsEmpty() const;
+
+            // Draw everything onto a colour copy of the gray frame. Output's
+            //  buffer is reused if it is already the right size... O(n)
+            void                Rasterize(cv::Mat &Output) const;
+
+        // Mutators...
+
+            // Start a new frame over the given gray image. Only a reference
+            //  to it is kept. Previously recorded primitives are forgotten,
+            //  but their storage is kept for reuse... θ(1)
+            void                Begin(cv::Mat const &GrayImage);
+
+            // Record a contour outline...
+            void                AddContour(CvContour const &Contour);
+
+            // Record a text label pointing at a point...
+            void                AddLabel(char const *pszText, CvPoint Anchor);
+
+            // Record the one millimeter legend length in pixels...
+            void                SetLegend(unsigned int const unLength);
+
+            // Forget everything, releasing storage too...
+            void                Clear();
+
+    // Protected types...
+    protected:
+
+        // A text label and where it points...
+        typedef struct Label
+        {
+            // Text...
+            std::string     sText;
+
+            // Point the label's line leads to...
+            cv::Point       Anchor;
+
+        }Label;
+
+    // Protected attributes...
+    protected:
+
+        // The frame everything is drawn over...
+        cv::Mat                             GrayImage;
+
+        // Contour outlines. Only the first unContours are in use, the rest are
+        //  spare capacity from busier frames...
+        std::vector<std::vector<cv::Point> > Contours;
+        unsigned int                        unContours;
+
+        // Labels, with the same spare capacity arrangement...
+        std::vector<Label>                  Labels;
+        unsigned int                        unLabels;
+
+        // One millimeter legend length in pixels...
+        unsigned int                        unLegendLength;
+};
+
+#endif
+
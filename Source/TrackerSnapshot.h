@@ -0,0 +1,112 @@
+/*
+  Name:         TrackerSnapshot.h (definition and implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Immutable summary of the tracker's state after a frame. The
+                tracker publishes a new one after every frame and readers hold
+                onto whichever one they got for as long as they like, so they
+                never wait on the analysis thread or see it half way through
+                updating something...
+*/
+
+// Multiple include protection...
+#ifndef _TRACKERSNAPSHOT_H_
+#define _TRACKERSNAPSHOT_H_
+
+// Includes...
+
+    // OpenCV types...
+    #include <opencv2/opencv.hpp>
+    #include <opencv2/core/types_c.h>
+
+    // Standard libraries and STL...
+    #include <limits>
+    #include <vector>
+
+// TrackerSnapshot structure...
+typedef struct TrackerSnapshot
+{
+    // Default constructor...
+    TrackerSnapshot()
+        : unCurrentFrame(0),
+          unTotalFrames(0),
+          dMillimetersPerPixel(0.0),
+          unStimuli(0)
+    {
+    }
+
+    // Summary of a single worm, in pixels...
+    typedef struct WormSummary
+    {
+        // Best guess of the worm's centre...
+        CvPoint         Centre;
+
+        // Best guess of the head and tail positions...
+        CvPoint         Head;
+        CvPoint         Tail;
+
+        // Best guess of the length, width, and area...
+        double          dLength;
+        double          dWidth;
+        double          dArea;
+
+        // Number of times worm has been refreshed...
+        unsigned int    unRefreshes;
+
+        // Reversals it has started and the total time spent reversing,
+        //  including any reversal still under way...
+        unsigned int    unReversals;
+        double          dReversalSeconds;
+
+    }WormSummary;
+
+    // Convert from pixels to millimeters... θ(1)
+    double ConvertPixelsToMillimeters(double const dPixels) const
+    {
+        // Convert units...
+        return dMillimetersPerPixel * dPixels;
+    }
+
+    // Convert from pixels² to millimeters²... θ(1)
+    double ConvertSquarePixelsToSquareMillimeters(
+        double const dPixelsSquared) const
+    {
+        // Convert units...
+        return dMillimetersPerPixel * dMillimetersPerPixel * dPixelsSquared;
+    }
+
+    // Get a worm's response to a stimulus in pixels, backwards being
+    //  negative, or NaN if not measured... θ(1)
+    float Response(unsigned int const unWorm, 
+                   unsigned int const unStimulus) const
+    {
+        // Not measured...
+        size_t const Index = unWorm * unStimuli + unStimulus;
+        if(unStimulus >= unStimuli || Index >= Responses.size())
+            return std::numeric_limits<float>::quiet_NaN();
+
+        // Lookup...
+        return Responses[Index];
+    }
+
+    // The number of worms being tracked... θ(1)
+    unsigned int Tracking() const { return Worms.size(); }
+
+    // Frames processed so far and the total expected, zero if unknown...
+    unsigned int                unCurrentFrame;
+    unsigned int                unTotalFrames;
+
+    // Scale at the time, for converting the worm metrics to SI units...
+    double                      dMillimetersPerPixel;
+
+    // Every worm being tracked, in the tracker's own order...
+    std::vector<WormSummary>    Worms;
+
+    // Stimuli in the schedule and every worm's response to each, worm after
+    //  worm. Worms found too late to have been measured may be missing...
+    unsigned int                unStimuli;
+    std::vector<float>          Responses;
+
+}TrackerSnapshot;
+
+#endif
+
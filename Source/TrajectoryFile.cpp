@@ -0,0 +1,692 @@
+/*
+  Name:         TrajectoryFile.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Versioned binary file format for a TrajectoryStore, built to be
+                memory mapped and queried in place rather than parsed...
+*/
+
+// Includes...
+#include "TrajectoryFile.h"
+#ifdef HAVE_CONFIG_H
+    #include "config.h"
+#endif
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_MMAN_H
+    #include <sys/mman.h>
+#endif
+
+// The on disk structures are read in place, so their layout must never move...
+static_assert(sizeof(TrajectoryFile::Header) == 32,
+              "trajectory file header layout changed");
+static_assert(sizeof(TrajectoryFile::BlockIndexEntry) == 32,
+              "trajectory block index layout changed");
+static_assert(sizeof(TrajectoryFile::WormIndexEntry) == 24,
+              "trajectory worm index layout changed");
+static_assert(sizeof(TrajectoryFile::Trailer) == 40,
+              "trajectory file trailer layout changed");
+
+// Magic at either end of the file...
+static char const HeaderMagic[8]    = {'S', 'L', 'I', 'T', 'R', 'A', 'J', '\0'};
+static char const TrailerMagic[8]   = {'S', 'L', 'I', 'T', 'E', 'N', 'D', '\0'};
+
+// Integral coordinate columns that are delta encoded, in on disk order...
+static unsigned int const Coordinates = 6;
+
+// Fixed width block header preceding each block's packed data...
+typedef struct BlockHeader
+{
+    // Rows in the block...
+    uint32_t    unRows;
+
+    // Bytes of varint data, before padding to the float columns...
+    uint32_t    unVarintBytes;
+
+}BlockHeader;
+
+// Whether this machine stores integers the way the file does...
+static bool IsLittleEndian()
+{
+    // Check the first byte of a known value...
+    uint32_t const unProbe = 1;
+    return *reinterpret_cast<uint8_t const *>(&unProbe) == 1;
+}
+
+// Pack an unsigned value as a little endian base 128 varint... θ(1)
+static void PutVarint(std::vector<uint8_t> &Output, uint32_t unValue)
+{
+    // Seven bits at a time, high bit set on all but the last...
+    while(unValue >= 0x80)
+    {
+        Output.push_back(static_cast<uint8_t>(unValue | 0x80));
+        unValue >>= 7;
+    }
+    Output.push_back(static_cast<uint8_t>(unValue));
+}
+
+// Unpack a varint, advancing the cursor. False if it runs off the end... θ(1)
+static bool GetVarint(
+    uint8_t const *&pCursor, uint8_t const *pEnd, uint32_t &unValue)
+{
+    // Seven bits at a time, for at most five bytes...
+    unValue = 0;
+    for(unsigned int unShift = 0; unShift < 35; unShift += 7)
+    {
+        // Ran out...
+        if(pCursor == pEnd)
+            return false;
+
+        // Accumulate, stopping on the last byte...
+        uint8_t const Byte = *pCursor++;
+        unValue |= static_cast<uint32_t>(Byte & 0x7f) << unShift;
+        if(!(Byte & 0x80))
+            return true;
+    }
+
+    // Too long to be ours...
+    return false;
+}
+
+// Zig-zag map a signed delta so small magnitudes of either sign stay small...
+static uint32_t ZigZag(int32_t const nValue)
+{
+    return (static_cast<uint32_t>(nValue) << 1) ^
+            static_cast<uint32_t>(nValue >> 31);
+}
+
+// ...and back...
+static int32_t UnZigZag(uint32_t const unValue)
+{
+    return static_cast<int32_t>(unValue >> 1) ^
+          -static_cast<int32_t>(unValue & 1);
+}
+
+// Round up to the next multiple of four, for the float columns...
+static size_t AlignToFour(size_t const Value)
+{
+    return (Value + 3) & ~static_cast<size_t>(3);
+}
+
+// Default constructor...
+TrajectoryFile::TrajectoryFile()
+    : pData(NULL),
+      Size(0),
+      bMapped(false),
+      pHeader(NULL),
+      pBlockIndex(NULL),
+      pWormIndex(NULL),
+      pTrailer(NULL)
+{
+
+}
+
+// Number of blocks...
+uint32_t TrajectoryFile::Blocks() const
+{
+    return pTrailer ? pTrailer->unBlocks : 0;
+}
+
+// Close the file, if any...
+void TrajectoryFile::Close()
+{
+    // Unmap...
+#ifdef HAVE_SYS_MMAN_H
+    if(bMapped)
+        munmap(const_cast<uint8_t *>(pData), Size);
+#endif
+
+    // Or just release the buffer...
+    Buffer.clear();
+    Buffer.shrink_to_fit();
+
+    // Forget everything...
+    pData       = NULL;
+    Size        = 0;
+    bMapped     = false;
+    pHeader     = NULL;
+    pBlockIndex = NULL;
+    pWormIndex  = NULL;
+    pTrailer    = NULL;
+}
+
+// Decode a block, appending the rows matching the frame range and worm...
+bool TrajectoryFile::DecodeBlock(
+    uint32_t const unBlock,
+    uint32_t const unFirstFrame,
+    uint32_t const unLastFrame,
+    uint32_t const unWorm,
+    TrajectoryStore::Chunk &Output) const
+{
+    // Variables...
+    BlockHeader     Block;
+    uint32_t        unFrame         = 0;
+    uint32_t        unCurrentWorm   = 0;
+    uint32_t        unValue         = 0;
+
+    // Find the block and make sure its header is inside the file, without
+    //  a corrupt offset wrapping around...
+    BlockIndexEntry const &Entry = GetBlockIndex(unBlock);
+    if(pTrailer->ulBlockIndexOffset < sizeof(Block) ||
+       Entry.ulOffset > pTrailer->ulBlockIndexOffset - sizeof(Block))
+        return false;
+    memcpy(&Block, pData + Entry.ulOffset, sizeof(Block));
+
+    // Locate the varint data and the float columns after it...
+    uint8_t const  *pCursor     = pData + Entry.ulOffset + sizeof(Block);
+    uint8_t const  *pVarintEnd  = pCursor + Block.unVarintBytes;
+    size_t const    FloatOffset =
+        AlignToFour(Entry.ulOffset + sizeof(Block) + Block.unVarintBytes);
+    if(Block.unRows != Entry.unRows ||
+       FloatOffset + 3 * sizeof(float) * Block.unRows >
+        pTrailer->ulBlockIndexOffset)
+        return false;
+    float const    *pLength     =
+        reinterpret_cast<float const *>(pData + FloatOffset);
+    float const    *pWidth      = pLength + Block.unRows;
+    float const    *pArea       = pWidth  + Block.unRows;
+
+    // Its range of worms has to be in order, and within the ids the worm
+    //  index knows, which is sorted by id, or a corrupt file could have us
+    //  decode past the end of where they're kept...
+    if(pTrailer->unWorms == 0 ||
+       Entry.unMinimumWorm > Entry.unMaximumWorm ||
+       Entry.unMaximumWorm > pWormIndex[pTrailer->unWorms - 1].unWorm)
+        return false;
+
+    // Each worm's last coordinates in this block, which deltas are against...
+    std::vector<int32_t> Previous(
+        (size_t(Entry.unMaximumWorm) - Entry.unMinimumWorm + 1) * Coordinates,
+        0);
+
+    // Decode each row...
+    for(uint32_t unRow = 0; unRow < Block.unRows; ++unRow)
+    {
+        // Frame delta from the previous row...
+        if(!GetVarint(pCursor, pVarintEnd, unValue))
+            return false;
+        unFrame += unValue;
+
+        // Worm delta from the previous row...
+        if(!GetVarint(pCursor, pVarintEnd, unValue))
+            return false;
+        unCurrentWorm += UnZigZag(unValue);
+        if(unCurrentWorm < Entry.unMinimumWorm ||
+           unCurrentWorm > Entry.unMaximumWorm)
+            return false;
+
+        // Coordinates, each a delta from this worm's previous row...
+        int32_t *pPrevious = &Previous[
+            size_t(unCurrentWorm - Entry.unMinimumWorm) * Coordinates];
+        for(unsigned int unCoordinate = 0; unCoordinate < Coordinates;
+            ++unCoordinate)
+        {
+            if(!GetVarint(pCursor, pVarintEnd, unValue))
+                return false;
+            pPrevious[unCoordinate] += UnZigZag(unValue);
+        }
+
+        // Not wanted, keep decoding though since deltas depend on it...
+        if(unFrame < unFirstFrame || unFrame > unLastFrame ||
+           (unWorm != AnyWorm && unCurrentWorm != unWorm))
+            continue;
+
+        // Append the row...
+        Output.Frame.push_back(unFrame);
+        Output.Worm.push_back(unCurrentWorm);
+        Output.CentreX.push_back(pPrevious[0]);
+        Output.CentreY.push_back(pPrevious[1]);
+        Output.HeadX.push_back(pPrevious[2]);
+        Output.HeadY.push_back(pPrevious[3]);
+        Output.TailX.push_back(pPrevious[4]);
+        Output.TailY.push_back(pPrevious[5]);
+        Output.Length.push_back(pLength[unRow]);
+        Output.Width.push_back(pWidth[unRow]);
+        Output.Area.push_back(pArea[unRow]);
+    }
+
+    // Every byte should have been used...
+    return pCursor == pVarintEnd;
+}
+
+// Get the index entry for a worm...
+TrajectoryFile::WormIndexEntry const *TrajectoryFile::FindWorm(
+    uint32_t const unWorm) const
+{
+    // Nothing open...
+    if(!pTrailer)
+        return NULL;
+
+    // Binary search, the index is sorted by worm id...
+    WormIndexEntry const *pEnd = pWormIndex + pTrailer->unWorms;
+    WormIndexEntry const *pEntry = std::lower_bound(pWormIndex, pEnd, unWorm,
+        [](WormIndexEntry const &Entry, uint32_t const unKey)
+        {
+            return Entry.unWorm < unKey;
+        });
+
+    // Found?
+    return (pEntry != pEnd && pEntry->unWorm == unWorm) ? pEntry : NULL;
+}
+
+// Get the index entry for a block...
+TrajectoryFile::BlockIndexEntry const &TrajectoryFile::GetBlockIndex(
+    uint32_t const unBlock) const
+{
+    return pBlockIndex[unBlock];
+}
+
+// Scale at the time of analysis...
+double TrajectoryFile::GetMillimetersPerPixel() const
+{
+    return pHeader ? pHeader->dMillimetersPerPixel : 0.0;
+}
+
+// Is a file open?
+bool TrajectoryFile::IsOpen() const
+{
+    return pTrailer != NULL;
+}
+
+// Open a file for reading...
+bool TrajectoryFile::Open(std::string const &sPath)
+{
+    // Variables...
+    struct stat     Status;
+
+    // Close whatever was open before...
+    Close();
+
+    // The file is read in place, so it must match our byte order...
+    if(!IsLittleEndian())
+        return false;
+
+    // Open it and find out how big it is...
+    int const nDescriptor = open(sPath.c_str(), O_RDONLY);
+    if(nDescriptor < 0)
+        return false;
+    if(fstat(nDescriptor, &Status) != 0 ||
+       static_cast<size_t>(Status.st_size) < sizeof(Header) + sizeof(Trailer))
+    {
+        close(nDescriptor);
+        return false;
+    }
+    Size = Status.st_size;
+
+    // Map it in...
+#ifdef HAVE_SYS_MMAN_H
+    void *pMapping = mmap(NULL, Size, PROT_READ, MAP_SHARED, nDescriptor, 0);
+    if(pMapping != MAP_FAILED)
+    {
+        pData   = static_cast<uint8_t const *>(pMapping);
+        bMapped = true;
+    }
+#endif
+
+    // Can't map it, read the whole thing instead...
+    if(!bMapped)
+    {
+        // Read it all...
+        Buffer.resize(Size);
+        size_t Done = 0;
+        while(Done < Size)
+        {
+            ssize_t const Count = read(nDescriptor, &Buffer[Done], Size - Done);
+            if(Count <= 0)
+                break;
+            Done += Count;
+        }
+
+        // Short read...
+        if(Done != Size)
+        {
+            close(nDescriptor);
+            Close();
+            return false;
+        }
+        pData = Buffer.data();
+    }
+
+    // The mapping keeps its own reference, so we are done with this...
+    close(nDescriptor);
+
+    // Check the header...
+    pHeader = reinterpret_cast<Header const *>(pData);
+    if(memcmp(pHeader->Magic, HeaderMagic, sizeof(HeaderMagic)) != 0 ||
+       pHeader->unVersion != Version ||
+       pHeader->unHeaderSize != sizeof(Header))
+    {
+        Close();
+        return false;
+    }
+
+    // Check the trailer and that both indices fall between the two...
+    pTrailer = reinterpret_cast<Trailer const *>(
+        pData + Size - sizeof(Trailer));
+    uint64_t const ulIndexEnd = Size - sizeof(Trailer);
+    if(memcmp(pTrailer->Magic, TrailerMagic, sizeof(TrailerMagic)) != 0 ||
+       pTrailer->ulBlockIndexOffset < sizeof(Header) ||
+       pTrailer->ulBlockIndexOffset > ulIndexEnd ||
+       pTrailer->ulWormIndexOffset > ulIndexEnd ||
+       pTrailer->ulBlockIndexOffset % 8 != 0 ||
+       pTrailer->ulBlockIndexOffset +
+        pTrailer->unBlocks * sizeof(BlockIndexEntry) !=
+            pTrailer->ulWormIndexOffset ||
+       pTrailer->ulWormIndexOffset +
+        pTrailer->unWorms * sizeof(WormIndexEntry) != ulIndexEnd)
+    {
+        Close();
+        return false;
+    }
+
+    // Point at the indices...
+    pBlockIndex = reinterpret_cast<BlockIndexEntry const *>(
+        pData + pTrailer->ulBlockIndexOffset);
+    pWormIndex  = reinterpret_cast<WormIndexEntry const *>(
+        pData + pTrailer->ulWormIndexOffset);
+
+    // Each worm's range of blocks has to be in order and among them, since
+    //  queries index the blocks with it directly...
+    for(uint32_t unEntry = 0; unEntry < pTrailer->unWorms; ++unEntry)
+    {
+        if(pWormIndex[unEntry].unFirstBlock > pWormIndex[unEntry].unLastBlock ||
+           pWormIndex[unEntry].unLastBlock >= pTrailer->unBlocks)
+        {
+            Close();
+            return false;
+        }
+    }
+
+    // Ready...
+    return true;
+}
+
+// Append every row in the frame range for the worm, or every worm...
+bool TrajectoryFile::Query(
+    uint32_t const unFirstFrame,
+    uint32_t const unLastFrame,
+    uint32_t const unWorm,
+    TrajectoryStore::Chunk &Output) const
+{
+    // Variables...
+    uint32_t    unBeginBlock    = 0;
+    uint32_t    unEndBlock      = Blocks();
+
+    // Nothing open...
+    if(!IsOpen())
+        return false;
+
+    // A single worm only ever appears in its own range of blocks...
+    if(unWorm != AnyWorm)
+    {
+        // Find it...
+        WormIndexEntry const *pEntry = FindWorm(unWorm);
+        if(!pEntry)
+            return true;
+
+        // Narrow...
+        unBeginBlock    = pEntry->unFirstBlock;
+        unEndBlock      = pEntry->unLastBlock + 1;
+    }
+
+    // Blocks are in frame order, so skip straight to the first that could end
+    //  at or after the first frame wanted...
+    BlockIndexEntry const *pBegin = std::lower_bound(
+        pBlockIndex + unBeginBlock, pBlockIndex + unEndBlock, unFirstFrame,
+        [](BlockIndexEntry const &Entry, uint32_t const unKey)
+        {
+            return Entry.unLastFrame < unKey;
+        });
+
+    // Decode blocks until they start after the last frame wanted...
+    for(uint32_t unBlock = pBegin - pBlockIndex; unBlock < unEndBlock;
+        ++unBlock)
+    {
+        // Get the block's entry...
+        BlockIndexEntry const &Entry = pBlockIndex[unBlock];
+
+        // Past the range...
+        if(Entry.unFirstFrame > unLastFrame)
+            break;
+
+        // Can't contain the worm...
+        if(unWorm != AnyWorm &&
+           (unWorm < Entry.unMinimumWorm || unWorm > Entry.unMaximumWorm))
+            continue;
+
+        // Decode it...
+        if(!DecodeBlock(unBlock, unFirstFrame, unLastFrame, unWorm, Output))
+            return false;
+    }
+
+    // Done...
+    return true;
+}
+
+// Decode a whole block...
+bool TrajectoryFile::ReadBlock(
+    uint32_t const unBlock, TrajectoryStore::Chunk &Output) const
+{
+    // Nothing open or out of range...
+    if(!IsOpen() || unBlock >= Blocks())
+        return false;
+
+    // Decode every row...
+    return DecodeBlock(unBlock, 0, UINT32_MAX, AnyWorm, Output);
+}
+
+// Total rows...
+uint64_t TrajectoryFile::Rows() const
+{
+    return pTrailer ? pTrailer->ulRows : 0;
+}
+
+// Number of worms in the worm index...
+uint32_t TrajectoryFile::Worms() const
+{
+    return pTrailer ? pTrailer->unWorms : 0;
+}
+
+// Write a trajectory store out in this format...
+bool TrajectoryFile::Write(
+    std::string const &sPath,
+    TrajectoryStore const &Store,
+    double const dMillimetersPerPixel)
+{
+    // Variables...
+    Header                          FileHeader;
+    Trailer                         FileTrailer;
+    TrajectoryStore::Chunk          CurrentChunk;
+    std::vector<BlockIndexEntry>    BlockIndex;
+    std::vector<WormIndexEntry>     WormIndex;
+    std::vector<uint8_t>            Packed;
+    std::vector<int32_t>            Previous;
+    std::vector<float>              Floats;
+    uint64_t                        ulOffset    = 0;
+    uint64_t                        ulRows      = 0;
+    bool                            bSuccess    = true;
+
+    // Only little endian machines write the format directly...
+    if(!IsLittleEndian())
+        return false;
+
+    // Open for writing...
+    FILE *pFile = fopen(sPath.c_str(), "wb");
+    if(!pFile)
+        return false;
+
+    // Write the header...
+    memset(&FileHeader, 0, sizeof(FileHeader));
+    memcpy(FileHeader.Magic, HeaderMagic, sizeof(HeaderMagic));
+    FileHeader.unVersion            = Version;
+    FileHeader.unHeaderSize         = sizeof(FileHeader);
+    FileHeader.dMillimetersPerPixel = dMillimetersPerPixel;
+    bSuccess = fwrite(&FileHeader, sizeof(FileHeader), 1, pFile) == 1;
+    ulOffset = sizeof(FileHeader);
+
+    // Each chunk becomes a block...
+    for(unsigned int unChunk = 0;
+        bSuccess && unChunk < Store.Chunks(); ++unChunk)
+    {
+        // Variables...
+        BlockIndexEntry     Entry;
+        BlockHeader         Block;
+        uint32_t            unPreviousFrame = 0;
+        uint32_t            unPreviousWorm  = 0;
+
+        // Load it...
+        if(!Store.GetChunk(unChunk, CurrentChunk) || CurrentChunk.Rows() == 0)
+        {
+            bSuccess = (CurrentChunk.Rows() == 0);
+            continue;
+        }
+
+        // Fill in its index entry...
+        memset(&Entry, 0, sizeof(Entry));
+        Entry.ulOffset      = ulOffset;
+        Entry.unRows        = CurrentChunk.Rows();
+        Entry.unFirstFrame  = CurrentChunk.Frame.front();
+        Entry.unLastFrame   = CurrentChunk.Frame.back();
+        Entry.unMinimumWorm = *std::min_element(
+            CurrentChunk.Worm.begin(), CurrentChunk.Worm.end());
+        Entry.unMaximumWorm = *std::max_element(
+            CurrentChunk.Worm.begin(), CurrentChunk.Worm.end());
+
+        // Each worm's deltas are against its own previous row in the block...
+        Previous.assign(
+            (size_t(Entry.unMaximumWorm) - Entry.unMinimumWorm + 1) *
+                Coordinates, 0);
+
+        // Pack the identification and position columns...
+        Packed.clear();
+        for(size_t Row = 0; Row < CurrentChunk.Rows(); ++Row)
+        {
+            // Frame and worm, against the previous row...
+            uint32_t const unFrame  = CurrentChunk.Frame[Row];
+            uint32_t const unWorm   = CurrentChunk.Worm[Row];
+            PutVarint(Packed, unFrame - unPreviousFrame);
+            PutVarint(Packed, ZigZag(unWorm - unPreviousWorm));
+            unPreviousFrame = unFrame;
+            unPreviousWorm  = unWorm;
+
+            // Coordinates, against the same worm's previous row. These are
+            //  whole pixels to begin with...
+            int32_t const Current[Coordinates] =
+            {
+                static_cast<int32_t>(lround(CurrentChunk.CentreX[Row])),
+                static_cast<int32_t>(lround(CurrentChunk.CentreY[Row])),
+                static_cast<int32_t>(lround(CurrentChunk.HeadX[Row])),
+                static_cast<int32_t>(lround(CurrentChunk.HeadY[Row])),
+                static_cast<int32_t>(lround(CurrentChunk.TailX[Row])),
+                static_cast<int32_t>(lround(CurrentChunk.TailY[Row]))
+            };
+            int32_t *pPrevious =
+                &Previous[size_t(unWorm - Entry.unMinimumWorm) * Coordinates];
+            for(unsigned int unCoordinate = 0; unCoordinate < Coordinates;
+                ++unCoordinate)
+            {
+                PutVarint(Packed,
+                    ZigZag(Current[unCoordinate] - pPrevious[unCoordinate]));
+                pPrevious[unCoordinate] = Current[unCoordinate];
+            }
+
+            // Update this worm's entry in the worm index, growing it as new
+            //  ids turn up...
+            if(unWorm >= WormIndex.size())
+            {
+                // Unseen entries are marked by a zero row count...
+                size_t const OldSize = WormIndex.size();
+                WormIndex.resize(unWorm + 1);
+                for(size_t Index = OldSize; Index < WormIndex.size(); ++Index)
+                {
+                    memset(&WormIndex[Index], 0, sizeof(WormIndexEntry));
+                    WormIndex[Index].unWorm = Index;
+                }
+            }
+            WormIndexEntry &Worm = WormIndex[unWorm];
+            if(Worm.unRows++ == 0)
+            {
+                Worm.unFirstFrame   = unFrame;
+                Worm.unFirstBlock   = BlockIndex.size();
+            }
+            Worm.unLastFrame    = unFrame;
+            Worm.unLastBlock    = BlockIndex.size();
+        }
+
+        // Pad the packed data so the float columns are aligned...
+        Block.unRows        = Entry.unRows;
+        Block.unVarintBytes = Packed.size();
+        Packed.resize(
+            AlignToFour(ulOffset + sizeof(Block) + Packed.size()) -
+            ulOffset - sizeof(Block), 0);
+
+        // Gather the float columns...
+        Floats.clear();
+        Floats.insert(Floats.end(),
+                      CurrentChunk.Length.begin(), CurrentChunk.Length.end());
+        Floats.insert(Floats.end(),
+                      CurrentChunk.Width.begin(), CurrentChunk.Width.end());
+        Floats.insert(Floats.end(),
+                      CurrentChunk.Area.begin(), CurrentChunk.Area.end());
+
+        // Write the block out...
+        bSuccess =
+            fwrite(&Block, sizeof(Block), 1, pFile) == 1 &&
+            fwrite(Packed.data(), 1, Packed.size(), pFile) == Packed.size() &&
+            fwrite(Floats.data(), sizeof(float), Floats.size(), pFile) ==
+                Floats.size();
+        ulOffset += sizeof(Block) + Packed.size() +
+                    Floats.size() * sizeof(float);
+
+        // Remember it...
+        BlockIndex.push_back(Entry);
+        ulRows += Entry.unRows;
+    }
+
+    // Pad so the indices are aligned...
+    while(bSuccess && ulOffset % 8 != 0)
+    {
+        bSuccess = fputc(0, pFile) != EOF;
+        ++ulOffset;
+    }
+
+    // Drop ids that never appeared, keeping it sorted by id...
+    WormIndex.erase(std::remove_if(WormIndex.begin(), WormIndex.end(),
+        [](WormIndexEntry const &Entry) { return Entry.unRows == 0; }),
+        WormIndex.end());
+
+    // Write both indices and the trailer locating them...
+    memset(&FileTrailer, 0, sizeof(FileTrailer));
+    FileTrailer.ulBlockIndexOffset  = ulOffset;
+    FileTrailer.ulWormIndexOffset   =
+        ulOffset + BlockIndex.size() * sizeof(BlockIndexEntry);
+    FileTrailer.unBlocks            = BlockIndex.size();
+    FileTrailer.unWorms             = WormIndex.size();
+    FileTrailer.ulRows              = ulRows;
+    memcpy(FileTrailer.Magic, TrailerMagic, sizeof(TrailerMagic));
+    bSuccess = bSuccess &&
+        fwrite(BlockIndex.data(), sizeof(BlockIndexEntry), BlockIndex.size(),
+               pFile) == BlockIndex.size() &&
+        fwrite(WormIndex.data(), sizeof(WormIndexEntry), WormIndex.size(),
+               pFile) == WormIndex.size() &&
+        fwrite(&FileTrailer, sizeof(FileTrailer), 1, pFile) == 1;
+
+    // Close, which flushes...
+    if(fclose(pFile) != 0)
+        bSuccess = false;
+
+    // Done...
+    return bSuccess;
+}
+
+// Deconstructor...
+TrajectoryFile::~TrajectoryFile()
+{
+    // Unmap or release...
+    Close();
+}
+
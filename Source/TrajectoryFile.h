@@ -0,0 +1,234 @@
+/*
+  Name:         TrajectoryFile.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Versioned binary file format for a TrajectoryStore, built to be
+                memory mapped and queried in place rather than parsed. The
+                layout is...
+
+                    Header
+                    Block 0
+                    ...
+                    Block n - 1
+                    Block index     (one fixed width entry per block)
+                    Worm index      (one fixed width entry per worm id)
+                    Trailer         (locates both indices)
+
+                Each block holds one chunk of rows in frame order. Frame, worm
+                id, and the integral pixel coordinates are delta encoded and
+                then zig-zag varint packed, with each coordinate's delta taken
+                against that same worm's previous row in the block. Length,
+                width, and area follow as fixed width float columns. Blocks are
+                independent, so any one can be decoded on its own. Everything
+                is little endian...
+*/
+
+// Multiple include protection...
+#ifndef _TRAJECTORYFILE_H_
+#define _TRAJECTORYFILE_H_
+
+// Includes...
+
+    // The in memory form...
+    #include "TrajectoryStore.h"
+
+    // Standard libraries and STL...
+    #include <cstdint>
+    #include <string>
+    #include <vector>
+
+// TrajectoryFile class...
+class TrajectoryFile
+{
+    // Public constants...
+    public:
+
+        // Current format version...
+        static uint32_t const   Version     = 1;
+
+        // Pass as the worm to query every worm...
+        static uint32_t const   AnyWorm     = UINT32_MAX;
+
+    // Public types. These are the on disk structures, so fixed width only...
+    public:
+
+        // File header...
+        typedef struct Header
+        {
+            // "SLITRAJ" and a terminator...
+            char            Magic[8];
+
+            // Format version and size of this header...
+            uint32_t        unVersion;
+            uint32_t        unHeaderSize;
+
+            // Scale at the time of analysis...
+            double          dMillimetersPerPixel;
+
+            // Reserved, always zero...
+            uint64_t        ulReserved;
+
+        }Header;
+
+        // Block index entry...
+        typedef struct BlockIndexEntry
+        {
+            // Byte offset of the block from the start of the file...
+            uint64_t        ulOffset;
+
+            // Rows in the block...
+            uint32_t        unRows;
+
+            // First and last frame in the block...
+            uint32_t        unFirstFrame;
+            uint32_t        unLastFrame;
+
+            // Lowest and highest worm id in the block...
+            uint32_t        unMinimumWorm;
+            uint32_t        unMaximumWorm;
+
+            // Reserved, always zero...
+            uint32_t        unReserved;
+
+        }BlockIndexEntry;
+
+        // Worm index entry...
+        typedef struct WormIndexEntry
+        {
+            // Worm id...
+            uint32_t        unWorm;
+
+            // First and last frame it was seen on, and how many times...
+            uint32_t        unFirstFrame;
+            uint32_t        unLastFrame;
+            uint32_t        unRows;
+
+            // First and last block it appears in...
+            uint32_t        unFirstBlock;
+            uint32_t        unLastBlock;
+
+        }WormIndexEntry;
+
+        // File trailer...
+        typedef struct Trailer
+        {
+            // Byte offsets of the two indices...
+            uint64_t        ulBlockIndexOffset;
+            uint64_t        ulWormIndexOffset;
+
+            // Entries in each index...
+            uint32_t        unBlocks;
+            uint32_t        unWorms;
+
+            // Total rows across every block...
+            uint64_t        ulRows;
+
+            // "SLITEND" and a terminator...
+            char            Magic[8];
+
+        }Trailer;
+
+    // Public methods...
+    public:
+
+        // Default constructor...
+        TrajectoryFile();
+
+        // Accessors...
+
+            // Number of blocks... θ(1)
+            uint32_t            Blocks() const;
+
+            // Get the index entry for a block... θ(1)
+            BlockIndexEntry const &GetBlockIndex(uint32_t const unBlock) const;
+
+            // Get the index entry for a worm, or null if it never appears...
+            //  O(log n)
+            WormIndexEntry const *FindWorm(uint32_t const unWorm) const;
+
+            // Scale at the time of analysis...
+            double              GetMillimetersPerPixel() const;
+
+            // Is a file open?
+            bool                IsOpen() const;
+
+            // Append every row in the frame range, inclusive, for the given
+            //  worm or AnyWorm. Only blocks that can contain a match are
+            //  decoded. Returns false if the file is corrupt... O(n) in rows
+            //  decoded
+            bool                Query(
+                                    uint32_t const unFirstFrame,
+                                    uint32_t const unLastFrame,
+                                    uint32_t const unWorm,
+                                    TrajectoryStore::Chunk &Output) const;
+
+            // Decode a whole block, appending its rows to the output. Returns
+            //  false if the block is corrupt... O(n)
+            bool                ReadBlock(
+                                    uint32_t const unBlock,
+                                    TrajectoryStore::Chunk &Output) const;
+
+            // Total rows... θ(1)
+            uint64_t            Rows() const;
+
+            // Number of worms in the worm index... θ(1)
+            uint32_t            Worms() const;
+
+        // Mutators...
+
+            // Close the file, if any...
+            void                Close();
+
+            // Open a file for reading, memory mapping it where the platform
+            //  allows and reading it in whole otherwise. Only the header and
+            //  trailer are checked, nothing else is touched until queried...
+            bool                Open(std::string const &sPath);
+
+        // Write a trajectory store out in this format. Returns false on any
+        //  error, in which case the file may be partially written...
+        static bool             Write(
+                                    std::string const &sPath,
+                                    TrajectoryStore const &Store,
+                                    double const dMillimetersPerPixel);
+
+        // Deconstructor...
+       ~TrajectoryFile();
+
+    // Protected methods...
+    protected:
+
+        // Decode a block, appending the rows that fall in the frame range and
+        //  belong to the worm, or every worm if AnyWorm...
+        bool                    DecodeBlock(
+                                    uint32_t const unBlock,
+                                    uint32_t const unFirstFrame,
+                                    uint32_t const unLastFrame,
+                                    uint32_t const unWorm,
+                                    TrajectoryStore::Chunk &Output) const;
+
+    // Protected attributes...
+    protected:
+
+        // The whole file's contents and size...
+        uint8_t const          *pData;
+        size_t                  Size;
+
+        // True if pData is a mapping, otherwise it points into the buffer...
+        bool                    bMapped;
+        std::vector<uint8_t>    Buffer;
+
+        // Pointers into the data for the header, indices, and trailer...
+        Header const           *pHeader;
+        BlockIndexEntry const  *pBlockIndex;
+        WormIndexEntry const   *pWormIndex;
+        Trailer const          *pTrailer;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        TrajectoryFile(TrajectoryFile const &);
+        TrajectoryFile &operator=(TrajectoryFile const &);
+};
+
+#endif
+
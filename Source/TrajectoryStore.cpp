@@ -0,0 +1,211 @@
+/*
+  Name:         TrajectoryStore.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Per frame history of every worm's metrics, kept as a structure
+                of arrays with one column per metric. Rows accumulate in a
+                single in memory chunk. Once it fills, it is spilled to an
+                anonymous temporary file and only its location is remembered,
+                so memory stays bounded no matter how long the recording...
+*/
+
+// Includes...
+#include "TrajectoryStore.h"
+#include <cassert>
+
+// Apply an operation to every column of a chunk, in a fixed order. Both the
+//  spill writer and reader go through this so they can never disagree...
+template <typename ChunkType, typename Operation>
+static bool ForEachColumn(ChunkType &TargetChunk, Operation Apply)
+{
+    // Each column in turn, stopping at the first failure...
+    return Apply(TargetChunk.Frame)   && Apply(TargetChunk.Worm)    &&
+           Apply(TargetChunk.CentreX) && Apply(TargetChunk.CentreY) &&
+           Apply(TargetChunk.HeadX)   && Apply(TargetChunk.HeadY)   &&
+           Apply(TargetChunk.TailX)   && Apply(TargetChunk.TailY)   &&
+           Apply(TargetChunk.Length)  && Apply(TargetChunk.Width)   &&
+           Apply(TargetChunk.Area);
+}
+
+// Resize every column, keeping capacity...
+void TrajectoryStore::Chunk::Resize(size_t const Rows)
+{
+    // Resize each...
+    ForEachColumn(*this, [Rows](auto &Column)
+    {
+        Column.resize(Rows);
+        return true;
+    });
+}
+
+// Constructor takes how many rows to keep in memory before spilling...
+TrajectoryStore::TrajectoryStore(unsigned int const _unChunkRows)
+    : unChunkRows(_unChunkRows > 0 ? _unChunkRows : 1),
+      pSpillFile(NULL),
+      SpilledRows(0),
+      bStopped(false)
+{
+    // Reserve the whole in memory chunk up front so appending never
+    //  reallocates...
+    ForEachColumn(Active, [this](auto &Column)
+    {
+        Column.reserve(unChunkRows);
+        return true;
+    });
+}
+
+// Add a row, spilling the current chunk to disk first if it is full...
+bool TrajectoryStore::Append(Sample const &NewSample)
+{
+    // Already stopped...
+    if(bStopped)
+        return false;
+
+    // No room left, make some. If there's nowhere left to keep the history,
+    //  it ends here...
+    if(Active.Rows() >= unChunkRows && !Spill())
+    {
+        // Stop...
+        Stop();
+        return false;
+    }
+
+    // Identification...
+    Active.Frame.push_back(NewSample.unFrame);
+    Active.Worm.push_back(NewSample.unWorm);
+
+    // Position...
+    Active.CentreX.push_back(NewSample.Centre.x);
+    Active.CentreY.push_back(NewSample.Centre.y);
+    Active.HeadX.push_back(NewSample.Head.x);
+    Active.HeadY.push_back(NewSample.Head.y);
+    Active.TailX.push_back(NewSample.Tail.x);
+    Active.TailY.push_back(NewSample.Tail.y);
+
+    // Body size...
+    Active.Length.push_back(NewSample.dLength);
+    Active.Width.push_back(NewSample.dWidth);
+    Active.Area.push_back(NewSample.dArea);
+
+    // Done...
+    return true;
+}
+
+// Number of chunks, counting the partially filled one in memory...
+unsigned int TrajectoryStore::Chunks() const
+{
+    // Spilled ones plus the active one, if anything is in it...
+    return Spilled.size() + (Active.Rows() > 0 ? 1 : 0);
+}
+
+// Forget everything, including anything spilled...
+void TrajectoryStore::Clear()
+{
+    // Empty the active chunk, keeping its capacity...
+    Active.Resize(0);
+
+    // Forget spilled chunks. Closing the temporary file deletes it...
+    Spilled.clear();
+    SpilledRows = 0;
+    if(pSpillFile)
+        fclose(pSpillFile);
+    pSpillFile = NULL;
+
+    // Take rows again...
+    bStopped = false;
+}
+
+// Load the requested chunk into the output, reusing its storage...
+bool TrajectoryStore::GetChunk(unsigned int const unIndex, Chunk &Output) const
+{
+    // Check bounds...
+    assert(unIndex < Chunks());
+
+    // The active one is just copied...
+    if(unIndex == Spilled.size())
+    {
+        // Copy...
+        Output = Active;
+        return true;
+    }
+
+    // Otherwise find where it was spilled and seek to it...
+    SpilledChunk const &Location = Spilled.at(unIndex);
+    if(fseek(pSpillFile, Location.lOffset, SEEK_SET) != 0)
+        return false;
+
+    // Read each column back in...
+    Output.Resize(Location.unRows);
+    return ForEachColumn(Output, [this, &Location](auto &Column)
+    {
+        return fread(Column.data(), sizeof(Column[0]), Location.unRows,
+                     pSpillFile) == Location.unRows;
+    });
+}
+
+// Whether it has stopped taking rows...
+bool TrajectoryStore::IsStopped() const
+{
+    // Check...
+    return bStopped;
+}
+
+// Total number of rows stored...
+size_t TrajectoryStore::Rows() const
+{
+    // Spilled ones plus the active one...
+    return SpilledRows + Active.Rows();
+}
+
+// Write the in memory chunk out to the spill file and empty it...
+bool TrajectoryStore::Spill()
+{
+    // Variables...
+    SpilledChunk Location;
+
+    // Create the spill file the first time. It is anonymous and deleted
+    //  automatically when closed or if we crash...
+    if(!pSpillFile && !(pSpillFile = tmpfile()))
+        return false;
+
+    // Chunks are always appended to the end...
+    if(fseek(pSpillFile, 0, SEEK_END) != 0 ||
+       (Location.lOffset = ftell(pSpillFile)) < 0)
+        return false;
+    Location.unRows = Active.Rows();
+
+    // Write each column out contiguously, flushing so a full disk shows up
+    //  now rather than when it's read back. A partly written chunk is never
+    //  remembered, so it is just dead space in the file...
+    if(!ForEachColumn(Active, [this](auto const &Column)
+    {
+        return fwrite(Column.data(), sizeof(Column[0]), Column.size(),
+                      pSpillFile) == Column.size();
+    }) || fflush(pSpillFile) != 0)
+        return false;
+
+    // Remember where it went...
+    Spilled.push_back(Location);
+    SpilledRows += Location.unRows;
+
+    // Empty the active chunk for reuse, keeping its capacity...
+    Active.Resize(0);
+
+    // Done...
+    return true;
+}
+
+// Stop taking rows, keeping what it already has...
+void TrajectoryStore::Stop()
+{
+    // Stop...
+    bStopped = true;
+}
+
+// Deconstructor...
+TrajectoryStore::~TrajectoryStore()
+{
+    // Closing the spill file deletes it...
+    if(pSpillFile)
+        fclose(pSpillFile);
+}
+
@@ -0,0 +1,171 @@
+/*
+  Name:         TrajectoryStore.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Per frame history of every worm's metrics, kept as a structure
+                of arrays with one column per metric. Rows accumulate in a
+                single in memory chunk. Once it fills, it is spilled to an
+                anonymous temporary file and only its location is remembered,
+                so memory stays bounded no matter how long the recording...
+*/
+
+// Multiple include protection...
+#ifndef _TRAJECTORYSTORE_H_
+#define _TRAJECTORYSTORE_H_
+
+// Includes...
+
+    // OpenCV types...
+    #include <opencv2/opencv.hpp>
+    #include <opencv2/core/types_c.h>
+
+    // Standard libraries and STL...
+    #include <cstdint>
+    #include <cstdio>
+    #include <vector>
+
+// TrajectoryStore class...
+class TrajectoryStore
+{
+    // Public types...
+    public:
+
+        // A single worm's metrics on a single frame, in pixels...
+        typedef struct Sample
+        {
+            // Frame index and the tracker's index for the worm...
+            unsigned int    unFrame;
+            unsigned int    unWorm;
+
+            // Centre of gravity, head, and tail...
+            CvPoint         Centre;
+            CvPoint         Head;
+            CvPoint         Tail;
+
+            // Length, width, and area as measured on this frame...
+            double          dLength;
+            double          dWidth;
+            double          dArea;
+
+        }Sample;
+
+        // A run of rows, one vector per column. Every column always has the
+        //  same number of rows...
+        typedef struct Chunk
+        {
+            // Identification columns...
+            std::vector<uint32_t>   Frame;
+            std::vector<uint32_t>   Worm;
+
+            // Position columns...
+            std::vector<float>      CentreX;
+            std::vector<float>      CentreY;
+            std::vector<float>      HeadX;
+            std::vector<float>      HeadY;
+            std::vector<float>      TailX;
+            std::vector<float>      TailY;
+
+            // Body size columns...
+            std::vector<float>      Length;
+            std::vector<float>      Width;
+            std::vector<float>      Area;
+
+            // Number of rows... θ(1)
+            size_t Rows() const { return Frame.size(); }
+
+            // Resize every column, keeping capacity... O(n)
+            void Resize(size_t const Rows);
+
+        }Chunk;
+
+    // Public methods...
+    public:
+
+        // Constructor takes how many rows to keep in memory before spilling...
+        TrajectoryStore(unsigned int const _unChunkRows = 16384);
+
+        // Accessors...
+
+            // Number of chunks, counting the partially filled one in memory,
+            //  if it has anything in it... θ(1)
+            unsigned int        Chunks() const;
+
+            // Load the requested chunk into the output, reusing its storage.
+            //  Spilled chunks are read back from disk. Returns false on a read
+            //  error... O(n)
+            bool                GetChunk(unsigned int const unIndex,
+                                         Chunk &Output) const;
+
+            // Whether it has stopped taking rows... θ(1)
+            bool                IsStopped() const;
+
+            // Total number of rows stored... θ(1)
+            size_t              Rows() const;
+
+        // Mutators...
+
+            // Add a row, spilling the current chunk to disk first if it is
+            //  already full. If it can't be spilled, it stops and returns
+            //  false, keeping what it already has... θ(1) amortized
+            bool                Append(Sample const &NewSample);
+
+            // Forget everything, including anything spilled, and start taking
+            //  rows again...
+            void                Clear();
+
+            // Stop taking rows, keeping what it already has. Any gap in the
+            //  history would be worse than it ending early...
+            void                Stop();
+
+        // Deconstructor...
+       ~TrajectoryStore();
+
+    // Protected types...
+    protected:
+
+        // Where a spilled chunk lives in the spill file...
+        typedef struct SpilledChunk
+        {
+            // Byte offset of its first column...
+            long            lOffset;
+
+            // How many rows it has...
+            unsigned int    unRows;
+
+        }SpilledChunk;
+
+    // Protected methods...
+    protected:
+
+        // Write the in memory chunk out to the spill file and empty it.
+        //  Returns false if it couldn't be written...
+        bool                Spill();
+
+    // Protected attributes...
+    protected:
+
+        // Rows per chunk...
+        unsigned int                unChunkRows;
+
+        // The chunk still being filled...
+        Chunk                       Active;
+
+        // Chunks already spilled, in order, and the file they went to...
+        std::vector<SpilledChunk>   Spilled;
+        FILE                       *pSpillFile;
+
+        // Rows across every spilled chunk...
+        size_t                      SpilledRows;
+
+        // Set once it stops taking rows...
+        bool                        bStopped;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        TrajectoryStore(TrajectoryStore const &);
+        TrajectoryStore &operator=(TrajectoryStore const &);
+};
+
+#endif
+
@@ -0,0 +1,123 @@
+/*
+  Name:         TripleBuffer.h (definition and implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Lock free single producer, single consumer triple buffer. The
+                producer always has a back slot to fill and the consumer always
+                has a front slot to read, so neither ever waits on the other.
+                Finished slots are handed over by atomically exchanging indices
+                through the middle slot, never by copying the contents...
+*/
+
+// Multiple include protection...
+#ifndef _TRIPLEBUFFER_H_
+#define _TRIPLEBUFFER_H_
+
+// Includes...
+
+    // Atomic index exchange...
+    #include <atomic>
+
+// TripleBuffer class template...
+template <typename Type>
+class TripleBuffer
+{
+    // Public methods...
+    public:
+
+        // Default constructor...
+        TripleBuffer()
+            : Middle(1),
+              unBack(0),
+              unFront(2)
+        {
+        }
+
+        // Producer side...
+
+            // Get the slot the producer is free to fill. Contents are whatever
+            //  the consumer released last, so reuse any storage already in
+            //  there... θ(1)
+            Type &Back() { return Slots[unBack]; }
+
+            // Hand the back slot to the consumer as the newest and take
+            //  whatever was waiting in the middle as the new back slot. If the
+            //  consumer never picked that one up, it is simply overwritten
+            //  next time... θ(1)
+            void Publish()
+            {
+                // Swap, marking the middle as fresh...
+                unBack = Middle.exchange(
+                    unBack | DirtyFlag, std::memory_order_acq_rel) & IndexMask;
+            }
+
+        // Consumer side...
+
+            // Swap the newest published slot into the front, if anything was
+            //  published since the last call. Returns true if the front
+            //  changed... θ(1)
+            bool Acquire()
+            {
+                // Nothing new...
+                if(!(Middle.load(std::memory_order_relaxed) & DirtyFlag))
+                    return false;
+
+                // Swap the stale front for the fresh middle...
+                unFront = Middle.exchange(
+                    unFront, std::memory_order_acq_rel) & IndexMask;
+
+                // Done...
+                return true;
+            }
+
+            // Get the slot the consumer holds. The producer will not touch it
+            //  until the consumer's next Acquire()... θ(1)
+            Type const &Front() const { return Slots[unFront]; }
+
+        // Neither side...
+
+            // Reset every slot. Only safe while neither side is active...
+            void Reset(Type const &Value = Type())
+            {
+                // Clear contents...
+                for(unsigned int unIndex = 0; unIndex < 3; ++unIndex)
+                    Slots[unIndex] = Value;
+
+                // Back to initial arrangement with nothing published...
+                Middle.store(1, std::memory_order_relaxed);
+                unBack  = 0;
+                unFront = 2;
+            }
+
+    // Protected constants...
+    protected:
+
+        // The middle index shares its word with a flag marking it as fresh...
+        static unsigned int const DirtyFlag = 0x4;
+        static unsigned int const IndexMask = 0x3;
+
+    // Protected attributes...
+    protected:
+
+        // The three slots...
+        Type                                Slots[3];
+
+        // Index of the middle slot and its fresh flag. Kept on its own cache
+        //  line so the two sides' private indices don't bounce it around...
+        alignas(64) std::atomic<unsigned int>   Middle;
+
+        // Index of the producer's slot...
+        alignas(64) unsigned int                unBack;
+
+        // Index of the consumer's slot...
+        alignas(64) unsigned int                unFront;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        TripleBuffer(TripleBuffer const &);
+        TripleBuffer &operator=(TripleBuffer const &);
+};
+
+#endif
+
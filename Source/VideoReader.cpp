@@ -0,0 +1,303 @@
+/*
+  Name:         VideoReader.cpp (implementation)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Decodes a video to 8-bit grayscale frames on its own thread...
+*/
+
+// Includes...
+#include "VideoReader.h"
+#include <algorithm>
+#include <string>
+
+// Frames the reader may hold on to beyond the ones queued. The frame being
+//  analyzed, and the ones the tracker's thinking displays still refer to...
+static unsigned int const SpareFrames = 4;
+
+// Constructor...
+VideoReader::VideoReader(unsigned int const unDepth)
+    : wxThread(wxTHREAD_JOINABLE),
+      bGrayCapture(false),
+      dFramesPerSecond(0.0),
+      unTotalFrames(0),
+      unStride(1),
+      unSkip(0),
+      pPool(NULL),
+      FrameDecoded(QueueMutex),
+      FrameRead(QueueMutex),
+      Queue(std::max(unDepth, 1U)),
+      unQueueHead(0),
+      unQueued(0),
+      bEnded(false),
+      bStopping(false),
+      bStarted(false)
+{
+
+}
+
+// Decode the next frame into a pooled buffer...
+bool VideoReader::Decode(cv::Mat &DecodedFrame)
+{
+    // Pass over the frames between this one and the last. Grabbing still has
+    //  to decode whatever later frames depend on, but nothing is converted
+    //  or copied out...
+    for(; unSkip > 0; --unSkip)
+        if(!Capture.grab())
+            return false;
+
+    // Start with a pooled buffer the shape of the last frame. If this one
+    //  turns out different, the decoder reallocates it from the pool...
+    DecodedFrame = pPool->Acquire(FrameSize.height, FrameSize.width, CV_8UC1);
+
+    // Backend gives us gray, so decode straight into it...
+    if(bGrayCapture)
+    {
+        // There are no more...
+        if(!Capture.read(DecodedFrame) || DecodedFrame.empty())
+            return false;
+    }
+
+    // Otherwise decode the colour frame and convert into it...
+    else
+    {
+        // There are no more...
+        if(!Capture.read(ColourFrame) || ColourFrame.empty())
+            return false;
+
+        // Convert...
+        cv::cvtColor(ColourFrame, DecodedFrame, cv::COLOR_BGR2GRAY);
+    }
+
+    // The Quicktime backend appears to be buggy in that it keeps cycling
+    //  through the video even after we have all frames. A temporary hack
+    //  is to just stop when we have both current frame, total frame, and they
+    //  are equal...
+    #ifdef __APPLE__
+
+        // Get current position...
+        int const nCurrentFrame = (int) Capture.get(cv::CAP_PROP_POS_FRAMES);
+
+        // Reached the end...
+        if(nCurrentFrame + 1 >= (int) unTotalFrames)
+            return false;
+
+    #endif
+
+    // Remember the shape for next time...
+    FrameSize = DecodedFrame.size();
+
+    // Skip ahead to the next wanted before decoding again...
+    unSkip = unStride - 1;
+
+    // Done...
+    return true;
+}
+
+// Thread entry point...
+wxThread::ExitCode VideoReader::Entry()
+{
+    // Keep decoding until the end or asked to stop...
+    while(true)
+    {
+        // Variables...
+        cv::Mat DecodedFrame;
+
+        // Wait for room in the queue...
+        {
+            // Lock...
+            wxMutexLocker Lock(QueueMutex);
+
+            // Wait...
+            while(unQueued == Queue.size() && !bStopping)
+                FrameRead.Wait();
+
+            // Asked to stop...
+            if(bStopping)
+                break;
+        }
+
+        // Decode, without holding up the reader...
+        if(!Decode(DecodedFrame))
+            break;
+
+        // Queue it...
+        {
+            // Lock...
+            wxMutexLocker Lock(QueueMutex);
+
+            // Add to the end of the ring...
+            Queue[(unQueueHead + unQueued) % Queue.size()] = DecodedFrame;
+          ++unQueued;
+
+            // Wake the reader...
+            FrameDecoded.Signal();
+        }
+    }
+
+    // Nothing more is coming. Wake the reader to find out...
+    {
+        // Lock...
+        wxMutexLocker Lock(QueueMutex);
+
+        // Mark and wake...
+        bEnded = true;
+        FrameDecoded.Broadcast();
+    }
+
+    // Done with the capture...
+    Capture.release();
+    ColourFrame.release();
+
+    // Done...
+    return NULL;
+}
+
+// Frame rate...
+double VideoReader::GetFramesPerSecond() const
+{
+    return dFramesPerSecond;
+}
+
+// Total number of frames...
+unsigned int VideoReader::GetTotalFrames() const
+{
+    return unTotalFrames;
+}
+
+// Open a video and start decoding ahead...
+bool VideoReader::Open(
+    wxString const &sPath, unsigned int const unFirstFrame,
+    MediaIndex const *pIndex, unsigned int const _unStride)
+{
+    // Already open...
+    if(bStarted)
+        return false;
+
+    // Every frame at least...
+    unStride    = std::max(_unStride, 1U);
+    unSkip      = 0;
+
+    // Ask for just the luma plane, or else whatever the default backend
+    //  decodes to...
+    bGrayCapture = OpenGrayscaleCapture(sPath);
+    if(!bGrayCapture && !Capture.open(std::string(sPath.fn_str())))
+        return false;
+
+    // Note what we know about it...
+    dFramesPerSecond    = Capture.get(cv::CAP_PROP_FPS);
+    unTotalFrames       = (unsigned int) Capture.get(cv::CAP_PROP_FRAME_COUNT);
+    FrameSize           = cv::Size(
+        (int) Capture.get(cv::CAP_PROP_FRAME_WIDTH),
+        (int) Capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+
+    // The index knows better than the container how long it is...
+    if(pIndex && pIndex->IsOk())
+        unTotalFrames = pIndex->Frames();
+
+    // Seek to the first frame wanted, from the keyframe before it...
+    if(unFirstFrame > 0 && pIndex && pIndex->IsOk())
+    {
+        if(!pIndex->Seek(Capture, unFirstFrame))
+            return false;
+    }
+
+    // No index, so the backend has to find the keyframe itself...
+    else if(unFirstFrame > 0 &&
+            !Capture.set(cv::CAP_PROP_POS_FRAMES, (double) unFirstFrame))
+        return false;
+
+    // Make enough buffers for a full queue and everything the reader holds...
+    pPool = new FramePool(Queue.size() + SpareFrames,
+                          FrameSize.height, FrameSize.width, CV_8UC1);
+
+    // Start decoding...
+    if(Create() != wxTHREAD_NO_ERROR || Run() != wxTHREAD_NO_ERROR)
+        return false;
+    bStarted = true;
+
+    // Done...
+    return true;
+}
+
+// Open the video so that it decodes straight to its luma plane...
+bool VideoReader::OpenGrayscaleCapture(wxString const &sPath)
+{
+    // Quote the path for the pipeline description...
+    wxString sQuotedPath = sPath;
+    sQuotedPath.Replace(wxT("\\"), wxT("\\\\"));
+    sQuotedPath.Replace(wxT("\""), wxT("\\\""));
+
+    // Let GStreamer pick the decoder and then convert to 8-bit gray. Most
+    //  codecs decode to planar YUV, so that is just a copy of the Y plane
+    //  instead of a conversion to BGR and back. Fails if OpenCV was built
+    //  without GStreamer...
+    wxString const sPipeline =
+        wxT("filesrc location=\"") + sQuotedPath + wxT("\" ! decodebin ! ")
+        wxT("videoconvert ! video/x-raw,format=GRAY8 ! appsink sync=false");
+
+    // Open...
+    return Capture.open(std::string(sPipeline.fn_str()), cv::CAP_GSTREAMER);
+}
+
+// Get the next frame...
+bool VideoReader::Read(cv::Mat &NextFrame)
+{
+    // Lock...
+    wxMutexLocker Lock(QueueMutex);
+
+    // Wait for one to be decoded, unless there won't be any more...
+    while(unQueued == 0 && !bEnded)
+        FrameDecoded.Wait();
+
+    // There are no more...
+    if(unQueued == 0)
+        return false;
+
+    // Take the oldest, leaving nothing behind in its slot...
+    NextFrame = Queue[unQueueHead];
+    Queue[unQueueHead].release();
+    unQueueHead = (unQueueHead + 1) % Queue.size();
+  --unQueued;
+
+    // Let the decoder fill the space...
+    FrameRead.Signal();
+
+    // Done...
+    return true;
+}
+
+// Stop decoding and wait for the thread to finish...
+void VideoReader::Stop()
+{
+    // Not running...
+    if(!bStarted)
+        return;
+
+    // Ask it to stop, waking it if it's waiting for room...
+    {
+        // Lock...
+        wxMutexLocker Lock(QueueMutex);
+
+        // Ask and wake...
+        bStopping = true;
+        FrameRead.Broadcast();
+    }
+
+    // Wait for it to finish whatever frame it was on...
+    Wait();
+    bStarted = false;
+}
+
+// Deconstructor...
+VideoReader::~VideoReader()
+{
+    // Stop decoding...
+    Stop();
+
+    // Let go of anything still queued...
+    Queue.clear();
+
+    // Release the pool, which lives on until every frame handed out is...
+    if(pPool)
+        pPool->Release();
+}
+
@@ -0,0 +1,148 @@
+/*
+  Name:         VideoReader.h (definition)
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Decodes a video to 8-bit grayscale frames on its own thread,
+                staying up to a fixed number of frames ahead of whoever is
+                reading them. Frames are decoded into buffers from a pool, and
+                a frame goes back to the pool when the last cv::Mat holding it
+                is released. Once the pool has warmed up, reading needs no
+                allocations, and decoding overlaps with whatever the reader
+                does with each frame...
+*/
+
+// Multiple include protection...
+#ifndef _VIDEOREADER_H_
+#define _VIDEOREADER_H_
+
+// Includes...
+
+    // wxWidgets...
+    #include <wx/wx.h>
+    #include <wx/thread.h>
+
+    // OpenCV...
+    #include <opencv2/opencv.hpp>
+
+    // Frame buffer pool...
+    #include "FramePool.h"
+
+    // Media frame index...
+    #include "MediaIndex.h"
+
+    // Standard libraries and STL...
+    #include <vector>
+
+// VideoReader class...
+class VideoReader : public wxThread
+{
+    // Public methods...
+    public:
+
+        // Constructor takes how many frames to decode ahead by...
+        VideoReader(unsigned int const unDepth);
+
+        // Accessors...
+
+            // Frame rate, zero if unknown. Only valid once open...
+            double              GetFramesPerSecond() const;
+
+            // Total number of frames, zero if unknown. Only valid once
+            //  open...
+            unsigned int        GetTotalFrames() const;
+
+        // Mutators...
+
+            // Open a video, asking for just its luma plane if the backend can
+            //  give it to us, and start decoding ahead from the given frame.
+            //  Only every unStride'th frame is read, the ones in between are
+            //  grabbed but never retrieved. With its index, the seek goes by
+            //  way of the keyframes and the length is the index's rather than
+            //  the container's. Returns false if it can't be opened, can't
+            //  seek there, or decoding can't start...
+            bool                Open(wxString const &sPath,
+                                     unsigned int const unFirstFrame = 0,
+                                     MediaIndex const *pIndex = NULL,
+                                     unsigned int const unStride = 1);
+
+            // Get the next frame, waiting for it to be decoded if it hasn't
+            //  been yet. The frame must not be written to. Returns false once
+            //  there are no more... θ(1)
+            bool                Read(cv::Mat &NextFrame);
+
+            // Stop decoding and wait for the thread to finish. Frames already
+            //  read stay valid...
+            void                Stop();
+
+        // Deconstructor stops...
+       ~VideoReader();
+
+    // Protected methods...
+    protected:
+
+        // Decode the next frame into a pooled buffer. Returns false at the
+        //  end of the video...
+        bool                    Decode(cv::Mat &DecodedFrame);
+
+        // Thread entry point...
+        virtual ExitCode        Entry();
+
+        // Open the video so that it decodes straight to its luma plane...
+        bool                    OpenGrayscaleCapture(wxString const &sPath);
+
+    // Protected attributes...
+    protected:
+
+        // Capture handle, and whether it decodes to gray. Only the decoding
+        //  thread touches either once started...
+        cv::VideoCapture        Capture;
+        bool                    bGrayCapture;
+
+        // Frame rate and length, read when opened...
+        double                  dFramesPerSecond;
+        unsigned int            unTotalFrames;
+
+        // Frames from one read to the next, and how many to skip before
+        //  decoding the next...
+        unsigned int            unStride;
+        unsigned int            unSkip;
+
+        // Pool the frames are decoded into. Released rather than deleted,
+        //  frames may outlive us...
+        FramePool              *pPool;
+
+        // Shape of the last frame decoded, which the next is assumed to
+        //  have...
+        cv::Size                FrameSize;
+
+        // Colour frame decoded into when the backend can't give us gray...
+        cv::Mat                 ColourFrame;
+
+        // Guards everything below, and the conditions signalled when a frame
+        //  is decoded or read...
+        wxMutex                 QueueMutex;
+        wxCondition             FrameDecoded;
+        wxCondition             FrameRead;
+
+        // Ring of decoded frames waiting to be read, where the oldest is,
+        //  and how many there are...
+        std::vector<cv::Mat>    Queue;
+        unsigned int            unQueueHead;
+        unsigned int            unQueued;
+
+        // Has the decoder hit the end, and has it been asked to stop?
+        bool                    bEnded;
+        bool                    bStopping;
+
+        // Is the thread running?
+        bool                    bStarted;
+
+    // Private methods...
+    private:
+
+        // Not copyable...
+        VideoReader(VideoReader const &);
+        VideoReader &operator=(VideoReader const &);
+};
+
+#endif
+
@@ -6,7 +6,20 @@
 
 // Includes...
 #include "VideosGridDropTarget.h"
+#include "FrameSource.h"
 #include <wx/longlong.h>
+#include <sys/stat.h>
+
+// Is it a video, rather than a still?
+static bool IsVideo(wxFileName const &MediaFile)
+{
+    // Check the extension...
+    wxString const sExtension = MediaFile.GetExt().Lower();
+    return (sExtension == wxT("mov")   ||
+            sExtension == wxT("avi")   ||
+            sExtension == wxT("mpg")   ||
+            sExtension == wxT("mpeg"));
+}
 
 // Constructor...
 MediaGridDropTarget::MediaGridDropTarget(MainFrame *_pMainFrame)
@@ -15,62 +28,149 @@ MediaGridDropTarget::MediaGridDropTarget(MainFrame *_pMainFrame)
 
 }
 
-// We override here to receive dropped files...
-bool MediaGridDropTarget::OnDropFiles(wxCoord x, wxCoord y, 
-                                      const wxArrayString& FileNames)
+// Add a piece of media imported to the media grid...
+void MediaGridDropTarget::AddImported(MediaImporter::Item const &Imported)
 {
     // Constants...
-    //const wxULongLong   ulMegaByte  = 1024 * 1024;
     const wxULongLong   ulKiloByte  = 1024;
-    
+
     // Variables...
     wxULongLong         ulTotalSize = 0;
     wxULongLong         ulFileSize  = 0;
-    unsigned int        unProgress  = 0;
     int                 nRow        = 0;
 
-    // We were dropped a Slither experiment...
-    wxFileName ExperimentFile(FileNames[0]);
-    if(ExperimentFile.GetExt().Lower() == wxT("sex"))
+    // It couldn't be copied...
+    if(!Imported.bImported)
     {
-        // Extract unnormalized file name...
-        wxString sFileName = FileNames[0];
+        // Alert user...
+        wxLogError(wxT("Unable to copy ") + Imported.sTitle +
+                   wxT(" into experiment..."));
 
-        // Win32 passes short form, normalize...
-        wxFileName NormalizedFileName(sFileName);
-        NormalizedFileName.Normalize(wxPATH_NORM_LONG | wxPATH_NORM_DOTS |
-                                     wxPATH_NORM_TILDE | wxPATH_NORM_ABSOLUTE);
+        // Skip...
+        return;
+    }
 
-        // Store the experiment name...
-      ::wxGetApp().sExperimentRequestedFromShell = 
-            NormalizedFileName.GetFullPath();
+    // Trigger need save, since experiment is now modified...
+    pMainFrame->pExperiment->TriggerNeedSave();
 
-        // Tell the main frame to try opening the experiment now...
-        pMainFrame->ProcessCommand(wxID_OPEN);
+    // Keep its frame index with the experiment, so it never has to be built
+    //  again. It will be when it's needed if this fails...
+    if(Imported.Index.IsOk())
+    {
+        wxString const sIndexPath =
+            pMainFrame->pExperiment->GetMediaIndexPath(Imported.sTitle);
+        if(!Imported.Index.Save(std::string(sIndexPath.fn_str())))
+            ::wxRemoveFile(sIndexPath);
+    }
+
+    // Add new row to media grid and check for error...
+    /*nRow = pMainFrame->MediaGrid->YToRow(y);
+    nRow = nRow == wxNOT_FOUND ? 0 : nRow;*/
+    nRow = 0;
+    if(!pMainFrame->MediaGrid->InsertRows(nRow))
+        return;
+
+    // Update each column...
+
+        // Title...
+        pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::TITLE,
+                                            Imported.sTitle);
         
-        // Report drag and drop operation ok to shell...
-        return true;
+        // Date...
+        pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::DATE,
+            Imported.Modified.FormatDate());
+
+        // Time...
+        pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::TIME,
+            Imported.Modified.FormatTime());
+
+        // Technician...
+        pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::TECHNICIAN,
+          ::wxGetUserId());
+
+        // Length, from the index built while it was imported, or how many
+        //  images there are if it's a sequence of them...
+        if(Imported.bSequence)
+            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::LENGTH,
+                wxString::Format(wxT("%u images"),
+                                 (unsigned int) Imported.Images.size()));
+        else if(!Imported.bVideo || !Imported.Index.IsOk())
+            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::LENGTH,
+                wxT("?"));
+        else
+            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::LENGTH,
+                MainFrame::FormatMediaLength(Imported.Index.Length()));
+
+        // Size...
+        ulFileSize = Imported.ulSize;
+        ulFileSize /= ulKiloByte;
+        pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::SIZE,
+            ulFileSize.ToString() + wxT(" KB"));
+
+        // Notes...
+        pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::NOTES,
+            wxT("You may place whatever you like here..."));
+
+    // Update total embedded media count...
+    wxString sEmbeddedMedia;
+    sEmbeddedMedia << pMainFrame->MediaGrid->GetNumberRows();
+    pMainFrame->EmbeddedMedia->ChangeValue(sEmbeddedMedia);
+
+    // Set the new total size...
+    ulTotalSize = pMainFrame->GetTotalMediaSize() / ulKiloByte;
+    pMainFrame->TotalSize->ChangeValue(ulTotalSize.ToString() + wxT(" KB"));
+
+    // Say what it was, if we could tell...
+    if(Imported.nWidth > 0 && Imported.nHeight > 0)
+        pMainFrame->SetStatusText(wxString::Format(
+            wxT("Imported %s, %dx%d..."), Imported.sTitle.c_str(),
+            Imported.nWidth, Imported.nHeight));
+    else
+        pMainFrame->SetStatusText(wxT("Imported ") + Imported.sTitle +
+                                  wxT("..."));
+}
+
+// Prompt to add media and start importing it...
+bool MediaGridDropTarget::AddMedia(const wxArrayString &FileNames,
+                                   bool const bRemoveSources)
+{
+    // Constants...
+    //const wxULongLong   ulMegaByte  = 1024 * 1024;
+    const wxULongLong   ulKiloByte  = 1024;
+
+    // Variables...
+    wxULongLong         ulTotalSize = 0;
+    std::vector<MediaImporter::Item> Items;
+    struct stat         Status;
+
+    // Still importing the last lot...
+    if(pMainFrame->pExperiment->IsImportingMedia())
+    {
+        pMainFrame->SetStatusText(wxT("Still importing media, please wait..."));
+        return false;
     }
 
-    // Calculate total media size...
+    // Work out what to import...
     for(unsigned int unIndex = 0; unIndex < FileNames.GetCount(); unIndex++)
     {
+        // A directory is a sequence of the images in it. Named after it,
+        //  however its path ends...
+        wxString sSourcePath = FileNames[unIndex];
+        bool const bSequence = ::wxDirExists(sSourcePath);
+        while(bSequence && sSourcePath.Length() > 1 &&
+              wxFileName::IsPathSeparator(sSourcePath.Last()))
+            sSourcePath.RemoveLast();
+
         // Find the media...
-        wxFileName MediaFile(FileNames[unIndex]);
+        wxFileName MediaFile(sSourcePath);
 
             // Failed...
             if(!MediaFile.IsOk())
                 return false;
 
         // Verify it is of the write format...
-        if(!(MediaFile.GetExt().Lower() == wxT("mov")   ||
-             MediaFile.GetExt().Lower() == wxT("avi")   ||
-             MediaFile.GetExt().Lower() == wxT("mpg")   ||
-             MediaFile.GetExt().Lower() == wxT("mpeg")  ||
-             MediaFile.GetExt().Lower() == wxT("png")   ||
-             MediaFile.GetExt().Lower() == wxT("jpg")   ||
-             MediaFile.GetExt().Lower() == wxT("jpeg")  ||
-             MediaFile.GetExt().Lower() == wxT("bmp")))
+        if(!bSequence && !IsVideo(MediaFile) &&
+           !ImageSequenceFrameSource::IsImage(sSourcePath))
         {
             // Log it...
             wxLogError(MediaFile.GetFullName() + 
@@ -80,8 +180,93 @@ bool MediaGridDropTarget::OnDropFiles(wxCoord x, wxCoord y,
             return false;
         }
 
+        // Check for duplicate name in cache, or among those dropped...
+        bool bDuplicate =
+            pMainFrame->IsExperimentContainMedia(MediaFile.GetFullName());
+        for(size_t Index = 0; Index < Items.size() && !bDuplicate; ++Index)
+            bDuplicate = (Items[Index].sTitle.Lower() ==
+                          MediaFile.GetFullName().Lower());
+        if(bDuplicate)
+        {
+            // Prepare error message box...
+            wxMessageDialog
+                Message(pMainFrame,
+                        wxT("Your experiment already contains media by the"
+                            " name of:\n\n\t") + MediaFile.GetFullName() +
+                            wxT(".\n\nYou might want to rename it and try"
+                                " again."), wxT("Duplicate Media"),
+                        wxICON_EXCLAMATION);
+
+            // Show it...
+            Message.ShowModal();
+
+            // Skip media...
+            continue;
+        }
+
+        // Find out how big it is and when it was last modified, at once...
+        if(stat(sSourcePath.fn_str(), &Status) != 0)
+        {
+            // Log it...
+            wxLogError(wxT("Unable to read ") + MediaFile.GetFullName() +
+                       wxT("..."));
+
+            // Abort...
+            return false;
+        }
+
+        // Queue it to be copied into the cache...
+        MediaImporter::Item Importing;
+        Importing.sSourcePath       = std::string(sSourcePath.fn_str());
+        Importing.sDestinationPath  = std::string((
+            pMainFrame->pExperiment->GetCachePath() + wxT("/media/") +
+            MediaFile.GetFullName()).fn_str());
+        Importing.sTitle            = MediaFile.GetFullName();
+        Importing.ulSize            = Status.st_size;
+        Importing.Modified          = wxDateTime((time_t) Status.st_mtime);
+        Importing.bVideo            = !bSequence && IsVideo(MediaFile);
+        Importing.bSequence         = bSequence;
+        Importing.bRemoveSource     = bRemoveSources;
+
+        // A sequence is as big as every image in it...
+        if(bSequence)
+        {
+            // Find them, in order...
+            std::vector<wxString> Images;
+            ImageSequenceFrameSource::List(sSourcePath, Images);
+
+            // Add each up...
+            Importing.ulSize = 0;
+            for(size_t Image = 0; Image < Images.size(); ++Image)
+            {
+                // Size it...
+                if(stat(Images[Image].fn_str(), &Status) != 0)
+                    continue;
+
+                // Remember it...
+                MediaImporter::SequenceImage Member;
+                Member.sName  = std::string(
+                    wxFileName(Images[Image]).GetFullName().fn_str());
+                Member.ulSize = Status.st_size;
+                Importing.Images.push_back(Member);
+                Importing.ulSize += Member.ulSize;
+            }
+
+            // There aren't any...
+            if(Importing.Images.empty())
+            {
+                // Log it...
+                wxLogError(MediaFile.GetFullName() +
+                           wxT(" contains no images..."));
+
+                // Abort...
+                return false;
+            }
+        }
+        Items.push_back(Importing);
+
         // Update total size...
-        ulTotalSize += MediaFile.GetSize();
+        ulTotalSize += Importing.ulSize;
     }
 
         // Nothing to add...
@@ -99,128 +284,49 @@ bool MediaGridDropTarget::OnDropFiles(wxCoord x, wxCoord y,
                     pMainFrame) == wxCANCEL)
         return false;
 
-    // Initialize progress dialog...
-    wxProgressDialog ProgressDialog(wxT("Media"), 
-                                    wxT("Adding new media content..."), 
-                                    FileNames.GetCount(), NULL, 
-                                    wxPD_APP_MODAL | wxPD_AUTO_HIDE | 
-                                    wxPD_SMOOTH);
-
-    // Set progress bar to zero...
-    unProgress = 0;
-    ProgressDialog.Update(unProgress);
-
-    // Add the media...
-    for(unsigned int unIndex = 0; unIndex < FileNames.GetCount(); unIndex++)
+    // Start copying it in the background, each appearing in the media grid
+    //  as soon as it has been, and check for error...
+    if(!pMainFrame->pExperiment->ImportMedia(Items))
     {
-        // Find the media...
-        wxFileName MediaFile(FileNames[unIndex]);
+        // Alert user...
+        wxLogError(wxT("Unable to start importing media..."));
 
-            // Failed...
-            if(!MediaFile.IsOk())
-                continue;
-
-        // Check for duplicate name in cache...
-        if(pMainFrame->IsExperimentContainMedia(MediaFile.GetFullName()))
-        {
-            // Prepare error message box...
-            wxMessageDialog 
-                Message(pMainFrame, 
-                        wxT("Your experiment already contains media by the"
-                            " name of:\n\n\t") + MediaFile.GetFullName() + 
-                            wxT(".\n\nYou might want to rename it and try"
-                                " again."), wxT("Duplicate Media"), 
-                        wxICON_EXCLAMATION);
-                            
-            // Show it...
-            Message.ShowModal();
-            
-            // Skip media...
-            continue;
-        }
-
-        // Copy the file into the cache...
-
-            // Create path to media to copy into cache...
-            wxString sDestination = pMainFrame->pExperiment->GetCachePath() + 
-                                wxT("/media/") + MediaFile.GetFullName();
-
-            // Copy into cache and check for error...
-            if(!::wxCopyFile(FileNames[unIndex], sDestination, true))
-            {
-                // Alert user...
-                wxLogError(wxT("Unable to copy file into experiment..."));
+        // Abort...
+        return false;
+    }
 
-                // Skip...
-                continue;
-            }
+    // Done...
+    pMainFrame->SetStatusText(wxT("Importing media..."));
+    return true;
+}
 
-            // Trigger need save, since experiment is now modified...
-            pMainFrame->pExperiment->TriggerNeedSave();
+// We override here to receive dropped files...
+bool MediaGridDropTarget::OnDropFiles(wxCoord x, wxCoord y,
+                                      const wxArrayString& FileNames)
+{
+    // We were dropped a Slither experiment...
+    wxFileName ExperimentFile(FileNames[0]);
+    if(ExperimentFile.GetExt().Lower() == wxT("sex"))
+    {
+        // Extract unnormalized file name...
+        wxString sFileName = FileNames[0];
 
-            // Update progress, but check for user abort...
-            if(!ProgressDialog.Update(unProgress++, 
-                                      wxT("Please wait while adding ") + 
-                                        FileNames[unIndex]))
-            {
-                // Alert user...
-                wxMessageBox(wxT("The adding of new media was cancelled..."));
-                
-                // Cleanup...
-                return false;
-            }
+        // Win32 passes short form, normalize...
+        wxFileName NormalizedFileName(sFileName);
+        NormalizedFileName.Normalize(wxPATH_NORM_LONG | wxPATH_NORM_DOTS |
+                                     wxPATH_NORM_TILDE | wxPATH_NORM_ABSOLUTE);
 
-        // Add new row to media grid and check for error...
-        /*nRow = pMainFrame->MediaGrid->YToRow(y);
-        nRow = nRow == wxNOT_FOUND ? 0 : nRow;*/
-        nRow = 0;
-        if(!pMainFrame->MediaGrid->InsertRows(nRow))
-            continue;
+        // Store the experiment name...
+      ::wxGetApp().sExperimentRequestedFromShell =
+            NormalizedFileName.GetFullPath();
 
-        // Update each column...
+        // Tell the main frame to try opening the experiment now...
+        pMainFrame->ProcessCommand(wxID_OPEN);
         
-            // Title...
-            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::TITLE, 
-                                                MediaFile.GetFullName());
-            
-            // Date...
-            wxDateTime LastModificationTime;
-            MediaFile.GetTimes(NULL, &LastModificationTime, NULL);
-            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::DATE,
-                LastModificationTime.FormatDate());
-
-            // Time...
-            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::TIME,
-                LastModificationTime.FormatTime());
-            
-            // Technician...
-            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::TECHNICIAN,
-              ::wxGetUserId());
-
-            // Length...
-            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::LENGTH,
-                wxT("?"));
-
-            // Size...
-            ulFileSize = MediaFile.GetSize();
-            ulFileSize /= ulKiloByte;
-            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::SIZE,
-                ulFileSize.ToString() + wxT(" KB"));
-
-            // Notes...
-            pMainFrame->MediaGrid->SetCellValue(nRow, MainFrame::NOTES,
-                wxT("You may place whatever you like here..."));
+        // Report drag and drop operation ok to shell...
+        return true;
     }
-    
-    // Update total embedded media count...
-    wxString sEmbeddedMedia;
-    sEmbeddedMedia << pMainFrame->MediaGrid->GetNumberRows();
-    pMainFrame->EmbeddedMedia->ChangeValue(sEmbeddedMedia);
-    
-    // Set the new total size...
-    ulTotalSize = pMainFrame->GetTotalMediaSize() / ulKiloByte;
-    pMainFrame->TotalSize->ChangeValue(ulTotalSize.ToString() + wxT(" KB"));
 
-    // Done...
-    return true;
+    // Prompt to add media...
+    return AddMedia(FileNames);
 }
@@ -29,6 +29,16 @@ class MediaGridDropTarget : public wxFileDropTarget
         // Constructor...
         MediaGridDropTarget(MainFrame *_pMainFrame);
 
+        // Add a piece of media imported to the media grid, or say why it
+        //  couldn't be...
+        void AddImported(MediaImporter::Item const &Imported);
+
+        // Prompt to add media and start importing it in the background,
+        //  optionally removing the originals once they have been. Returns
+        //  false if nothing is being imported...
+        bool AddMedia(const wxArrayString &FileNames,
+                      bool const bRemoveSources = false);
+
         // We override here to receive dropped files...
         virtual bool OnDropFiles(wxCoord x, wxCoord y, 
                                  const wxArrayString& FileNames);
@@ -18,6 +18,9 @@
     // For assistance with debugging...
     #include <cassert>
 
+    // For std::max...
+    #include <algorithm>
+
 // Within the SlitherMath namespace...
 using namespace SlitherMath;
 
@@ -35,6 +38,9 @@ Worm::Worm()
       GravitationalCentre(cvPoint(0, 0)),
       dLength(0.0f), 
       dWidth(0.0f),
+      dCurrentArea(0.0f),
+      dCurrentLength(0.0f),
+      dCurrentWidth(0.0f),
       TerminalA(cvPoint(0, 0), 0),
       TerminalB(cvPoint(0, 0), 0)
 {
@@ -52,6 +58,9 @@ Worm::Worm(CvContour const &Contour, IplImage const &GrayImage)
       GravitationalCentre(cvPoint(0, 0)),
       dLength(0.0f), 
       dWidth(0.0f),
+      dCurrentArea(0.0f),
+      dCurrentLength(0.0f),
+      dCurrentWidth(0.0f),
       TerminalA(cvPoint(0, 0), 0),
       TerminalB(cvPoint(0, 0), 0)
 {    
@@ -91,6 +100,27 @@ CvContour const &Worm::Contour() const
     return *pContour;
 }
 
+// Area as measured in the most recent refresh...
+double const &Worm::CurrentArea() const
+{
+    // Return it...
+    return dCurrentArea;
+}
+
+// Length as measured in the most recent refresh...
+double const &Worm::CurrentLength() const
+{
+    // Return it...
+    return dCurrentLength;
+}
+
+// Width as measured in the most recent refresh...
+double const &Worm::CurrentWidth() const
+{
+    // Return it...
+    return dCurrentWidth;
+}
+
 // Find the vertex on the contour the given length away, starting in increasing 
 //  order... O(n)
 inline unsigned int const Worm::FindVertexIndexByLength(
@@ -362,6 +392,22 @@ CvPoint const &Worm::Head() const
             return TerminalB.LastSeenLocus;
 }                                                
 
+// How sure we are of which end is the head...
+double Worm::HeadConfidence() const
+{
+    // Total votes cast...
+    unsigned int const unVotes = 
+        TerminalA.unHeadScore + TerminalB.unHeadScore;
+
+        // None yet...
+        if(unVotes == 0)
+            return 0.0;
+
+    // The winning end's share, same tie break as Head()...
+    return (double) std::max(TerminalA.unHeadScore, TerminalB.unHeadScore) / 
+           unVotes;
+}
+
 // Given only the two vertex indices, *this* image, and assuming they are 
 //  opposite ends of the worm, would the first of the two most likely be the 
 //  head if we had but this image alone to consider?
@@ -798,6 +844,49 @@ CvPoint const &Worm::Tail() const
             return TerminalA.LastSeenLocus;
 }
 
+// Fold in what another tracker saw of this same worm right after us...
+void Worm::Merge(Worm const &Later, bool const bFlipped)
+{
+    // It never saw anything...
+    if(Later.unRefreshes == 0)
+        return;
+
+    // Length is a mean over every refresh, so weight each by its count...
+    dLength = ((dLength * unRefreshes) + (Later.dLength * Later.unRefreshes)) /
+              (unRefreshes + Later.unRefreshes);
+
+    // Area and width are the greatest either of us saw...
+    dArea   = std::max(dArea, Later.dArea);
+    dWidth  = std::max(dWidth, Later.dWidth);
+
+    // Its terminal end A is wherever it first guessed the head was. Work out
+    //  which of ours that is...
+    bool const bHeadIsA = (TerminalA.unHeadScore >= TerminalB.unHeadScore);
+    TerminalEndNotes &OurHead = bHeadIsA ? TerminalA : TerminalB;
+    TerminalEndNotes &OurTail = bHeadIsA ? TerminalB : TerminalA;
+    TerminalEndNotes &MatchA  = bFlipped ? OurTail : OurHead;
+    TerminalEndNotes &MatchB  = bFlipped ? OurHead : OurTail;
+
+    // Add its votes to ours and take where it last saw each end...
+    MatchA.unHeadScore     += Later.TerminalA.unHeadScore;
+    MatchA.LastSeenLocus    = Later.TerminalA.LastSeenLocus;
+    MatchB.unHeadScore     += Later.TerminalB.unHeadScore;
+    MatchB.LastSeenLocus    = Later.TerminalB.LastSeenLocus;
+
+    // Its latest refresh is now the latest...
+    if(pContour)
+        cvClearSeq((CvSeq *) pContour);
+    pContour = (CvContour *) cvCloneSeq((CvSeq *) Later.pContour, pStorage);
+    pContour->rect      = Later.pContour->rect;
+    GravitationalCentre = Later.GravitationalCentre;
+    dCurrentArea        = Later.dCurrentArea;
+    dCurrentLength      = Later.dCurrentLength;
+    dCurrentWidth       = Later.dCurrentWidth;
+
+    // And so are its refreshes...
+    unRefreshes += Later.unRefreshes;
+}
+
 // Refresh the worm's metrics based on its new contour... (area, length, width, 
 //  et cetera)
 inline void Worm::Refresh(CvContour const &NewContour, 
@@ -840,6 +929,9 @@ inline void Worm::Refresh(CvContour const &NewContour,
 
     // Find both ends... (head and tail)
 
+        // Each pinch below measures a width, so start this refresh's afresh...
+        dCurrentWidth = 0.0f;
+
         // Find an end, either will do... θ(n)
         unsigned int const unMysteryEndVertexIndex = 
             PinchShiftForAnEnd(GrayImage, Forwards);
@@ -883,6 +975,9 @@ inline void Worm::UpdateArea(double const &dAreaAtThisMoment)
     //  encompassing less than or equal to the entire vermiform. It is best 
     //  then to forget averages and just store the greatest we find then...
     dArea = std::max(dArea, dAreaAtThisMoment);
+
+    // Remember this one too...
+    dCurrentArea = dAreaAtThisMoment;
 }
 
 // Update the gravitational centre from this image...
@@ -951,6 +1046,9 @@ inline void Worm::UpdateLength(double const &dLengthAtThisMoment)
     //  average by n, add x_{n+1}, and then divide the whole thing by n+1...
     dLength = ((dLength * unRefreshes) + dLengthAtThisMoment) / 
               (unRefreshes + 1);
+
+    // Remember this one too...
+    dCurrentLength = dLengthAtThisMoment;
 }
 
 // Update the approximate width, based on the value at this moment in time. 
@@ -962,6 +1060,9 @@ inline void Worm::UpdateWidth(double const &dWidthAtThisMoment)
     // the line segment formed between the two will probably have an upper 
     // bound of the worm's actual width...
     dWidth = std::max(dWidth, dWidthAtThisMoment);
+
+    // Same goes for the widest pinch of this refresh alone...
+    dCurrentWidth = std::max(dCurrentWidth, dWidthAtThisMoment);
 }
 
 // Number of times worm has been refreshed...
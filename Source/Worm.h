@@ -49,10 +49,21 @@ class Worm
             // Get the worm's contour...
             CvContour const    &Contour() const;
 
+            // Area, length, and width as measured in the most recent refresh
+            //  alone, rather than our best guess over all of them...
+            double const       &CurrentArea() const;
+            double const       &CurrentLength() const;
+            double const       &CurrentWidth() const;
+
             // Best guess as to the head's position at this moment in time, 
             //  since it changes...
             CvPoint const      &Head() const;
 
+            // How sure we are of which end is the head, as the fraction of
+            //  every head vote that went to the end Head() picked. One half
+            //  is a coin toss, zero if there have been no votes yet...
+            double              HeadConfidence() const;
+
             // Best guess of the length from head to tail, considering 
             //  everything we've seen thus far...
             double const       &Length() const;
@@ -73,6 +84,12 @@ class Worm
 
         // Mutators...
 
+            // Fold in what another tracker saw of this same worm over the
+            //  frames that came right after ours, as if we had seen every one
+            //  of its refreshes ourselves. Flipped if the end it first took for
+            //  the head is the one we take for the tail...
+            void Merge(Worm const &Later, bool const bFlipped);
+
             // Refresh worm's metrics based on new contour and image data...
             void Refresh(
                 CvContour const &NewContour, IplImage const &GrayImage);
@@ -237,6 +254,11 @@ class Worm
                 // Width of the worm...
                 double          dWidth;
 
+            // The same metrics as measured in the most recent refresh...
+            double              dCurrentArea;
+            double              dCurrentLength;
+            double              dCurrentWidth;
+
             // Terminal end scores...
             TerminalEndNotes    TerminalA;
             TerminalEndNotes    TerminalB;
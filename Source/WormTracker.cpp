@@ -11,16 +11,18 @@
 #include <cmath>
 #include <cassert>
 #include <algorithm>
-#include <sstream>
+#include <cstdio>
 
 // Default constructor...
 WormTracker::WormTracker()
     : fFieldOfViewDiameter(0.0f),
       pGrayImage(NULL),
-      pThinkingImage(NULL),
+      dFramesPerSecond(0.0),
       unWormsJustAdded(0),
       unCurrentFrame(0),
       unTotalFrames(0),
+      unFirstMediaFrame(0),
+      unMediaFrameStride(1),
       unThreshold(150),
       unMaxThresholdValue(255),
       unMinimumCandidateSize(150),
@@ -39,6 +41,9 @@ WormTracker::WormTracker()
         // Initialize the font structure...
         cvInitFont(&ThinkingLabelFont, CV_FONT_HERSHEY_PLAIN, 
                    fHorizontalScale, fVerticalScale, unThickness, unLineWidth);
+
+    // Readers always get something, even before the first frame...
+    PublishSnapshot();
 }
 
 // Add new worm to tracker...
@@ -57,36 +62,23 @@ void WormTracker::Add(CvContour const &WormContour)
   ++unWormsJustAdded;
 }
 
-// Add a text label to the thinking image at a point...
-void WormTracker::AddThinkingLabel(string const sLabel, CvPoint Point)
+// Swap in the newest finished thinking display, if any...
+bool WormTracker::AcquireThinkingDisplay()
 {
-    cv::Mat pThinkingMatImage = cv::cvarrToMat(pThinkingImage); 
-    
-    // Draw label line...
-    cv::line(pThinkingMatImage, cvPoint(Point.x + 20, Point.y + 20), Point,
-	   CV_RGB(0xfe, 0x00, 0x00)); 
-    //cvLine(pThinkingImage, cvPoint(Point.x + 20, Point.y + 20), Point,
-    //       CV_RGB(0xfe, 0x00, 0x00));
-
-    // Draw text...
-    cv::putText(pThinkingMatImage, sLabel, cvPoint(Point.x + 25, Point.y + 25),  cv::FONT_HERSHEY_PLAIN, 0.7,
-	    CV_RGB(0xfe, 0x00, 0x00));
-    //cvPutText(pThinkingImage, sLabel.c_str(), 
-    //          cvPoint(Point.x + 25, Point.y + 25), &ThinkingLabelFont,
-    //         CV_RGB(0xfe, 0x00, 0x00));
+    // Just an index exchange with the analysis thread, no copy or lock...
+    return ThinkingDisplays.Acquire();
 }
 
-// Advance frame...
+// Advance frame, sharing the image's buffer...
 //  2020/06/13 - Fixed contour drawing by using cvScalar
 // functions instead of CV_RGB which does not return a CvScalar any more 
-void WormTracker::Advance(IplImage const &NewGrayImage)
+void WormTracker::Advance(cv::Mat const &NewGrayMat)
 {
     // Variables...
     CvMemStorage   *pStorage        = NULL;
     CvContour      *pFirstContour   = NULL;
     CvContour      *pCurrentContour = NULL;
     unsigned int    unFoundIndex    = (unsigned) - 1;
-    CvSize const    ImageSize       = cvGetSize(&NewGrayImage);
 
     // Lock resources...
     wxMutexLocker   Lock(ResourcesMutex);
@@ -94,46 +86,22 @@ void WormTracker::Advance(IplImage const &NewGrayImage)
     // Lock should have been gained successfully...
     assert(Lock.IsOk());
 
-    // Release the old image, if any...
-    if(pGrayImage)
-        cvReleaseImage(&pGrayImage);
-        
-    // Release the old thinking image, if any...
-    if(pThinkingImage)
-        cvReleaseImage(&pThinkingImage);
-    
-    // Allocate and clone the new one...
-    pGrayImage = cvCloneImage(&NewGrayImage);
-    
-        // Failed...
-        if(!pGrayImage)
-            throw bad_alloc();
-
-    // Prepare the thinking image...
-	// 2020/06/13 - using cv::Mat to get around
-	//issues with cvConvertImage in OpenCV 4
-	cv::Mat pGrayMatImage = cv::cvarrToMat(pGrayImage); 
-	cv::Mat pThinkingMatImage(cvGetSize(pGrayImage), CV_8UC1);
-	//convert to grayscale
-	cv::cvtColor(pGrayMatImage, pThinkingMatImage, CV_GRAY2BGR);
-	  
-	// Allocate...
-        //pThinkingImage = cvCreateImage(ImageSize, IPL_DEPTH_8U, 3);
-	
-	//replace pGrayImage
-	IplImage copyThinkingImg = cvIplImage(pThinkingMatImage);
-	pThinkingImage = &copyThinkingImg;
-        
-        
-            // Failed...
-            if(!pThinkingImage)
-                throw bad_alloc();
+    // Take a reference to the new image. The old one lives on for as long as
+    //  any thinking display still refers to it. Only a view into some larger
+    //  image needs copying, the legacy routines can't take one...
+    GrayImage       = NewGrayMat.isContinuous() ? 
+                        NewGrayMat : NewGrayMat.clone();
+    GrayIplImage    = cvIplImage(GrayImage);
+    pGrayImage      = &GrayIplImage;
 
-        // Copy in the original grayscale image as colour now...
-        //cvConvertImage(pGrayImage, pThinkingImage, CV_GRAY2BGR);
+    // Start recording a thinking display in whichever slot the user interface
+    //  isn't looking at. Nothing gets drawn unless somebody asks for it...
+    ThinkingDisplayList &ThinkingDisplay = ThinkingDisplays.Back();
+    ThinkingDisplay.Begin(GrayImage);
 
     // Image must be a 8-bit, unsigned, grayscale...
     assert(pGrayImage->depth == IPL_DEPTH_8U);
+    assert(pGrayImage->nChannels == 1);
 
     // Image must not have a region of interest set...
     assert(pGrayImage->roi == NULL);
@@ -219,66 +187,76 @@ void WormTracker::Advance(IplImage const &NewGrayImage)
     
     // Cleanup...
     cvReleaseMemStorage(&pStorage); 
+
+    // Remember where everybody was on this frame...
+    RecordTrajectories();
+
+    // Measure responses to any stimulus being watched...
+    Habituation.Advance(unCurrentFrame, TrackingTable);
+
+    // Watch for reversals, at this frame's scale...
+    Reversals.SetScale(ConvertMillimetersToPixels(1.0), dFramesPerSecond);
+    Reversals.Advance(unCurrentFrame, TrackingTable);
     
-    // Show some information on each worm contour...
+    // Note some information on each worm contour...
     for(unsigned int unWormIndex = 0; unWormIndex < TrackingTable.size();
       ++unWormIndex)
     {
+        // Variables...
+        char szCentreLabel[64] = {0};
+
         // Get the current worm...
         Worm const &CurrentWorm = GetWorm(unWormIndex);
 
-        // Draw the contours onto the thinking image...
-	
-	// 2020/06/13 - since we cannot use CV_RGB(r,g,b) as it no longer
-	//returns a CvScalar, we need to use cvScalar(b,g,r)
-	//The RGB value is (0x00, 0x00, 0xfe)	
-	//ref: https://www.rubydoc.info/github/gonzedge/ruby-opencv/OpenCV/CvScalar
-	CvScalar externColour = cvScalar(0xfe, 0x00, 0x00);
-	CvScalar holeColour = cvScalar(0xfe, 0x00, 0x00);	
-        cvDrawContours(pThinkingImage, (CvSeq *) &CurrentWorm.Contour(),
-                       externColour, holeColour, 0, 
-                       1);
-	
-        // Show some information about the worm on the thinking image...
-        AddThinkingLabel("head", CurrentWorm.Head());
-        std::ostringstream ssCentre;
-        ssCentre << "(worm " << unWormIndex + 1 << ", updated " 
-                 << CurrentWorm.Refreshes() << ")";
-        AddThinkingLabel(ssCentre.str(), CurrentWorm.Centre());
-        AddThinkingLabel("tail", CurrentWorm.Tail());
+        // Outline the worm...
+        ThinkingDisplay.AddContour(CurrentWorm.Contour());
+
+        // Label its ends and centre...
+        snprintf(szCentreLabel, sizeof(szCentreLabel), "(worm %u, updated %u)",
+                 unWormIndex + 1, CurrentWorm.Refreshes());
+        ThinkingDisplay.AddLabel("head", CurrentWorm.Head());
+        ThinkingDisplay.AddLabel(szCentreLabel, CurrentWorm.Centre());
+        ThinkingDisplay.AddLabel("tail", CurrentWorm.Tail());
     }
-    
-    // Show one millimeter legend...
-    
-        // Convert one millimeter to pixels...
-        unsigned int const unLegendLength = 
-            (unsigned int) ConvertMillimetersToPixels(1.0f);
-	
-	// Fixing line and text to work with OpenCV 4
-	//C++ API	
-        // Draw the legend line...
-        //cvLine(pThinkingImage, 
-        //       cvPoint(50, ImageSize.height - 5),
-        //       cvPoint(50 + unLegendLength, ImageSize.height - 5),
-        //       CV_RGB(0x00, 0x00, 0xff), 2);
-
-	cv::line(pThinkingMatImage, 
-               cvPoint(50, ImageSize.height - 5),
-               cvPoint(50 + unLegendLength, ImageSize.height - 5),
-               CV_RGB(0x00, 0x00, 0xff), 2);
-
-        // Draw label...
-        //cvPutText(pThinkingImage, "1 mm", 
-        //            cvPoint(50 + unLegendLength + 5, ImageSize.height - 3), 
-        //            &ThinkingLabelFont, CV_RGB(0x00, 0x00, 0xff));
-	
-	cv::putText(pThinkingMatImage, "1 mm", 
-                    cvPoint(50 + unLegendLength + 5, ImageSize.height - 3), 
-                    cv::FONT_HERSHEY_PLAIN, 0.7, CV_RGB(0x00, 0x00, 0xff));
 
+    // Note the one millimeter legend...
+    ThinkingDisplay.SetLegend(
+        (unsigned int) ConvertMillimetersToPixels(1.0f));
+
+    // Hand the finished thinking display over to the user interface...
+    ThinkingDisplays.Publish();
 
     // Advance frame counter...
   ++unCurrentFrame;
+
+    // Let readers see the result...
+    PublishSnapshot();
+}
+
+// Take on every setting of another tracker...
+void WormTracker::CopySettings(WormTracker const &Source)
+{
+    // Lock resources...
+    wxMutexLocker   Lock(ResourcesMutex);
+
+    // Scale and timing...
+    fFieldOfViewDiameter    = Source.fFieldOfViewDiameter;
+    dFramesPerSecond        = Source.dFramesPerSecond;
+
+    // Artificial intelligence settings...
+    unThreshold             = Source.unThreshold;
+    unMaxThresholdValue     = Source.unMaxThresholdValue;
+    unMinimumCandidateSize  = Source.unMinimumCandidateSize;
+    unMaximumCandidateSize  = Source.unMaximumCandidateSize;
+    bInletDetection         = Source.bInletDetection;
+    unMorphologySize        = Source.unMorphologySize;
+
+    // Analyzers carry their settings, so copy them whole and forget their
+    //  results...
+    Habituation = Source.Habituation;
+    Habituation.Reset();
+    Reversals   = Source.Reversals;
+    Reversals.Reset();
 }
 
 // Convert from pixels to millimeters...
@@ -333,46 +311,39 @@ unsigned int const WormTracker::CountRectanglesIntersected(
     return unIntersections;
 }
 
-// Get the current frame index...
+// Get the current frame index, from the latest snapshot...
 unsigned int const WormTracker::GetCurrentFrameIndex() const
 {
-    // Lock resources...
-    wxMutexLocker   Lock(ResourcesMutex);
-
     // Return count...
-    return unCurrentFrame;
+    return GetSnapshot()->unCurrentFrame;
 }
 
-// Get a copy of the current thinking image. Caller frees...
-IplImage *WormTracker::GetThinkingImage() const
+// Get the summary published after the most recent frame...
+std::shared_ptr<TrackerSnapshot const> WormTracker::GetSnapshot() const
 {
-    // Lock resources...
-    wxMutexLocker   Lock(ResourcesMutex);
-    
-    // If a deadlock was encountered, just abort...
-    if(!Lock.IsOk())
-        return NULL;
-
-    // Clone the thinking image, if any...
-    if(pThinkingImage) {
-	cerr << "Trying to clone image..." << endl;
-        return cvCloneImage(pThinkingImage);
-    }
-    // Otherwise, no thinking image available yet...
-    else {
-	cerr << "Cannot clone image!" << endl;
-        return NULL;
-    }
+    // Return it...
+    return std::atomic_load(&Snapshot);
 }
 
-// Get the total number of frames...
-unsigned int const WormTracker::GetTotalFrames() const
+// Get the thinking display last acquired...
+ThinkingDisplayList const &WormTracker::GetThinkingDisplay() const
 {
-    // Lock resources...
-    wxMutexLocker   Lock(ResourcesMutex);
+    // Return it...
+    return ThinkingDisplays.Front();
+}
 
+// Get every worm's per frame history...
+TrajectoryStore const &WormTracker::GetTrajectories() const
+{
+    // Return it...
+    return Trajectories;
+}
+
+// Get the total number of frames, from the latest snapshot...
+unsigned int const WormTracker::GetTotalFrames() const
+{
     // Return count...
-    return unTotalFrames;
+    return GetSnapshot()->unTotalFrames;
 }
 
 // Get the nth worm, or null worm if no more...
@@ -388,12 +359,9 @@ Worm const &WormTracker::GetWorm(unsigned int const unIndex) const
 // Get the number of worms just added since last check...
 unsigned int const WormTracker::GetWormsAddedSinceLastCheck()
 {
-    // Backup original for caller before resetting count...
-    unsigned int unTemp = unWormsJustAdded;
-    unWormsJustAdded    = 0;
-    
-    // Done...
-    return unTemp;
+    // Take the count and reset it in one step, since the analysis thread may
+    //  be adding to it at the same time...
+    return unWormsJustAdded.exchange(0);
 }
 
 // Find the nearest worm to given...
@@ -471,6 +439,12 @@ bool WormTracker::IsAnyPointOnImageExterior(CvContour const &MysteryContour)
     return false;
 }
 
+// Does it have stimuli scheduled to measure responses to?
+bool WormTracker::IsMeasuringStimuli() const
+{
+    return (Habituation.Stimuli() > 0);
+}
+
 // Could this contour be a worm, independent of what we know?
 bool WormTracker::IsPossibleWorm(CvContour const &MysteryContour) const
 {
@@ -522,6 +496,100 @@ unsigned int WormTracker::Tracking() const
     return TrackingTable.size();
 }
 
+// Publish a new snapshot of the tracker's current state...
+void WormTracker::PublishSnapshot()
+{
+    // Variables...
+    std::shared_ptr<TrackerSnapshot> NewSnapshot =
+        std::make_shared<TrackerSnapshot>();
+
+    // Frame counters...
+    NewSnapshot->unCurrentFrame = unCurrentFrame;
+    NewSnapshot->unTotalFrames  = unTotalFrames;
+
+    // Scale, if we've seen a frame to know it by...
+    if(pGrayImage)
+        NewSnapshot->dMillimetersPerPixel = ConvertPixelsToMillimeters(1.0);
+
+    // Summarize each worm...
+    NewSnapshot->Worms.resize(TrackingTable.size());
+    for(unsigned int unWormIndex = 0; unWormIndex < TrackingTable.size();
+      ++unWormIndex)
+    {
+        // Get the worm and its summary...
+        Worm const                     &CurrentWorm = *TrackingTable[unWormIndex];
+        TrackerSnapshot::WormSummary   &Summary     = NewSnapshot->Worms[unWormIndex];
+
+        // Copy its metrics...
+        Summary.Centre      = CurrentWorm.Centre();
+        Summary.Head        = CurrentWorm.Head();
+        Summary.Tail        = CurrentWorm.Tail();
+        Summary.dLength     = CurrentWorm.Length();
+        Summary.dWidth      = CurrentWorm.Width();
+        Summary.dArea       = CurrentWorm.Area();
+        Summary.unRefreshes = CurrentWorm.Refreshes();
+
+        // And its reversals...
+        Summary.unReversals         = Reversals.Reversals(unWormIndex);
+        Summary.dReversalSeconds    = Reversals.ReversalSeconds(unWormIndex);
+    }
+
+    // Stimulus responses so far...
+    NewSnapshot->unStimuli  = Habituation.Stimuli();
+    NewSnapshot->Responses  = Habituation.GetResponses();
+
+    // Swap it in. Readers holding the old one keep it until they let go...
+    std::atomic_store(&Snapshot,
+        std::shared_ptr<TrackerSnapshot const>(std::move(NewSnapshot)));
+}
+
+// Append a row to the trajectories for every worm refreshed on this frame...
+void WormTracker::RecordTrajectories()
+{
+    // Variables...
+    TrajectoryStore::Sample NewSample;
+
+    // Recording already stopped because there was nowhere to keep it...
+    if(Trajectories.IsStopped())
+        return;
+
+    // Any worms added this frame haven't been recorded yet...
+    RecordedRefreshes.resize(TrackingTable.size(), 0);
+
+    // Check each worm...
+    for(unsigned int unWormIndex = 0; unWormIndex < TrackingTable.size();
+      ++unWormIndex)
+    {
+        // Get the worm...
+        Worm const &CurrentWorm = *TrackingTable[unWormIndex];
+
+        // Not seen on this frame, so there's nothing new to say about it...
+        if(CurrentWorm.Refreshes() == RecordedRefreshes[unWormIndex])
+            continue;
+        RecordedRefreshes[unWormIndex] = CurrentWorm.Refreshes();
+
+        // Fill in its row...
+        NewSample.unFrame   =
+            unFirstMediaFrame + unCurrentFrame * unMediaFrameStride;
+        NewSample.unWorm    = unWormIndex;
+        NewSample.Centre    = CurrentWorm.Centre();
+        NewSample.Head      = CurrentWorm.Head();
+        NewSample.Tail      = CurrentWorm.Tail();
+        NewSample.dLength   = CurrentWorm.CurrentLength();
+        NewSample.dWidth    = CurrentWorm.CurrentWidth();
+        NewSample.dArea     = CurrentWorm.CurrentArea();
+
+        // Store. If there's nowhere left to keep it, recording stops...
+        if(!Trajectories.Append(NewSample))
+        {
+            // Alert user...
+            wxLogError(wxT("Unable to keep any more worm trajectories. They"
+                           " will end at frame %u..."), NewSample.unFrame);
+            return;
+        }
+    }
+}
+
 // Reset the tracker...
 void WormTracker::Reset(unsigned int const _unTotalFrames)
 {
@@ -542,15 +610,18 @@ void WormTracker::Reset(unsigned int const _unTotalFrames)
         // Clear the dead pointer table space...
         TrackingTable.clear();
 
+    // Forget their histories too...
+    Trajectories.Clear();
+    RecordedRefreshes.clear();
+    Habituation.Reset();
+    Reversals.Reset();
+
     // Cleanup the gray image, if any...
-    if(pGrayImage)
-        cvReleaseImage(&pGrayImage);
+    GrayImage.release();
     pGrayImage = NULL;
 
-    // Cleanup the thinking image, if any...
-    if(pThinkingImage)
-        cvReleaseImage(&pThinkingImage);
-    pThinkingImage = NULL;
+    // Release the thinking displays. The analysis thread isn't running yet...
+    ThinkingDisplays.Reset();
         
     // Worms just added in this frame...
     unWormsJustAdded = 0;
@@ -558,6 +629,13 @@ void WormTracker::Reset(unsigned int const _unTotalFrames)
     // Reset current frame and total count...
     unCurrentFrame  = 0;
     unTotalFrames   = _unTotalFrames;
+
+    // Every frame of the media from its first, until told otherwise...
+    unFirstMediaFrame   = 0;
+    unMediaFrameStride  = 1;
+
+    // Let readers know...
+    PublishSnapshot();
 }
 
 // Set the field of view diameter...
@@ -567,6 +645,256 @@ void WormTracker::SetFieldOfViewDiameter(float const fDiameter)
     fFieldOfViewDiameter = fDiameter > 0.01 ? fDiameter : 0.01;
 }
 
+// Set the media's number for our first frame and how far apart the rest
+//  are...
+void WormTracker::SetFrameNumbering(
+    unsigned int const _unFirstMediaFrame,
+    unsigned int const _unMediaFrameStride)
+{
+    // Store...
+    unFirstMediaFrame   = _unFirstMediaFrame;
+    unMediaFrameStride  = _unMediaFrameStride > 0 ? _unMediaFrameStride : 1;
+}
+
+// Set the media's frame rate...
+void WormTracker::SetFrameRate(double const _dFramesPerSecond)
+{
+    // Store for timing reversals...
+    dFramesPerSecond = _dFramesPerSecond;
+
+    // And the habituation analysis needs it to place the stimuli...
+    Habituation.SetFrameRate(dFramesPerSecond);
+}
+
+// Set the stimulus schedule to measure responses to...
+void WormTracker::SetHabituationSchedule(
+    HabituationAnalyzer::Schedule const &Schedule)
+{
+    // Store...
+    Habituation.SetSchedule(Schedule);
+}
+
+// Set the reversal detection thresholds...
+void WormTracker::SetReversalSettings(ReversalDetector::Settings const &Settings)
+{
+    // Store...
+    Reversals.SetSettings(Settings);
+}
+
+// Carry on with the results of another tracker that analyzed the frames right
+//  after ours...
+void WormTracker::Stitch(WormTracker &Later)
+{
+    // Variables...
+    TrajectoryStore::Chunk          Rows;
+    TrajectoryStore::Sample         NewSample;
+    vector<TrajectoryStore::Sample> FirstSamples(Later.Tracking());
+    vector<bool>                    Seen(Later.Tracking(), false);
+    vector<bool>                    Flipped(Later.Tracking(), false);
+    vector<unsigned int>            WormMap(Later.Tracking(), (unsigned) -1);
+    vector<bool>                    Matched(Tracking(), false);
+    unsigned int                    unUnseen = Later.Tracking();
+
+    // A pairing of one of our worms with one of its, and what it costs...
+    typedef struct Pairing
+    {
+        double          dCost;
+        unsigned int    unOurs;
+        unsigned int    unTheirs;
+        bool            bFlipped;
+
+        bool operator<(Pairing const &Other) const
+            { return dCost < Other.dCost; }
+
+    }Pairing;
+    vector<Pairing> Pairings;
+
+    // Lock resources of both...
+    wxMutexLocker   Lock(ResourcesMutex);
+    wxMutexLocker   LaterLock(Later.ResourcesMutex);
+
+    // Its frames carry on from where ours stopped...
+    unsigned int const unFrameOffset = unCurrentFrame;
+
+    // Find where each of its worms was first seen. It records every worm as
+    //  soon as it finds it, so this is usually just its first few rows...
+    for(unsigned int unChunk = 0;
+        unUnseen > 0 && unChunk < Later.Trajectories.Chunks() &&
+            Later.Trajectories.GetChunk(unChunk, Rows);
+      ++unChunk)
+    {
+        // Check each row...
+        for(size_t Row = 0; unUnseen > 0 && Row < Rows.Rows(); ++Row)
+        {
+            // Already found this one...
+            unsigned int const unWorm = Rows.Worm[Row];
+            if(unWorm >= Seen.size() || Seen[unWorm])
+                continue;
+
+            // Note it...
+            TrajectoryStore::Sample &First = FirstSamples[unWorm];
+            First.Centre    =
+                cvPoint(Rows.CentreX[Row], Rows.CentreY[Row]);
+            First.Head      = cvPoint(Rows.HeadX[Row], Rows.HeadY[Row]);
+            First.Tail      = cvPoint(Rows.TailX[Row], Rows.TailY[Row]);
+            First.dArea     = Rows.Area[Row];
+            Seen[unWorm]    = true;
+          --unUnseen;
+        }
+    }
+
+    // Cost every plausible pairing of where one of ours was last and one of
+    //  its was first, a frame apart...
+    for(unsigned int unOurs = 0; unOurs < Tracking(); ++unOurs)
+    {
+        // Get our worm...
+        Worm const &OurWorm = *TrackingTable[unOurs];
+
+        // Check against each of its...
+        for(unsigned int unTheirs = 0; unTheirs < Later.Tracking(); ++unTheirs)
+        {
+            // Never recorded...
+            if(!Seen[unTheirs])
+                continue;
+            TrajectoryStore::Sample const &First = FirstSamples[unTheirs];
+
+            // Too far away to have got there in a frame. Half a body length
+            //  is already generous...
+            double const dDistance = SlitherMath::DistanceBetweenTwoPoints(
+                OurWorm.Centre(), First.Centre);
+            if(dDistance > std::max(OurWorm.Length() / 2.0, 1.0))
+                continue;
+
+            // Too different in size to be the same worm...
+            double const dAreaRatio = (OurWorm.CurrentArea() > 0.0) ?
+                First.dArea / OurWorm.CurrentArea() : 0.0;
+            if(dAreaRatio < 0.5 || 2.0 < dAreaRatio)
+                continue;
+
+            // Closer and more alike is cheaper...
+            Pairing NewPairing;
+            NewPairing.dCost    = dDistance * (1.0 + fabs(log(dAreaRatio)));
+            NewPairing.unOurs   = unOurs;
+            NewPairing.unTheirs = unTheirs;
+
+            // Its first head guess lies nearer our tail than our head...
+            CvPoint const &OurHead = OurWorm.Head();
+            CvPoint const &OurTail = OurWorm.Tail();
+            double const dAsIs =
+                SlitherMath::DistanceBetweenTwoPoints(First.Head, OurHead) +
+                SlitherMath::DistanceBetweenTwoPoints(First.Tail, OurTail);
+            double const dFlipped =
+                SlitherMath::DistanceBetweenTwoPoints(First.Head, OurTail) +
+                SlitherMath::DistanceBetweenTwoPoints(First.Tail, OurHead);
+            NewPairing.bFlipped = (dFlipped < dAsIs);
+
+            // Remember...
+            Pairings.push_back(NewPairing);
+        }
+    }
+
+    // Take the cheapest pairings first, each worm pairing at most once...
+    std::sort(Pairings.begin(), Pairings.end());
+    for(size_t Index = 0; Index < Pairings.size(); ++Index)
+    {
+        // Either already paired...
+        Pairing const &Candidate = Pairings[Index];
+        if(Matched[Candidate.unOurs] ||
+           WormMap[Candidate.unTheirs] != (unsigned) -1)
+            continue;
+
+        // Pair them...
+        Matched[Candidate.unOurs]       = true;
+        WormMap[Candidate.unTheirs]     = Candidate.unOurs;
+        Flipped[Candidate.unTheirs]     = Candidate.bFlipped;
+    }
+
+    // Fold each of its worms into ours, or take it on as a new one...
+    for(unsigned int unTheirs = 0; unTheirs < Later.Tracking(); ++unTheirs)
+    {
+        // Get its worm...
+        Worm *pTheirWorm = Later.TrackingTable[unTheirs];
+
+        // Paired, so fold it in...
+        if(WormMap[unTheirs] != (unsigned) -1)
+        {
+            TrackingTable[WormMap[unTheirs]]->Merge(
+                *pTheirWorm, Flipped[unTheirs]);
+            delete pTheirWorm;
+        }
+
+        // Someone new...
+        else
+        {
+            WormMap[unTheirs] = TrackingTable.size();
+            TrackingTable.push_back(pTheirWorm);
+          ++unWormsJustAdded;
+        }
+    }
+    Later.TrackingTable.clear();
+
+    // Its reversals carry on from ours...
+    Reversals.Stitch(Later.Reversals, WormMap, unFrameOffset);
+
+    // So does its history, its worms renumbered. Its rows already carry the
+    //  media's frame numbers. None of it is kept if ours already stopped...
+    for(unsigned int unChunk = 0;
+        !Trajectories.IsStopped() && unChunk < Later.Trajectories.Chunks();
+      ++unChunk)
+    {
+        // Load. If it can't be read back, our history ends here...
+        if(!Later.Trajectories.GetChunk(unChunk, Rows))
+        {
+            // Alert user and stop recording...
+            wxLogError(wxT("Unable to read back worm trajectories, so they"
+                           " will end early..."));
+            Trajectories.Stop();
+            break;
+        }
+
+        // Append each row...
+        for(size_t Row = 0; Row < Rows.Rows(); ++Row)
+        {
+            NewSample.unFrame   = Rows.Frame[Row];
+            NewSample.unWorm    = WormMap.at(Rows.Worm[Row]);
+            NewSample.Centre    =
+                cvPoint(Rows.CentreX[Row], Rows.CentreY[Row]);
+            NewSample.Head      = cvPoint(Rows.HeadX[Row], Rows.HeadY[Row]);
+            NewSample.Tail      = cvPoint(Rows.TailX[Row], Rows.TailY[Row]);
+            NewSample.dLength   = Rows.Length[Row];
+            NewSample.dWidth    = Rows.Width[Row];
+            NewSample.dArea     = Rows.Area[Row];
+            if(!Trajectories.Append(NewSample))
+            {
+                // Alert user...
+                wxLogError(wxT("Unable to keep any more worm trajectories."
+                               " They will end at frame %u..."),
+                           NewSample.unFrame);
+                break;
+            }
+        }
+    }
+
+    // Our history can't carry on past where either of ours stopped...
+    if(Later.Trajectories.IsStopped())
+        Trajectories.Stop();
+    Later.Trajectories.Clear();
+
+    // Every worm's history is current as of now...
+    RecordedRefreshes.resize(TrackingTable.size());
+    for(unsigned int unWormIndex = 0; unWormIndex < TrackingTable.size();
+      ++unWormIndex)
+        RecordedRefreshes[unWormIndex] =
+            TrackingTable[unWormIndex]->Refreshes();
+
+    // Its frames are ours now too...
+    unCurrentFrame += Later.unCurrentFrame;
+    unTotalFrames  += Later.unTotalFrames;
+
+    // Let readers see the result...
+    PublishSnapshot();
+}
+
 // Set artificial intelligence magic numbers / flags...
 void WormTracker::SetArtificialIntelligenceMagic(
     unsigned int const  _unThreshold, 
@@ -596,14 +924,6 @@ WormTracker::~WormTracker()
         // Deallocate
         delete *Iterator;
     }
-
-    // Cleanup the gray image, if any...
-    if(pGrayImage)
-        cvReleaseImage(&pGrayImage);
-
-    // Cleanup the thinking image, if any...
-    if(pThinkingImage)
-        cvReleaseImage(&pThinkingImage);   
 }
 
 // Output some info on current tracker state......
@@ -13,6 +13,22 @@
     // Worm class...
     #include "Worm.h"
 
+    // Published summaries of the tracker's state...
+    #include "TrackerSnapshot.h"
+
+    // Per frame history of each worm...
+    #include "TrajectoryStore.h"
+
+    // Stimulus response measurement...
+    #include "HabituationAnalyzer.h"
+
+    // Reversal detection...
+    #include "ReversalDetector.h"
+
+    // Thinking display handoff to the user interface...
+    #include "ThinkingDisplayList.h"
+    #include "TripleBuffer.h"
+
     // OpenCV...
     #include <opencv2/opencv.hpp>
     // 2020/06/10 - deprecated header, using new one
@@ -26,7 +42,9 @@
     #include <wx/thread.h>
     
     // Standard libraries and STL...
+    #include <atomic>
     #include <iostream>
+    #include <memory>
     #include <string>
     #include <utility>
     #include <vector>
@@ -45,6 +63,12 @@ class WormTracker
 
         // Accessors...
 
+            // Swap in the newest finished thinking display, if one was
+            //  finished since the last call, without copying or locking.
+            //  Returns true if it changed. Only the user interface thread may
+            //  call this...
+            bool                AcquireThinkingDisplay();
+
             // Convert millimeters to pixels...
             double              ConvertMillimetersToPixels(
                                     double const dMillimeters) const;
@@ -57,26 +81,47 @@ class WormTracker
             double              ConvertSquarePixelsToSquareMillimeters(
                                     double const dPixelsSquared) const;
 
-            // Get the current frame index...
+            // Get the current frame index, from the latest snapshot...
             unsigned int const  GetCurrentFrameIndex() const;
 
-            // Get a copy of the current thinking image. Caller frees...
-            IplImage           *GetThinkingImage() const;
+            // Get the summary published after the most recent frame. Never
+            //  blocks on the analysis thread and never null...
+            std::shared_ptr<TrackerSnapshot const> GetSnapshot() const;
+
+            // Get the thinking display last acquired, empty if none yet.
+            //  Rasterize it to actually see it. The analysis thread leaves it
+            //  alone until the next AcquireThinkingDisplay()...
+            ThinkingDisplayList const &GetThinkingDisplay() const;
             
-            // Get the total number of frames...
+            // Get every worm's per frame history. Only safe from the analysis
+            //  thread or once it has finished...
+            TrajectoryStore const &GetTrajectories() const;
+
+            // Get the total number of frames, from the latest snapshot...
             unsigned int const  GetTotalFrames() const;
 
-            // Get the nth worm, or null worm if no more...
+            // Get the nth worm, or null worm if no more. Only safe from the
+            //  analysis thread, everyone else should use GetSnapshot()...
             Worm const         &GetWorm(unsigned int const unIndex) const;
 
-            // The number of worms we are currently tracking...
+            // Does it have stimuli scheduled to measure responses to? If so,
+            //  it can't be stitched, since responses aren't carried over...
+            bool                IsMeasuringStimuli() const;
+
+            // The number of worms we are currently tracking. Only safe from
+            //  the analysis thread, everyone else should use GetSnapshot()...
             unsigned int        Tracking() const;
 
         // Mutators...
 
-            // Advance frame...
-            void                Advance(IplImage const &NewGrayImage);
-	    void Advance(cv::Mat const &NewGrayMat);
+            // Advance frame, sharing the image's buffer rather than copying
+            //  it. The caller must not write into that buffer again, since the
+            //  thinking display may still be drawing from it...
+            void                Advance(cv::Mat const &NewGrayMat);
+
+            // Take on every setting of another tracker, but none of what it
+            //  has tracked...
+            void                CopySettings(WormTracker const &Source);
 
             // Get the number of worms just added since last check...
             unsigned int const  GetWormsAddedSinceLastCheck();
@@ -96,6 +141,35 @@ class WormTracker
             // Set the field of view diameter...
             void                SetFieldOfViewDiameter(float const fDiameter);
 
+            // Set the media's number for the first frame after a reset, and
+            //  how many of the media's frames apart the rest are, so
+            //  trajectories record which of its frames each row came from.
+            //  Resetting goes back to every frame from the first...
+            void                SetFrameNumbering(
+                unsigned int const  _unFirstMediaFrame,
+                unsigned int const  _unMediaFrameStride);
+
+            // Set the media's frame rate, zero if unknown...
+            void                SetFrameRate(double const dFramesPerSecond);
+
+            // Set the stimulus schedule to measure responses to. The default
+            //  one has no stimuli, which measures nothing...
+            void                SetHabituationSchedule(
+                HabituationAnalyzer::Schedule const &Schedule);
+
+            // Set the reversal detection thresholds...
+            void                SetReversalSettings(
+                ReversalDetector::Settings const &Settings);
+
+            // Carry on with the results of another tracker that analyzed the
+            //  frames right after ours, as though we had gone on to analyze
+            //  them ourselves. Each of its worms is matched to one of ours
+            //  where they meet, by where it is and how big it is, and the
+            //  rest are added. Its worms and history are moved into ours,
+            //  leaving it empty. Stimulus responses aren't carried over, so
+            //  only stitch trackers with no stimulus schedule...
+            void                Stitch(WormTracker &Later);
+
         // Operators...
 
             // Output some info on current tracker state......
@@ -133,8 +207,12 @@ class WormTracker
             // Add new worm to tracker...
             void Add(CvContour const &WormContour);
 
-            // Add a text label to the thinking image at a point...
-            void AddThinkingLabel(string const sLabel, CvPoint Point);
+            // Publish a new snapshot of the tracker's current state...
+            void PublishSnapshot();
+
+            // Append a row to the trajectories for every worm that was
+            //  refreshed on this frame...
+            void RecordTrajectories();
 
     // Protected attributes...
     protected:
@@ -145,22 +223,49 @@ class WormTracker
         // Thinking image label font...
 	CvFont              ThinkingLabelFont;
 
-        // Current frame's gray image and thinking image...
+        // Current frame's gray image, with a legacy header over it for the
+        //  C routines. The pointer is null until the first frame...
+        cv::Mat             GrayImage;
+        IplImage            GrayIplImage;
         IplImage           *pGrayImage;
-        IplImage           *pThinkingImage;
+
+        // Thinking displays. The analysis thread records into the back slot
+        //  while the user interface shows the front one...
+        TripleBuffer<ThinkingDisplayList> ThinkingDisplays;
         
         // Table of worms being tracked...
         vector<Worm *>      TrackingTable;
         
-        // Worms just added in this frame...
-        unsigned int        unWormsJustAdded;
+        // Every worm's per frame history, and how many refreshes each worm
+        //  had when it was last recorded there...
+        TrajectoryStore         Trajectories;
+        vector<unsigned int>    RecordedRefreshes;
+
+        // Every worm's responses to the stimulus schedule...
+        HabituationAnalyzer     Habituation;
+
+        // Every worm's reversals, and the media's frame rate they're timed
+        //  by, zero if unknown...
+        ReversalDetector        Reversals;
+        double                  dFramesPerSecond;
+
+        // Worms added since the user interface last checked...
+        std::atomic<unsigned int> unWormsJustAdded;
         
         // Resources mutex...
         mutable wxMutex     ResourcesMutex;
+
+        // Latest published snapshot. Only ever accessed atomically...
+        std::shared_ptr<TrackerSnapshot const> Snapshot;
         
         // The current frame and the total number of frames...
         unsigned int        unCurrentFrame;
         unsigned int        unTotalFrames;
+
+        // The media's number for our first frame, and how far apart the rest
+        //  are in it...
+        unsigned int        unFirstMediaFrame;
+        unsigned int        unMediaFrameStride;
         
         // Artificial intelligence settings...
         unsigned int        unThreshold; 
@@ -169,6 +274,14 @@ class WormTracker
         unsigned int        unMaximumCandidateSize;
         bool                bInletDetection;
         unsigned int        unMorphologySize;
+
+    // Private methods...
+    private:
+
+        // Not copyable. Its legacy image header points into its own
+        //  members...
+        WormTracker(WormTracker const &);
+        WormTracker &operator=(WormTracker const &);
 };
 
 #endif
@@ -0,0 +1,164 @@
+/*
+  Name:         SlitherMathBenchmark.cpp
+  Author:       Kip Warner (Kip@TheVertigo.com)
+  Description:  Microbenchmark for the SlitherMath helpers as the Worm contour
+                walks use them. Compares calling through an opaque out of line
+                function, as the old SlitherMath.cpp forced, against the header
+                only templates the compiler can now inline...
+  Quick Debug:  g++ -std=c++17 -O2 -I../Source `pkg-config --cflags opencv4` SlitherMathBenchmark.cpp -o SlitherMathBenchmark -Wall -Werror `pkg-config --libs opencv4` && ./SlitherMathBenchmark
+*/
+
+// Includes...
+#include "../Source/SlitherMath.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Using the standard and SlitherMath namespaces...
+using namespace std;
+using namespace SlitherMath;
+
+// Opaque wrappers that stand in for the old translation unit boundary...
+__attribute__((noinline)) double OutOfLineDistance(
+    CvPoint const &First, CvPoint const &Second)
+{
+    return DistanceBetweenTwoPoints(First, Second);
+}
+__attribute__((noinline)) bool OutOfLineIntersect(
+    LineSegment const &A, LineSegment const &B)
+{
+    return IsLineSegmentsIntersect(A, B);
+}
+__attribute__((noinline)) double OutOfLineSegmentDistance(
+    LineSegment const &A, LineSegment const &B)
+{
+    return DistanceBetweenLineSegments(A, B);
+}
+
+// Build a synthetic worm shaped contour, roughly a long thin ellipse...
+vector<CvPoint> CreateContour(unsigned int const unVertices)
+{
+    // Variables...
+    vector<CvPoint> Contour;
+    Contour.reserve(unVertices);
+
+    // Walk around the ellipse with a bit of wobble...
+    for(unsigned int unIndex = 0; unIndex < unVertices; ++unIndex)
+    {
+        double const dTheta = (2.0 * Pi * unIndex) / unVertices;
+        Contour.push_back(cvPoint(
+            (int) (320.0 + 150.0 * cos(dTheta) + (rand() % 3)),
+            (int) (240.0 +  12.0 * sin(dTheta) + (rand() % 3))));
+    }
+
+    // Done...
+    return Contour;
+}
+
+// Walk the contour like Worm::FindVertexIndexByLength, then for each edge scan
+//  every other edge like the opposite side search in Worm::PinchShiftForAnEnd...
+template <typename DistanceFunction, typename IntersectFunction,
+          typename SegmentDistanceFunction>
+double Walk(vector<CvPoint> const &Contour, DistanceFunction Distance,
+            IntersectFunction Intersect,
+            SegmentDistanceFunction SegmentDistance)
+{
+    // Variables...
+    size_t const    Size        = Contour.size();
+    double          dChecksum   = 0.0;
+
+    // Perimeter walk...
+    for(size_t Index = 0; Index < Size; ++Index)
+        dChecksum += Distance(Contour[Index], Contour[(Index + 1) % Size]);
+
+    // Opposite segment search...
+    for(size_t Start = 0; Start < Size; Start += 8)
+    {
+        // Probe across the body from this edge...
+        LineSegment const Probe(
+            cvPointTo32f(Contour[Start]),
+            cvPoint2D32f(Contour[Start].x, Contour[Start].y + 40.0f));
+
+        // Check every candidate...
+        for(size_t Candidate = 0; Candidate < Size; ++Candidate)
+        {
+            LineSegment const CandidateSegment(
+                cvPointTo32f(Contour[Candidate]),
+                cvPointTo32f(Contour[(Candidate + 1) % Size]));
+
+            if(Intersect(Probe, CandidateSegment))
+                dChecksum += SegmentDistance(Probe, CandidateSegment);
+        }
+    }
+
+    // Done...
+    return dChecksum;
+}
+
+// Time a number of passes of the walk in milliseconds...
+template <typename DistanceFunction, typename IntersectFunction,
+          typename SegmentDistanceFunction>
+double Time(vector<CvPoint> const &Contour, unsigned int const unPasses,
+            double &dChecksum, DistanceFunction Distance,
+            IntersectFunction Intersect,
+            SegmentDistanceFunction SegmentDistance)
+{
+    // Start the clock...
+    auto const Start = chrono::steady_clock::now();
+
+    // Run...
+    dChecksum = 0.0;
+    for(unsigned int unPass = 0; unPass < unPasses; ++unPass)
+        dChecksum += Walk(Contour, Distance, Intersect, SegmentDistance);
+
+    // Return elapsed...
+    return chrono::duration<double, milli>(
+        chrono::steady_clock::now() - Start).count();
+}
+
+// Entry point...
+int main(int nArguments, char *ppszArguments[])
+{
+    // Variables...
+    unsigned int const  unVertices  = (nArguments > 1) ? atoi(ppszArguments[1]) : 400;
+    unsigned int const  unPasses    = (nArguments > 2) ? atoi(ppszArguments[2]) : 2000;
+    double              dOutOfLineChecksum  = 0.0;
+    double              dInlineChecksum     = 0.0;
+
+    // Same contour for both runs...
+    srand(1);
+    vector<CvPoint> const Contour = CreateContour(unVertices);
+
+    // Out of line...
+    double const dOutOfLine = Time(Contour, unPasses, dOutOfLineChecksum,
+        OutOfLineDistance, OutOfLineIntersect, OutOfLineSegmentDistance);
+
+    // Inlined...
+    double const dInline = Time(Contour, unPasses, dInlineChecksum,
+        [](CvPoint const &First, CvPoint const &Second)
+            { return DistanceBetweenTwoPoints(First, Second); },
+        [](LineSegment const &A, LineSegment const &B)
+            { return IsLineSegmentsIntersect(A, B); },
+        [](LineSegment const &A, LineSegment const &B)
+            { return DistanceBetweenLineSegments(A, B); });
+
+    // Both must agree or the comparison is meaningless...
+    if(dOutOfLineChecksum != dInlineChecksum)
+    {
+        cerr << "checksum mismatch: " << dOutOfLineChecksum << " != "
+             << dInlineChecksum << endl;
+        return EXIT_FAILURE;
+    }
+
+    // Report...
+    cout << unVertices << " vertices, " << unPasses << " passes" << endl
+         << "  out of line: " << dOutOfLine << " ms" << endl
+         << "  inline:      " << dInline << " ms" << endl
+         << "  speedup:     " << (dOutOfLine / dInline) << "x" << endl;
+
+    // Done...
+    return EXIT_SUCCESS;
+}
+
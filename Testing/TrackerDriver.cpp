@@ -2,7 +2,7 @@
   Name:         TrackerDriver.cpp
   Author:       Kip Warner (Kip@TheVertigo.com)
   Description:  Driver for the worm tracker class...
-  Quick Debug: g++ -I/home/varun/Projects/slither/Source `pkg-config --cflags opencv4` `wx-config --cflags` TrackerDriver.cpp ../Source/WormTracker.cpp ../Source/Worm.cpp ../Source/SlitherMath.cpp -g3 -o TrackerDriver -Wall -Werror `pkg-config --libs opencv4` `wx-config --libs`
+  Quick Debug: g++ -I/home/varun/Projects/slither/Source `pkg-config --cflags opencv4` `wx-config --cflags` TrackerDriver.cpp ../Source/WormTracker.cpp ../Source/Worm.cpp ../Source/ThinkingDisplayList.cpp ../Source/TrajectoryStore.cpp ../Source/HabituationAnalyzer.cpp ../Source/ReversalDetector.cpp -g3 -o TrackerDriver -Wall -Werror `pkg-config --libs opencv4` `wx-config --libs`
 
 */
 
@@ -182,9 +182,9 @@ int main(int nArguments, char *ppszArguments[])
 
 	cv::imshow("Tracker", pGrayImage);
 
-        // Advance tracker frame...
-        IplImage grayImg = cvIplImage(pGrayImage);
-	TestTracker.Advance(grayImg);
+        // Advance tracker frame. Each image is freshly loaded, so the tracker
+        //  can share its buffer...
+	TestTracker.Advance(pGrayImage);
 
         // Show some information on the tracker...
         cout << "Tracker reports: " << TestTracker << endl;